@@ -21,7 +21,10 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <math.h>
 
 #include <shell/tash.h>
 
@@ -29,12 +32,28 @@
 #include <artik_error.h>
 #include <artik_adc.h>
 
+#include "adc-sampler.h"
 #include "command.h"
+#include "dsp-filter.h"
+#include "perf-stats.h"
+
+#define ADC_STREAM_BATCH	32
+#define ADC_STREAM_POLL_US	10000
+#define DSP_BENCH_TAPS		32
+#define DSP_BENCH_BLOCK		256
+#define DSP_BENCH_SETTLE	8
 
 static int adc_read(int argc, char *argv[]);
+static int adc_stream(int argc, char *argv[]);
+static int adc_filter(int argc, char *argv[]);
+static int adc_dspbench(int argc, char *argv[]);
 
 const struct command adc_commands[] = {
 	{ "read", "read <pin num>", adc_read },
+	{ "stream", "stream <pin>[,<pin>...] <rate hz> <count> [quiet]", adc_stream },
+	{ "filter", "filter <pin> <rate hz> <count> <stage>[,...] - avg:n cic:order:decim "
+		"fir:taps:decim iir:alpha stats:n thr:hi:lo", adc_filter },
+	{ "dspbench", "dspbench [<iterations>] - Check and time the filter kernels", adc_dspbench },
 	{ "", "", NULL }
 };
 
@@ -88,6 +107,296 @@ exit:
 	return ret;
 }
 
+static int adc_stream(int argc, char *argv[])
+{
+	struct adc_sampler *sampler = NULL;
+	struct adc_sample samples[ADC_STREAM_BATCH];
+	int pins[ADC_SAMPLER_MAX_PINS];
+	int num_pins = 0;
+	int rate, count;
+	bool quiet = false;
+	bool running;
+	artik_error err = S_OK;
+	unsigned int i, n;
+	char *pin;
+	int ret = 0;
+
+	if (argc < 6) {
+		fprintf(stderr, "Wrong arguments\n");
+		usage(argv[1], adc_commands);
+		return -1;
+	}
+
+	for (pin = strtok(argv[3], ","); pin && (num_pins < ADC_SAMPLER_MAX_PINS);
+			pin = strtok(NULL, ","))
+		pins[num_pins++] = atoi(pin);
+
+	rate = atoi(argv[4]);
+	count = atoi(argv[5]);
+	if ((argc > 6) && !strcmp(argv[6], "quiet"))
+		quiet = true;
+
+	if ((rate <= 0) || (count <= 0)) {
+		fprintf(stderr, "Rate and count must be positive\n");
+		return -1;
+	}
+
+	sampler = malloc(sizeof(struct adc_sampler));
+	if (!sampler) {
+		fprintf(stderr, "Failed to allocate sampler\n");
+		return -1;
+	}
+
+	err = adc_sampler_start(sampler, pins, num_pins, rate, count);
+	if (err != S_OK) {
+		fprintf(stderr, "Failed to start sampling (%d)\n", err);
+		ret = -1;
+		goto exit;
+	}
+
+	/*
+	 * Drain the ring until the sampler is done and nothing is left. The
+	 * state is checked before reading so that the last samples pushed
+	 * before the sampler stopped are not missed.
+	 */
+	do {
+		running = adc_sampler_running(sampler);
+		n = adc_sampler_read(sampler, samples, ADC_STREAM_BATCH);
+		for (i = 0; !quiet && (i < n); i++)
+			fprintf(stdout, "%u ADC%d=%d\n", samples[i].time_us, samples[i].pin,
+				samples[i].value);
+		if (!n && running)
+			usleep(ADC_STREAM_POLL_US);
+	} while (n || running);
+
+	adc_sampler_stop(sampler);
+	adc_sampler_report(sampler);
+
+exit:
+	free(sampler);
+	return ret;
+}
+
+static void adc_filter_window(const struct dsp_window *window, void *user_data)
+{
+	fprintf(stdout, "window: min=%d max=%d rms=%d\n", window->min, window->max, window->rms);
+}
+
+static void adc_filter_event(bool above, q15_t value, void *user_data)
+{
+	fprintf(stdout, "threshold: %s at %d\n", above ? "above" : "below", value);
+}
+
+static int adc_filter(int argc, char *argv[])
+{
+	struct adc_sampler *sampler = NULL;
+	struct dsp_pipeline *pipeline = NULL;
+	struct adc_sample samples[ADC_STREAM_BATCH];
+	q15_t values[ADC_STREAM_BATCH];
+	unsigned int in = 0, out = 0;
+	int pin, rate, count, i, n, got;
+	artik_error err = S_OK;
+	bool running;
+	int ret = 0;
+
+	if (argc < 7) {
+		fprintf(stderr, "Wrong arguments\n");
+		usage(argv[1], adc_commands);
+		return -1;
+	}
+
+	pin = atoi(argv[3]);
+	rate = atoi(argv[4]);
+	count = atoi(argv[5]);
+	if ((rate <= 0) || (count <= 0)) {
+		fprintf(stderr, "Rate and count must be positive\n");
+		return -1;
+	}
+
+	sampler = malloc(sizeof(struct adc_sampler));
+	pipeline = malloc(sizeof(struct dsp_pipeline));
+	if (!sampler || !pipeline) {
+		fprintf(stderr, "Failed to allocate filter\n");
+		ret = -1;
+		goto exit;
+	}
+
+	if (dsp_pipeline_parse(pipeline, argv[6], adc_filter_window, adc_filter_event,
+			NULL) != S_OK) {
+		ret = -1;
+		goto exit;
+	}
+
+	err = adc_sampler_start(sampler, &pin, 1, rate, count);
+	if (err != S_OK) {
+		fprintf(stderr, "Failed to start sampling (%d)\n", err);
+		ret = -1;
+		goto exit;
+	}
+
+	/* Only what comes out of the pipeline is printed */
+	do {
+		running = adc_sampler_running(sampler);
+		got = adc_sampler_read(sampler, samples, ADC_STREAM_BATCH);
+		for (i = 0; i < got; i++)
+			values[i] = samples[i].value;
+		in += got;
+
+		n = dsp_pipeline_process(pipeline, values, got);
+		for (i = 0; i < n; i++)
+			fprintf(stdout, "ADC%d=%d\n", pin, values[i]);
+		out += n;
+
+		if (!got && running)
+			usleep(ADC_STREAM_POLL_US);
+	} while (got || running);
+
+	adc_sampler_stop(sampler);
+	adc_sampler_report(sampler);
+	fprintf(stdout, "%u samples in, %u out\n", in, out);
+
+exit:
+	free(pipeline);
+	free(sampler);
+	return ret;
+}
+
+static uint32_t adc_dspbench_pipeline(const char *spec, const q15_t *input, int iterations)
+{
+	struct dsp_pipeline pipeline;
+	q15_t block[DSP_BENCH_BLOCK];
+	char stages[32];
+	uint64_t start;
+	int i;
+
+	strncpy(stages, spec, sizeof(stages) - 1);
+	stages[sizeof(stages) - 1] = '\0';
+	if (dsp_pipeline_parse(&pipeline, stages, NULL, NULL, NULL) != S_OK)
+		return 0;
+
+	start = perf_now_us();
+	for (i = 0; i < iterations; i++) {
+		memcpy(block, input, sizeof(block));
+		dsp_pipeline_process(&pipeline, block, DSP_BENCH_BLOCK);
+	}
+
+	/* Nanoseconds per input sample */
+	return (uint32_t)((perf_now_us() - start) * 1000 / ((uint64_t)iterations * DSP_BENCH_BLOCK));
+}
+
+/*
+ * Checks the fixed-point kernels against single precision on a synthetic
+ * signal, then times them and a few pipelines.
+ */
+static int adc_dspbench(int argc, char *argv[])
+{
+	static const char * const pipelines[] = {
+		"avg:16", "cic:3:4", "fir:32:4", "iir:0.05", "cic:2:4,fir:16:2,iir:0.1"
+	};
+	float design[DSP_BENCH_TAPS], coeffs_f[DSP_BENCH_TAPS];
+	float input_f[DSP_BENCH_BLOCK];
+	q15_t coeffs_q[DSP_BENCH_TAPS];
+	q15_t input_q[DSP_BENCH_BLOCK];
+	struct dsp_pipeline pipeline;
+	int iterations = 100;
+	int fir_err = 0, iir_err = 0, dc_err = 0;
+	int windows = DSP_BENCH_BLOCK - DSP_BENCH_TAPS;
+	float ref, y = 0.0f;
+	uint64_t start;
+	uint32_t q15_ns, f32_ns;
+	q15_t out, dc[DSP_BENCH_BLOCK];
+	int i, n, d;
+	int ret = 0;
+
+	if (argc > 3)
+		iterations = atoi(argv[3]);
+	if (iterations <= 0) {
+		fprintf(stderr, "Iterations must be positive\n");
+		return -1;
+	}
+
+	for (i = 0; i < DSP_BENCH_BLOCK; i++) {
+		input_q[i] = DSP_FLOAT_TO_Q15(0.4f * sinf(2 * M_PI * i / 64) +
+			0.1f * sinf(2 * M_PI * i * 7 / 17));
+		input_f[i] = input_q[i];
+	}
+
+	dsp_fir_design_lowpass(design, DSP_BENCH_TAPS, 0.1f);
+	for (i = 0; i < DSP_BENCH_TAPS; i++) {
+		coeffs_q[i] = DSP_FLOAT_TO_Q15(design[i]);
+		coeffs_f[i] = coeffs_q[i] / 32768.0f;
+	}
+
+	/* FIR: same quantized coefficients and inputs, results within rounding */
+	for (n = 0; n < windows; n++) {
+		out = dsp_fir_q15(coeffs_q, &input_q[n], DSP_BENCH_TAPS);
+		ref = dsp_fir_f32(coeffs_f, &input_f[n], DSP_BENCH_TAPS);
+		d = abs(out - (int)lrintf(ref));
+		if (d > fir_err)
+			fir_err = d;
+	}
+
+	/* IIR: Q31 state against float */
+	dsp_pipeline_init(&pipeline);
+	dsp_add_iir(&pipeline, DSP_FLOAT_TO_Q15(0.05f));
+	memcpy(dc, input_q, sizeof(dc));
+	dsp_pipeline_process(&pipeline, dc, DSP_BENCH_BLOCK);
+	for (i = 0; i < DSP_BENCH_BLOCK; i++) {
+		ref = dsp_iir_f32(&y, DSP_FLOAT_TO_Q15(0.05f) / 32768.0f, input_f[i]);
+		d = abs(dc[i] - (int)lrintf(ref));
+		if (d > iir_err)
+			iir_err = d;
+	}
+
+	/* Every pipeline must settle to unity gain on a constant input */
+	for (i = 0; i < (int)(sizeof(pipelines) / sizeof(pipelines[0])); i++) {
+		char stages[32];
+		int block;
+
+		strncpy(stages, pipelines[i], sizeof(stages) - 1);
+		stages[sizeof(stages) - 1] = '\0';
+		dsp_pipeline_parse(&pipeline, stages, NULL, NULL, NULL);
+		for (block = 0; block < DSP_BENCH_SETTLE; block++) {
+			for (n = 0; n < DSP_BENCH_BLOCK; n++)
+				dc[n] = 1000;
+			n = dsp_pipeline_process(&pipeline, dc, DSP_BENCH_BLOCK);
+		}
+		d = abs(dc[n - 1] - 1000);
+		if (d > dc_err)
+			dc_err = d;
+	}
+
+	fprintf(stdout, "max error: fir %d LSB, iir %d LSB, dc gain %d/1000\n", fir_err,
+		iir_err, dc_err);
+	if ((fir_err > 1) || (iir_err > 2) || (dc_err > 10)) {
+		fprintf(stderr, "Filter kernels are out of tolerance\n");
+		ret = -1;
+	}
+
+	start = perf_now_us();
+	for (i = 0; i < iterations; i++)
+		for (n = 0; n < windows; n++)
+			input_q[n] = dsp_fir_q15(coeffs_q, &input_q[n], DSP_BENCH_TAPS);
+	q15_ns = (uint32_t)((perf_now_us() - start) * 1000 / ((uint64_t)iterations * windows));
+
+	start = perf_now_us();
+	for (i = 0; i < iterations; i++)
+		for (n = 0; n < windows; n++)
+			input_f[n] = dsp_fir_f32(coeffs_f, &input_f[n], DSP_BENCH_TAPS);
+	f32_ns = (uint32_t)((perf_now_us() - start) * 1000 / ((uint64_t)iterations * windows));
+
+	fprintf(stdout, "fir %d taps: q15 %u ns/sample, f32 %u ns/sample\n", DSP_BENCH_TAPS,
+		q15_ns, f32_ns);
+
+	/* The kernels above overwrote the signal, so the pipelines get a fresh one */
+	for (i = 0; i < DSP_BENCH_BLOCK; i++)
+		input_q[i] = DSP_FLOAT_TO_Q15(0.4f * sinf(2 * M_PI * i / 64));
+	for (i = 0; i < (int)(sizeof(pipelines) / sizeof(pipelines[0])); i++)
+		fprintf(stdout, "%s: %u ns/sample\n", pipelines[i],
+			adc_dspbench_pipeline(pipelines[i], input_q, iterations));
+
+	return ret;
+}
 
 #ifdef CONFIG_BUILD_KERNEL
 int main(int argc, FAR char *argv[])
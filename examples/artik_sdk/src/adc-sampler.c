@@ -0,0 +1,208 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file adc-sampler.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <artik_module.h>
+
+#include "adc-sampler.h"
+
+#define ADC_SAMPLER_STACK_SIZE	4096
+#define RING_MASK				(ADC_SAMPLER_RING_SIZE - 1)
+
+/* Producer side, only ever called from the sampler thread */
+static void adc_sampler_push(struct adc_sampler *s, uint32_t time_us, int pin, int value)
+{
+	unsigned int head = s->head;
+	unsigned int tail = __atomic_load_n(&s->tail, __ATOMIC_ACQUIRE);
+	struct adc_sample *slot;
+
+	if (head - tail >= ADC_SAMPLER_RING_SIZE) {
+		s->overruns++;
+		return;
+	}
+
+	slot = &s->ring[head & RING_MASK];
+	slot->time_us = time_us;
+	slot->pin = pin;
+	slot->value = value;
+	__atomic_store_n(&s->head, head + 1, __ATOMIC_RELEASE);
+	s->samples++;
+}
+
+static pthread_addr_t adc_sampler_thread(pthread_addr_t arg)
+{
+	struct adc_sampler *s = (struct adc_sampler *)arg;
+	uint64_t period_us = 1000000 / s->rate_hz;
+	uint64_t deadline, now, t;
+	int i, value;
+
+	s->start_us = perf_now_us();
+	deadline = s->start_us;
+
+	while (__atomic_load_n(&s->running, __ATOMIC_ACQUIRE) &&
+			(!s->ticks || (s->taken < s->ticks))) {
+		now = perf_now_us();
+		if (now < deadline) {
+			usleep(deadline - now);
+			now = perf_now_us();
+		}
+
+		for (i = 0; i < s->num_pins; i++) {
+			t = perf_now_us();
+			if (s->adc->get_value(s->handles[i], &value) != S_OK) {
+				s->errors++;
+				continue;
+			}
+			perf_stats_add(&s->read, perf_now_us() - t);
+			adc_sampler_push(s, t - s->start_us, s->pins[i], value);
+		}
+		s->taken++;
+
+		/* Skip the ticks that went by while this one was late */
+		deadline += period_us;
+		now = perf_now_us();
+		if (now > deadline + period_us) {
+			s->missed += (now - deadline) / period_us;
+			deadline += ((now - deadline) / period_us) * period_us;
+		}
+	}
+
+	s->end_us = perf_now_us();
+	__atomic_store_n(&s->running, false, __ATOMIC_RELEASE);
+
+	return NULL;
+}
+
+static void adc_sampler_release(struct adc_sampler *s)
+{
+	int i;
+
+	for (i = 0; i < s->num_pins; i++) {
+		if (s->handles[i])
+			s->adc->release(s->handles[i]);
+		s->handles[i] = NULL;
+	}
+
+	artik_release_api_module(s->adc);
+	s->adc = NULL;
+}
+
+/* Samples num_pins pins rate_hz times per second, 'ticks' times or until stopped if 0 */
+artik_error adc_sampler_start(struct adc_sampler *s, const int *pins, int num_pins,
+		unsigned int rate_hz, unsigned int ticks)
+{
+	artik_adc_config config;
+	pthread_attr_t attr;
+	char name[16];
+	artik_error ret = S_OK;
+	int i;
+
+	if (!s || !pins || (num_pins <= 0) || (num_pins > ADC_SAMPLER_MAX_PINS) ||
+			!rate_hz || (rate_hz > ADC_SAMPLER_MAX_RATE))
+		return E_BAD_ARGS;
+
+	memset(s, 0, sizeof(*s));
+	perf_stats_reset(&s->read);
+	s->num_pins = num_pins;
+	s->rate_hz = rate_hz;
+	s->ticks = ticks;
+
+	s->adc = (artik_adc_module *)artik_request_api_module("adc");
+	if (!s->adc)
+		return E_NOT_SUPPORTED;
+
+	for (i = 0; i < num_pins; i++) {
+		memset(&config, 0, sizeof(config));
+		config.pin_num = pins[i];
+		snprintf(name, sizeof(name), "adc%d", pins[i]);
+		config.name = name;
+
+		ret = s->adc->request(&s->handles[i], &config);
+		if (ret != S_OK) {
+			fprintf(stderr, "Failed to request ADC %d (%d)\n", pins[i], ret);
+			s->handles[i] = NULL;
+			adc_sampler_release(s);
+			return ret;
+		}
+		s->pins[i] = pins[i];
+	}
+
+	s->running = true;
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, ADC_SAMPLER_STACK_SIZE);
+	if (pthread_create(&s->thread, &attr, adc_sampler_thread, s) != 0) {
+		s->running = false;
+		adc_sampler_release(s);
+		ret = E_NO_MEM;
+	}
+	pthread_attr_destroy(&attr);
+
+	return ret;
+}
+
+/* Consumer side, returns the number of samples copied */
+unsigned int adc_sampler_read(struct adc_sampler *s, struct adc_sample *samples,
+		unsigned int max)
+{
+	unsigned int tail = s->tail;
+	unsigned int head = __atomic_load_n(&s->head, __ATOMIC_ACQUIRE);
+	unsigned int n = 0;
+
+	while ((tail != head) && (n < max))
+		samples[n++] = s->ring[tail++ & RING_MASK];
+
+	__atomic_store_n(&s->tail, tail, __ATOMIC_RELEASE);
+
+	return n;
+}
+
+bool adc_sampler_running(struct adc_sampler *s)
+{
+	return __atomic_load_n(&s->running, __ATOMIC_ACQUIRE);
+}
+
+void adc_sampler_stop(struct adc_sampler *s)
+{
+	if (!s->adc)
+		return;
+
+	__atomic_store_n(&s->running, false, __ATOMIC_RELEASE);
+	pthread_join(s->thread, NULL);
+	adc_sampler_release(s);
+}
+
+void adc_sampler_report(struct adc_sampler *s)
+{
+	uint64_t elapsed = s->end_us - s->start_us;
+
+	fprintf(stdout, "%u ticks, %u samples from %d pins, %u overruns, %u missed ticks, "
+		"%u read errors\n", s->taken, s->samples, s->num_pins, s->overruns, s->missed,
+		s->errors);
+	if (elapsed)
+		fprintf(stdout, "rate %llu.%02llu Hz (requested %u Hz)\n",
+			(unsigned long long)s->taken * 1000000 / elapsed,
+			(unsigned long long)s->taken * 100000000 / elapsed % 100, s->rate_hz);
+	perf_stats_print("read", &s->read);
+}
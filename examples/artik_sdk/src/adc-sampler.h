@@ -0,0 +1,91 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file adc-sampler.h
+ */
+
+#ifndef __ARTIK_ADC_SAMPLER_H__
+#define __ARTIK_ADC_SAMPLER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include <artik_adc.h>
+
+#include "perf-stats.h"
+
+#define ADC_SAMPLER_MAX_PINS	8
+#define ADC_SAMPLER_RING_SIZE	256	/* Must be a power of two */
+#define ADC_SAMPLER_MAX_RATE	10000
+
+struct adc_sample {
+	uint32_t time_us;	/* Since the sampler was started */
+	uint16_t pin;
+	int value;
+};
+
+/*
+ * Periodic sampling of one or more ADC pins.
+ *
+ * The pins are requested once when the sampler starts and kept open, so a
+ * sample only costs the get_value() call. A sampler thread reads every
+ * pin once per tick, with ticks paced against absolute deadlines so that
+ * the rate does not drift with the time spent reading. Ticks that could
+ * not be taken in time are skipped and counted as missed.
+ *
+ * Samples are handed to the consumer through a lock-free single producer,
+ * single consumer ring: the sampler thread only writes head, the consumer
+ * only writes tail. A sample arriving while the ring is full is dropped and
+ * counted as an overrun.
+ */
+struct adc_sampler {
+	artik_adc_module *adc;
+	artik_adc_handle handles[ADC_SAMPLER_MAX_PINS];
+	int pins[ADC_SAMPLER_MAX_PINS];
+	int num_pins;
+	unsigned int rate_hz;
+	unsigned int ticks;
+
+	struct adc_sample ring[ADC_SAMPLER_RING_SIZE];
+	unsigned int head;
+	unsigned int tail;
+	bool running;
+	pthread_t thread;
+
+	/* Written by the sampler thread, read once it is done */
+	unsigned int taken;
+	unsigned int samples;
+	unsigned int overruns;
+	unsigned int missed;
+	unsigned int errors;
+	struct perf_stats read;
+	uint64_t start_us;
+	uint64_t end_us;
+};
+
+artik_error adc_sampler_start(struct adc_sampler *s, const int *pins, int num_pins,
+		unsigned int rate_hz, unsigned int ticks);
+unsigned int adc_sampler_read(struct adc_sampler *s, struct adc_sample *samples,
+		unsigned int max);
+bool adc_sampler_running(struct adc_sampler *s);
+void adc_sampler_stop(struct adc_sampler *s);
+void adc_sampler_report(struct adc_sampler *s);
+
+#endif /* __ARTIK_ADC_SAMPLER_H__ */
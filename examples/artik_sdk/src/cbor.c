@@ -0,0 +1,197 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file cbor.c
+ */
+
+#include <string.h>
+
+#include "cbor.h"
+
+#define CBOR_UINT		0
+#define CBOR_NEGINT		1
+#define CBOR_TEXT		3
+#define CBOR_ARRAY		4
+#define CBOR_MAP		5
+#define CBOR_SIMPLE		7
+
+#define CBOR_FALSE		20
+#define CBOR_TRUE		21
+#define CBOR_NULL		22
+#define CBOR_FLOAT32	26
+#define CBOR_FLOAT64	27
+
+static void cbor_write(struct cbor_writer *w, const void *data, unsigned int len)
+{
+	const uint8_t *p = (const uint8_t *)data;
+	unsigned int n;
+
+	w->total += len;
+
+	while (len && !w->overflow) {
+		if (w->len == w->size) {
+			if (!w->sink || (w->sink(w->buf, w->len, w->user_data) < 0)) {
+				w->overflow = true;
+				return;
+			}
+			w->len = 0;
+		}
+
+		n = w->size - w->len;
+		if (n > len)
+			n = len;
+		memcpy(w->buf + w->len, p, n);
+		w->len += n;
+		p += n;
+		len -= n;
+	}
+}
+
+/* Initial byte and argument in the shortest form, big endian */
+static void cbor_put_head(struct cbor_writer *w, uint8_t major, uint64_t value)
+{
+	uint8_t head[9];
+	unsigned int len, i;
+
+	if (value < 24) {
+		head[0] = (major << 5) | value;
+		len = 1;
+	} else if (value <= 0xff) {
+		head[0] = (major << 5) | 24;
+		len = 2;
+	} else if (value <= 0xffff) {
+		head[0] = (major << 5) | 25;
+		len = 3;
+	} else if (value <= 0xffffffff) {
+		head[0] = (major << 5) | 26;
+		len = 5;
+	} else {
+		head[0] = (major << 5) | 27;
+		len = 9;
+	}
+
+	for (i = len - 1; i > 0; i--) {
+		head[i] = value & 0xff;
+		value >>= 8;
+	}
+
+	cbor_write(w, head, len);
+}
+
+void cbor_init(struct cbor_writer *w, uint8_t *buf, unsigned int size, cbor_sink sink,
+		void *user_data)
+{
+	memset(w, 0, sizeof(struct cbor_writer));
+	w->buf = buf;
+	w->size = size;
+	w->sink = sink;
+	w->user_data = user_data;
+}
+
+void cbor_put_uint(struct cbor_writer *w, uint64_t value)
+{
+	cbor_put_head(w, CBOR_UINT, value);
+}
+
+void cbor_put_int(struct cbor_writer *w, int64_t value)
+{
+	if (value < 0)
+		cbor_put_head(w, CBOR_NEGINT, (uint64_t)(-1 - value));
+	else
+		cbor_put_head(w, CBOR_UINT, (uint64_t)value);
+}
+
+void cbor_put_float(struct cbor_writer *w, float value)
+{
+	union {
+		float f;
+		uint32_t u;
+	} v = { .f = value };
+	uint8_t data[5];
+	int i;
+
+	data[0] = (CBOR_SIMPLE << 5) | CBOR_FLOAT32;
+	for (i = 4; i > 0; i--) {
+		data[i] = v.u & 0xff;
+		v.u >>= 8;
+	}
+
+	cbor_write(w, data, sizeof(data));
+}
+
+void cbor_put_double(struct cbor_writer *w, double value)
+{
+	union {
+		double d;
+		uint64_t u;
+	} v = { .d = value };
+	uint8_t data[9];
+	int i;
+
+	data[0] = (CBOR_SIMPLE << 5) | CBOR_FLOAT64;
+	for (i = 8; i > 0; i--) {
+		data[i] = v.u & 0xff;
+		v.u >>= 8;
+	}
+
+	cbor_write(w, data, sizeof(data));
+}
+
+void cbor_put_bool(struct cbor_writer *w, bool value)
+{
+	cbor_put_head(w, CBOR_SIMPLE, value ? CBOR_TRUE : CBOR_FALSE);
+}
+
+void cbor_put_null(struct cbor_writer *w)
+{
+	cbor_put_head(w, CBOR_SIMPLE, CBOR_NULL);
+}
+
+void cbor_put_text(struct cbor_writer *w, const char *text, unsigned int len)
+{
+	cbor_put_head(w, CBOR_TEXT, len);
+	cbor_write(w, text, len);
+}
+
+void cbor_put_string(struct cbor_writer *w, const char *str)
+{
+	cbor_put_text(w, str, strlen(str));
+}
+
+void cbor_put_array(struct cbor_writer *w, unsigned int count)
+{
+	cbor_put_head(w, CBOR_ARRAY, count);
+}
+
+void cbor_put_map(struct cbor_writer *w, unsigned int count)
+{
+	cbor_put_head(w, CBOR_MAP, count);
+}
+
+/*
+ * Returns the number of bytes left in the buffer (all of the message when
+ * there is no sink), or -1 if the message did not fit.
+ */
+int cbor_finish(struct cbor_writer *w)
+{
+	if (w->overflow)
+		return -1;
+
+	return w->len;
+}
@@ -0,0 +1,65 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file cbor.h
+ */
+
+#ifndef __ARTIK_CBOR_H__
+#define __ARTIK_CBOR_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Streaming CBOR (RFC 7049) encoder writing into a caller supplied
+ * buffer. Nothing is allocated: when the buffer fills up it is handed to
+ * the sink and reused, or the writer is marked as overflowed if there is
+ * no sink, in which case cbor_finish() fails.
+ *
+ * Only the JSON representable subset is produced (text keys, integers,
+ * floats, booleans, null, text, arrays and maps) so that a message can
+ * be converted to JSON item by item as described in RFC 7049 section 4.1.
+ */
+typedef int (*cbor_sink)(const uint8_t *data, unsigned int len, void *user_data);
+
+struct cbor_writer {
+	uint8_t *buf;
+	unsigned int size;
+	unsigned int len;
+	unsigned int total;
+	bool overflow;
+	cbor_sink sink;
+	void *user_data;
+};
+
+void cbor_init(struct cbor_writer *w, uint8_t *buf, unsigned int size, cbor_sink sink,
+		void *user_data);
+void cbor_put_uint(struct cbor_writer *w, uint64_t value);
+void cbor_put_int(struct cbor_writer *w, int64_t value);
+void cbor_put_float(struct cbor_writer *w, float value);
+void cbor_put_double(struct cbor_writer *w, double value);
+void cbor_put_bool(struct cbor_writer *w, bool value);
+void cbor_put_null(struct cbor_writer *w);
+void cbor_put_text(struct cbor_writer *w, const char *text, unsigned int len);
+void cbor_put_string(struct cbor_writer *w, const char *str);
+void cbor_put_array(struct cbor_writer *w, unsigned int count);
+void cbor_put_map(struct cbor_writer *w, unsigned int count);
+int cbor_finish(struct cbor_writer *w);
+
+#endif /* __ARTIK_CBOR_H__ */
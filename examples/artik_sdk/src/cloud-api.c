@@ -31,7 +31,18 @@
 #include <artik_http.h>
 #include <artik_lwm2m.h>
 
+#include "cloud-sched.h"
+#include "cloud-stream.h"
+#include "cloud-devices.h"
 #include "command.h"
+#include "device-cache.h"
+#include "dns-cache.h"
+#include "flash-queue.h"
+#include "perf-stats.h"
+#include "telemetry.h"
+#include "telemetry-batch.h"
+#include "wifi-manager.h"
+#include "ws-manager.h"
 
 #ifdef CONFIG_EXAMPLES_ARTIK_CLOUD
 #include "wifi-auto.h"
@@ -50,6 +61,13 @@
 #define OTA_FIRMWARE_HEADER_SIZE	4096
 #define UUID_MAX_LEN				64
 #define LWM2M_RES_DEVICE_REBOOT	"/3/0/4"
+#define CLOUD_WEBSOCKET_URI			"wss://api.artik.cloud/v1.1/websocket"
+#define CLOUD_WEBSOCKET_NAME		"cloud"
+#define ENCODE_MAX_FIELDS			20
+#define TOKEN_MAX_LEN				64
+#define OFFLINE_DRAIN_RATE			5
+#define OFFLINE_DRAIN_BATCH			5
+#define ENCODE_BUFFER_SIZE			512
 
 struct ota_info {
 	char header[OTA_FIRMWARE_HEADER_SIZE];
@@ -66,44 +84,157 @@ static int disconnect_command(int argc, char *argv[]);
 static int send_command(int argc, char *argv[]);
 static int sdr_command(int argc, char *argv[]);
 static int dm_command(int argc, char *argv[]);
+static int stats_command(int argc, char *argv[]);
+static int encode_command(int argc, char *argv[]);
+static int batch_command(int argc, char *argv[]);
+static int queue_command(int argc, char *argv[]);
+static int sched_command(int argc, char *argv[]);
+static int cache_command(int argc, char *argv[]);
 
 static artik_websocket_handle ws_handle;
+static artik_cloud_module *ws_cloud;
+static char ws_device_id[TELEMETRY_BATCH_DEVICE_LEN];
+static char g_batch_token[TOKEN_MAX_LEN];
+static struct flash_queue g_offline;
+static bool g_offline_open;
+static bool g_link_down;
+static int g_wifi_subscriber = -1;
 static artik_lwm2m_config *g_dm_config;
 static artik_lwm2m_handle g_dm_client;
 static struct ota_info *g_dm_info;
 
 const struct command cloud_commands[] = {
 	{ "device", "device <token> <device id> [<properties>]", device_command },
-	{ "devices", "<token> <user id> [<count> <offset> <properties>]", devices_command },
+	{ "devices", "<token> <user id> [<count> (0 for all) <offset> <properties>]", devices_command },
 	{ "message", "<token> <device id> <message>", message_command },
 	{ "connect", "<token> <device id> [use_se]", connect_command },
 	{ "disconnect", "", disconnect_command },
 	{ "send", "<message>", send_command },
 	{ "sdr", "start|status|complete <dtid> <vdid>|<regid>|<regid> <nonce>", sdr_command },
 	{ "dm", "connect|read|change|disconnect <token> <did>|<uri>|<uri> <value>", dm_command },
+	{ "stats", "Display websocket connection statistics", stats_command },
+	{ "encode", "[<fields> <iterations>] - Compare JSON and CBOR message encoding", encode_command },
+	{ "batch", "config|agg|add|flush|stats <did> <records> <age ms> [<token>]|<did> <field> <agg>|"
+		"<did> <field>=<value>...|[<did>]", batch_command },
+	{ "queue", "stats|clear - Offline message queue", queue_command },
+	{ "sched", "stats|rate <endpoint> <per minute> <burst> - Outbound rate limiting", sched_command },
+	{ "cache", "stats|clear - Conditional device requests", cache_command },
 	{ "", "", NULL }
 };
 
-static void websocket_rx_callback(void *user_data, void *result)
+static void websocket_rx_callback(const char *name, struct ws_frame *frame, void *user_data)
 {
-	if (result) {
-		fprintf(stderr, "RX: %s\n", (char *)result);
-		free(result);
+	fprintf(stderr, "RX: %.*s\n", frame->len, frame->data);
+}
+
+/* Messages that cannot be sent are kept in flash until the next connection */
+static struct flash_queue *offline_queue(void)
+{
+	if (!g_offline_open) {
+		if (flash_queue_open(&g_offline, FLASH_QUEUE_PATH) != S_OK) {
+			fprintf(stderr, "Failed to open offline queue %s\n", FLASH_QUEUE_PATH);
+			return NULL;
+		}
+		g_offline_open = true;
+	}
+
+	return &g_offline;
+}
+
+static int cloud_network_ready(void)
+{
+	artik_error err = wifi_manager_wait_ready(WIFI_MANAGER_READY_TIMEOUT_MS);
+
+	if (err != S_OK) {
+		fprintf(stderr, "Network is not ready (%s)\n", error_msg(err));
+		return -1;
+	}
+
+	return 0;
+}
+
+/* A throttled endpoint stops the replay until the next drain round */
+static artik_error offline_sink(const char *data, unsigned int len, void *user_data)
+{
+	if (cloud_sched_acquire(CLOUD_SCHED_WEBSOCKET, CLOUD_SCHED_TELEMETRY, 0) != S_OK)
+		return E_BUSY;
+
+	return ws_manager_send(CLOUD_WEBSOCKET_NAME, data, 0);
+}
+
+/*
+ * Sends over the websocket, or stores the message while it is down or the
+ * endpoint is throttled. Once anything is stored, new messages are queued
+ * behind it until the queue has drained, so that they reach the cloud in
+ * order.
+ */
+static artik_error cloud_publish(const char *message)
+{
+	struct flash_queue *q = offline_queue();
+
+	if (ws_handle && !g_link_down && (!q || flash_queue_empty(q)) &&
+			(cloud_sched_acquire(CLOUD_SCHED_WEBSOCKET, CLOUD_SCHED_TELEMETRY, 0) == S_OK) &&
+			(ws_manager_send(CLOUD_WEBSOCKET_NAME, message, 0) == S_OK))
+		return S_OK;
+
+	return q ? flash_queue_append(q, message, strlen(message)) : E_NOT_SUPPORTED;
+}
+
+/*
+ * Runs on the websocket manager task, so it never waits for a token: those
+ * are taken before the message is queued. A message the socket refuses is
+ * stored for the next connection instead of being lost.
+ */
+static artik_error websocket_close(artik_websocket_handle handle)
+{
+	return ws_cloud->websocket_close_stream(handle);
+}
+
+static artik_error websocket_write(artik_websocket_handle handle, char *message)
+{
+	artik_error err = S_OK;
+
+	err = ws_cloud->websocket_send_message(handle, message);
+	cloud_sched_complete(CLOUD_SCHED_WEBSOCKET, err, CLOUD_SCHED_STATUS_UNKNOWN);
+	if ((err != S_OK) && g_offline_open)
+		flash_queue_append(&g_offline, message, strlen(message));
+
+	return err;
+}
+
+/*
+ * Runs on the wifi manager task. Messages are stored rather than queued to
+ * the websocket while the link is down, and the replay resumes once the
+ * network is back.
+ */
+static void cloud_link_event(enum wifi_manager_event event, void *user_data)
+{
+	if (event == WIFI_EVENT_LINK_DOWN) {
+		g_link_down = true;
+		if (g_offline_open)
+			flash_queue_stop_drain(&g_offline);
+	} else if (event == WIFI_EVENT_IP_READY) {
+		g_link_down = false;
+		if (ws_handle && g_offline_open)
+			flash_queue_drain(&g_offline, offline_sink, NULL, OFFLINE_DRAIN_RATE,
+				OFFLINE_DRAIN_BATCH);
 	}
 }
 
+static int print_response_chunk(const char *data, unsigned int len, void *user_data)
+{
+	fwrite(data, 1, len, stdout);
+
+	return len;
+}
+
 static int device_command(int argc, char *argv[])
 {
-	artik_cloud_module *cloud = (artik_cloud_module *)artik_request_api_module("cloud");
 	int ret = 0;
-	char *response = NULL;
 	artik_error err = S_OK;
 	bool properties = false;
-
-	if (!cloud) {
-		fprintf(stderr, "Failed to request cloud module\n");
-		return -1;
-	}
+	bool cached = false;
+	int status = 0;
 
 	/* Check number of arguments */
 	if (argc < 5) {
@@ -111,43 +242,54 @@ static int device_command(int argc, char *argv[])
 		goto exit;
 	}
 
+	if (cloud_network_ready() < 0) {
+		ret = -1;
+		goto exit;
+	}
+
 	/* Parse optional arguments */
 	if (argc > 5) {
 		properties = (atoi(argv[5]) > 0);
 	}
 
-	err = cloud->get_device(argv[3], argv[4], properties, &response);
+	err = cloud_sched_acquire(CLOUD_SCHED_DEVICES, CLOUD_SCHED_CONTROL, CLOUD_SCHED_TIMEOUT_MS);
 	if (err != S_OK) {
-		FAIL_AND_EXIT("Failed to get user devices\n");
+		FAIL_AND_EXIT("Device requests are throttled\n");
 		goto exit;
 	}
 
-	if (response) {
-		fprintf(stdout, "Response: %s\n", response);
-		free(response);
+	/* Polling an unchanged device only costs a 304 */
+	fprintf(stdout, "Response: ");
+	err = device_cache_get(argv[3], argv[4], properties, print_response_chunk, NULL,
+		&status, &cached);
+	fprintf(stdout, "\n");
+	cloud_sched_complete(CLOUD_SCHED_DEVICES, err, status);
+	if (cached)
+		fprintf(stdout, "Not modified, served from cache\n");
+	if (err != S_OK) {
+		FAIL_AND_EXIT("Failed to get device\n");
+		goto exit;
 	}
 
 exit:
-	if (cloud)
-		artik_release_api_module(cloud);
-
 	return ret;
 }
 
+static int print_device(const char *record, unsigned int len, void *user_data)
+{
+	fprintf(stdout, "%s\n", record);
+
+	return 0;
+}
+
 static int devices_command(int argc, char *argv[])
 {
-	artik_cloud_module *cloud = (artik_cloud_module *)artik_request_api_module("cloud");
 	int ret = 0;
-	char *response = NULL;
 	artik_error err = S_OK;
 	int count = 10;
 	bool properties = false;
 	int offset = 0;
-
-	if (!cloud) {
-		fprintf(stderr, "Failed to request cloud module\n");
-		return -1;
-	}
+	struct cloud_devices_iter iter;
 
 	/* Check number of arguments */
 	if (argc < 5) {
@@ -155,6 +297,11 @@ static int devices_command(int argc, char *argv[])
 		goto exit;
 	}
 
+	if (cloud_network_ready() < 0) {
+		ret = -1;
+		goto exit;
+	}
+
 	/* Parse optional arguments */
 	if (argc > 5) {
 		count = atoi(argv[5]);
@@ -165,29 +312,52 @@ static int devices_command(int argc, char *argv[])
 		}
 	}
 
-	err = cloud->get_user_devices(argv[3], count, properties, 0, argv[4], &response);
+	/* Records are printed as pages arrive, the next page is fetched meanwhile */
+	cloud_devices_init(&iter, argv[3], argv[4], offset, count, properties);
+	err = cloud_devices_iterate(&iter, print_device, NULL);
+	fprintf(stdout, "%d devices from offset %d", iter.delivered, offset);
+	if (iter.total >= 0)
+		fprintf(stdout, " of %d", iter.total);
+	fprintf(stdout, " in %d pages\n", iter.pages);
+	if (iter.oversized)
+		fprintf(stderr, "%d devices too large to list were skipped\n", iter.oversized);
 	if (err != S_OK) {
 		FAIL_AND_EXIT("Failed to get user devices\n");
 		goto exit;
 	}
 
-	if (response) {
-		fprintf(stdout, "Response: %s\n", response);
-		free(response);
+exit:
+	return ret;
+}
+
+struct message_request {
+	artik_cloud_module *cloud;
+	const char *token;
+	const char *device_id;
+	const char *message;
+	char *response;
+};
+
+static artik_error message_send(void *user_data)
+{
+	struct message_request *req = (struct message_request *)user_data;
+	artik_error err = S_OK;
+
+	if (req->response) {
+		free(req->response);
+		req->response = NULL;
 	}
 
-exit:
-	if (cloud)
-		artik_release_api_module(cloud);
+	err = req->cloud->send_message(req->token, req->device_id, req->message, &req->response);
 
-	return ret;
+	return err;
 }
 
 static int message_command(int argc, char *argv[])
 {
 	artik_cloud_module *cloud = (artik_cloud_module *)artik_request_api_module("cloud");
 	int ret = 0;
-	char *response = NULL;
+	struct message_request req;
 	artik_error err = S_OK;
 
 	if (!cloud) {
@@ -201,15 +371,27 @@ static int message_command(int argc, char *argv[])
 		goto exit;
 	}
 
-	err = cloud->send_message(argv[3], argv[4], argv[5], &response);
-	if (err != S_OK) {
-		FAIL_AND_EXIT("Failed to send message\n");
+	if (cloud_network_ready() < 0) {
+		ret = -1;
 		goto exit;
 	}
 
-	if (response) {
-		fprintf(stdout, "Response: %s\n", response);
-		free(response);
+	memset(&req, 0, sizeof(req));
+	req.cloud = cloud;
+	req.token = argv[3];
+	req.device_id = argv[4];
+	req.message = argv[5];
+
+	dns_cache_lookup_uri(CLOUD_REST_URI, NULL);
+	err = cloud_sched_run(CLOUD_SCHED_MESSAGES, CLOUD_SCHED_TELEMETRY, message_send, &req);
+	if (req.response) {
+		fprintf(stdout, "Response: %s\n", req.response);
+		free(req.response);
+	}
+
+	if (err != S_OK) {
+		FAIL_AND_EXIT("Failed to send message\n");
+		goto exit;
 	}
 
 exit:
@@ -224,6 +406,7 @@ static int connect_command(int argc, char *argv[])
 	int ret = 0;
 	artik_error err = S_OK;
 	artik_cloud_module *cloud = (artik_cloud_module *)artik_request_api_module("cloud");
+	struct ws_connection *conn = NULL;
 	bool use_se = false;
 
 	/* Check number of arguments */
@@ -242,6 +425,18 @@ static int connect_command(int argc, char *argv[])
 		goto exit;
 	}
 
+	if (ws_handle) {
+		fprintf(stderr, "Websocket to cloud is already connected\n");
+		ret = -1;
+		goto exit;
+	}
+
+	if (cloud_network_ready() < 0) {
+		ret = -1;
+		goto exit;
+	}
+
+	dns_cache_lookup_uri(CLOUD_WEBSOCKET_URI, NULL);
 	err = cloud->websocket_open_stream(&ws_handle, argv[3], argv[4], use_se);
 	if (err != S_OK) {
 		fprintf(stderr, "Failed to connect websocket\n");
@@ -250,17 +445,49 @@ static int connect_command(int argc, char *argv[])
 		goto exit;
 	}
 
-	err = cloud->websocket_set_receive_callback(ws_handle, websocket_rx_callback, NULL);
+	/* Held for as long as the websocket is, websocket_write() uses it */
+	ws_cloud = cloud;
+	cloud = NULL;
+
+	/* Cloud expects one JSON message per frame, so nothing is coalesced */
+	err = ws_manager_register(CLOUD_WEBSOCKET_NAME, ws_handle, websocket_write,
+		websocket_close, websocket_rx_callback, NULL, &conn);
+	if (err != S_OK) {
+		fprintf(stderr, "Failed to register cloud websocket (%s)\n", error_msg(err));
+		ws_cloud->websocket_close_stream(ws_handle);
+		ws_handle = NULL;
+		ret = -1;
+		goto exit;
+	}
+
+	strncpy(ws_device_id, argv[4], sizeof(ws_device_id) - 1);
+
+	err = ws_cloud->websocket_set_receive_callback(ws_handle, ws_manager_receive_callback,
+		conn);
 	if (err != S_OK) {
 		fprintf(stderr, "Failed to set websocket receive callback\n");
+		/* Closes the stream too */
+		ws_manager_close(CLOUD_WEBSOCKET_NAME);
 		ws_handle = NULL;
 		ret = -1;
 		goto exit;
 	}
 
+	if (g_wifi_subscriber < 0)
+		g_wifi_subscriber = wifi_manager_subscribe(cloud_link_event, NULL);
+
+	/* Replay what was stored while offline, slowly enough not to flood the server */
+	if (offline_queue())
+		flash_queue_drain(&g_offline, offline_sink, NULL, OFFLINE_DRAIN_RATE,
+			OFFLINE_DRAIN_BATCH);
+
 exit:
 	if (cloud)
 		artik_release_api_module(cloud);
+	if (!ws_handle && ws_cloud) {
+		artik_release_api_module(ws_cloud);
+		ws_cloud = NULL;
+	}
 
 	return ret;
 }
@@ -280,7 +507,13 @@ static int disconnect_command(int argc, char *argv[])
 		goto exit;
 	}
 
-	cloud->websocket_close_stream(ws_handle);
+	if (g_offline_open)
+		flash_queue_stop_drain(&g_offline);
+	/* Closes the stream before the manager slot goes away */
+	ws_manager_close(CLOUD_WEBSOCKET_NAME);
+	ws_handle = NULL;
+	artik_release_api_module(ws_cloud);
+	ws_cloud = NULL;
 
 exit:
 	artik_release_api_module(cloud);
@@ -299,28 +532,349 @@ static int send_command(int argc, char *argv[])
 		return -1;
 	}
 
+	/* Check number of arguments */
+	if (argc < 4) {
+		FAIL_AND_EXIT("Wrong number of arguments\n");
+		goto exit;
+	}
+
+	fprintf(stderr, "Sending %s\n", argv[3]);
+	err = cloud_publish(argv[3]);
+	if (err != S_OK) {
+		FAIL_AND_EXIT("Failed to send or store message\n");
+		goto exit;
+	}
+
+exit:
+	artik_release_api_module(cloud);
+
+	return ret;
+}
+
+static int stats_command(int argc, char *argv[])
+{
 	if (!ws_handle) {
 		fprintf(stderr, "Websocket to cloud is not connected\n");
+		return -1;
+	}
+
+	ws_manager_dump(CLOUD_WEBSOCKET_NAME);
+
+	return 0;
+}
+
+/* Typical sensor message, one name per field */
+static const char * const encode_field_names[ENCODE_MAX_FIELDS] = {
+	"temperature", "humidity", "pressure", "battery", "state", "light",
+	"motion", "co2", "noise", "rssi", "uptime", "voltage", "current",
+	"power", "door", "alarm", "latitude", "longitude", "altitude", "firmware"
+};
+
+static void encode_fill_fields(struct telemetry_field *fields, int count, int seq)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		fields[i].name = encode_field_names[i];
+		switch (i % 4) {
+		case 0:
+			fields[i].type = TELEMETRY_FLOAT;
+			fields[i].value.f = 20.0f + (float)((seq + i) % 100) / 4;
+			break;
+		case 1:
+			fields[i].type = TELEMETRY_INT;
+			fields[i].value.i = 1000 + (seq * 7 + i) % 5000;
+			break;
+		case 2:
+			fields[i].type = TELEMETRY_BOOL;
+			fields[i].value.b = (seq + i) & 1;
+			break;
+		default:
+			fields[i].type = TELEMETRY_STRING;
+			fields[i].value.s = (seq & 1) ? "ok" : "idle";
+			break;
+		}
+	}
+}
+
+static int encode_command(int argc, char *argv[])
+{
+	struct telemetry_field fields[ENCODE_MAX_FIELDS];
+	struct perf_stats json_stats, cbor_stats;
+	uint32_t json_bytes = 0, cbor_bytes = 0;
+	int count = 15, iterations = 1000;
+	uint8_t *buf = NULL;
+	uint64_t start = 0;
+	int ret = 0;
+	int i, len;
+
+	if (argc > 4) {
+		count = atoi(argv[3]);
+		iterations = atoi(argv[4]);
+	}
+
+	if ((count <= 0) || (count > ENCODE_MAX_FIELDS) || (iterations <= 0)) {
+		fprintf(stderr, "Fields must be between 1 and %d\n", ENCODE_MAX_FIELDS);
+		return -1;
+	}
+
+	buf = malloc(ENCODE_BUFFER_SIZE);
+	if (!buf) {
+		fprintf(stderr, "Failed to allocate encoding buffer\n");
+		return -1;
+	}
+
+	perf_stats_reset(&json_stats);
+	perf_stats_reset(&cbor_stats);
+
+	for (i = 0; i < iterations; i++) {
+		encode_fill_fields(fields, count, i);
+
+		start = perf_now_us();
+		len = telemetry_to_json(fields, count, (char *)buf, ENCODE_BUFFER_SIZE);
+		perf_stats_add(&json_stats, perf_now_us() - start);
+		if (len < 0) {
+			ret = -1;
+			break;
+		}
+		json_bytes += len;
+
+		start = perf_now_us();
+		len = telemetry_to_cbor(fields, count, buf, ENCODE_BUFFER_SIZE);
+		perf_stats_add(&cbor_stats, perf_now_us() - start);
+		if (len < 0) {
+			ret = -1;
+			break;
+		}
+		cbor_bytes += len;
+	}
+
+	if (ret < 0) {
+		fprintf(stderr, "Message does not fit in %d bytes\n", ENCODE_BUFFER_SIZE);
 		goto exit;
 	}
 
-	/* Check number of arguments */
+	fprintf(stdout, "%d messages of %d fields\n", iterations, count);
+	fprintf(stdout, "json: %u bytes per message\n", json_bytes / iterations);
+	perf_stats_print("json encode", &json_stats);
+	fprintf(stdout, "cbor: %u bytes per message\n", cbor_bytes / iterations);
+	perf_stats_print("cbor encode", &cbor_stats);
+
+exit:
+	free(buf);
+
+	return ret;
+}
+
+/*
+ * Batches of the device connected to the cloud websocket go through it, or
+ * to the offline queue while it is down. Other devices are posted over
+ * REST with the token given to 'batch config'.
+ */
+static artik_error batch_sink(const char *device_id, const char *message, void *user_data)
+{
+	artik_cloud_module *cloud = NULL;
+	char *response = NULL;
+	artik_error err = S_OK;
+
+	if (ws_device_id[0] && !strncmp(ws_device_id, device_id, sizeof(ws_device_id)))
+		return cloud_publish(message);
+
+	if (!g_batch_token[0])
+		return E_NOT_INITIALIZED;
+
+	cloud = (artik_cloud_module *)artik_request_api_module("cloud");
+	if (!cloud)
+		return E_NOT_SUPPORTED;
+
+	err = cloud_sched_acquire(CLOUD_SCHED_MESSAGES, CLOUD_SCHED_TELEMETRY,
+		CLOUD_SCHED_TIMEOUT_MS);
+	if (err != S_OK)
+		goto exit;
+
+	err = cloud->send_message(g_batch_token, device_id, message, &response);
+	cloud_sched_complete(CLOUD_SCHED_MESSAGES, err, CLOUD_SCHED_STATUS_UNKNOWN);
+	if (response)
+		free(response);
+
+exit:
+	artik_release_api_module(cloud);
+
+	return err;
+}
+
+/* Parses <name>=<value>, values are bool, float if they contain a '.', else int */
+static int batch_parse_field(char *arg, struct telemetry_field *field)
+{
+	char *value = strchr(arg, '=');
+
+	if (!value || (value == arg) || !value[1])
+		return -1;
+
+	*value++ = '\0';
+	field->name = arg;
+
+	if (!strcmp(value, "true") || !strcmp(value, "false")) {
+		field->type = TELEMETRY_BOOL;
+		field->value.b = !strcmp(value, "true");
+	} else if (strchr(value, '.')) {
+		field->type = TELEMETRY_FLOAT;
+		field->value.f = strtof(value, NULL);
+	} else {
+		field->type = TELEMETRY_INT;
+		field->value.i = strtol(value, NULL, 0);
+	}
+
+	return 0;
+}
+
+static int batch_command(int argc, char *argv[])
+{
+	struct telemetry_field fields[TELEMETRY_BATCH_MAX_FIELDS];
+	artik_error err = S_OK;
+	int ret = 0;
+	int i, agg;
+
 	if (argc < 4) {
 		FAIL_AND_EXIT("Wrong number of arguments\n");
 		goto exit;
 	}
 
-	fprintf(stderr, "Sending %s\n", argv[3]);
+	telemetry_batch_set_sink(batch_sink, NULL);
+
+	if (!strcmp(argv[3], "config")) {
+		if (argc < 7) {
+			FAIL_AND_EXIT("Wrong number of arguments\n");
+			goto exit;
+		}
+
+		if (argc > 7)
+			strncpy(g_batch_token, argv[7], sizeof(g_batch_token) - 1);
+
+		err = telemetry_batch_configure(argv[4], atoi(argv[5]), atoi(argv[6]));
+	} else if (!strcmp(argv[3], "agg")) {
+		if (argc < 7) {
+			FAIL_AND_EXIT("Wrong number of arguments\n");
+			goto exit;
+		}
+
+		agg = telemetry_agg_from_string(argv[6]);
+		if (agg < 0) {
+			FAIL_AND_EXIT("Aggregation must be none, last, min, max or mean\n");
+			goto exit;
+		}
+
+		err = telemetry_batch_set_aggregation(argv[4], argv[5], agg);
+	} else if (!strcmp(argv[3], "add")) {
+		if ((argc < 6) || (argc - 5 > TELEMETRY_BATCH_MAX_FIELDS)) {
+			FAIL_AND_EXIT("Wrong number of arguments\n");
+			goto exit;
+		}
+
+		for (i = 5; i < argc; i++) {
+			if (batch_parse_field(argv[i], &fields[i - 5]) < 0) {
+				FAIL_AND_EXIT("Fields must be given as <name>=<value>\n");
+				goto exit;
+			}
+		}
+
+		err = telemetry_batch_add(argv[4], fields, argc - 5);
+	} else if (!strcmp(argv[3], "flush")) {
+		err = telemetry_batch_flush((argc > 4) ? argv[4] : NULL);
+	} else if (!strcmp(argv[3], "stats")) {
+		telemetry_batch_dump();
+	} else {
+		FAIL_AND_EXIT("Unknown batch command\n");
+		goto exit;
+	}
 
-	err = cloud->websocket_send_message(ws_handle, argv[3]);
 	if (err != S_OK) {
-		FAIL_AND_EXIT("Failed to send message to cloud through websocket\n");
+		fprintf(stderr, "Batch %s failed (%s)\n", argv[3], error_msg(err));
+		ret = -1;
+	}
+
+exit:
+	return ret;
+}
+
+static int queue_command(int argc, char *argv[])
+{
+	struct flash_queue *q = NULL;
+	int ret = 0;
+
+	if (argc < 4) {
+		FAIL_AND_EXIT("Wrong number of arguments\n");
 		goto exit;
 	}
 
+	q = offline_queue();
+	if (!q) {
+		ret = -1;
+		goto exit;
+	}
+
+	if (!strcmp(argv[3], "stats")) {
+		flash_queue_dump(q);
+	} else if (!strcmp(argv[3], "clear")) {
+		if (flash_queue_clear(q) != S_OK) {
+			fprintf(stderr, "Failed to clear offline queue\n");
+			ret = -1;
+		}
+	} else {
+		FAIL_AND_EXIT("Unknown queue command\n");
+	}
+
 exit:
-	artik_release_api_module(cloud);
+	return ret;
+}
 
+static int sched_command(int argc, char *argv[])
+{
+	int ret = 0;
+
+	if (argc < 4) {
+		FAIL_AND_EXIT("Wrong number of arguments\n");
+		goto exit;
+	}
+
+	if (!strcmp(argv[3], "stats")) {
+		cloud_sched_dump();
+	} else if (!strcmp(argv[3], "rate")) {
+		if (argc < 7) {
+			FAIL_AND_EXIT("Wrong number of arguments\n");
+			goto exit;
+		}
+
+		if (cloud_sched_configure(argv[4], atoi(argv[5]), atoi(argv[6])) != S_OK) {
+			fprintf(stderr, "Invalid endpoint or rate, endpoints are messages, "
+				"devices, websocket, sdr and ota\n");
+			ret = -1;
+		}
+	} else {
+		FAIL_AND_EXIT("Unknown sched command\n");
+	}
+
+exit:
+	return ret;
+}
+
+static int cache_command(int argc, char *argv[])
+{
+	int ret = 0;
+
+	if (argc < 4) {
+		FAIL_AND_EXIT("Wrong number of arguments\n");
+		goto exit;
+	}
+
+	if (!strcmp(argv[3], "stats"))
+		device_cache_dump();
+	else if (!strcmp(argv[3], "clear"))
+		device_cache_flush();
+	else
+		FAIL_AND_EXIT("Unknown cache command\n");
+
+exit:
 	return ret;
 }
 
@@ -329,6 +883,9 @@ static int sdr_command(int argc, char *argv[])
 	int ret = 0;
 	artik_cloud_module *cloud = NULL;
 
+	if (cloud_network_ready() < 0)
+		return -1;
+
 	if (!strcmp(argv[3], "start")) {
 		char *response = NULL;
 
@@ -343,7 +900,14 @@ static int sdr_command(int argc, char *argv[])
 			goto exit;
 		}
 
-		cloud->sdr_start_registration(argv[4], argv[5], &response);
+		if (cloud_sched_acquire(CLOUD_SCHED_SDR, CLOUD_SCHED_CONTROL,
+				CLOUD_SCHED_TIMEOUT_MS) != S_OK) {
+			FAIL_AND_EXIT("Registration requests are throttled\n");
+			goto exit;
+		}
+
+		cloud_sched_complete(CLOUD_SCHED_SDR, cloud->sdr_start_registration(argv[4], argv[5], &response),
+			CLOUD_SCHED_STATUS_UNKNOWN);
 
 		if (response) {
 			fprintf(stdout, "Response: %s\n", response);
@@ -363,7 +927,14 @@ static int sdr_command(int argc, char *argv[])
 			goto exit;
 		}
 
-		cloud->sdr_registration_status(argv[4], &response);
+		if (cloud_sched_acquire(CLOUD_SCHED_SDR, CLOUD_SCHED_CONTROL,
+				CLOUD_SCHED_TIMEOUT_MS) != S_OK) {
+			FAIL_AND_EXIT("Registration requests are throttled\n");
+			goto exit;
+		}
+
+		cloud_sched_complete(CLOUD_SCHED_SDR, cloud->sdr_registration_status(argv[4], &response),
+			CLOUD_SCHED_STATUS_UNKNOWN);
 
 		if (response) {
 			fprintf(stdout, "Response: %s\n", response);
@@ -383,7 +954,14 @@ static int sdr_command(int argc, char *argv[])
 			goto exit;
 		}
 
-		cloud->sdr_complete_registration(argv[4], argv[5], &response);
+		if (cloud_sched_acquire(CLOUD_SCHED_SDR, CLOUD_SCHED_CONTROL,
+				CLOUD_SCHED_TIMEOUT_MS) != S_OK) {
+			FAIL_AND_EXIT("Registration requests are throttled\n");
+			goto exit;
+		}
+
+		cloud_sched_complete(CLOUD_SCHED_SDR, cloud->sdr_complete_registration(argv[4], argv[5], &response),
+			CLOUD_SCHED_STATUS_UNKNOWN);
 
 		if (response) {
 			fprintf(stdout, "Response: %s\n", response);
@@ -463,7 +1041,7 @@ static void dm_on_execute_resource(void *data, void *user_data)
 	}
 }
 
-static int write_firmware(char *data, size_t len, void *user_data)
+static int write_firmware(const char *data, unsigned int len, void *user_data)
 {
 	int header_size = 0;
 
@@ -486,8 +1064,10 @@ static int download_firmware(int argc, char *argv[])
 {
 	artik_lwm2m_module *lwm2m = (artik_lwm2m_module *)artik_request_api_module("lwm2m");
 	artik_http_module *http = (artik_http_module *)artik_request_api_module("http");
-	artik_ssl_config ssl_conf;
 	int status = 0;
+	char chunk[HTTP_STREAM_CHUNK_SIZE];
+	struct http_stream stream;
+	artik_ssl_config ssl;
 
 	artik_error ret;
 	artik_http_headers headers;
@@ -522,11 +1102,23 @@ static int download_firmware(int argc, char *argv[])
 
 	headers.fields = fields;
 	headers.num_fields = ARRAY_SIZE(fields);
-	memset(&ssl_conf, 0, sizeof(artik_ssl_config));
-	ssl_conf.verify_cert = ARTIK_SSL_VERIFY_NONE;
+	/* An encoded image is inflated on the way, the flash gets the raw one */
+	http_stream_init(&stream, chunk, sizeof(chunk), write_firmware, NULL);
+	stream.flags = HTTP_STREAM_ACCEPT_ENCODING;
+	/* The package URL comes from the LWM2M server, as with the SDK download */
+	memset(&ssl, 0, sizeof(ssl));
+	ssl.verify_cert = ARTIK_SSL_VERIFY_NONE;
+	stream.ssl = &ssl;
 	g_dm_info->fd = open("/dev/mtdblock7", O_RDWR);
 	lseek(g_dm_info->fd, 4096, SEEK_SET);
-	ret = http->get_stream(argv[1], &headers, &status, write_firmware, NULL, &ssl_conf);
+	ret = cloud_sched_acquire(CLOUD_SCHED_OTA, CLOUD_SCHED_OTA_STATUS, CLOUD_SCHED_TIMEOUT_MS);
+	if (ret == S_OK) {
+		ret = http_stream_request(HTTP_STREAM_GET, argv[1], &headers, NULL, &status,
+			&stream);
+		cloud_sched_complete(CLOUD_SCHED_OTA, ret, status);
+	}
+	fprintf(stdout, "Firmware: %u bytes written, %u bytes received\n", stream.total,
+		stream.received);
 	if (ret != S_OK) {
 		lwm2m->client_write_resource(
 			g_dm_client,
@@ -648,6 +1240,11 @@ static int dm_command(int argc, char *argv[])
 			goto exit;
 		}
 
+		if (cloud_network_ready() < 0) {
+			ret = -1;
+			goto exit;
+		}
+
 		lwm2m = (artik_lwm2m_module *)artik_request_api_module("lwm2m");
 		if (!lwm2m) {
 			FAIL_AND_EXIT("Failed to request lwm2m module\n");
@@ -694,6 +1291,7 @@ static int dm_command(int argc, char *argv[])
 			ret = -1;
 			goto exit;
 		}
+		dns_cache_lookup_uri(g_dm_config->server_uri, NULL);
 		ret = lwm2m->client_connect(&g_dm_client, g_dm_config);
 		if (ret != S_OK) {
 			fprintf(stderr, "Failed to connect to the DM server (%d)\n", ret);
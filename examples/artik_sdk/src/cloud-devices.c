@@ -0,0 +1,323 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file cloud-devices.c
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "cloud-devices.h"
+#include "cloud-sched.h"
+#include "cloud-stream.h"
+
+#define CLOUD_DEVICES_STACK_SIZE	16384
+
+/* Nesting of device objects in {"data":{"devices":[{...}]}} */
+#define RECORD_DEPTH	3
+#define TOTAL_DEPTH		1
+
+struct devices_page {
+	int offset;
+	int count;
+	artik_error err;
+	int status;
+
+	/* Records stored back to back, each terminated by a NUL */
+	char buf[CLOUD_DEVICES_PAGE_BYTES];
+	unsigned int len;
+	int records;
+	int oversized;
+	int total;
+	bool full;
+
+	/* JSON splitter state */
+	int depth;
+	bool in_string;
+	bool escape;
+	bool recording;
+	bool skipping;
+	unsigned int start;
+	char key[8];
+	unsigned int key_len;
+	bool in_total;
+
+	struct cloud_devices_iter *iter;
+	char chunk[HTTP_STREAM_CHUNK_SIZE];
+};
+
+static void devices_page_reset(struct devices_page *page, struct cloud_devices_iter *iter,
+		int offset, int count)
+{
+	memset(page, 0, offsetof(struct devices_page, chunk));
+	page->iter = iter;
+	page->offset = offset;
+	page->count = count;
+	page->total = -1;
+}
+
+/* Returns false once the page buffer cannot take the current record any more */
+static bool devices_page_append(struct devices_page *page, char c)
+{
+	if (page->skipping)
+		return true;
+
+	/* Keep room for the terminating NUL */
+	if (page->len + 1 >= sizeof(page->buf)) {
+		if (page->records)
+			return false;
+
+		/* Would not fit in any page, drop it and move past it */
+		page->skipping = true;
+		page->len = page->start;
+		return true;
+	}
+
+	page->buf[page->len++] = c;
+
+	return true;
+}
+
+static void devices_page_end_record(struct devices_page *page)
+{
+	page->recording = false;
+	if (page->skipping) {
+		page->skipping = false;
+		page->oversized++;
+		return;
+	}
+
+	page->buf[page->len++] = '\0';
+	page->records++;
+}
+
+static int devices_page_sink(const char *data, unsigned int len, void *user_data)
+{
+	struct devices_page *page = (struct devices_page *)user_data;
+	unsigned int i;
+	char c;
+
+	for (i = 0; i < len; i++) {
+		c = data[i];
+
+		if (page->recording && !devices_page_append(page, c)) {
+			/* The rest is fetched again with the next page */
+			page->full = true;
+			return -1;
+		}
+
+		if (page->in_string) {
+			if (page->escape)
+				page->escape = false;
+			else if (c == '\\')
+				page->escape = true;
+			else if (c == '"')
+				page->in_string = false;
+			else if ((page->depth == TOTAL_DEPTH) && (page->key_len < sizeof(page->key) - 1))
+				page->key[page->key_len++] = c;
+
+			if (!page->in_string && (page->depth == TOTAL_DEPTH)) {
+				page->key[page->key_len] = '\0';
+				page->in_total = !strcmp(page->key, "total");
+				if (page->in_total)
+					page->total = 0;
+			}
+			continue;
+		}
+
+		switch (c) {
+		case '"':
+			page->in_string = true;
+			page->key_len = 0;
+			break;
+		case '{':
+		case '[':
+			if ((c == '{') && (page->depth == RECORD_DEPTH) && !page->recording) {
+				page->recording = true;
+				page->start = page->len;
+				if (!devices_page_append(page, c)) {
+					page->full = true;
+					return -1;
+				}
+			}
+			page->depth++;
+			break;
+		case '}':
+		case ']':
+			page->depth--;
+			if (page->recording && (page->depth == RECORD_DEPTH))
+				devices_page_end_record(page);
+			page->in_total = false;
+			break;
+		default:
+			if (page->in_total && (c >= '0') && (c <= '9'))
+				page->total = page->total * 10 + (c - '0');
+			else if (c == ',')
+				page->in_total = false;
+			break;
+		}
+	}
+
+	return len;
+}
+
+static void devices_page_fetch(struct devices_page *page)
+{
+	struct cloud_devices_iter *iter = page->iter;
+	struct http_stream stream;
+
+	http_stream_init(&stream, page->chunk, sizeof(page->chunk), devices_page_sink, page);
+
+	page->err = cloud_sched_acquire(CLOUD_SCHED_DEVICES, CLOUD_SCHED_CONTROL,
+		CLOUD_SCHED_TIMEOUT_MS);
+	if (page->err != S_OK)
+		return;
+
+	page->err = cloud_stream_get_user_devices(iter->token, iter->user_id, page->count,
+		page->offset, iter->properties, &page->status, &stream);
+	cloud_sched_complete(CLOUD_SCHED_DEVICES, page->err, page->status);
+
+	/* Stopping early on a full buffer is not a failure */
+	if ((page->err == E_INTERRUPTED) && page->full)
+		page->err = S_OK;
+	if ((page->err == S_OK) && (page->status != 200))
+		page->err = E_HTTP_ERROR;
+}
+
+static pthread_addr_t devices_page_thread(pthread_addr_t arg)
+{
+	devices_page_fetch((struct devices_page *)arg);
+
+	return NULL;
+}
+
+void cloud_devices_init(struct cloud_devices_iter *iter, const char *token,
+		const char *user_id, int offset, int count, bool properties)
+{
+	memset(iter, 0, sizeof(*iter));
+	iter->token = token;
+	iter->user_id = user_id;
+	iter->offset = offset;
+	iter->count = count;
+	iter->properties = properties;
+	iter->page_size = CLOUD_DEVICES_PAGE_SIZE;
+	iter->total = -1;
+}
+
+/*
+ * Calls cb for each of the 'count' devices starting at 'offset', or all of
+ * them if count is 0.
+ */
+artik_error cloud_devices_iterate(struct cloud_devices_iter *iter, cloud_devices_cb cb,
+		void *user_data)
+{
+	struct devices_page *pages[2] = { NULL, NULL };
+	struct devices_page *cur, *next;
+	pthread_attr_t attr;
+	pthread_t tid;
+	artik_error ret = S_OK;
+	int remaining, next_offset, n, i;
+	bool more, threaded, stop = false;
+	char *record;
+
+	if (!iter || !iter->token || !iter->user_id || !cb || (iter->page_size <= 0))
+		return E_BAD_ARGS;
+
+	pages[0] = malloc(sizeof(struct devices_page));
+	pages[1] = malloc(sizeof(struct devices_page));
+	if (!pages[0] || !pages[1]) {
+		ret = E_NO_MEM;
+		goto exit;
+	}
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, CLOUD_DEVICES_STACK_SIZE);
+
+	cur = pages[0];
+	next = pages[1];
+	remaining = iter->count;
+	n = iter->page_size;
+	if ((remaining > 0) && (remaining < n))
+		n = remaining;
+	devices_page_reset(cur, iter, iter->offset, n);
+	devices_page_fetch(cur);
+
+	while (cur->err == S_OK) {
+		iter->pages++;
+		iter->oversized += cur->oversized;
+		if (cur->total >= 0)
+			iter->total = cur->total;
+		if (remaining > 0)
+			remaining -= cur->records + cur->oversized;
+
+		/* Work out the next page and start fetching it before going through this one */
+		next_offset = cur->offset + cur->records + cur->oversized;
+		more = (cur->records + cur->oversized > 0) &&
+			(cur->full || (cur->records + cur->oversized >= cur->count)) &&
+			((iter->total < 0) || (next_offset < iter->total)) &&
+			((iter->count <= 0) || (remaining > 0));
+
+		threaded = false;
+		if (more) {
+			n = iter->page_size;
+			if ((remaining > 0) && (remaining < n))
+				n = remaining;
+			devices_page_reset(next, iter, next_offset, n);
+			threaded = (pthread_create(&tid, &attr, devices_page_thread, next) == 0);
+		}
+
+		record = cur->buf;
+		for (i = 0; i < cur->records; i++) {
+			if (cb(record, strlen(record), user_data) < 0) {
+				stop = true;
+				break;
+			}
+			iter->delivered++;
+			record += strlen(record) + 1;
+		}
+
+		if (!more)
+			break;
+
+		if (threaded)
+			pthread_join(tid, NULL);
+		else if (!stop)
+			devices_page_fetch(next);
+
+		if (stop)
+			break;
+
+		cur = next;
+		next = (cur == pages[0]) ? pages[1] : pages[0];
+	}
+
+	if (!stop && (cur->err != S_OK))
+		ret = cur->err;
+
+	pthread_attr_destroy(&attr);
+
+exit:
+	free(pages[0]);
+	free(pages[1]);
+
+	return ret;
+}
@@ -0,0 +1,70 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file cloud-devices.h
+ */
+
+#ifndef __ARTIK_CLOUD_DEVICES_H__
+#define __ARTIK_CLOUD_DEVICES_H__
+
+#include <stdbool.h>
+
+#include <artik_error.h>
+
+/*
+ * Paginated listing of the devices of a user.
+ *
+ * Devices are requested CLOUD_DEVICES_PAGE_SIZE at a time and each device
+ * object of the response is handed to the caller's callback as its own
+ * NUL terminated JSON string. While the records of one page are being
+ * processed the next page is already being fetched by a helper thread, so
+ * at most two pages of CLOUD_DEVICES_PAGE_BYTES are held at once whatever
+ * the number of devices of the account.
+ *
+ * When a page does not fit in its buffer, the records that did not fit are
+ * requested again at the start of the next page. A single record larger
+ * than the whole buffer is skipped and counted as oversized.
+ */
+#define CLOUD_DEVICES_PAGE_SIZE		20
+#define CLOUD_DEVICES_PAGE_BYTES	4096
+
+/* Return a negative value to stop the iteration */
+typedef int (*cloud_devices_cb)(const char *record, unsigned int len, void *user_data);
+
+struct cloud_devices_iter {
+	const char *token;
+	const char *user_id;
+	bool properties;
+	int offset;
+	int count;
+	int page_size;
+
+	/* Filled in while iterating */
+	int total;
+	int delivered;
+	int pages;
+	int oversized;
+};
+
+void cloud_devices_init(struct cloud_devices_iter *iter, const char *token,
+		const char *user_id, int offset, int count, bool properties);
+artik_error cloud_devices_iterate(struct cloud_devices_iter *iter, cloud_devices_cb cb,
+		void *user_data);
+
+#endif /* __ARTIK_CLOUD_DEVICES_H__ */
@@ -0,0 +1,307 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file cloud-sched.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "cloud-sched.h"
+#include "perf-stats.h"
+
+/* Tokens are counted in thousandths to refill smoothly at low rates */
+#define TOKEN			1000
+#define WAIT_SLICE_US	100000
+
+struct sched_bucket {
+	const char *name;
+	unsigned int per_minute;
+	unsigned int burst;
+	unsigned int reserve;
+	uint64_t tokens;
+	uint64_t refill_us;
+	uint64_t blocked_until_us;
+	unsigned int failures;
+	unsigned int waiting[CLOUD_SCHED_LANES];
+
+	unsigned int granted[CLOUD_SCHED_LANES];
+	unsigned int timeouts;
+	unsigned int throttled;
+	unsigned int retries;
+	struct perf_stats wait;
+};
+
+static struct sched_bucket g_buckets[CLOUD_SCHED_ENDPOINTS] = {
+	[CLOUD_SCHED_MESSAGES]	= { .name = "messages", .per_minute = 100, .burst = 10 },
+	[CLOUD_SCHED_DEVICES]	= { .name = "devices", .per_minute = 60, .burst = 5 },
+	[CLOUD_SCHED_WEBSOCKET]	= { .name = "websocket", .per_minute = 600, .burst = 20 },
+	[CLOUD_SCHED_SDR]		= { .name = "sdr", .per_minute = 10, .burst = 2 },
+	[CLOUD_SCHED_OTA]		= { .name = "ota", .per_minute = 30, .burst = 3 },
+};
+
+static const char * const lane_names[CLOUD_SCHED_LANES] = { "control", "ota", "telemetry" };
+
+static pthread_mutex_t g_sched_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_sched_cond = PTHREAD_COND_INITIALIZER;
+static bool g_sched_ready;
+
+/* Must be called with g_sched_lock held */
+static void sched_init(void)
+{
+	uint64_t now = perf_now_us();
+	int i;
+
+	if (g_sched_ready)
+		return;
+
+	for (i = 0; i < CLOUD_SCHED_ENDPOINTS; i++) {
+		g_buckets[i].tokens = (uint64_t)g_buckets[i].burst * TOKEN;
+		g_buckets[i].reserve = (g_buckets[i].burst > 2) ? 1 : 0;
+		g_buckets[i].refill_us = now;
+		perf_stats_reset(&g_buckets[i].wait);
+	}
+
+	srand((unsigned int)now);
+	g_sched_ready = true;
+}
+
+/* Must be called with g_sched_lock held */
+static void sched_refill(struct sched_bucket *b, uint64_t now)
+{
+	uint64_t max = (uint64_t)b->burst * TOKEN;
+
+	b->tokens += (now - b->refill_us) * b->per_minute / 60000;
+	if (b->tokens > max)
+		b->tokens = max;
+	b->refill_us = now;
+}
+
+/* Must be called with g_sched_lock held */
+static bool sched_higher_waiting(struct sched_bucket *b, enum cloud_sched_lane lane)
+{
+	int l;
+
+	for (l = 0; l < lane; l++) {
+		if (b->waiting[l])
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Waits for a token of the endpoint, at most timeout_ms. Returns E_TIMEOUT
+ * if none could be had in time.
+ */
+artik_error cloud_sched_acquire(enum cloud_sched_endpoint endpoint, enum cloud_sched_lane lane,
+		unsigned int timeout_ms)
+{
+	struct sched_bucket *b = &g_buckets[endpoint];
+	uint64_t start = perf_now_us();
+	uint64_t deadline = start + (uint64_t)timeout_ms * 1000;
+	uint64_t now, needed, wait_us;
+	struct timespec abstime;
+	artik_error ret = S_OK;
+
+	if ((endpoint >= CLOUD_SCHED_ENDPOINTS) || (lane >= CLOUD_SCHED_LANES))
+		return E_BAD_ARGS;
+
+	pthread_mutex_lock(&g_sched_lock);
+	sched_init();
+	b->waiting[lane]++;
+
+	while (1) {
+		now = perf_now_us();
+		sched_refill(b, now);
+
+		needed = TOKEN * (1 + ((lane == CLOUD_SCHED_TELEMETRY) ? b->reserve : 0));
+		if ((now >= b->blocked_until_us) && !sched_higher_waiting(b, lane) &&
+				(b->tokens >= needed)) {
+			b->tokens -= TOKEN;
+			break;
+		}
+
+		if (now >= deadline) {
+			b->timeouts++;
+			ret = E_TIMEOUT;
+			break;
+		}
+
+		/* Sleep until the endpoint may be ready, woken earlier on any change */
+		if (now < b->blocked_until_us)
+			wait_us = b->blocked_until_us - now;
+		else if (b->tokens < needed && b->per_minute)
+			wait_us = (needed - b->tokens) * 60000 / b->per_minute + 1;
+		else
+			wait_us = WAIT_SLICE_US;
+		if (wait_us > WAIT_SLICE_US)
+			wait_us = WAIT_SLICE_US;
+		if (wait_us > deadline - now)
+			wait_us = deadline - now;
+
+		clock_gettime(CLOCK_REALTIME, &abstime);
+		abstime.tv_nsec += (wait_us % 1000000) * 1000;
+		abstime.tv_sec += wait_us / 1000000 + abstime.tv_nsec / 1000000000;
+		abstime.tv_nsec %= 1000000000;
+		pthread_cond_timedwait(&g_sched_cond, &g_sched_lock, &abstime);
+	}
+
+	b->waiting[lane]--;
+	if (ret == S_OK) {
+		b->granted[lane]++;
+		perf_stats_add(&b->wait, perf_now_us() - start);
+	}
+	pthread_cond_broadcast(&g_sched_cond);
+	pthread_mutex_unlock(&g_sched_lock);
+
+	return ret;
+}
+
+static bool sched_retryable(artik_error result, int status)
+{
+	if (status > 0)
+		return (status == 429) || (status >= 500);
+
+	/* Without a status line, a broken response is a transport failure */
+	if ((result == E_HTTP_ERROR) && (status == 0))
+		return true;
+
+	return (result == E_TRY_AGAIN) || (result == E_TIMEOUT) || (result == E_BUSY) ||
+		(result == E_NOT_CONNECTED);
+}
+
+/*
+ * Reports the outcome of a request along with its HTTP status, 0 when no
+ * response was read. Returns the back-off in ms imposed on the endpoint
+ * when the request should be retried, 0 otherwise.
+ */
+unsigned int cloud_sched_complete(enum cloud_sched_endpoint endpoint, artik_error result,
+		int status)
+{
+	struct sched_bucket *b = &g_buckets[endpoint];
+	unsigned int backoff = 0;
+
+	if (endpoint >= CLOUD_SCHED_ENDPOINTS)
+		return 0;
+
+	pthread_mutex_lock(&g_sched_lock);
+	if (sched_retryable(result, status)) {
+		backoff = CLOUD_SCHED_BACKOFF_MIN_MS << (b->failures < 7 ? b->failures : 7);
+		if (backoff > CLOUD_SCHED_BACKOFF_MAX_MS)
+			backoff = CLOUD_SCHED_BACKOFF_MAX_MS;
+		/* Half fixed, half random so that peers do not retry in step */
+		backoff = backoff / 2 + rand() % (backoff / 2 + 1);
+
+		b->failures++;
+		b->throttled++;
+		b->blocked_until_us = perf_now_us() + (uint64_t)backoff * 1000;
+	} else if (result == S_OK) {
+		b->failures = 0;
+	}
+	pthread_cond_broadcast(&g_sched_cond);
+	pthread_mutex_unlock(&g_sched_lock);
+
+	return backoff;
+}
+
+artik_error cloud_sched_run(enum cloud_sched_endpoint endpoint, enum cloud_sched_lane lane,
+		cloud_sched_fn fn, void *user_data)
+{
+	artik_error ret;
+	int attempt;
+
+	for (attempt = 0; ; attempt++) {
+		ret = cloud_sched_acquire(endpoint, lane, CLOUD_SCHED_TIMEOUT_MS);
+		if (ret != S_OK)
+			break;
+
+		ret = fn(user_data);
+		if (!cloud_sched_complete(endpoint, ret, CLOUD_SCHED_STATUS_UNKNOWN) || (attempt == CLOUD_SCHED_MAX_RETRIES))
+			break;
+
+		/* The next acquire waits for the back-off to expire */
+		pthread_mutex_lock(&g_sched_lock);
+		g_buckets[endpoint].retries++;
+		pthread_mutex_unlock(&g_sched_lock);
+	}
+
+	return ret;
+}
+
+artik_error cloud_sched_configure(const char *endpoint, unsigned int per_minute,
+		unsigned int burst)
+{
+	artik_error ret = E_BAD_ARGS;
+	int i;
+
+	if (!per_minute || !burst)
+		return E_BAD_ARGS;
+
+	pthread_mutex_lock(&g_sched_lock);
+	sched_init();
+	for (i = 0; i < CLOUD_SCHED_ENDPOINTS; i++) {
+		if (strcmp(g_buckets[i].name, endpoint))
+			continue;
+
+		sched_refill(&g_buckets[i], perf_now_us());
+		g_buckets[i].per_minute = per_minute;
+		g_buckets[i].burst = burst;
+		g_buckets[i].reserve = (burst > 2) ? 1 : 0;
+		if (g_buckets[i].tokens > (uint64_t)burst * TOKEN)
+			g_buckets[i].tokens = (uint64_t)burst * TOKEN;
+		ret = S_OK;
+	}
+	pthread_cond_broadcast(&g_sched_cond);
+	pthread_mutex_unlock(&g_sched_lock);
+
+	return ret;
+}
+
+void cloud_sched_dump(void)
+{
+	struct sched_bucket *b;
+	uint64_t now;
+	int i, l;
+
+	pthread_mutex_lock(&g_sched_lock);
+	sched_init();
+	now = perf_now_us();
+	for (i = 0; i < CLOUD_SCHED_ENDPOINTS; i++) {
+		b = &g_buckets[i];
+		sched_refill(b, now);
+
+		fprintf(stdout, "%s: %u/min burst %u, %llu.%llu tokens", b->name, b->per_minute,
+			b->burst, (unsigned long long)b->tokens / TOKEN,
+			(unsigned long long)(b->tokens % TOKEN) / 100);
+		if (now < b->blocked_until_us)
+			fprintf(stdout, ", backing off %llu ms",
+				(unsigned long long)(b->blocked_until_us - now) / 1000);
+		fprintf(stdout, "\n ");
+		for (l = 0; l < CLOUD_SCHED_LANES; l++)
+			fprintf(stdout, " %s %u", lane_names[l], b->granted[l]);
+		fprintf(stdout, ", throttled %u retries %u timeouts %u\n", b->throttled,
+			b->retries, b->timeouts);
+		perf_stats_print("  wait", &b->wait);
+	}
+	pthread_mutex_unlock(&g_sched_lock);
+}
@@ -0,0 +1,84 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file cloud-sched.h
+ */
+
+#ifndef __ARTIK_CLOUD_SCHED_H__
+#define __ARTIK_CLOUD_SCHED_H__
+
+#include <artik_error.h>
+
+/*
+ * Outbound traffic shaping for ARTIK Cloud.
+ *
+ * Every endpoint has a token bucket refilled at a per minute rate up to a
+ * burst size. A caller takes a token with cloud_sched_acquire() before the
+ * request and reports its outcome with cloud_sched_complete(). Callers in
+ * a higher priority lane always go first on the same endpoint, and bulk
+ * telemetry may not take the last token of a bucket so that control and
+ * OTA traffic keep some headroom.
+ *
+ * A request failing in a way that calls for a retry puts the whole endpoint
+ * in back-off. Only overload and server errors (429, 5xx) and transport
+ * failures qualify: a response that never arrived or was broken off, a
+ * timeout, a busy or unreachable peer. Other 4xx answers will not change on
+ * a retry. SDK calls do not report the HTTP status, so their callers pass
+ * CLOUD_SCHED_STATUS_UNKNOWN and their E_HTTP_ERROR, which may be a 401,
+ * is not retried either. The back-off doubles up to
+ * CLOUD_SCHED_BACKOFF_MAX_MS with random jitter, so that devices
+ * reconnecting together spread out instead of retrying in step.
+ * cloud_sched_run() wraps acquire, call and complete of an SDK call with a
+ * bounded number of retries.
+ */
+#define CLOUD_SCHED_BACKOFF_MIN_MS	500
+#define CLOUD_SCHED_BACKOFF_MAX_MS	60000
+#define CLOUD_SCHED_MAX_RETRIES		3
+#define CLOUD_SCHED_TIMEOUT_MS		30000
+#define CLOUD_SCHED_STATUS_UNKNOWN	-1
+
+enum cloud_sched_endpoint {
+	CLOUD_SCHED_MESSAGES,
+	CLOUD_SCHED_DEVICES,
+	CLOUD_SCHED_WEBSOCKET,
+	CLOUD_SCHED_SDR,
+	CLOUD_SCHED_OTA,
+	CLOUD_SCHED_ENDPOINTS
+};
+
+enum cloud_sched_lane {
+	CLOUD_SCHED_CONTROL,
+	CLOUD_SCHED_OTA_STATUS,
+	CLOUD_SCHED_TELEMETRY,
+	CLOUD_SCHED_LANES
+};
+
+typedef artik_error (*cloud_sched_fn)(void *user_data);
+
+artik_error cloud_sched_acquire(enum cloud_sched_endpoint endpoint, enum cloud_sched_lane lane,
+		unsigned int timeout_ms);
+unsigned int cloud_sched_complete(enum cloud_sched_endpoint endpoint, artik_error result,
+		int status);
+artik_error cloud_sched_run(enum cloud_sched_endpoint endpoint, enum cloud_sched_lane lane,
+		cloud_sched_fn fn, void *user_data);
+artik_error cloud_sched_configure(const char *endpoint, unsigned int per_minute,
+		unsigned int burst);
+void cloud_sched_dump(void);
+
+#endif /* __ARTIK_CLOUD_SCHED_H__ */
@@ -0,0 +1,203 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file cloud-stream.c
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <artik_module.h>
+#include <artik_security.h>
+
+#include "cloud-stream.h"
+
+#define ARRAY_SIZE(a) (sizeof(a)/sizeof((a)[0]))
+
+#define CLOUD_URL_MAX_LEN		256
+#define CLOUD_AUTH_MAX_LEN		128
+#define CLOUD_ID_MAX_LEN		96
+
+static char *g_root_ca;
+static pthread_mutex_t g_root_ca_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Percent-encodes an ID so that it stays a single path segment */
+static int cloud_stream_escape(const char *id, char *dst, unsigned int size)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	unsigned int len = 0;
+
+	for (; *id; id++) {
+		unsigned char c = *id;
+
+		if (isalnum(c) || (c == '-') || (c == '_') || (c == '.') || (c == '~')) {
+			if (len + 1 >= size)
+				return -1;
+			dst[len++] = c;
+		} else {
+			if (len + 3 >= size)
+				return -1;
+			dst[len++] = '%';
+			dst[len++] = hex[c >> 4];
+			dst[len++] = hex[c & 0xf];
+		}
+	}
+	dst[len] = '\0';
+
+	return 0;
+}
+
+/*
+ * Bearer tokens only go to a server that proves to be api.artik.cloud. The
+ * ARTIK Cloud root CA is provisioned in the secure element; it is read out
+ * on first use and kept for the following requests.
+ */
+static artik_error cloud_stream_ssl_config(artik_ssl_config *ssl)
+{
+	artik_security_module *security = NULL;
+	artik_security_handle handle;
+	artik_error ret = S_OK;
+
+	pthread_mutex_lock(&g_root_ca_lock);
+	if (g_root_ca)
+		goto exit;
+
+	security = (artik_security_module *)artik_request_api_module("security");
+	if (!security) {
+		ret = E_NOT_SUPPORTED;
+		goto exit;
+	}
+
+	ret = security->request(&handle);
+	if (ret == S_OK) {
+		ret = security->get_root_ca(handle, &g_root_ca);
+		security->release(handle);
+	}
+	artik_release_api_module(security);
+
+	if ((ret == S_OK) && !g_root_ca)
+		ret = E_NOT_SUPPORTED;
+
+exit:
+	if (ret == S_OK) {
+		memset(ssl, 0, sizeof(artik_ssl_config));
+		ssl->verify_cert = ARTIK_SSL_VERIFY_REQUIRED;
+		ssl->ca_cert.data = g_root_ca;
+		/* PEM input is parsed by mbedTLS with its terminating NUL */
+		ssl->ca_cert.len = strlen(g_root_ca) + 1;
+	} else {
+		fprintf(stderr, "Failed to get the ARTIK Cloud root CA (err=%d)\n", ret);
+	}
+	pthread_mutex_unlock(&g_root_ca_lock);
+
+	return ret;
+}
+
+/*
+ * Streaming counterparts of cloud->get_device() and
+ * cloud->get_user_devices(). The SDK calls return the whole body as one
+ * string and cannot send conditional headers, so the same REST requests
+ * are issued through http_stream_request() and the JSON body is delivered
+ * to the caller's sink chunk by chunk. IDs are escaped before they become
+ * part of the URL.
+ */
+static artik_error cloud_stream_get(const char *token, const char *url, const char *etag,
+		const char *last_modified, int *status, struct http_stream *stream)
+{
+	char auth[CLOUD_AUTH_MAX_LEN];
+	artik_ssl_config ssl;
+	artik_error ret = S_OK;
+	artik_http_headers headers;
+	artik_http_header_field fields[4] = {
+		{"Authorization", auth},
+		{"Content-Type", "application/json"},
+	};
+
+	snprintf(auth, CLOUD_AUTH_MAX_LEN, "Bearer %s", token);
+	headers.fields = fields;
+	headers.num_fields = 2;
+	if (etag && etag[0]) {
+		fields[headers.num_fields].name = "If-None-Match";
+		fields[headers.num_fields++].data = (char *)etag;
+	}
+	if (last_modified && last_modified[0]) {
+		fields[headers.num_fields].name = "If-Modified-Since";
+		fields[headers.num_fields++].data = (char *)last_modified;
+	}
+	stream->flags |= HTTP_STREAM_ACCEPT_ENCODING;
+
+	ret = cloud_stream_ssl_config(&ssl);
+	if (ret != S_OK)
+		return ret;
+
+	stream->ssl = &ssl;
+	ret = http_stream_request(HTTP_STREAM_GET, url, &headers, NULL, status, stream);
+	stream->ssl = NULL;
+
+	return ret;
+}
+
+artik_error cloud_stream_get_device(const char *token, const char *device_id,
+		bool properties, int *status, struct http_stream *stream)
+{
+	return cloud_stream_get_device_if(token, device_id, properties, NULL, NULL, status,
+		stream);
+}
+
+/*
+ * Same as cloud_stream_get_device() made conditional on the ETag and
+ * Last-Modified values of a previous response, sent back as they came
+ * when not NULL. The server answers 304 with no body when the device did
+ * not change.
+ */
+artik_error cloud_stream_get_device_if(const char *token, const char *device_id,
+		bool properties, const char *etag, const char *last_modified, int *status,
+		struct http_stream *stream)
+{
+	char url[CLOUD_URL_MAX_LEN];
+	char id[CLOUD_ID_MAX_LEN];
+
+	if (!token || !device_id || (cloud_stream_escape(device_id, id, sizeof(id)) < 0))
+		return E_BAD_ARGS;
+
+	snprintf(url, CLOUD_URL_MAX_LEN, CLOUD_REST_URI "/devices/%s?includeProperties=%s",
+		id, properties ? "true" : "false");
+
+	return cloud_stream_get(token, url, etag, last_modified, status, stream);
+}
+
+artik_error cloud_stream_get_user_devices(const char *token, const char *user_id,
+		int count, int offset, bool properties, int *status,
+		struct http_stream *stream)
+{
+	char url[CLOUD_URL_MAX_LEN];
+	char id[CLOUD_ID_MAX_LEN];
+
+	if (!token || !user_id || (cloud_stream_escape(user_id, id, sizeof(id)) < 0))
+		return E_BAD_ARGS;
+
+	snprintf(url, CLOUD_URL_MAX_LEN,
+		CLOUD_REST_URI "/users/%s/devices?count=%d&offset=%d&includeProperties=%s",
+		id, count, offset, properties ? "true" : "false");
+
+	return cloud_stream_get(token, url, NULL, NULL, status, stream);
+}
@@ -0,0 +1,41 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file cloud-stream.h
+ */
+
+#ifndef __ARTIK_CLOUD_STREAM_H__
+#define __ARTIK_CLOUD_STREAM_H__
+
+#include <stdbool.h>
+
+#include "http-stream.h"
+
+#define CLOUD_REST_URI		"https://api.artik.cloud/v1.1"
+
+artik_error cloud_stream_get_device(const char *token, const char *device_id,
+		bool properties, int *status, struct http_stream *stream);
+artik_error cloud_stream_get_device_if(const char *token, const char *device_id,
+		bool properties, const char *etag, const char *last_modified, int *status,
+		struct http_stream *stream);
+artik_error cloud_stream_get_user_devices(const char *token, const char *user_id,
+		int count, int offset, bool properties, int *status,
+		struct http_stream *stream);
+
+#endif /* __ARTIK_CLOUD_STREAM_H__ */
@@ -0,0 +1,288 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file device-cache.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+
+#include "cloud-stream.h"
+#include "device-cache.h"
+#include "inflate.h"
+#include "perf-stats.h"
+
+struct device_cache_entry {
+	char device_id[64];
+	uint32_t token_crc;
+	bool properties;
+	char etag[DEVICE_CACHE_VALIDATOR_LEN];
+	char last_modified[DEVICE_CACHE_VALIDATOR_LEN];
+	char *body;
+	unsigned int len;
+	unsigned int lookups;
+	uint64_t last_used;
+};
+
+struct device_cache_fetch {
+	http_stream_sink sink;
+	void *user_data;
+	char *body;
+	unsigned int len;
+	bool overflow;
+	char etag[DEVICE_CACHE_VALIDATOR_LEN];
+	char last_modified[DEVICE_CACHE_VALIDATOR_LEN];
+};
+
+static struct device_cache_entry g_device_cache[DEVICE_CACHE_MAX_ENTRIES];
+static pthread_mutex_t g_device_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int g_requests;
+static unsigned int g_hits;
+static unsigned int g_misses;
+static unsigned int g_unchanged;
+static unsigned int g_errors;
+static uint64_t g_bytes_saved;
+
+static uint32_t device_cache_token_crc(const char *token)
+{
+	return inflate_crc32(0, (const unsigned char *)token, strlen(token));
+}
+
+/* Must be called with g_device_lock held */
+static struct device_cache_entry *device_cache_find(uint32_t token_crc,
+		const char *device_id, bool properties, bool create)
+{
+	struct device_cache_entry *entry = NULL;
+	struct device_cache_entry *oldest = &g_device_cache[0];
+	int i;
+
+	for (i = 0; i < DEVICE_CACHE_MAX_ENTRIES; i++) {
+		if (g_device_cache[i].device_id[0] &&
+				(g_device_cache[i].token_crc == token_crc) &&
+				(g_device_cache[i].properties == properties) &&
+				!strcmp(g_device_cache[i].device_id, device_id)) {
+			entry = &g_device_cache[i];
+			break;
+		}
+
+		if (g_device_cache[i].last_used < oldest->last_used)
+			oldest = &g_device_cache[i];
+	}
+
+	if (!entry && create) {
+		entry = oldest;
+		free(entry->body);
+		memset(entry, 0, sizeof(struct device_cache_entry));
+		strncpy(entry->device_id, device_id, sizeof(entry->device_id) - 1);
+		entry->token_crc = token_crc;
+		entry->properties = properties;
+	}
+
+	if (entry)
+		entry->last_used = perf_now_us();
+
+	return entry;
+}
+
+/* Passes the body through to the caller while keeping a copy of it */
+static int device_cache_sink(const char *data, unsigned int len, void *user_data)
+{
+	struct device_cache_fetch *fetch = (struct device_cache_fetch *)user_data;
+
+	if (!fetch->overflow) {
+		if (fetch->len + len <= DEVICE_CACHE_MAX_BODY) {
+			memcpy(fetch->body + fetch->len, data, len);
+			fetch->len += len;
+		} else {
+			fetch->overflow = true;
+		}
+	}
+
+	return fetch->sink(data, len, fetch->user_data);
+}
+
+static void device_cache_copy_validator(char *dst, const char *value)
+{
+	/* A truncated validator would never match, keep none instead */
+	if (strlen(value) < DEVICE_CACHE_VALIDATOR_LEN)
+		strcpy(dst, value);
+	else
+		dst[0] = '\0';
+}
+
+static void device_cache_header(const char *name, const char *value, void *user_data)
+{
+	struct device_cache_fetch *fetch = (struct device_cache_fetch *)user_data;
+
+	if (!strcasecmp(name, "ETag"))
+		device_cache_copy_validator(fetch->etag, value);
+	else if (!strcasecmp(name, "Last-Modified"))
+		device_cache_copy_validator(fetch->last_modified, value);
+}
+
+/*
+ * Fetches a device into sink. On return *cached tells whether the body
+ * came from the cache, in which case *status is 304.
+ */
+artik_error device_cache_get(const char *token, const char *device_id, bool properties,
+		http_stream_sink sink, void *user_data, int *status, bool *cached)
+{
+	struct device_cache_entry *entry;
+	struct device_cache_fetch fetch;
+	struct http_stream stream;
+	char chunk[HTTP_STREAM_CHUNK_SIZE];
+	char etag[DEVICE_CACHE_VALIDATOR_LEN] = "";
+	char last_modified[DEVICE_CACHE_VALIDATOR_LEN] = "";
+	uint32_t token_crc;
+	artik_error ret = S_OK;
+	unsigned int off, n;
+	char *body;
+
+	if (!token || !device_id || !sink || !status || !cached)
+		return E_BAD_ARGS;
+
+	*cached = false;
+	memset(&fetch, 0, sizeof(fetch));
+	fetch.sink = sink;
+	fetch.user_data = user_data;
+	fetch.body = malloc(DEVICE_CACHE_MAX_BODY);
+	if (!fetch.body)
+		return E_NO_MEM;
+
+	token_crc = device_cache_token_crc(token);
+
+	pthread_mutex_lock(&g_device_lock);
+	g_requests++;
+	entry = device_cache_find(token_crc, device_id, properties, false);
+	if (entry) {
+		entry->lookups++;
+		if (entry->body) {
+			strcpy(etag, entry->etag);
+			strcpy(last_modified, entry->last_modified);
+		}
+	}
+	pthread_mutex_unlock(&g_device_lock);
+
+	http_stream_init(&stream, chunk, sizeof(chunk), device_cache_sink, &fetch);
+	stream.header = device_cache_header;
+	ret = cloud_stream_get_device_if(token, device_id, properties, etag, last_modified,
+		status, &stream);
+
+	pthread_mutex_lock(&g_device_lock);
+	if ((ret == S_OK) && (*status == 304)) {
+		entry = device_cache_find(token_crc, device_id, properties, false);
+		if (entry && entry->body) {
+			memcpy(fetch.body, entry->body, entry->len);
+			fetch.len = entry->len;
+			/* A 304 may carry updated validators */
+			if (fetch.etag[0])
+				strcpy(entry->etag, fetch.etag);
+			if (fetch.last_modified[0])
+				strcpy(entry->last_modified, fetch.last_modified);
+			*cached = true;
+			g_hits++;
+			g_bytes_saved += entry->len;
+		} else {
+			/* Evicted while the request was going on */
+			ret = E_HTTP_ERROR;
+			g_errors++;
+		}
+	} else if ((ret == S_OK) && (*status == 200)) {
+		g_misses++;
+		entry = device_cache_find(token_crc, device_id, properties, !fetch.overflow);
+		if (entry && fetch.overflow) {
+			free(entry->body);
+			entry->body = NULL;
+			entry->len = 0;
+		} else if (entry) {
+			if (entry->body && (entry->len == fetch.len) &&
+					!memcmp(entry->body, fetch.body, fetch.len)) {
+				g_unchanged++;
+			} else {
+				body = malloc(fetch.len ? fetch.len : 1);
+				if (body) {
+					memcpy(body, fetch.body, fetch.len);
+					free(entry->body);
+					entry->body = body;
+					entry->len = fetch.len;
+				}
+			}
+			strcpy(entry->etag, fetch.etag);
+			strcpy(entry->last_modified, fetch.last_modified);
+		}
+	} else {
+		g_errors++;
+	}
+	pthread_mutex_unlock(&g_device_lock);
+
+	/* Replay the cached copy outside of the lock */
+	for (off = 0; *cached && (off < fetch.len); off += n) {
+		n = fetch.len - off;
+		if (n > HTTP_STREAM_CHUNK_SIZE)
+			n = HTTP_STREAM_CHUNK_SIZE;
+		if (sink(fetch.body + off, n, user_data) < 0) {
+			ret = E_INTERRUPTED;
+			break;
+		}
+	}
+
+	free(fetch.body);
+
+	return ret;
+}
+
+void device_cache_dump(void)
+{
+	unsigned int done;
+	int i;
+
+	pthread_mutex_lock(&g_device_lock);
+	done = g_hits + g_misses;
+	fprintf(stdout, "requests %u, not modified %u, modified %u (unchanged %u), errors %u\n",
+		g_requests, g_hits, g_misses, g_unchanged, g_errors);
+	if (done)
+		fprintf(stdout, "hit rate %u%%, %llu bytes not transferred\n", g_hits * 100 / done,
+			(unsigned long long)g_bytes_saved);
+
+	for (i = 0; i < DEVICE_CACHE_MAX_ENTRIES; i++) {
+		if (!g_device_cache[i].device_id[0])
+			continue;
+
+		fprintf(stdout, "%s%s: %u bytes, lookups %u\n", g_device_cache[i].device_id,
+			g_device_cache[i].properties ? " (properties)" : "",
+			g_device_cache[i].len, g_device_cache[i].lookups);
+	}
+	pthread_mutex_unlock(&g_device_lock);
+}
+
+void device_cache_flush(void)
+{
+	int i;
+
+	pthread_mutex_lock(&g_device_lock);
+	for (i = 0; i < DEVICE_CACHE_MAX_ENTRIES; i++)
+		free(g_device_cache[i].body);
+	memset(g_device_cache, 0, sizeof(g_device_cache));
+	g_requests = g_hits = g_misses = g_unchanged = g_errors = 0;
+	g_bytes_saved = 0;
+	pthread_mutex_unlock(&g_device_lock);
+}
@@ -0,0 +1,55 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file device-cache.h
+ */
+
+#ifndef __ARTIK_DEVICE_CACHE_H__
+#define __ARTIK_DEVICE_CACHE_H__
+
+#include <stdbool.h>
+
+#include "http-stream.h"
+
+#define DEVICE_CACHE_MAX_ENTRIES	4
+#define DEVICE_CACHE_MAX_BODY		2048
+
+/*
+ * Conditional fetch of cloud devices, for callers polling a device for
+ * configuration changes.
+ *
+ * The last body of each (token, device id, properties) request is kept
+ * along with the ETag and Last-Modified headers the server sent with it.
+ * The next request sends them back as If-None-Match and If-Modified-Since,
+ * and on 304 Not Modified the cached body is handed to the sink without
+ * being transferred again. Only the server's own values are used, so the
+ * device clock plays no part. A response with neither header is cached
+ * but the next request for it is unconditional.
+ *
+ * Tokens are only kept as a checksum. Bodies over DEVICE_CACHE_MAX_BODY,
+ * and validators over DEVICE_CACHE_VALIDATOR_LEN, are not cached.
+ */
+#define DEVICE_CACHE_VALIDATOR_LEN	64
+
+artik_error device_cache_get(const char *token, const char *device_id, bool properties,
+		http_stream_sink sink, void *user_data, int *status, bool *cached);
+void device_cache_dump(void);
+void device_cache_flush(void);
+
+#endif /* __ARTIK_DEVICE_CACHE_H__ */
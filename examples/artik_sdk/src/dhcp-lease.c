@@ -0,0 +1,466 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file dhcp-lease.c
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+#include <artik_module.h>
+#include <artik_network.h>
+
+#include "dhcp-lease.h"
+#include "inflate.h"
+#include "perf-stats.h"
+
+#define DHCP_LEASE_MAGIC		0x44484350	/* "DHCP" */
+#define DHCP_LEASE_STACK_SIZE	8192
+
+struct dhcp_lease {
+	char network[DHCP_LEASE_NETWORK_LEN];
+	artik_network_config config;
+	uint32_t last_used;
+	uint32_t saved_at;		/* Wall clock seconds */
+};
+
+struct dhcp_lease_file {
+	uint32_t magic;
+	struct dhcp_lease leases[DHCP_LEASE_MAX_NETWORKS];
+	uint32_t use_count;
+	uint32_t crc;
+};
+
+struct dhcp_lease_stats {
+	unsigned int saved_used;
+	unsigned int renewed;
+	unsigned int changed;
+	unsigned int failed;
+	unsigned int expired;
+	unsigned int ambiguous;
+	struct perf_stats apply;
+	struct perf_stats exchange;
+};
+
+struct dhcp_lease_state {
+	struct dhcp_lease_file file;
+	bool loaded;
+	char network[DHCP_LEASE_NETWORK_LEN];
+	artik_network_dhcp_client_handle handle;
+	bool renewing;
+	bool exchanging;	/* In the foreground */
+	struct dhcp_lease_stats stats;
+	pthread_mutex_t lock;
+};
+
+static struct dhcp_lease_state g_dhcp = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/* Must be called with g_dhcp.lock held */
+static void dhcp_lease_load(void)
+{
+	ssize_t len;
+	int fd;
+
+	if (g_dhcp.loaded)
+		return;
+
+	g_dhcp.loaded = true;
+
+	fd = open(DHCP_LEASE_PATH, O_RDONLY);
+	if (fd < 0)
+		return;
+
+	len = read(fd, &g_dhcp.file, sizeof(g_dhcp.file));
+	close(fd);
+
+	if ((len != sizeof(g_dhcp.file)) || (g_dhcp.file.magic != DHCP_LEASE_MAGIC) ||
+			(g_dhcp.file.crc != inflate_crc32(0, (const unsigned char *)&g_dhcp.file,
+				offsetof(struct dhcp_lease_file, crc))))
+		memset(&g_dhcp.file, 0, sizeof(g_dhcp.file));
+}
+
+/* Must be called with g_dhcp.lock held */
+static void dhcp_lease_write(void)
+{
+	ssize_t len = -1;
+	int fd;
+
+	g_dhcp.file.magic = DHCP_LEASE_MAGIC;
+	g_dhcp.file.crc = inflate_crc32(0, (const unsigned char *)&g_dhcp.file,
+		offsetof(struct dhcp_lease_file, crc));
+
+	fd = open(DHCP_LEASE_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd >= 0) {
+		len = write(fd, &g_dhcp.file, sizeof(g_dhcp.file));
+		close(fd);
+	}
+
+	if (len != sizeof(g_dhcp.file))
+		fprintf(stderr, "Failed to save DHCP leases to %s\n", DHCP_LEASE_PATH);
+}
+
+/* Must be called with g_dhcp.lock held */
+static struct dhcp_lease *dhcp_lease_find(const char *network, const char *gateway,
+		bool create)
+{
+	struct dhcp_lease *oldest = &g_dhcp.file.leases[0];
+	struct dhcp_lease *lease;
+	int i;
+
+	if (!network[0])
+		return NULL;
+
+	for (i = 0; i < DHCP_LEASE_MAX_NETWORKS; i++) {
+		lease = &g_dhcp.file.leases[i];
+		if (lease->network[0] && !strcmp(lease->network, network) &&
+				!strncmp(lease->config.gw_addr.address, gateway, MAX_IP_ADDRESS_LEN)) {
+			lease->last_used = ++g_dhcp.file.use_count;
+			return lease;
+		}
+
+		if (lease->last_used < oldest->last_used)
+			oldest = lease;
+	}
+
+	if (!create)
+		return NULL;
+
+	memset(oldest, 0, sizeof(struct dhcp_lease));
+	strncpy(oldest->network, network, DHCP_LEASE_NETWORK_LEN - 1);
+	oldest->last_used = ++g_dhcp.file.use_count;
+
+	return oldest;
+}
+
+/*
+ * Must be called with g_dhcp.lock held. Returns the lease to apply on the
+ * network, NULL when there is none or when networks with different
+ * gateways were seen under that name, there is no telling which one this is.
+ */
+static struct dhcp_lease *dhcp_lease_pick(const char *network)
+{
+	struct dhcp_lease *found = NULL;
+	struct dhcp_lease *lease;
+	int i;
+
+	if (!network[0])
+		return NULL;
+
+	for (i = 0; i < DHCP_LEASE_MAX_NETWORKS; i++) {
+		lease = &g_dhcp.file.leases[i];
+		if (!lease->network[0] || strcmp(lease->network, network))
+			continue;
+
+		if (found) {
+			g_dhcp.stats.ambiguous++;
+			fprintf(stderr, "DHCP: several networks named %s, not using a saved lease\n",
+				network);
+			return NULL;
+		}
+
+		found = lease;
+	}
+
+	if (found)
+		found->last_used = ++g_dhcp.file.use_count;
+
+	return found;
+}
+
+static bool dhcp_lease_fresh(const struct dhcp_lease *lease)
+{
+	uint32_t now = (uint32_t)time(NULL);
+
+	return (now >= lease->saved_at) && (now - lease->saved_at < DHCP_LEASE_MAX_AGE_S);
+}
+
+/* Leaves the interface without an address */
+static void dhcp_lease_unconfigure(artik_network_module *network)
+{
+	artik_network_config config;
+	int i;
+
+	memset(&config, 0, sizeof(config));
+	strncpy(config.ip_addr.address, "0.0.0.0", MAX_IP_ADDRESS_LEN - 1);
+	strncpy(config.netmask.address, "0.0.0.0", MAX_IP_ADDRESS_LEN - 1);
+	strncpy(config.gw_addr.address, "0.0.0.0", MAX_IP_ADDRESS_LEN - 1);
+	for (i = 0; i < MAX_DNS_ADDRESSES; i++)
+		strncpy(config.dns_addr[i].address, "0.0.0.0", MAX_IP_ADDRESS_LEN - 1);
+
+	if (network->set_network_config(&config, ARTIK_WIFI) != S_OK)
+		fprintf(stderr, "Failed to clear the interface configuration\n");
+}
+
+static bool dhcp_config_equal(const artik_network_config *a, const artik_network_config *b)
+{
+	int i;
+
+	if (strncmp(a->ip_addr.address, b->ip_addr.address, MAX_IP_ADDRESS_LEN) ||
+			strncmp(a->netmask.address, b->netmask.address, MAX_IP_ADDRESS_LEN) ||
+			strncmp(a->gw_addr.address, b->gw_addr.address, MAX_IP_ADDRESS_LEN))
+		return false;
+
+	for (i = 0; i < MAX_DNS_ADDRESSES; i++) {
+		if (strncmp(a->dns_addr[i].address, b->dns_addr[i].address, MAX_IP_ADDRESS_LEN))
+			return false;
+	}
+
+	return true;
+}
+
+void dhcp_lease_network_changed(const char *network_id)
+{
+	pthread_mutex_lock(&g_dhcp.lock);
+	memset(g_dhcp.network, 0, sizeof(g_dhcp.network));
+	if (network_id)
+		strncpy(g_dhcp.network, network_id, DHCP_LEASE_NETWORK_LEN - 1);
+	pthread_mutex_unlock(&g_dhcp.lock);
+}
+
+/*
+ * Runs a full DHCP exchange, the SDK client always starts with a DISCOVER,
+ * and saves the address obtained. 'saved' is the lease applied beforehand,
+ * or NULL. Failing to renew it leaves the interface unconfigured.
+ */
+static artik_error dhcp_lease_exchange(artik_network_module *network, const char *network_id,
+		const artik_network_config *saved)
+{
+	artik_network_config config;
+	struct dhcp_lease *lease;
+	artik_error err;
+	uint64_t start;
+	uint32_t elapsed;
+
+	memset(&config, 0, sizeof(config));
+	start = perf_now_us();
+	err = network->dhcp_client_start(&g_dhcp.handle, ARTIK_WIFI);
+	elapsed = perf_now_us() - start;
+
+	if (err == S_OK)
+		err = network->get_network_config(&config, ARTIK_WIFI);
+
+	pthread_mutex_lock(&g_dhcp.lock);
+	if (err != S_OK) {
+		g_dhcp.stats.failed++;
+		if (saved) {
+			fprintf(stderr, "DHCP failed (%d), dropping the saved lease %s\n", err,
+				saved->ip_addr.address);
+			lease = dhcp_lease_find(network_id, saved->gw_addr.address, false);
+			if (lease) {
+				memset(lease, 0, sizeof(struct dhcp_lease));
+				dhcp_lease_write();
+			}
+			dhcp_lease_unconfigure(network);
+		}
+		goto exit;
+	}
+
+	perf_stats_add(&g_dhcp.stats.exchange, elapsed);
+	if (saved)
+		g_dhcp.stats.renewed++;
+
+	fprintf(stderr, "DHCP: %s in %u ms\n", config.ip_addr.address, elapsed / 1000);
+
+	if (saved && !dhcp_config_equal(saved, &config)) {
+		g_dhcp.stats.changed++;
+		fprintf(stderr, "DHCP: address changed from the saved %s\n",
+			saved->ip_addr.address);
+	}
+
+	/*
+	 * Saved again when unchanged too, the server just extended the lease.
+	 * Behind another gateway this is another network of the same name, its
+	 * lease is kept apart and the saved one left for the other network.
+	 */
+	lease = dhcp_lease_find(network_id, config.gw_addr.address, true);
+	if (lease) {
+		memcpy(&lease->config, &config, sizeof(config));
+		lease->saved_at = (uint32_t)time(NULL);
+		dhcp_lease_write();
+	}
+
+exit:
+	pthread_mutex_unlock(&g_dhcp.lock);
+
+	return err;
+}
+
+struct dhcp_renew {
+	char network_id[DHCP_LEASE_NETWORK_LEN];
+	artik_network_config saved;
+	artik_network_module *network;
+	dhcp_lease_callback cb;
+	void *user_data;
+};
+
+static struct dhcp_renew g_renew;
+
+static pthread_addr_t dhcp_lease_renew_thread(pthread_addr_t arg)
+{
+	struct dhcp_renew *renew = (struct dhcp_renew *)arg;
+	dhcp_lease_callback cb = renew->cb;
+	void *user_data = renew->user_data;
+	artik_error err;
+
+	err = dhcp_lease_exchange(renew->network, renew->network_id, &renew->saved);
+	artik_release_api_module(renew->network);
+
+	pthread_mutex_lock(&g_dhcp.lock);
+	g_dhcp.renewing = false;
+	pthread_mutex_unlock(&g_dhcp.lock);
+
+	if (cb)
+		cb(err, user_data);
+
+	return NULL;
+}
+
+/* Must be called with g_dhcp.lock held, takes over the network module reference */
+static artik_error dhcp_lease_renew(artik_network_module *network)
+{
+	pthread_attr_t attr;
+	pthread_t thread;
+	int ret;
+
+	g_renew.network = network;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, DHCP_LEASE_STACK_SIZE);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	ret = pthread_create(&thread, &attr, dhcp_lease_renew_thread, &g_renew);
+	pthread_attr_destroy(&attr);
+
+	if (ret != 0)
+		return E_NO_MEM;
+
+	g_dhcp.renewing = true;
+
+	return S_OK;
+}
+
+artik_error dhcp_lease_start(bool use_saved, dhcp_lease_callback renewed, void *user_data)
+{
+	artik_network_module *network;
+	struct dhcp_lease *lease = NULL;
+	char network_id[DHCP_LEASE_NETWORK_LEN];
+	artik_error err;
+	uint64_t start;
+
+	network = (artik_network_module *)artik_request_api_module("network");
+	if (!network)
+		return E_NOT_SUPPORTED;
+
+	pthread_mutex_lock(&g_dhcp.lock);
+	if (g_dhcp.renewing || g_dhcp.exchanging) {
+		pthread_mutex_unlock(&g_dhcp.lock);
+		artik_release_api_module(network);
+		return E_BUSY;
+	}
+
+	dhcp_lease_load();
+	memcpy(network_id, g_dhcp.network, sizeof(network_id));
+	if (use_saved)
+		lease = dhcp_lease_pick(network_id);
+
+	if (lease && !dhcp_lease_fresh(lease)) {
+		g_dhcp.stats.expired++;
+		fprintf(stderr, "DHCP: saved lease %s is too old, not using it\n",
+			lease->config.ip_addr.address);
+		lease = NULL;
+	}
+
+	if (lease) {
+		start = perf_now_us();
+		err = network->set_network_config(&lease->config, ARTIK_WIFI);
+		if (err == S_OK) {
+			perf_stats_add(&g_dhcp.stats.apply, perf_now_us() - start);
+			g_dhcp.stats.saved_used++;
+			fprintf(stderr, "DHCP: using saved lease %s, renewing in the background\n",
+				lease->config.ip_addr.address);
+
+			memcpy(g_renew.network_id, network_id, sizeof(g_renew.network_id));
+			memcpy(&g_renew.saved, &lease->config, sizeof(g_renew.saved));
+			g_renew.cb = renewed;
+			g_renew.user_data = user_data;
+			if (dhcp_lease_renew(network) == S_OK) {
+				pthread_mutex_unlock(&g_dhcp.lock);
+				return S_OK;
+			}
+		} else {
+			lease = NULL;
+		}
+	}
+
+	/* Without a saved lease, or a task to renew it, the exchange runs in the foreground */
+	g_dhcp.exchanging = true;
+	pthread_mutex_unlock(&g_dhcp.lock);
+
+	err = dhcp_lease_exchange(network, network_id, lease ? &g_renew.saved : NULL);
+	artik_release_api_module(network);
+
+	pthread_mutex_lock(&g_dhcp.lock);
+	g_dhcp.exchanging = false;
+	pthread_mutex_unlock(&g_dhcp.lock);
+
+	return err;
+}
+
+void dhcp_lease_clear(void)
+{
+	pthread_mutex_lock(&g_dhcp.lock);
+	memset(&g_dhcp.file, 0, sizeof(g_dhcp.file));
+	g_dhcp.loaded = true;
+	unlink(DHCP_LEASE_PATH);
+	pthread_mutex_unlock(&g_dhcp.lock);
+}
+
+void dhcp_lease_dump(void)
+{
+	struct dhcp_lease *lease;
+	int i;
+
+	pthread_mutex_lock(&g_dhcp.lock);
+	dhcp_lease_load();
+	for (i = 0; i < DHCP_LEASE_MAX_NETWORKS; i++) {
+		lease = &g_dhcp.file.leases[i];
+		if (!lease->network[0])
+			continue;
+
+		fprintf(stdout, "%s%s: %s gw %s dns %s\n", lease->network,
+			strcmp(lease->network, g_dhcp.network) ? "" : " (current)",
+			lease->config.ip_addr.address, lease->config.gw_addr.address,
+			lease->config.dns_addr[0].address);
+	}
+
+	fprintf(stdout, "saved used %u, renewed %u, changed %u, failed %u, expired %u, "
+		"ambiguous %u%s\n", g_dhcp.stats.saved_used, g_dhcp.stats.renewed,
+		g_dhcp.stats.changed, g_dhcp.stats.failed, g_dhcp.stats.expired,
+		g_dhcp.stats.ambiguous, g_dhcp.renewing ? ", renewing" : "");
+	perf_stats_print("apply saved", &g_dhcp.stats.apply);
+	perf_stats_print("exchange", &g_dhcp.stats.exchange);
+	pthread_mutex_unlock(&g_dhcp.lock);
+}
@@ -0,0 +1,82 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file dhcp-lease.h
+ */
+
+#ifndef __ARTIK_DHCP_LEASE_H__
+#define __ARTIK_DHCP_LEASE_H__
+
+#include <stdbool.h>
+
+#include <artik_error.h>
+
+#define DHCP_LEASE_MAX_NETWORKS		4
+#define DHCP_LEASE_NETWORK_LEN		33
+#ifndef DHCP_LEASE_PATH
+#define DHCP_LEASE_PATH				"/mnt/dhcp-leases"
+#endif
+#ifndef DHCP_LEASE_MAX_AGE_S
+#define DHCP_LEASE_MAX_AGE_S		3600
+#endif
+
+/*
+ * Addresses obtained by DHCP, saved per network in a file along with a
+ * CRC32, the least recently used network making room for a new one. The
+ * SDK reports neither the BSSID joined nor the DHCP server identifier, so
+ * a network is told by its SSID and the gateway handed out with the lease.
+ * Once an SSID was seen behind more than one gateway no saved lease is
+ * applied on it, the exchange runs in the foreground instead, until
+ * 'wifi dhcp clear' forgets the leases.
+ *
+ * When the current network has a saved lease, dhcp_lease_start() applies
+ * it to the interface right away and runs the DHCP client in the
+ * background. The address is thus usable as soon as the association is
+ * done. This is not the INIT-REBOOT of RFC 2131: dhcp_client_start() takes
+ * no address to request, so the renewal is a full DISCOVER/OFFER/REQUEST
+ * exchange and takes as long as without a saved lease. What is saved is
+ * the wait before the address can be used, not the exchange. If the
+ * server hands out another address it replaces the saved one. If the
+ * exchange fails the saved lease is dropped and the interface
+ * configuration cleared, since the address may no longer be valid, and
+ * the caller learns of it through the callback it passed, which is called
+ * from the background task once the exchange is over. Without a saved
+ * lease, or when asked not to use it, the client runs in the foreground
+ * as before and the callback is not called. dhcp_lease_start() returns
+ * E_BUSY while an exchange, in the background or not, is still running.
+ *
+ * Leases are saved with the wall clock time of the exchange and one older
+ * than DHCP_LEASE_MAX_AGE_S is not applied, the server may have given the
+ * address away since. The SDK does not report the lease time, so the age
+ * is a conservative guess at it. On a device whose clock is not set across
+ * resets the age can only be told when the clock went backwards, in which
+ * case the lease is not applied either.
+ *
+ * The time taken by full exchanges and by applying saved leases is kept
+ * for 'wifi dhcp stats'.
+ */
+typedef void (*dhcp_lease_callback)(artik_error result, void *user_data);
+
+void dhcp_lease_network_changed(const char *network_id);
+artik_error dhcp_lease_start(bool use_saved, dhcp_lease_callback renewed, void *user_data);
+void dhcp_lease_clear(void);
+void dhcp_lease_dump(void);
+
+#endif /* __ARTIK_DHCP_LEASE_H__ */
@@ -0,0 +1,85 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file dns-api.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <shell/tash.h>
+#include <arpa/inet.h>
+
+#include "command.h"
+#include "dns-cache.h"
+
+static int dns_stats(int argc, char *argv[]);
+static int dns_flush(int argc, char *argv[]);
+static int dns_lookup(int argc, char *argv[]);
+
+const struct command dns_commands[] = {
+	{ "stats", "Display DNS cache statistics and entries", dns_stats },
+	{ "flush", "Drop all the DNS cache entries", dns_flush },
+	{ "lookup", "lookup <host>", dns_lookup },
+	{ "", "", NULL }
+};
+
+static int dns_stats(int argc, char *argv[])
+{
+	dns_cache_dump();
+
+	return 0;
+}
+
+static int dns_flush(int argc, char *argv[])
+{
+	dns_cache_flush();
+
+	return 0;
+}
+
+static int dns_lookup(int argc, char *argv[])
+{
+	struct in_addr addr;
+	artik_error err;
+
+	if (argc < 4) {
+		fprintf(stderr, "Wrong number of arguments\n");
+		usage(argv[1], dns_commands);
+		return -1;
+	}
+
+	err = dns_cache_lookup(argv[3], &addr);
+	if (err != S_OK) {
+		fprintf(stderr, "Failed to resolve %s (%s)\n", argv[3], error_msg(err));
+		return -1;
+	}
+
+	fprintf(stdout, "%s: %s\n", argv[3], inet_ntoa(addr));
+
+	return 0;
+}
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int dns_main(int argc, char *argv[])
+#endif
+{
+	return commands_parser(argc, argv, dns_commands);
+}
@@ -0,0 +1,330 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file dns-cache.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+#include <artik_module.h>
+#include <artik_network.h>
+
+#include "dns-cache.h"
+#include "perf-stats.h"
+#include "uri.h"
+
+#define DNS_PREFETCH_STACK_SIZE	8192
+#define DNS_NETWORK_ID_LEN		(33 + 2 * MAX_IP_ADDRESS_LEN)
+
+struct dns_cache_entry {
+	char host[URI_MAX_HOST_LEN];
+	struct in_addr addr;
+	artik_error error;
+	bool negative;
+	bool prefetching;
+	uint32_t created;
+	uint32_t expires;
+	unsigned int hits;
+};
+
+struct dns_cache_stats {
+	unsigned int lookups;
+	unsigned int hits;
+	unsigned int negative_hits;
+	unsigned int misses;
+	unsigned int prefetches;
+	unsigned int failures;
+	unsigned int flushes;
+	struct perf_stats resolve;
+};
+
+static struct dns_cache_entry g_dns_cache[DNS_CACHE_ENTRIES];
+static struct dns_cache_stats g_dns_stats;
+static char g_dns_network[DNS_NETWORK_ID_LEN];
+static pthread_mutex_t g_dns_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t dns_now(void)
+{
+	return perf_now_us() / 1000000;
+}
+
+static artik_error dns_resolve(const char *host, struct in_addr *addr)
+{
+	struct addrinfo hints;
+	struct addrinfo *res = NULL;
+	uint64_t start = perf_now_us();
+	artik_error ret = S_OK;
+	int err;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+
+	err = getaddrinfo(host, NULL, &hints, &res);
+	if (err == EAI_NONAME) {
+		ret = E_INVALID_VALUE;
+	} else if (err == EAI_MEMORY) {
+		ret = E_NO_MEM;
+	} else if (err || !res) {
+		/* lwIP reports every resolver failure, timeouts included, as EAI_FAIL */
+		ret = E_TRY_AGAIN;
+	} else {
+		memcpy(addr, &((struct sockaddr_in *)res->ai_addr)->sin_addr,
+			sizeof(struct in_addr));
+		freeaddrinfo(res);
+	}
+
+	pthread_mutex_lock(&g_dns_lock);
+	perf_stats_add(&g_dns_stats.resolve, perf_now_us() - start);
+	pthread_mutex_unlock(&g_dns_lock);
+
+	return ret;
+}
+
+/* Must be called with g_dns_lock held */
+static struct dns_cache_entry *dns_cache_find(const char *host)
+{
+	int i;
+
+	for (i = 0; i < DNS_CACHE_ENTRIES; i++) {
+		if (!strcmp(g_dns_cache[i].host, host))
+			return &g_dns_cache[i];
+	}
+
+	return NULL;
+}
+
+/* Must be called with g_dns_lock held */
+static void dns_cache_store(const char *host, const struct in_addr *addr, artik_error error)
+{
+	bool negative = (error != S_OK);
+	struct dns_cache_entry *entry = dns_cache_find(host);
+	uint32_t now = dns_now();
+	int i;
+
+	if (!entry) {
+		entry = &g_dns_cache[0];
+		for (i = 0; i < DNS_CACHE_ENTRIES; i++) {
+			if (!g_dns_cache[i].host[0]) {
+				entry = &g_dns_cache[i];
+				break;
+			}
+			if (g_dns_cache[i].expires < entry->expires)
+				entry = &g_dns_cache[i];
+		}
+		memset(entry, 0, sizeof(struct dns_cache_entry));
+		strncpy(entry->host, host, URI_MAX_HOST_LEN - 1);
+	}
+
+	entry->negative = negative;
+	entry->error = error;
+	entry->prefetching = false;
+	entry->created = now;
+	entry->expires = now + (negative ? DNS_CACHE_NEGATIVE_TTL : DNS_CACHE_TTL);
+	if (!negative)
+		entry->addr = *addr;
+}
+
+static pthread_addr_t dns_prefetch(pthread_addr_t arg)
+{
+	char *host = (char *)arg;
+	struct in_addr addr;
+
+	/* Keep the previous answer if the refresh fails, it expires on its own */
+	if (dns_resolve(host, &addr) == S_OK) {
+		pthread_mutex_lock(&g_dns_lock);
+		dns_cache_store(host, &addr, S_OK);
+		pthread_mutex_unlock(&g_dns_lock);
+	} else {
+		struct dns_cache_entry *entry;
+
+		pthread_mutex_lock(&g_dns_lock);
+		entry = dns_cache_find(host);
+		if (entry)
+			entry->prefetching = false;
+		pthread_mutex_unlock(&g_dns_lock);
+	}
+
+	free(host);
+
+	return NULL;
+}
+
+/* Must be called with g_dns_lock held */
+static void dns_cache_start_prefetch(struct dns_cache_entry *entry)
+{
+	pthread_attr_t attr;
+	pthread_t tid;
+	char *host = strdup(entry->host);
+
+	if (!host)
+		return;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, DNS_PREFETCH_STACK_SIZE);
+	if (pthread_create(&tid, &attr, dns_prefetch, host) == 0) {
+		pthread_detach(tid);
+		entry->prefetching = true;
+		g_dns_stats.prefetches++;
+	} else {
+		free(host);
+	}
+	pthread_attr_destroy(&attr);
+}
+
+artik_error dns_cache_lookup(const char *host, struct in_addr *addr)
+{
+	struct dns_cache_entry *entry;
+	struct in_addr resolved;
+	uint32_t now = dns_now();
+	artik_error ret;
+
+	if (!host || !addr)
+		return E_BAD_ARGS;
+
+	/* Numeric hosts never reach the resolver */
+	if (inet_aton(host, addr))
+		return S_OK;
+
+	pthread_mutex_lock(&g_dns_lock);
+	g_dns_stats.lookups++;
+	entry = dns_cache_find(host);
+	if (entry && (now < entry->expires)) {
+		entry->hits++;
+		if (entry->negative) {
+			g_dns_stats.negative_hits++;
+			ret = entry->error;
+			pthread_mutex_unlock(&g_dns_lock);
+			return ret;
+		}
+
+		g_dns_stats.hits++;
+		*addr = entry->addr;
+
+		if (!entry->prefetching && ((now - entry->created) * 100 >=
+				(entry->expires - entry->created) * DNS_CACHE_PREFETCH_PERCENT))
+			dns_cache_start_prefetch(entry);
+
+		pthread_mutex_unlock(&g_dns_lock);
+		return S_OK;
+	}
+	g_dns_stats.misses++;
+	pthread_mutex_unlock(&g_dns_lock);
+
+	ret = dns_resolve(host, &resolved);
+
+	/* Only names that do not exist are remembered, other failures may be transient */
+	pthread_mutex_lock(&g_dns_lock);
+	if ((ret == S_OK) || (ret == E_INVALID_VALUE))
+		dns_cache_store(host, &resolved, ret);
+	if (ret != S_OK)
+		g_dns_stats.failures++;
+	pthread_mutex_unlock(&g_dns_lock);
+
+	if (ret == S_OK)
+		*addr = resolved;
+
+	return ret;
+}
+
+artik_error dns_cache_lookup_uri(const char *uri, struct in_addr *addr)
+{
+	char host[URI_MAX_HOST_LEN];
+	struct in_addr ignored;
+
+	if (!uri || (uri_get_host(uri, host, URI_MAX_HOST_LEN) < 0))
+		return E_BAD_ARGS;
+
+	return dns_cache_lookup(host, addr ? addr : &ignored);
+}
+
+/*
+ * Entries survive a reconnection to the same network. Joining a different
+ * one may change the resolver and the answers, so the cache is dropped.
+ * Networks sharing an SSID are told apart by their gateway and resolver,
+ * which is why this is called once the interface has its address.
+ */
+void dns_cache_network_changed(const char *ssid)
+{
+	artik_network_module *network;
+	artik_network_config config;
+	char network_id[DNS_NETWORK_ID_LEN];
+
+	if (!ssid)
+		return;
+
+	memset(&config, 0, sizeof(config));
+	network = (artik_network_module *)artik_request_api_module("network");
+	if (network) {
+		network->get_network_config(&config, ARTIK_WIFI);
+		artik_release_api_module(network);
+	}
+	snprintf(network_id, DNS_NETWORK_ID_LEN, "%s/%s/%s", ssid, config.gw_addr.address,
+		config.dns_addr[0].address);
+
+	pthread_mutex_lock(&g_dns_lock);
+	if (strncmp(g_dns_network, network_id, DNS_NETWORK_ID_LEN - 1)) {
+		if (g_dns_network[0]) {
+			memset(g_dns_cache, 0, sizeof(g_dns_cache));
+			g_dns_stats.flushes++;
+		}
+		strncpy(g_dns_network, network_id, DNS_NETWORK_ID_LEN - 1);
+	}
+	pthread_mutex_unlock(&g_dns_lock);
+}
+
+void dns_cache_flush(void)
+{
+	pthread_mutex_lock(&g_dns_lock);
+	memset(g_dns_cache, 0, sizeof(g_dns_cache));
+	g_dns_stats.flushes++;
+	pthread_mutex_unlock(&g_dns_lock);
+}
+
+void dns_cache_dump(void)
+{
+	uint32_t now = dns_now();
+	int i;
+
+	pthread_mutex_lock(&g_dns_lock);
+	fprintf(stdout, "lookups %u hits %u negative hits %u misses %u\n",
+		g_dns_stats.lookups, g_dns_stats.hits, g_dns_stats.negative_hits,
+		g_dns_stats.misses);
+	fprintf(stdout, "prefetches %u failures %u flushes %u\n",
+		g_dns_stats.prefetches, g_dns_stats.failures, g_dns_stats.flushes);
+	perf_stats_print("resolve", &g_dns_stats.resolve);
+
+	for (i = 0; i < DNS_CACHE_ENTRIES; i++) {
+		struct dns_cache_entry *entry = &g_dns_cache[i];
+
+		if (!entry->host[0])
+			continue;
+
+		fprintf(stdout, "\t%s %s ttl %ds hits %u\n", entry->host,
+			entry->negative ? "(failed)" : inet_ntoa(entry->addr),
+			(int)(entry->expires - now), entry->hits);
+	}
+	pthread_mutex_unlock(&g_dns_lock);
+}
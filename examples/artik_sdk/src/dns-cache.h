@@ -0,0 +1,55 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file dns-cache.h
+ */
+
+#ifndef __ARTIK_DNS_CACHE_H__
+#define __ARTIK_DNS_CACHE_H__
+
+#include <netinet/in.h>
+
+#include <artik_error.h>
+
+/*
+ * Host name cache shared by the network commands.
+ *
+ * The resolver API does not report record TTLs, so positive entries live
+ * for DNS_CACHE_TTL. Names the resolver reports as nonexistent are kept
+ * for DNS_CACHE_NEGATIVE_TTL and answered from the cache instead of
+ * waiting for another resolver timeout; other failures are not cached.
+ * An entry used after DNS_CACHE_PREFETCH_PERCENT of its lifetime is
+ * refreshed in the background.
+ *
+ * The HTTP client connects to the cached address. The SDK websocket and
+ * cloud calls only take URLs, for them a lookup fails fast on dead names
+ * and keeps the lwIP resolver table they consult warm.
+ */
+#define DNS_CACHE_ENTRIES			16
+#define DNS_CACHE_TTL				300
+#define DNS_CACHE_NEGATIVE_TTL		30
+#define DNS_CACHE_PREFETCH_PERCENT	80
+
+artik_error dns_cache_lookup(const char *host, struct in_addr *addr);
+artik_error dns_cache_lookup_uri(const char *uri, struct in_addr *addr);
+void dns_cache_network_changed(const char *ssid);
+void dns_cache_flush(void);
+void dns_cache_dump(void);
+
+#endif /* __ARTIK_DNS_CACHE_H__ */
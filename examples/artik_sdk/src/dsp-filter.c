@@ -0,0 +1,421 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file dsp-filter.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "dsp-filter.h"
+
+/* SMLALD is part of the ARMv6 SIMD extension, also found in ARMv7-R and ARMv7E-M */
+#if defined(__ARM_FEATURE_SIMD32) || (defined(__ARM_FEATURE_DSP) && (__ARM_ARCH >= 6))
+#define DSP_HAVE_SMLALD
+#endif
+
+static q15_t dsp_saturate(int64_t value)
+{
+	if (value > DSP_Q15_MAX)
+		return DSP_Q15_MAX;
+	if (value < DSP_Q15_MIN)
+		return DSP_Q15_MIN;
+
+	return (q15_t)value;
+}
+
+/* Dot product of Q15 vectors, taps must be even on the SIMD path */
+q15_t dsp_fir_q15(const q15_t *coeffs, const q15_t *samples, int taps)
+{
+	int64_t acc = 0;
+	int k;
+
+#ifdef DSP_HAVE_SMLALD
+	int32_t c, x;
+
+	/* Two 16x16 multiplies accumulated into 64 bits per instruction */
+	for (k = 0; k < taps; k += 2) {
+		memcpy(&c, &coeffs[k], sizeof(c));
+		memcpy(&x, &samples[k], sizeof(x));
+		__asm__ ("smlald %Q0, %R0, %1, %2" : "+r" (acc) : "r" (c), "r" (x));
+	}
+#else
+	for (k = 0; k < taps; k++)
+		acc += (int32_t)coeffs[k] * samples[k];
+#endif
+
+	return dsp_saturate((acc + (1 << 14)) >> 15);
+}
+
+float dsp_fir_f32(const float *coeffs, const float *samples, int taps)
+{
+	float acc = 0.0f;
+	int k;
+
+	for (k = 0; k < taps; k++)
+		acc += coeffs[k] * samples[k];
+
+	return acc;
+}
+
+float dsp_iir_f32(float *y, float alpha, float x)
+{
+	*y += alpha * (x - *y);
+
+	return *y;
+}
+
+q15_t dsp_isqrt(uint32_t value)
+{
+	uint32_t root = 0;
+	uint32_t bit = 1UL << 30;
+
+	while (bit > value)
+		bit >>= 2;
+
+	while (bit) {
+		if (value >= root + bit) {
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	return dsp_saturate(root);
+}
+
+/* Windowed sinc, cutoff is a fraction of the sample rate below 0.5 */
+void dsp_fir_design_lowpass(float *coeffs, int taps, float cutoff)
+{
+	float sum = 0.0f;
+	float m = (float)(taps - 1) / 2;
+	float t;
+	int n;
+
+	for (n = 0; n < taps; n++) {
+		t = (float)n - m;
+		coeffs[n] = (t == 0.0f) ? 2 * cutoff : sinf(2 * M_PI * cutoff * t) / (M_PI * t);
+		if (taps > 1)
+			coeffs[n] *= 0.54f - 0.46f * cosf(2 * M_PI * n / (taps - 1));
+		sum += coeffs[n];
+	}
+
+	/* Unity gain at DC */
+	for (n = 0; n < taps; n++)
+		coeffs[n] /= sum;
+}
+
+static struct dsp_stage *dsp_add_stage(struct dsp_pipeline *p, enum dsp_stage_type type)
+{
+	struct dsp_stage *stage;
+
+	if (p->num_stages >= DSP_MAX_STAGES)
+		return NULL;
+
+	stage = &p->stages[p->num_stages++];
+	memset(stage, 0, sizeof(*stage));
+	stage->type = type;
+
+	return stage;
+}
+
+void dsp_pipeline_init(struct dsp_pipeline *p)
+{
+	memset(p, 0, sizeof(*p));
+}
+
+artik_error dsp_add_moving_avg(struct dsp_pipeline *p, int len)
+{
+	struct dsp_stage *stage;
+
+	if ((len <= 0) || (len > DSP_MAX_WINDOW))
+		return E_BAD_ARGS;
+
+	stage = dsp_add_stage(p, DSP_MOVING_AVG);
+	if (!stage)
+		return E_NO_MEM;
+
+	stage->u.avg.len = len;
+
+	return S_OK;
+}
+
+/*
+ * Cascaded integrator-comb decimator. The gain decim^order is removed by a
+ * shift, so decim must be a power of two, and it must stay below 2^16 for
+ * the integrators not to lose the signal when they wrap.
+ */
+artik_error dsp_add_cic(struct dsp_pipeline *p, int order, int decim)
+{
+	struct dsp_stage *stage;
+	int shift = 0;
+
+	if ((order <= 0) || (order > DSP_CIC_MAX_ORDER) || (decim < 2) ||
+			(decim > DSP_CIC_MAX_DECIM) || (decim & (decim - 1)))
+		return E_BAD_ARGS;
+
+	while ((1 << shift) < decim)
+		shift++;
+	if (shift * order > 16)
+		return E_BAD_ARGS;
+
+	stage = dsp_add_stage(p, DSP_CIC);
+	if (!stage)
+		return E_NO_MEM;
+
+	stage->u.cic.order = order;
+	stage->u.cic.decim = decim;
+	stage->u.cic.shift = shift * order;
+
+	return S_OK;
+}
+
+artik_error dsp_add_fir(struct dsp_pipeline *p, const q15_t *coeffs, int taps, int decim)
+{
+	struct dsp_stage *stage;
+	int padded = taps + (taps & 1);
+	int j;
+
+	if (!coeffs || (taps <= 0) || (padded > DSP_FIR_MAX_TAPS) || (decim <= 0))
+		return E_BAD_ARGS;
+
+	stage = dsp_add_stage(p, DSP_FIR);
+	if (!stage)
+		return E_NO_MEM;
+
+	/* The delay line runs oldest to newest, the padding goes on the oldest side */
+	for (j = 0; j < taps; j++)
+		stage->u.fir.coeffs[padded - 1 - j] = coeffs[j];
+	stage->u.fir.taps = padded;
+	stage->u.fir.decim = decim;
+
+	return S_OK;
+}
+
+/* Decimating low-pass FIR with its cutoff just below the new Nyquist rate */
+artik_error dsp_add_lowpass(struct dsp_pipeline *p, int taps, int decim)
+{
+	float design[DSP_FIR_MAX_TAPS];
+	q15_t coeffs[DSP_FIR_MAX_TAPS];
+	int n;
+
+	if ((taps <= 0) || (taps > DSP_FIR_MAX_TAPS) || (decim <= 0))
+		return E_BAD_ARGS;
+
+	dsp_fir_design_lowpass(design, taps, 0.45f / decim);
+	for (n = 0; n < taps; n++)
+		coeffs[n] = DSP_FLOAT_TO_Q15(design[n]);
+
+	return dsp_add_fir(p, coeffs, taps, decim);
+}
+
+/* y += alpha * (x - y), the state is kept in Q31 so that small alphas do not stall */
+artik_error dsp_add_iir(struct dsp_pipeline *p, q15_t alpha)
+{
+	struct dsp_stage *stage;
+
+	if (alpha <= 0)
+		return E_BAD_ARGS;
+
+	stage = dsp_add_stage(p, DSP_IIR);
+	if (!stage)
+		return E_NO_MEM;
+
+	stage->u.iir.alpha = alpha;
+
+	return S_OK;
+}
+
+artik_error dsp_add_stats(struct dsp_pipeline *p, int len, dsp_window_cb cb, void *user_data)
+{
+	struct dsp_stage *stage;
+
+	if ((len <= 0) || !cb)
+		return E_BAD_ARGS;
+
+	stage = dsp_add_stage(p, DSP_STATS);
+	if (!stage)
+		return E_NO_MEM;
+
+	stage->u.stats.len = len;
+	stage->u.stats.cb = cb;
+	stage->u.stats.user_data = user_data;
+
+	return S_OK;
+}
+
+/* Fires once above high, then not again until the signal has gone below low */
+artik_error dsp_add_threshold(struct dsp_pipeline *p, q15_t high, q15_t low, dsp_event_cb cb,
+		void *user_data)
+{
+	struct dsp_stage *stage;
+
+	if ((low > high) || !cb)
+		return E_BAD_ARGS;
+
+	stage = dsp_add_stage(p, DSP_THRESHOLD);
+	if (!stage)
+		return E_NO_MEM;
+
+	stage->u.threshold.high = high;
+	stage->u.threshold.low = low;
+	stage->u.threshold.cb = cb;
+	stage->u.threshold.user_data = user_data;
+
+	return S_OK;
+}
+
+/*
+ * Builds a pipeline from a comma separated list of stages:
+ * avg:<len>, cic:<order>:<decim>, fir:<taps>:<decim>, iir:<alpha>,
+ * stats:<len> and thr:<high>:<low>.
+ */
+artik_error dsp_pipeline_parse(struct dsp_pipeline *p, char *spec, dsp_window_cb window_cb,
+		dsp_event_cb event_cb, void *user_data)
+{
+	artik_error ret = S_OK;
+	char *save = NULL;
+	char *stage;
+	float alpha;
+	int a, b;
+
+	dsp_pipeline_init(p);
+
+	for (stage = strtok_r(spec, ",", &save); stage && (ret == S_OK);
+			stage = strtok_r(NULL, ",", &save)) {
+		if (sscanf(stage, "avg:%d", &a) == 1)
+			ret = dsp_add_moving_avg(p, a);
+		else if (sscanf(stage, "cic:%d:%d", &a, &b) == 2)
+			ret = dsp_add_cic(p, a, b);
+		else if (sscanf(stage, "fir:%d:%d", &a, &b) == 2)
+			ret = dsp_add_lowpass(p, a, b);
+		else if (sscanf(stage, "iir:%f", &alpha) == 1)
+			ret = dsp_add_iir(p, DSP_FLOAT_TO_Q15(alpha));
+		else if (sscanf(stage, "stats:%d", &a) == 1)
+			ret = dsp_add_stats(p, a, window_cb, user_data);
+		else if (sscanf(stage, "thr:%d:%d", &a, &b) == 2)
+			ret = dsp_add_threshold(p, dsp_saturate(a), dsp_saturate(b), event_cb,
+				user_data);
+		else
+			ret = E_BAD_ARGS;
+
+		if (ret != S_OK)
+			fprintf(stderr, "Invalid filter stage '%s'\n", stage);
+	}
+
+	return ret;
+}
+
+/* Each stage writes at most one output per input, so all of them run in place */
+static int dsp_stage_process(struct dsp_stage *s, q15_t *samples, int count)
+{
+	int64_t delta;
+	uint32_t v, t;
+	q15_t x;
+	int i, j, out = 0;
+
+	for (i = 0; i < count; i++) {
+		x = samples[i];
+
+		switch (s->type) {
+		case DSP_MOVING_AVG:
+			s->u.avg.sum += x - s->u.avg.history[s->u.avg.pos];
+			s->u.avg.history[s->u.avg.pos] = x;
+			if (++s->u.avg.pos == s->u.avg.len)
+				s->u.avg.pos = 0;
+			samples[out++] = s->u.avg.sum / s->u.avg.len;
+			break;
+		case DSP_CIC:
+			v = (uint32_t)(int32_t)x;
+			for (j = 0; j < s->u.cic.order; j++) {
+				s->u.cic.integrator[j] += v;
+				v = s->u.cic.integrator[j];
+			}
+			if (++s->u.cic.phase < s->u.cic.decim)
+				break;
+			s->u.cic.phase = 0;
+			for (j = 0; j < s->u.cic.order; j++) {
+				t = v;
+				v -= s->u.cic.comb[j];
+				s->u.cic.comb[j] = t;
+			}
+			samples[out++] = dsp_saturate((int32_t)v >> s->u.cic.shift);
+			break;
+		case DSP_FIR:
+			s->u.fir.state[s->u.fir.pos] = x;
+			s->u.fir.state[s->u.fir.pos + s->u.fir.taps] = x;
+			if (++s->u.fir.pos == s->u.fir.taps)
+				s->u.fir.pos = 0;
+			if (++s->u.fir.phase < s->u.fir.decim)
+				break;
+			s->u.fir.phase = 0;
+			samples[out++] = dsp_fir_q15(s->u.fir.coeffs, &s->u.fir.state[s->u.fir.pos],
+				s->u.fir.taps);
+			break;
+		case DSP_IIR:
+			delta = (int64_t)x * 65536 - s->u.iir.y;
+			s->u.iir.y += (q31_t)((delta * s->u.iir.alpha) >> 15);
+			samples[out++] = dsp_saturate((s->u.iir.y + (1 << 15)) >> 16);
+			break;
+		case DSP_STATS:
+			if (!s->u.stats.window.count || (x < s->u.stats.window.min))
+				s->u.stats.window.min = x;
+			if (!s->u.stats.window.count || (x > s->u.stats.window.max))
+				s->u.stats.window.max = x;
+			s->u.stats.sum_squares += (int32_t)x * x;
+			if (++s->u.stats.window.count == s->u.stats.len) {
+				s->u.stats.window.rms = dsp_isqrt(s->u.stats.sum_squares /
+					s->u.stats.len);
+				s->u.stats.cb(&s->u.stats.window, s->u.stats.user_data);
+				memset(&s->u.stats.window, 0, sizeof(s->u.stats.window));
+				s->u.stats.sum_squares = 0;
+			}
+			samples[out++] = x;
+			break;
+		case DSP_THRESHOLD:
+			if (!s->u.threshold.above && (x >= s->u.threshold.high)) {
+				s->u.threshold.above = true;
+				s->u.threshold.events++;
+				s->u.threshold.cb(true, x, s->u.threshold.user_data);
+			} else if (s->u.threshold.above && (x <= s->u.threshold.low)) {
+				s->u.threshold.above = false;
+				s->u.threshold.events++;
+				s->u.threshold.cb(false, x, s->u.threshold.user_data);
+			}
+			samples[out++] = x;
+			break;
+		}
+	}
+
+	return out;
+}
+
+/* Filters count samples in place, returns the number of samples coming out */
+int dsp_pipeline_process(struct dsp_pipeline *p, q15_t *samples, int count)
+{
+	int i;
+
+	for (i = 0; (i < p->num_stages) && count; i++)
+		count = dsp_stage_process(&p->stages[i], samples, count);
+
+	return count;
+}
@@ -0,0 +1,152 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file dsp-filter.h
+ */
+
+#ifndef __ARTIK_DSP_FILTER_H__
+#define __ARTIK_DSP_FILTER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <artik_error.h>
+
+/*
+ * Fixed-point filter pipeline for sampled data.
+ *
+ * Samples are Q15: raw 12-bit ADC values fit as they are. A pipeline is a
+ * chain of up to DSP_MAX_STAGES stages run in place over a block of
+ * samples. Decimating stages shrink the block and dsp_pipeline_process()
+ * returns how many samples are left.
+ *
+ * The FIR kernel uses the dual 16-bit multiply-accumulate instructions
+ * (SMLALD) where the core has them, as on the Cortex-R4, and plain C
+ * otherwise. Single precision versions of the FIR and IIR kernels are
+ * provided for targets with an FPU and as a reference for the fixed-point
+ * ones.
+ */
+#define DSP_MAX_STAGES		6
+#define DSP_MAX_WINDOW		64
+#define DSP_FIR_MAX_TAPS	32
+#define DSP_CIC_MAX_ORDER	3
+#define DSP_CIC_MAX_DECIM	64
+
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+
+#define DSP_Q15_MAX		32767
+#define DSP_Q15_MIN		-32768
+#define DSP_FLOAT_TO_Q15(x)	((q15_t)((x) >= 1.0f ? DSP_Q15_MAX : \
+					(x) <= -1.0f ? DSP_Q15_MIN : (x) * 32768.0f))
+
+enum dsp_stage_type {
+	DSP_MOVING_AVG,
+	DSP_CIC,
+	DSP_FIR,
+	DSP_IIR,
+	DSP_STATS,
+	DSP_THRESHOLD
+};
+
+struct dsp_window {
+	q15_t min;
+	q15_t max;
+	q15_t rms;
+	unsigned int count;
+};
+
+/* Called at the end of each window of a DSP_STATS stage */
+typedef void (*dsp_window_cb)(const struct dsp_window *window, void *user_data);
+/* Called when a DSP_THRESHOLD stage crosses its high or low threshold */
+typedef void (*dsp_event_cb)(bool above, q15_t value, void *user_data);
+
+struct dsp_stage {
+	enum dsp_stage_type type;
+	union {
+		struct {
+			q15_t history[DSP_MAX_WINDOW];
+			int32_t sum;
+			int len;
+			int pos;
+		} avg;
+		struct {
+			uint32_t integrator[DSP_CIC_MAX_ORDER];
+			uint32_t comb[DSP_CIC_MAX_ORDER];
+			int order;
+			int decim;
+			int shift;
+			int phase;
+		} cic;
+		struct {
+			/* Reversed and padded to an even count for the dual MAC */
+			q15_t coeffs[DSP_FIR_MAX_TAPS];
+			q15_t state[2 * DSP_FIR_MAX_TAPS];
+			int taps;
+			int decim;
+			int pos;
+			int phase;
+		} fir;
+		struct {
+			q15_t alpha;
+			q31_t y;
+		} iir;
+		struct {
+			struct dsp_window window;
+			int64_t sum_squares;
+			unsigned int len;
+			dsp_window_cb cb;
+			void *user_data;
+		} stats;
+		struct {
+			q15_t high;
+			q15_t low;
+			bool above;
+			unsigned int events;
+			dsp_event_cb cb;
+			void *user_data;
+		} threshold;
+	} u;
+};
+
+struct dsp_pipeline {
+	struct dsp_stage stages[DSP_MAX_STAGES];
+	int num_stages;
+};
+
+void dsp_pipeline_init(struct dsp_pipeline *p);
+artik_error dsp_add_moving_avg(struct dsp_pipeline *p, int len);
+artik_error dsp_add_cic(struct dsp_pipeline *p, int order, int decim);
+artik_error dsp_add_fir(struct dsp_pipeline *p, const q15_t *coeffs, int taps, int decim);
+artik_error dsp_add_lowpass(struct dsp_pipeline *p, int taps, int decim);
+artik_error dsp_add_iir(struct dsp_pipeline *p, q15_t alpha);
+artik_error dsp_add_stats(struct dsp_pipeline *p, int len, dsp_window_cb cb, void *user_data);
+artik_error dsp_add_threshold(struct dsp_pipeline *p, q15_t high, q15_t low, dsp_event_cb cb,
+		void *user_data);
+artik_error dsp_pipeline_parse(struct dsp_pipeline *p, char *spec, dsp_window_cb window_cb,
+		dsp_event_cb event_cb, void *user_data);
+int dsp_pipeline_process(struct dsp_pipeline *p, q15_t *samples, int count);
+
+void dsp_fir_design_lowpass(float *coeffs, int taps, float cutoff);
+q15_t dsp_fir_q15(const q15_t *coeffs, const q15_t *samples, int taps);
+float dsp_fir_f32(const float *coeffs, const float *samples, int taps);
+float dsp_iir_f32(float *y, float alpha, float x);
+q15_t dsp_isqrt(uint32_t value);
+
+#endif /* __ARTIK_DSP_FILTER_H__ */
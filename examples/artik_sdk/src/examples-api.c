@@ -10,6 +10,8 @@ extern int http_main(int argc, char *argv[]);
 extern int wifi_main(int argc, char *argv[]);
 extern int websocket_main(int argc, char *argv[]);
 extern int see_main(int argc, char *argv[]);
+extern int dns_main(int argc, char *argv[]);
+extern int sensor_main(int argc, char *argv[]);
 
 static tash_cmdlist_t atk_cmds[] = {
     {"sdk", sdk_main, TASH_EXECMD_SYNC},
@@ -21,6 +23,8 @@ static tash_cmdlist_t atk_cmds[] = {
     {"wifi", wifi_main, TASH_EXECMD_SYNC},
     {"websocket", websocket_main, TASH_EXECMD_SYNC},
     {"see", see_main, TASH_EXECMD_SYNC},
+    {"dns", dns_main, TASH_EXECMD_SYNC},
+    {"sensor", sensor_main, TASH_EXECMD_SYNC},
     {NULL, NULL, 0}
 };
 
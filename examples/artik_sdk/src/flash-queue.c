@@ -0,0 +1,603 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file flash-queue.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include "flash-queue.h"
+#include "inflate.h"
+#include "perf-stats.h"
+
+#define SECTOR_MAGIC		0x51484c46
+#define RECORD_MAGIC		0xa5
+#define RECORD_PENDING		0xff
+#define RECORD_CONSUMED		0x00
+#define FLASH_ERASED		0xff
+
+#define FLASH_QUEUE_TICK_MS		100
+#define FLASH_QUEUE_STACK_SIZE	4096
+
+#define ALIGN4(x)			(((x) + 3) & ~3)
+
+struct sector_header {
+	uint32_t magic;
+	uint32_t seq;
+};
+
+struct record_header {
+	uint8_t magic;
+	uint8_t flags;
+	uint16_t len;
+	uint32_t crc;
+};
+
+#define SECTOR_DATA			sizeof(struct sector_header)
+#define RECORD_HEADER		sizeof(struct record_header)
+
+static int flash_read(struct flash_queue *q, int sector, unsigned int off, void *buf,
+		unsigned int len)
+{
+	off_t pos = (off_t)sector * FLASH_QUEUE_SECTOR_SIZE + off;
+
+	return (pread(q->fd, buf, len, pos) == (ssize_t)len) ? 0 : -1;
+}
+
+static int flash_write(struct flash_queue *q, int sector, unsigned int off, const void *buf,
+		unsigned int len)
+{
+	off_t pos = (off_t)sector * FLASH_QUEUE_SECTOR_SIZE + off;
+
+	return (pwrite(q->fd, buf, len, pos) == (ssize_t)len) ? 0 : -1;
+}
+
+static int flash_erase(struct flash_queue *q, int sector)
+{
+	uint8_t erased[256];
+	unsigned int off;
+
+	memset(erased, FLASH_ERASED, sizeof(erased));
+	for (off = 0; off < FLASH_QUEUE_SECTOR_SIZE; off += sizeof(erased)) {
+		if (flash_write(q, sector, off, erased, sizeof(erased)) < 0)
+			return -1;
+	}
+
+	q->sector_seq[sector] = 0;
+	q->stats.erases++;
+
+	return 0;
+}
+
+static int sector_format(struct flash_queue *q, int sector)
+{
+	struct sector_header hdr = { SECTOR_MAGIC, q->seq + 1 };
+
+	if ((flash_erase(q, sector) < 0) ||
+			(flash_write(q, sector, 0, &hdr, sizeof(hdr)) < 0))
+		return -1;
+
+	q->seq++;
+	q->sector_seq[sector] = q->seq;
+
+	return 0;
+}
+
+/*
+ * Reads the record at off into q->record. Returns its size in the log, 0
+ * at the end of the sector's log. *valid is false if its CRC is wrong.
+ */
+static unsigned int record_scan(struct flash_queue *q, int sector, unsigned int off,
+		struct record_header *hdr, bool *valid)
+{
+	if ((off + RECORD_HEADER > FLASH_QUEUE_SECTOR_SIZE) ||
+			(flash_read(q, sector, off, hdr, sizeof(*hdr)) < 0))
+		return 0;
+
+	if ((hdr->magic != RECORD_MAGIC) || !hdr->len || (hdr->len > FLASH_QUEUE_RECORD_MAX) ||
+			(off + RECORD_HEADER + hdr->len > FLASH_QUEUE_SECTOR_SIZE))
+		return 0;
+
+	*valid = !flash_read(q, sector, off + RECORD_HEADER, q->record, hdr->len) &&
+		(inflate_crc32(0, q->record, hdr->len) == hdr->crc);
+
+	return ALIGN4(RECORD_HEADER + hdr->len);
+}
+
+static unsigned int sector_pending(struct flash_queue *q, int sector, unsigned int off,
+		unsigned int end, bool *found, unsigned int *first)
+{
+	struct record_header hdr;
+	unsigned int size, count = 0;
+	bool valid;
+
+	while (off < end) {
+		size = record_scan(q, sector, off, &hdr, &valid);
+		if (!size)
+			break;
+
+		if (valid && (hdr.flags == RECORD_PENDING)) {
+			if (found && !*found) {
+				*found = true;
+				*first = off;
+			}
+			count++;
+		}
+		off += size;
+	}
+
+	return count;
+}
+
+/* Rebuilds the log state from the sectors found in the backing store */
+static int queue_mount(struct flash_queue *q)
+{
+	struct sector_header hdr;
+	struct record_header rec;
+	unsigned int off, size, first = 0;
+	bool found = false, valid;
+	int s, i;
+
+	q->write_sector = -1;
+	for (s = 0; s < FLASH_QUEUE_SECTORS; s++) {
+		q->sector_seq[s] = 0;
+		if ((flash_read(q, s, 0, &hdr, sizeof(hdr)) == 0) && (hdr.magic == SECTOR_MAGIC)) {
+			q->sector_seq[s] = hdr.seq;
+			if ((q->write_sector < 0) || (hdr.seq > q->seq)) {
+				q->seq = hdr.seq;
+				q->write_sector = s;
+			}
+		}
+	}
+
+	if (q->write_sector < 0) {
+		q->write_sector = 0;
+		if (sector_format(q, 0) < 0)
+			return -1;
+		q->write_off = SECTOR_DATA;
+		q->read_sector = 0;
+		q->read_off = SECTOR_DATA;
+		return 0;
+	}
+
+	off = SECTOR_DATA;
+	while ((size = record_scan(q, q->write_sector, off, &rec, &valid)) > 0)
+		off += size;
+
+	/* Garbage left by an interrupted write cannot be written over */
+	if ((off + RECORD_HEADER <= FLASH_QUEUE_SECTOR_SIZE) &&
+			((flash_read(q, q->write_sector, off, &rec, sizeof(rec)) < 0) ||
+			 (rec.magic != FLASH_ERASED)))
+		off = FLASH_QUEUE_SECTOR_SIZE;
+	q->write_off = off;
+
+	/* Sectors are used round robin, the oldest one follows the newest */
+	q->pending = 0;
+	for (i = 1; i <= FLASH_QUEUE_SECTORS; i++) {
+		s = (q->write_sector + i) % FLASH_QUEUE_SECTORS;
+		if (!q->sector_seq[s])
+			continue;
+
+		q->pending += sector_pending(q, s, SECTOR_DATA,
+			(s == q->write_sector) ? q->write_off : FLASH_QUEUE_SECTOR_SIZE, &found, &first);
+		if (found && !q->read_off) {
+			q->read_sector = s;
+			q->read_off = first;
+		}
+	}
+
+	if (!q->pending) {
+		q->read_sector = q->write_sector;
+		q->read_off = q->write_off;
+	}
+
+	return 0;
+}
+
+/* Moves the log to the next sector, dropping its records if still pending */
+static int queue_rotate(struct flash_queue *q)
+{
+	int next = (q->write_sector + 1) % FLASH_QUEUE_SECTORS;
+	unsigned int dropped;
+
+	if (q->pending && (q->read_sector == next)) {
+		dropped = sector_pending(q, next, q->read_off, FLASH_QUEUE_SECTOR_SIZE, NULL, NULL);
+		q->pending -= dropped;
+		q->stats.dropped += dropped;
+		q->read_sector = (next + 1) % FLASH_QUEUE_SECTORS;
+		q->read_off = SECTOR_DATA;
+		q->generation++;
+	}
+
+	if (sector_format(q, next) < 0)
+		return -1;
+
+	q->write_sector = next;
+	q->write_off = SECTOR_DATA;
+
+	if (!q->pending) {
+		q->read_sector = q->write_sector;
+		q->read_off = q->write_off;
+	}
+
+	return 0;
+}
+
+/* Record data is expected at q->staged + RECORD_HEADER */
+static int queue_write(struct flash_queue *q, unsigned int len)
+{
+	struct record_header hdr;
+	unsigned int size = ALIGN4(RECORD_HEADER + len);
+
+	if ((q->write_off + size > FLASH_QUEUE_SECTOR_SIZE) && (queue_rotate(q) < 0))
+		return -1;
+
+	hdr.magic = RECORD_MAGIC;
+	hdr.flags = RECORD_PENDING;
+	hdr.len = len;
+	hdr.crc = inflate_crc32(0, q->staged + RECORD_HEADER, len);
+	memcpy(q->staged, &hdr, sizeof(hdr));
+	memset(q->staged + RECORD_HEADER + len, FLASH_ERASED, size - RECORD_HEADER - len);
+
+	if (flash_write(q, q->write_sector, q->write_off, q->staged, size) < 0) {
+		/* Never write over a partially programmed record */
+		q->write_off = FLASH_QUEUE_SECTOR_SIZE;
+		return -1;
+	}
+
+	q->write_off += size;
+	q->pending++;
+	q->stats.written++;
+
+	return 0;
+}
+
+/* Loads the next pending record in q->record, returns its size in the log */
+static unsigned int queue_peek(struct flash_queue *q, unsigned int *len)
+{
+	struct record_header hdr;
+	unsigned int size;
+	bool valid;
+
+	while (q->pending) {
+		if ((q->read_sector == q->write_sector) && (q->read_off >= q->write_off))
+			break;
+
+		size = record_scan(q, q->read_sector, q->read_off, &hdr, &valid);
+		if (!size) {
+			if (q->read_sector == q->write_sector)
+				break;
+			q->read_sector = (q->read_sector + 1) % FLASH_QUEUE_SECTORS;
+			q->read_off = SECTOR_DATA;
+			continue;
+		}
+
+		if (valid && (hdr.flags == RECORD_PENDING)) {
+			*len = hdr.len;
+			return size;
+		}
+
+		if (!valid && (hdr.flags == RECORD_PENDING))
+			q->stats.corrupted++;
+		q->read_off += size;
+	}
+
+	return 0;
+}
+
+static void queue_consume(struct flash_queue *q, unsigned int size)
+{
+	uint8_t flags = RECORD_CONSUMED;
+
+	flash_write(q, q->read_sector, q->read_off + 1, &flags, sizeof(flags));
+	q->read_off += size;
+	q->pending--;
+	q->stats.drained++;
+}
+
+static void stage_copy_out(struct flash_queue *q, unsigned int offset, void *data,
+		unsigned int len)
+{
+	unsigned int pos = (q->stage_head + offset) % FLASH_QUEUE_STAGE_SIZE;
+	unsigned int first = FLASH_QUEUE_STAGE_SIZE - pos;
+
+	if (first > len)
+		first = len;
+
+	memcpy(data, q->stage + pos, first);
+	memcpy((uint8_t *)data + first, q->stage, len - first);
+}
+
+static void stage_copy_in(struct flash_queue *q, const void *data, unsigned int len)
+{
+	unsigned int first = FLASH_QUEUE_STAGE_SIZE - q->stage_tail;
+
+	if (first > len)
+		first = len;
+
+	memcpy(q->stage + q->stage_tail, data, first);
+	memcpy(q->stage, (const uint8_t *)data + first, len - first);
+	q->stage_tail = (q->stage_tail + len) % FLASH_QUEUE_STAGE_SIZE;
+	q->stage_used += len;
+}
+
+/*
+ * Copies the oldest staged message into q->staged and returns its length,
+ * or 0. It stays staged until stage_drop(), only the worker removes it.
+ */
+static unsigned int stage_peek(struct flash_queue *q)
+{
+	uint16_t len = 0;
+
+	pthread_mutex_lock(&q->stage_lock);
+	if (q->stage_used) {
+		stage_copy_out(q, 0, &len, sizeof(len));
+		stage_copy_out(q, sizeof(len), q->staged + RECORD_HEADER, len);
+	}
+	pthread_mutex_unlock(&q->stage_lock);
+
+	return len;
+}
+
+static void stage_drop(struct flash_queue *q, unsigned int len)
+{
+	pthread_mutex_lock(&q->stage_lock);
+	q->stage_head = (q->stage_head + sizeof(uint16_t) + len) % FLASH_QUEUE_STAGE_SIZE;
+	q->stage_used -= sizeof(uint16_t) + len;
+	pthread_mutex_unlock(&q->stage_lock);
+}
+
+static void queue_drain(struct flash_queue *q)
+{
+	unsigned int i, len, size;
+	uint32_t generation;
+	artik_error err;
+
+	for (i = 0; i < q->batch; i++) {
+		pthread_mutex_lock(&q->lock);
+		size = queue_peek(q, &len);
+		generation = q->generation;
+		pthread_mutex_unlock(&q->lock);
+
+		if (!size)
+			break;
+
+		q->record[len] = '\0';
+		err = q->sink((const char *)q->record, len, q->user_data);
+
+		pthread_mutex_lock(&q->lock);
+		if (err != S_OK) {
+			q->stats.sink_errors++;
+			pthread_mutex_unlock(&q->lock);
+			break;
+		}
+		/* The record may have been dropped or cleared while it was sent */
+		if (generation == q->generation)
+			queue_consume(q, size);
+		pthread_mutex_unlock(&q->lock);
+	}
+}
+
+static pthread_addr_t flash_queue_thread(pthread_addr_t arg)
+{
+	struct flash_queue *q = (struct flash_queue *)arg;
+	struct timespec timeout;
+	unsigned int len;
+	uint64_t now;
+	int ret;
+
+	while (q->running) {
+		clock_gettime(CLOCK_REALTIME, &timeout);
+		timeout.tv_nsec += FLASH_QUEUE_TICK_MS * 1000000;
+		if (timeout.tv_nsec >= 1000000000) {
+			timeout.tv_sec++;
+			timeout.tv_nsec -= 1000000000;
+		}
+		sem_timedwait(&q->wake, &timeout);
+
+		/* A record that fails to reach flash stays staged for the next tick */
+		while ((len = stage_peek(q)) > 0) {
+			pthread_mutex_lock(&q->lock);
+			ret = queue_write(q, len);
+			if (ret < 0)
+				q->stats.write_errors++;
+			pthread_mutex_unlock(&q->lock);
+
+			if (ret < 0)
+				break;
+			stage_drop(q, len);
+		}
+
+		now = perf_now_us();
+		if (q->draining && q->sink && (now >= q->next_drain_us)) {
+			queue_drain(q);
+			q->next_drain_us = now + 1000000ULL * q->batch / q->rate;
+		}
+	}
+
+	return NULL;
+}
+
+artik_error flash_queue_open(struct flash_queue *q, const char *path)
+{
+	pthread_attr_t attr;
+	off_t size;
+	int s;
+
+	memset(q, 0, sizeof(struct flash_queue));
+
+	q->fd = open(path, O_RDWR | O_CREAT, 0666);
+	if (q->fd < 0)
+		return E_ACCESS_DENIED;
+
+	/* A new or short backing file is brought to full size, erased */
+	size = lseek(q->fd, 0, SEEK_END);
+	for (s = 0; s < FLASH_QUEUE_SECTORS; s++) {
+		if ((off_t)(s + 1) * FLASH_QUEUE_SECTOR_SIZE > size)
+			flash_erase(q, s);
+	}
+
+	if (queue_mount(q) < 0) {
+		close(q->fd);
+		return E_ACCESS_DENIED;
+	}
+
+	pthread_mutex_init(&q->lock, NULL);
+	pthread_mutex_init(&q->stage_lock, NULL);
+	sem_init(&q->wake, 0, 0);
+	q->running = true;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, FLASH_QUEUE_STACK_SIZE);
+	if (pthread_create(&q->thread, &attr, flash_queue_thread, q) != 0) {
+		pthread_attr_destroy(&attr);
+		q->running = false;
+		flash_queue_close(q);
+		return E_NO_MEM;
+	}
+	pthread_attr_destroy(&attr);
+
+	return S_OK;
+}
+
+void flash_queue_close(struct flash_queue *q)
+{
+	if (q->running) {
+		q->running = false;
+		sem_post(&q->wake);
+		pthread_join(q->thread, NULL);
+	}
+
+	pthread_mutex_destroy(&q->lock);
+	pthread_mutex_destroy(&q->stage_lock);
+	sem_destroy(&q->wake);
+	close(q->fd);
+	q->fd = -1;
+}
+
+/* Never waits for the flash, fails with E_BUSY if the staging area is full */
+artik_error flash_queue_append(struct flash_queue *q, const char *data, unsigned int len)
+{
+	uint16_t rec_len = len;
+
+	if (!len || (len > FLASH_QUEUE_RECORD_MAX))
+		return E_BAD_ARGS;
+
+	pthread_mutex_lock(&q->stage_lock);
+	if (q->stage_used + sizeof(rec_len) + len > FLASH_QUEUE_STAGE_SIZE) {
+		q->stats.rejected++;
+		pthread_mutex_unlock(&q->stage_lock);
+		return E_BUSY;
+	}
+
+	stage_copy_in(q, &rec_len, sizeof(rec_len));
+	stage_copy_in(q, data, len);
+	q->stats.appended++;
+	pthread_mutex_unlock(&q->stage_lock);
+
+	sem_post(&q->wake);
+
+	return S_OK;
+}
+
+void flash_queue_drain(struct flash_queue *q, flash_queue_sink sink, void *user_data,
+		unsigned int rate, unsigned int batch)
+{
+	pthread_mutex_lock(&q->lock);
+	q->sink = sink;
+	q->user_data = user_data;
+	q->rate = rate ? rate : 1;
+	q->batch = batch ? batch : 1;
+	q->next_drain_us = 0;
+	q->draining = true;
+	pthread_mutex_unlock(&q->lock);
+
+	sem_post(&q->wake);
+}
+
+void flash_queue_stop_drain(struct flash_queue *q)
+{
+	pthread_mutex_lock(&q->lock);
+	q->draining = false;
+	pthread_mutex_unlock(&q->lock);
+}
+
+/* Drops every stored record, the next sector in the rotation starts the log */
+artik_error flash_queue_clear(struct flash_queue *q)
+{
+	int next, s;
+
+	pthread_mutex_lock(&q->lock);
+	next = (q->write_sector + 1) % FLASH_QUEUE_SECTORS;
+	for (s = 0; s < FLASH_QUEUE_SECTORS; s++) {
+		if (q->sector_seq[s] && (s != next))
+			flash_erase(q, s);
+	}
+
+	q->pending = 0;
+	q->generation++;
+	if (queue_rotate(q) < 0) {
+		pthread_mutex_unlock(&q->lock);
+		return E_ACCESS_DENIED;
+	}
+	pthread_mutex_unlock(&q->lock);
+
+	return S_OK;
+}
+
+/* True when nothing is stored or waiting to be written */
+bool flash_queue_empty(struct flash_queue *q)
+{
+	bool empty;
+
+	pthread_mutex_lock(&q->lock);
+	pthread_mutex_lock(&q->stage_lock);
+	empty = !q->pending && !q->stage_used;
+	pthread_mutex_unlock(&q->stage_lock);
+	pthread_mutex_unlock(&q->lock);
+
+	return empty;
+}
+
+void flash_queue_dump(struct flash_queue *q)
+{
+	int s, used = 0;
+
+	pthread_mutex_lock(&q->lock);
+	pthread_mutex_lock(&q->stage_lock);
+	for (s = 0; s < FLASH_QUEUE_SECTORS; s++) {
+		if (q->sector_seq[s])
+			used++;
+	}
+
+	fprintf(stdout, "%u records pending, %u bytes staged, %d/%d sectors in use%s\n",
+		q->pending, q->stage_used, used, FLASH_QUEUE_SECTORS,
+		q->draining ? ", draining" : "");
+	fprintf(stdout, "appended %u rejected %u written %u write errors %u drained %u\n",
+		q->stats.appended, q->stats.rejected, q->stats.written, q->stats.write_errors,
+		q->stats.drained);
+	fprintf(stdout, "dropped %u corrupted %u erases %u sink errors %u\n",
+		q->stats.dropped, q->stats.corrupted, q->stats.erases, q->stats.sink_errors);
+	pthread_mutex_unlock(&q->stage_lock);
+	pthread_mutex_unlock(&q->lock);
+}
@@ -0,0 +1,122 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file flash-queue.h
+ */
+
+#ifndef __ARTIK_FLASH_QUEUE_H__
+#define __ARTIK_FLASH_QUEUE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <artik_error.h>
+
+/*
+ * Persistent store-and-forward queue for messages that could not be sent.
+ *
+ * The backing store is a plain file, FLASH_QUEUE_PATH on the /mnt file
+ * system by default, not a raw MTD partition: the flash rules below are
+ * only followed on top of the file system. It is split into
+ * FLASH_QUEUE_SECTORS sectors written as a log: records are only ever
+ * appended, sectors are used round robin so that erases are spread evenly,
+ * and a consumed record is marked by clearing its flags byte, which flash
+ * allows without an erase. When the log is full the oldest sector is
+ * erased and the records still pending in it are dropped. Each record
+ * carries a CRC32 so that a write cut by a reset is ignored at the next
+ * mount. The same code runs on a host against a regular file, which is
+ * how the unit tests exercise it.
+ *
+ * flash_queue_append() only copies the message to a RAM staging area; a
+ * worker task writes it to flash, so producers never wait for the flash.
+ * A message whose write fails stays staged and is retried on the next
+ * tick; producers get E_BUSY once the staging area is full.
+ * The same task drains the queue to the sink set by flash_queue_drain()
+ * at no more than rate records per second, batch records at a time,
+ * until the sink fails or the queue is empty.
+ */
+#ifndef FLASH_QUEUE_PATH
+#define FLASH_QUEUE_PATH			"/mnt/cloud-queue"
+#endif
+#define FLASH_QUEUE_SECTOR_SIZE		4096
+#define FLASH_QUEUE_SECTORS			8
+#define FLASH_QUEUE_RECORD_MAX		1024
+#define FLASH_QUEUE_STAGE_SIZE		2048
+
+typedef artik_error (*flash_queue_sink)(const char *data, unsigned int len, void *user_data);
+
+struct flash_queue_stats {
+	unsigned int appended;
+	unsigned int rejected;
+	unsigned int written;
+	unsigned int write_errors;
+	unsigned int drained;
+	unsigned int dropped;
+	unsigned int corrupted;
+	unsigned int erases;
+	unsigned int sink_errors;
+};
+
+struct flash_queue {
+	int fd;
+	uint32_t seq;
+	uint32_t sector_seq[FLASH_QUEUE_SECTORS];
+	int write_sector;
+	unsigned int write_off;
+	int read_sector;
+	unsigned int read_off;
+	unsigned int pending;
+
+	uint8_t stage[FLASH_QUEUE_STAGE_SIZE];
+	unsigned int stage_head;
+	unsigned int stage_tail;
+	unsigned int stage_used;
+
+	flash_queue_sink sink;
+	void *user_data;
+	unsigned int rate;
+	unsigned int batch;
+	bool draining;
+	uint64_t next_drain_us;
+	uint32_t generation;
+
+	bool running;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_mutex_t stage_lock;
+	sem_t wake;
+
+	struct flash_queue_stats stats;
+	uint8_t staged[FLASH_QUEUE_RECORD_MAX + 8];
+	uint8_t record[FLASH_QUEUE_RECORD_MAX + 1];
+};
+
+artik_error flash_queue_open(struct flash_queue *q, const char *path);
+void flash_queue_close(struct flash_queue *q);
+artik_error flash_queue_append(struct flash_queue *q, const char *data, unsigned int len);
+void flash_queue_drain(struct flash_queue *q, flash_queue_sink sink, void *user_data,
+		unsigned int rate, unsigned int batch);
+void flash_queue_stop_drain(struct flash_queue *q);
+artik_error flash_queue_clear(struct flash_queue *q);
+bool flash_queue_empty(struct flash_queue *q);
+void flash_queue_dump(struct flash_queue *q);
+
+#endif /* __ARTIK_FLASH_QUEUE_H__ */
@@ -21,6 +21,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <shell/tash.h>
 
@@ -28,62 +29,63 @@
 #include <artik_gpio.h>
 
 #include "command.h"
+#include "gpio-cache.h"
+#include "gpio-group.h"
+#include "gpio-watch.h"
+#include "perf-stats.h"
+
+#define GPIO_WATCH_SECONDS	10
 
 static int gpio_read(int argc, char *argv[]);
 static int gpio_write(int argc, char *argv[]);
+static int gpio_readmask(int argc, char *argv[]);
+static int gpio_writemask(int argc, char *argv[]);
+static int gpio_watch(int argc, char *argv[]);
+static int gpio_toggle(int argc, char *argv[]);
+static int gpio_release(int argc, char *argv[]);
 
 const struct command gpio_commands[] = {
 	{ "read", "read <num>", gpio_read },
 	{ "write", "write <num> <0|1>", gpio_write },
+	{ "readmask", "readmask <num>[,<num>...] [<count>]", gpio_readmask },
+	{ "writemask", "writemask <num>[,<num>...] <value> [<count>] - Alternates value and ~value",
+		gpio_writemask },
+	{ "watch", "watch <num> <rising|falling|both> [<seconds> <debounce ms>]", gpio_watch },
+	{ "toggle", "toggle <num> <count> - Toggle rate with and without a cached handle",
+		gpio_toggle },
+	{ "release", "release [<num>] - Release pins kept open by read and write", gpio_release },
 	{ "", "", NULL}
 };
 
 static int gpio_io(artik_gpio_dir_t dir, artik_gpio_id id, int new_value)
 {
 	artik_gpio_module *gpio;
-	artik_gpio_config config;
 	artik_gpio_handle handle;
-	char name[16] = "";
 	int ret = 0;
 
-	gpio = (artik_gpio_module *)artik_request_api_module("gpio");
-	if (!gpio) {
-		fprintf(stderr, "GPIO module is not available\n");
+	/* The pin stays requested for the next command, see 'gpio release' */
+	if (gpio_cache_get(id, dir, &gpio, &handle) != S_OK) {
+		fprintf(stderr, "Failed to request GPIO %d\n", id);
 		return -1;
 	}
 
-	memset(&config, 0, sizeof(config));
-	config.dir = dir;
-	config.id = id;
-	snprintf(name, 16, "gpio%d", config.id);
-	config.name = name;
-
-	if (gpio->request(&handle, &config) != S_OK) {
-		fprintf(stderr, "Failed to request GPIO %d\n", config.id);
-		ret = -1;
-		goto exit;
-	}
-
 	if (dir == GPIO_IN) {
 		ret = gpio->write(handle, new_value);
 		if (ret != S_OK) {
-			fprintf(stderr, "Failed to write GPIO %d [err %d]\n", config.id, ret);
+			fprintf(stderr, "Failed to write GPIO %d [err %d]\n", id, ret);
 		} else {
-			fprintf(stdout, "Write %d to GPIO %d\n", new_value, config.id);
+			fprintf(stdout, "Write %d to GPIO %d\n", new_value, id);
 		}
 	} else {
 		ret = gpio->read(handle);
 		if (ret < 0) {
-			fprintf(stderr, "Failed to read GPIO %d [err %d]\n", config.id, ret);
+			fprintf(stderr, "Failed to read GPIO %d [err %d]\n", id, ret);
 		} else {
-			fprintf(stdout, "The value read in GPIO %d is %d\n", config.id, ret);
+			fprintf(stdout, "The value read in GPIO %d is %d\n", id, ret);
 		}
 	}
+	gpio_cache_put(handle);
 
-	gpio->release(handle);
-
-exit:
-	artik_release_api_module(gpio);
 	return ret;
 }
 
@@ -107,6 +109,272 @@ static int gpio_write(int argc, char *argv[])
 	return gpio_io(GPIO_IN, atoi(argv[3]), atoi(argv[4]));
 }
 
+/* Parses a comma separated pin list, bit 0 of the masks is the first pin */
+static int gpio_parse_pins(char *list, artik_gpio_id *ids)
+{
+	int num = 0;
+	char *pin;
+
+	for (pin = strtok(list, ","); pin && (num < GPIO_GROUP_MAX_PINS); pin = strtok(NULL, ",")) {
+		ids[num] = atoi(pin);
+		gpio_cache_release(ids[num++]);
+	}
+
+	return num;
+}
+
+static int gpio_readmask(int argc, char *argv[])
+{
+	struct gpio_group group;
+	artik_gpio_id ids[GPIO_GROUP_MAX_PINS];
+	uint32_t value = 0;
+	int num, count = 1;
+	int i, ret = 0;
+
+	if (argc < 4) {
+		usage(argv[1], gpio_commands);
+		return -1;
+	}
+
+	num = gpio_parse_pins(argv[3], ids);
+	if (argc > 4)
+		count = atoi(argv[4]);
+	if (count < 1)
+		count = 1;
+
+	/* Same direction as gpio_read() */
+	if (gpio_group_open(&group, ids, num, GPIO_OUT) != S_OK) {
+		fprintf(stderr, "Failed to open GPIO group\n");
+		return -1;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (gpio_group_read(&group, &value) != S_OK) {
+			fprintf(stderr, "Failed to read GPIO group\n");
+			ret = -1;
+			break;
+		}
+		fprintf(stdout, "0x%04x\n", value);
+	}
+
+	gpio_group_report(&group);
+	gpio_group_close(&group);
+
+	return ret;
+}
+
+static int gpio_writemask(int argc, char *argv[])
+{
+	struct gpio_group group;
+	artik_gpio_id ids[GPIO_GROUP_MAX_PINS];
+	uint32_t value, all;
+	int num, count = 1;
+	int i, ret = 0;
+
+	if (argc < 5) {
+		usage(argv[1], gpio_commands);
+		return -1;
+	}
+
+	num = gpio_parse_pins(argv[3], ids);
+	value = strtoul(argv[4], NULL, 0);
+	if (argc > 5)
+		count = atoi(argv[5]);
+	if (count < 1)
+		count = 1;
+
+	/* Same direction as gpio_write() */
+	if (gpio_group_open(&group, ids, num, GPIO_IN) != S_OK) {
+		fprintf(stderr, "Failed to open GPIO group\n");
+		return -1;
+	}
+
+	all = (1UL << num) - 1;
+	for (i = 0; i < count; i++) {
+		if (gpio_group_write(&group, (i & 1) ? ~value : value, all) != S_OK) {
+			fprintf(stderr, "Failed to write GPIO group\n");
+			ret = -1;
+			break;
+		}
+	}
+
+	fprintf(stdout, "Wrote 0x%04x to %d pins\n", ((count & 1) ? value : ~value) & all, num);
+	gpio_group_report(&group);
+	gpio_group_close(&group);
+
+	return ret;
+}
+
+static int gpio_watch(int argc, char *argv[])
+{
+	struct gpio_watch *watch = NULL;
+	struct gpio_event event;
+	artik_gpio_edge_t edge;
+	int seconds = GPIO_WATCH_SECONDS;
+	int debounce = GPIO_WATCH_DEBOUNCE_MS;
+	uint64_t deadline, now;
+	artik_error err;
+	int ret = 0;
+
+	if (argc < 5) {
+		usage(argv[1], gpio_commands);
+		return -1;
+	}
+
+	if (!strcmp(argv[4], "rising")) {
+		edge = GPIO_EDGE_RISING;
+	} else if (!strcmp(argv[4], "falling")) {
+		edge = GPIO_EDGE_FALLING;
+	} else if (!strcmp(argv[4], "both")) {
+		edge = GPIO_EDGE_BOTH;
+	} else {
+		usage(argv[1], gpio_commands);
+		return -1;
+	}
+
+	if (argc > 5)
+		seconds = atoi(argv[5]);
+	if (argc > 6)
+		debounce = atoi(argv[6]);
+	if ((seconds <= 0) || (debounce < 0)) {
+		fprintf(stderr, "Invalid duration or debounce time\n");
+		return -1;
+	}
+
+	watch = malloc(sizeof(struct gpio_watch));
+	if (!watch) {
+		fprintf(stderr, "Failed to allocate GPIO watch\n");
+		return -1;
+	}
+
+	gpio_cache_release(atoi(argv[3]));
+	err = gpio_watch_start(watch, atoi(argv[3]), edge, debounce);
+	if (err != S_OK) {
+		fprintf(stderr, "Failed to watch GPIO %s [err %d]\n", argv[3], err);
+		ret = -1;
+		goto exit;
+	}
+
+	/* Sleeps until an edge comes, nothing is polled */
+	deadline = perf_now_us() + (uint64_t)seconds * 1000000;
+	while ((now = perf_now_us()) < deadline) {
+		if (gpio_watch_wait(watch, &event, (deadline - now) / 1000) != S_OK)
+			continue;
+		fprintf(stdout, "%llu.%06llu GPIO %d %s\n",
+			(unsigned long long)(event.time_us - watch->start_us) / 1000000,
+			(unsigned long long)(event.time_us - watch->start_us) % 1000000,
+			event.id, event.value ? "rising" : "falling");
+	}
+
+	gpio_watch_stop(watch);
+	gpio_watch_report(watch);
+
+exit:
+	free(watch);
+	return ret;
+}
+
+/* One toggle the way gpio_io() used to do it: request, write, release */
+static artik_error gpio_toggle_uncached(artik_gpio_id id, int value)
+{
+	artik_gpio_module *gpio;
+	artik_gpio_config config;
+	artik_gpio_handle handle;
+	char name[16] = "";
+	artik_error ret;
+
+	gpio = (artik_gpio_module *)artik_request_api_module("gpio");
+	if (!gpio)
+		return E_NOT_SUPPORTED;
+
+	memset(&config, 0, sizeof(config));
+	config.dir = GPIO_IN;
+	config.id = id;
+	snprintf(name, 16, "gpio%d", config.id);
+	config.name = name;
+
+	ret = gpio->request(&handle, &config);
+	if (ret == S_OK) {
+		ret = gpio->write(handle, value);
+		gpio->release(handle);
+	}
+
+	artik_release_api_module(gpio);
+
+	return ret;
+}
+
+static void gpio_toggle_report(const char *label, int count, uint64_t elapsed_us)
+{
+	if (!elapsed_us)
+		elapsed_us = 1;
+
+	/* A full period takes two toggles */
+	fprintf(stdout, "%s: %d toggles in %llu us, %llu toggles/s, %llu Hz\n", label, count,
+		(unsigned long long)elapsed_us,
+		(unsigned long long)count * 1000000 / elapsed_us,
+		(unsigned long long)count * 500000 / elapsed_us);
+}
+
+static int gpio_toggle(int argc, char *argv[])
+{
+	artik_gpio_module *gpio;
+	artik_gpio_handle handle;
+	artik_gpio_id id;
+	uint64_t start;
+	int count, i;
+
+	if (argc < 5) {
+		usage(argv[1], gpio_commands);
+		return -1;
+	}
+
+	id = atoi(argv[3]);
+	count = atoi(argv[4]);
+	if (count <= 0) {
+		fprintf(stderr, "Count must be positive\n");
+		return -1;
+	}
+
+	gpio_cache_release(id);
+	start = perf_now_us();
+	for (i = 0; i < count; i++) {
+		if (gpio_toggle_uncached(id, i & 1) != S_OK) {
+			fprintf(stderr, "Failed to toggle GPIO %d\n", id);
+			return -1;
+		}
+	}
+	gpio_toggle_report("request/write/release", count, perf_now_us() - start);
+
+	/* Same direction as gpio_write() */
+	start = perf_now_us();
+	if (gpio_cache_get(id, GPIO_IN, &gpio, &handle) != S_OK) {
+		fprintf(stderr, "Failed to request GPIO %d\n", id);
+		return -1;
+	}
+	for (i = 0; i < count; i++) {
+		if (gpio->write(handle, i & 1) != S_OK) {
+			fprintf(stderr, "Failed to toggle GPIO %d\n", id);
+			gpio_cache_put(handle);
+			return -1;
+		}
+	}
+	gpio_toggle_report("cached handle", count, perf_now_us() - start);
+	gpio_cache_put(handle);
+
+	return 0;
+}
+
+static int gpio_release(int argc, char *argv[])
+{
+	if (argc > 3)
+		gpio_cache_release(atoi(argv[3]));
+	else
+		gpio_cache_release_all();
+
+	return 0;
+}
+
 #ifdef CONFIG_BUILD_KERNEL
 int main(int argc, FAR char *argv[])
 #else
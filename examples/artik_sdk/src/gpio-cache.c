@@ -0,0 +1,188 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file gpio-cache.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <artik_module.h>
+
+#include "gpio-cache.h"
+
+struct gpio_cache_entry {
+	bool used;
+	/* Released while referenced, dropped at the last put */
+	bool stale;
+	unsigned int refs;
+	artik_gpio_id id;
+	artik_gpio_dir_t dir;
+	artik_gpio_handle handle;
+};
+
+static struct gpio_cache_entry g_gpio_cache[GPIO_CACHE_MAX_PINS];
+static artik_gpio_module *g_gpio;
+static int g_gpio_cached;
+static pthread_mutex_t g_gpio_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Must be called with g_gpio_lock held */
+static void gpio_cache_drop(struct gpio_cache_entry *entry)
+{
+	g_gpio->release(entry->handle);
+	memset(entry, 0, sizeof(*entry));
+
+	if (--g_gpio_cached == 0) {
+		artik_release_api_module(g_gpio);
+		g_gpio = NULL;
+	}
+}
+
+artik_error gpio_cache_get(artik_gpio_id id, artik_gpio_dir_t dir, artik_gpio_module **gpio,
+		artik_gpio_handle *handle)
+{
+	struct gpio_cache_entry *entry = NULL;
+	struct gpio_cache_entry *free_entry = NULL;
+	artik_gpio_config config;
+	char name[16];
+	artik_error ret = S_OK;
+	int i;
+
+	pthread_mutex_lock(&g_gpio_lock);
+	for (i = 0; i < GPIO_CACHE_MAX_PINS; i++) {
+		if (g_gpio_cache[i].used && (g_gpio_cache[i].id == id)) {
+			entry = &g_gpio_cache[i];
+			break;
+		}
+		if (!g_gpio_cache[i].used && !free_entry)
+			free_entry = &g_gpio_cache[i];
+	}
+
+	if (entry && !entry->stale && (entry->dir == dir))
+		goto exit;
+
+	/* The pin is still requested by whoever holds a reference to it */
+	if (entry && entry->refs) {
+		entry = NULL;
+		ret = E_BUSY;
+		goto exit;
+	}
+
+	if (entry) {
+		free_entry = entry;
+		gpio_cache_drop(entry);
+		entry = NULL;
+	}
+
+	if (!free_entry) {
+		ret = E_NO_MEM;
+		goto exit;
+	}
+
+	if (!g_gpio) {
+		g_gpio = (artik_gpio_module *)artik_request_api_module("gpio");
+		if (!g_gpio) {
+			ret = E_NOT_SUPPORTED;
+			goto exit;
+		}
+	}
+
+	memset(&config, 0, sizeof(config));
+	config.dir = dir;
+	config.id = id;
+	snprintf(name, sizeof(name), "gpio%d", id);
+	config.name = name;
+
+	ret = g_gpio->request(&free_entry->handle, &config);
+	if (ret != S_OK) {
+		if (!g_gpio_cached) {
+			artik_release_api_module(g_gpio);
+			g_gpio = NULL;
+		}
+		goto exit;
+	}
+
+	entry = free_entry;
+	entry->used = true;
+	entry->id = id;
+	entry->dir = dir;
+	g_gpio_cached++;
+
+exit:
+	if (entry) {
+		entry->refs++;
+		*gpio = g_gpio;
+		*handle = entry->handle;
+	}
+	pthread_mutex_unlock(&g_gpio_lock);
+
+	return ret;
+}
+
+void gpio_cache_put(artik_gpio_handle handle)
+{
+	struct gpio_cache_entry *entry;
+	int i;
+
+	pthread_mutex_lock(&g_gpio_lock);
+	for (i = 0; i < GPIO_CACHE_MAX_PINS; i++) {
+		entry = &g_gpio_cache[i];
+		if (!entry->used || (entry->handle != handle) || !entry->refs)
+			continue;
+
+		if ((--entry->refs == 0) && entry->stale)
+			gpio_cache_drop(entry);
+		break;
+	}
+	pthread_mutex_unlock(&g_gpio_lock);
+}
+
+/* Must be called with g_gpio_lock held */
+static void gpio_cache_release_entry(struct gpio_cache_entry *entry)
+{
+	if (entry->refs)
+		entry->stale = true;
+	else
+		gpio_cache_drop(entry);
+}
+
+void gpio_cache_release(artik_gpio_id id)
+{
+	int i;
+
+	pthread_mutex_lock(&g_gpio_lock);
+	for (i = 0; i < GPIO_CACHE_MAX_PINS; i++) {
+		if (g_gpio_cache[i].used && (g_gpio_cache[i].id == id))
+			gpio_cache_release_entry(&g_gpio_cache[i]);
+	}
+	pthread_mutex_unlock(&g_gpio_lock);
+}
+
+void gpio_cache_release_all(void)
+{
+	int i;
+
+	pthread_mutex_lock(&g_gpio_lock);
+	for (i = 0; i < GPIO_CACHE_MAX_PINS; i++) {
+		if (g_gpio_cache[i].used)
+			gpio_cache_release_entry(&g_gpio_cache[i]);
+	}
+	pthread_mutex_unlock(&g_gpio_lock);
+}
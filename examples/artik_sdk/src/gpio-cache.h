@@ -0,0 +1,47 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file gpio-cache.h
+ */
+
+#ifndef __ARTIK_GPIO_CACHE_H__
+#define __ARTIK_GPIO_CACHE_H__
+
+#include <artik_gpio.h>
+
+#define GPIO_CACHE_MAX_PINS	16
+
+/*
+ * Pins requested once and kept open across commands. A pin asked for
+ * with another direction than the cached one is released and requested
+ * again, so a cache hit costs nothing but a table lookup. The gpio module
+ * stays referenced as long as a pin is cached.
+ *
+ * gpio_cache_get() hands out a reference to the pin, which the caller
+ * gives back with gpio_cache_put() once done with the handle. A pin still
+ * referenced is only released at its last put, and cannot change
+ * direction meanwhile (E_BUSY).
+ */
+artik_error gpio_cache_get(artik_gpio_id id, artik_gpio_dir_t dir, artik_gpio_module **gpio,
+		artik_gpio_handle *handle);
+void gpio_cache_put(artik_gpio_handle handle);
+void gpio_cache_release(artik_gpio_id id);
+void gpio_cache_release_all(void);
+
+#endif /* __ARTIK_GPIO_CACHE_H__ */
@@ -0,0 +1,154 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file gpio-group.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <artik_module.h>
+
+#include "gpio-group.h"
+
+artik_error gpio_group_open(struct gpio_group *g, const artik_gpio_id *ids, int num_pins,
+		artik_gpio_dir_t dir)
+{
+	artik_gpio_config config;
+	char name[16];
+	artik_error ret = S_OK;
+	int i;
+
+	if (!g || !ids || (num_pins <= 0) || (num_pins > GPIO_GROUP_MAX_PINS))
+		return E_BAD_ARGS;
+
+	memset(g, 0, sizeof(*g));
+	perf_stats_reset(&g->latency);
+	perf_stats_reset(&g->skew);
+
+	g->gpio = (artik_gpio_module *)artik_request_api_module("gpio");
+	if (!g->gpio)
+		return E_NOT_SUPPORTED;
+
+	for (i = 0; i < num_pins; i++) {
+		memset(&config, 0, sizeof(config));
+		config.dir = dir;
+		config.id = ids[i];
+		snprintf(name, sizeof(name), "gpio%d", ids[i]);
+		config.name = name;
+
+		ret = g->gpio->request(&g->handles[i], &config);
+		if (ret != S_OK) {
+			fprintf(stderr, "Failed to request GPIO %d\n", ids[i]);
+			g->handles[i] = NULL;
+			gpio_group_close(g);
+			return ret;
+		}
+		g->ids[i] = ids[i];
+		g->num_pins++;
+	}
+
+	return S_OK;
+}
+
+artik_error gpio_group_read(struct gpio_group *g, uint32_t *value)
+{
+	uint64_t start = perf_now_us();
+	uint32_t mask = 0;
+	int i, v;
+
+	for (i = 0; i < g->num_pins; i++) {
+		v = g->gpio->read(g->handles[i]);
+		if (v < 0)
+			return v;
+		if (v)
+			mask |= 1UL << i;
+	}
+	g->pin_ops += g->num_pins;
+
+	perf_stats_add(&g->latency, perf_now_us() - start);
+	*value = mask;
+
+	return S_OK;
+}
+
+/* Sets the pins selected by mask to the matching bits of value */
+artik_error gpio_group_write(struct gpio_group *g, uint32_t value, uint32_t mask)
+{
+	uint64_t start = perf_now_us();
+	uint64_t first = 0, last = 0;
+	uint32_t bit;
+	artik_error ret;
+	int i;
+
+	for (i = 0; i < g->num_pins; i++) {
+		bit = 1UL << i;
+		if (!(mask & bit))
+			continue;
+		if (g->shadow_valid && ((g->shadow ^ value) & bit) == 0)
+			continue;
+
+		last = perf_now_us();
+		if (!first)
+			first = last;
+
+		ret = g->gpio->write(g->handles[i], (value & bit) ? 1 : 0);
+		if (ret != S_OK) {
+			/* The pin state is unknown now, write every pin next time */
+			g->shadow_valid = false;
+			return ret;
+		}
+		g->shadow = (g->shadow & ~bit) | (value & bit);
+		g->pin_ops++;
+	}
+
+	if (mask == (1UL << g->num_pins) - 1)
+		g->shadow_valid = true;
+
+	perf_stats_add(&g->latency, perf_now_us() - start);
+	if (first)
+		perf_stats_add(&g->skew, last - first);
+
+	return S_OK;
+}
+
+void gpio_group_close(struct gpio_group *g)
+{
+	int i;
+
+	if (!g->gpio)
+		return;
+
+	for (i = 0; i < GPIO_GROUP_MAX_PINS; i++) {
+		if (g->handles[i])
+			g->gpio->release(g->handles[i]);
+		g->handles[i] = NULL;
+	}
+
+	artik_release_api_module(g->gpio);
+	g->gpio = NULL;
+}
+
+void gpio_group_report(struct gpio_group *g)
+{
+	fprintf(stdout, "%d pins, %u pin operations\n", g->num_pins, g->pin_ops);
+	perf_stats_print("latency", &g->latency);
+	if (g->skew.count)
+		perf_stats_print("skew", &g->skew);
+}
@@ -0,0 +1,65 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file gpio-group.h
+ */
+
+#ifndef __ARTIK_GPIO_GROUP_H__
+#define __ARTIK_GPIO_GROUP_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <artik_gpio.h>
+
+#include "perf-stats.h"
+
+#define GPIO_GROUP_MAX_PINS	16
+
+/*
+ * A set of pins kept open together and accessed as one bitmask, bit i
+ * being the i-th pin given to gpio_group_open(). Typical uses are a
+ * parallel bus or a keypad.
+ *
+ * The SDK has no port-level access, so a group operation still goes
+ * through one call per pin. What the group saves is the request and
+ * release of every pin on every access. Writes also keep a shadow of the
+ * last value and only touch the pins that change. The time between the
+ * first and the last pin of a write is recorded as skew.
+ */
+struct gpio_group {
+	artik_gpio_module *gpio;
+	artik_gpio_handle handles[GPIO_GROUP_MAX_PINS];
+	artik_gpio_id ids[GPIO_GROUP_MAX_PINS];
+	int num_pins;
+	uint32_t shadow;
+	bool shadow_valid;
+	unsigned int pin_ops;
+	struct perf_stats latency;
+	struct perf_stats skew;
+};
+
+artik_error gpio_group_open(struct gpio_group *g, const artik_gpio_id *ids, int num_pins,
+		artik_gpio_dir_t dir);
+artik_error gpio_group_read(struct gpio_group *g, uint32_t *value);
+artik_error gpio_group_write(struct gpio_group *g, uint32_t value, uint32_t mask);
+void gpio_group_close(struct gpio_group *g);
+void gpio_group_report(struct gpio_group *g);
+
+#endif /* __ARTIK_GPIO_GROUP_H__ */
@@ -0,0 +1,203 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file gpio-watch.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <artik_module.h>
+
+#include "gpio-watch.h"
+#include "perf-stats.h"
+
+#define QUEUE_MASK	(GPIO_WATCH_QUEUE_SIZE - 1)
+
+/* Must be called with w->lock held */
+static void gpio_watch_push(struct gpio_watch *w, uint64_t time_us, int value)
+{
+	struct gpio_event *event;
+
+	if (((w->edge == GPIO_EDGE_RISING) && !value) ||
+			((w->edge == GPIO_EDGE_FALLING) && value))
+		return;
+
+	if (w->head - w->tail >= GPIO_WATCH_QUEUE_SIZE) {
+		w->dropped++;
+		return;
+	}
+
+	event = &w->queue[w->head++ & QUEUE_MASK];
+	event->time_us = time_us;
+	event->id = w->id;
+	event->value = value;
+	w->queued++;
+	sem_post(&w->events);
+}
+
+static void gpio_watch_edge(void *user_data, int value)
+{
+	struct gpio_watch *w = (struct gpio_watch *)user_data;
+	uint64_t now = perf_now_us();
+
+	pthread_mutex_lock(&w->lock);
+	w->edges++;
+	w->raw = value;
+	w->raw_us = now;
+
+	if ((value == w->level) || (now - w->level_us < w->debounce_us)) {
+		w->bounces++;
+	} else {
+		w->level = value;
+		w->level_us = now;
+		gpio_watch_push(w, now, value);
+	}
+	pthread_mutex_unlock(&w->lock);
+}
+
+artik_error gpio_watch_start(struct gpio_watch *w, artik_gpio_id id, artik_gpio_edge_t edge,
+		unsigned int debounce_ms)
+{
+	artik_gpio_config config;
+	char name[16];
+	artik_error ret = S_OK;
+	int value;
+
+	if (!w || (edge <= GPIO_EDGE_NONE) || (edge > GPIO_EDGE_BOTH))
+		return E_BAD_ARGS;
+
+	memset(w, 0, sizeof(*w));
+	w->id = id;
+	w->edge = edge;
+	w->debounce_us = debounce_ms * 1000;
+
+	w->gpio = (artik_gpio_module *)artik_request_api_module("gpio");
+	if (!w->gpio)
+		return E_NOT_SUPPORTED;
+
+	memset(&config, 0, sizeof(config));
+	config.id = id;
+	config.dir = GPIO_IN;
+	/* Both edges are needed to follow the level through the debounce filter */
+	config.edge = GPIO_EDGE_BOTH;
+	snprintf(name, sizeof(name), "gpio%d", id);
+	config.name = name;
+
+	ret = w->gpio->request(&w->handle, &config);
+	if (ret != S_OK) {
+		artik_release_api_module(w->gpio);
+		w->gpio = NULL;
+		return ret;
+	}
+
+	value = w->gpio->read(w->handle);
+	w->level = w->raw = (value > 0);
+	w->start_us = w->level_us = w->raw_us = perf_now_us();
+
+	pthread_mutex_init(&w->lock, NULL);
+	sem_init(&w->events, 0, 0);
+
+	ret = w->gpio->set_change_callback(w->handle, gpio_watch_edge, w);
+	if (ret != S_OK) {
+		sem_destroy(&w->events);
+		pthread_mutex_destroy(&w->lock);
+		w->gpio->release(w->handle);
+		artik_release_api_module(w->gpio);
+		w->gpio = NULL;
+	}
+
+	return ret;
+}
+
+/*
+ * Waits up to timeout_ms for the next event. Wakes up at least once per
+ * debounce period to report a level that settled after a bounce.
+ */
+artik_error gpio_watch_wait(struct gpio_watch *w, struct gpio_event *event,
+		unsigned int timeout_ms)
+{
+	uint64_t deadline = perf_now_us() + (uint64_t)timeout_ms * 1000;
+	uint64_t now, slice;
+	struct timespec timeout;
+
+	while (1) {
+		now = perf_now_us();
+		if (sem_trywait(&w->events) == 0)
+			break;
+
+		pthread_mutex_lock(&w->lock);
+		if ((w->raw != w->level) && (now - w->raw_us >= w->debounce_us)) {
+			w->level = w->raw;
+			w->level_us = now;
+			gpio_watch_push(w, w->raw_us, w->raw);
+		}
+		pthread_mutex_unlock(&w->lock);
+
+		if (sem_trywait(&w->events) == 0)
+			break;
+		if (now >= deadline)
+			return E_TIMEOUT;
+
+		slice = deadline - now;
+		if (w->debounce_us && (slice > w->debounce_us))
+			slice = w->debounce_us;
+
+		clock_gettime(CLOCK_REALTIME, &timeout);
+		timeout.tv_nsec += (slice % 1000000) * 1000;
+		timeout.tv_sec += slice / 1000000 + timeout.tv_nsec / 1000000000;
+		timeout.tv_nsec %= 1000000000;
+		if (sem_timedwait(&w->events, &timeout) == 0)
+			break;
+	}
+
+	pthread_mutex_lock(&w->lock);
+	*event = w->queue[w->tail++ & QUEUE_MASK];
+	pthread_mutex_unlock(&w->lock);
+
+	return S_OK;
+}
+
+void gpio_watch_stop(struct gpio_watch *w)
+{
+	if (!w->gpio)
+		return;
+
+	w->gpio->unset_change_callback(w->handle);
+	w->gpio->release(w->handle);
+	artik_release_api_module(w->gpio);
+	w->gpio = NULL;
+
+	sem_destroy(&w->events);
+	pthread_mutex_destroy(&w->lock);
+}
+
+void gpio_watch_report(struct gpio_watch *w)
+{
+	uint64_t elapsed = perf_now_us() - w->start_us;
+
+	fprintf(stdout, "GPIO %d: %u edges, %u bounces filtered, %u events, %u dropped\n",
+		w->id, w->edges, w->bounces, w->queued, w->dropped);
+	if (elapsed)
+		fprintf(stdout, "event rate %llu.%02llu/s over %llu ms\n",
+			(unsigned long long)w->queued * 1000000 / elapsed,
+			(unsigned long long)w->queued * 100000000 / elapsed % 100,
+			(unsigned long long)elapsed / 1000);
+}
@@ -0,0 +1,86 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file gpio-watch.h
+ */
+
+#ifndef __ARTIK_GPIO_WATCH_H__
+#define __ARTIK_GPIO_WATCH_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <artik_gpio.h>
+
+#define GPIO_WATCH_QUEUE_SIZE		32
+#define GPIO_WATCH_DEBOUNCE_MS		20
+
+struct gpio_event {
+	uint64_t time_us;
+	artik_gpio_id id;
+	int value;
+};
+
+/*
+ * Edge events of an input pin, delivered to a subscriber through a
+ * bounded queue.
+ *
+ * The SDK change callback timestamps every edge. Edges coming within the
+ * debounce time of the last accepted one are counted as bounces and
+ * dropped. If the pin then settles on a level other than the last one
+ * reported, gpio_watch_wait() emits that level once the debounce time has
+ * passed, so no final state is lost to the filter. Only the requested
+ * edges are queued. An event arriving while the queue is full is counted
+ * as dropped.
+ */
+struct gpio_watch {
+	artik_gpio_module *gpio;
+	artik_gpio_handle handle;
+	artik_gpio_id id;
+	artik_gpio_edge_t edge;
+	uint32_t debounce_us;
+
+	pthread_mutex_t lock;
+	sem_t events;
+	struct gpio_event queue[GPIO_WATCH_QUEUE_SIZE];
+	unsigned int head;
+	unsigned int tail;
+
+	int level;
+	uint64_t level_us;
+	int raw;
+	uint64_t raw_us;
+
+	unsigned int edges;
+	unsigned int bounces;
+	unsigned int queued;
+	unsigned int dropped;
+	uint64_t start_us;
+};
+
+artik_error gpio_watch_start(struct gpio_watch *w, artik_gpio_id id, artik_gpio_edge_t edge,
+		unsigned int debounce_ms);
+artik_error gpio_watch_wait(struct gpio_watch *w, struct gpio_event *event,
+		unsigned int timeout_ms);
+void gpio_watch_stop(struct gpio_watch *w);
+void gpio_watch_report(struct gpio_watch *w);
+
+#endif /* __ARTIK_GPIO_WATCH_H__ */
@@ -28,6 +28,10 @@
 #include <artik_http.h>
 
 #include "command.h"
+#include "http-bench.h"
+#include "http-stream.h"
+#include "tls-cache.h"
+#include "wifi-manager.h"
 
 #ifdef CONFIG_EXAMPLES_ARTIK_HTTP
 #include "wifi-auto.h"
@@ -39,59 +43,46 @@ static int http_get(int argc, char **argv);
 static int http_post(int argc, char **argv);
 static int http_put(int argc, char **argv);
 static int http_delete(int argc, char **argv);
+static int http_tls(int argc, char **argv);
+static int http_bench_command(int argc, char **argv);
 
 const struct command http_commands[] = {
 	{ "get", "get <url>", http_get},
 	{ "post", "post <url> <body>", http_post},
 	{ "put", "put <url> <body>", http_put},
 	{ "delete", "delete <url>", http_delete },
+	{ "tls", "tls [flush] - Display or drop the cached TLS sessions and handshake times", http_tls },
+	{ "bench", "bench <url> <requests> <concurrency> [<body size>] [gzip]", http_bench_command },
 	{ "", "", NULL }
 };
 
-static int http_get(int argc, char **argv)
+static int http_print_chunk(const char *data, unsigned int len, void *user_data)
 {
-	artik_http_module *http = (artik_http_module *)artik_request_api_module("http");
-	artik_error ret = S_OK;
-	char *response = NULL;
-	int status = 0;
-	artik_http_headers headers;
-	artik_http_header_field fields[] = {
-		{"Connect", "close"},
-		{"User-Agent", "Artik browser"},
-		{"Accept-Language", "en-US,en;q=0.8"},
-	};
+	fwrite(data, 1, len, stderr);
 
-	if (argc < 4) {
-		fprintf(stderr, "Wrong number of arguments");
-		goto exit;
-	}
-
-	headers.fields = fields;
-	headers.num_fields = ARRAY_SIZE(fields);
+	return len;
+}
 
-	printf("uri = %s\n", argv[3]);
-	ret = http->get(argv[3], &headers, &response, &status, NULL);
-	if (ret != S_OK) {
-		fprintf(stderr, "Failed to get %s (err:%s)\n", argv[3], error_msg(ret));
-		goto exit;
-	}
+static int http_network_ready(void)
+{
+	artik_error err = wifi_manager_wait_ready(WIFI_MANAGER_READY_TIMEOUT_MS);
 
-	if (response) {
-		fprintf(stderr, "HTTP %d - %s\n", status, response);
-		free(response);
+	if (err != S_OK) {
+		fprintf(stderr, "Network is not ready (%s)\n", error_msg(err));
+		return -1;
 	}
 
-exit:
-	artik_release_api_module(http);
-	return (ret == S_OK);
+	return 0;
 }
 
-static int http_post(int argc, char **argv)
+static int http_request(enum http_stream_method method, const char *url,
+		const char *body)
 {
-	artik_http_module *http = (artik_http_module *)artik_request_api_module("http");
 	artik_error ret = S_OK;
-	char *response = NULL;
 	int status = 0;
+	char chunk[HTTP_STREAM_CHUNK_SIZE];
+	struct http_stream stream;
+	artik_ssl_config ssl;
 	artik_http_headers headers;
 	artik_http_header_field fields[] = {
 		{"Connect", "close"},
@@ -99,102 +90,112 @@ static int http_post(int argc, char **argv)
 		{"Accept-Language", "en-US,en;q=0.8"},
 	};
 
-	if (argc < 5) {
-		fprintf(stderr, "Wrong number of arguments");
-		goto exit;
-	}
+	if (http_network_ready() < 0)
+		return -1;
 
 	headers.fields = fields;
 	headers.num_fields = ARRAY_SIZE(fields);
 
-	ret = http->post(argv[3], &headers, argv[4], &response, &status, NULL);
+	http_stream_init(&stream, chunk, sizeof(chunk), http_print_chunk, NULL);
+	stream.flags = HTTP_STREAM_ACCEPT_ENCODING;
+
+	/* Any URL can be typed in and the shell has no CA store to check it with */
+	memset(&ssl, 0, sizeof(ssl));
+	ssl.verify_cert = ARTIK_SSL_VERIFY_NONE;
+	stream.ssl = &ssl;
+
+	printf("uri = %s\n", url);
+	ret = http_stream_request(method, url, &headers, body, &status, &stream);
 	if (ret != S_OK) {
-		fprintf(stderr, "Failed to get %s (err:%s)\n", argv[3], error_msg(ret));
-		goto exit;
+		fprintf(stderr, "Failed to request %s (err:%s)\n", url, error_msg(ret));
+		return -1;
 	}
 
-	if (response) {
-		fprintf(stderr, "HTTP %d - %s\n", status, response);
-		free(response);
-	}
+	fprintf(stderr, "\nHTTP %d - %u bytes (%u received)\n", status, stream.total,
+		stream.received);
 
-exit:
-	artik_release_api_module(http);
-	return (ret == S_OK);
+	return 0;
 }
 
-static int http_put(int argc, char **argv)
+static int http_get(int argc, char **argv)
 {
-	artik_http_module *http = (artik_http_module *)artik_request_api_module("http");
-	artik_error ret = S_OK;
-	char *response = NULL;
-	int status = 0;
-	artik_http_headers headers;
-	artik_http_header_field fields[] = {
-		{"Connect", "close"},
-		{"User-Agent", "Artik browser"},
-		{"Accept-Language", "en-US,en;q=0.8"},
-	};
-
 	if (argc < 4) {
-		fprintf(stderr, "Wrong number of arguments");
-		goto exit;
+		fprintf(stderr, "Wrong number of arguments\n");
+		usage(argv[1], http_commands);
+		return -1;
 	}
 
-	headers.fields = fields;
-	headers.num_fields = ARRAY_SIZE(fields);
+	return http_request(HTTP_STREAM_GET, argv[3], NULL);
+}
 
-	ret = http->put(argv[3], &headers, argv[4], &response, &status, NULL);
-	if (ret != S_OK) {
-		fprintf(stderr, "Failed to get %s (err:%s)\n", argv[3], error_msg(ret));
-		goto exit;
+static int http_post(int argc, char **argv)
+{
+	if (argc < 5) {
+		fprintf(stderr, "Wrong number of arguments\n");
+		usage(argv[1], http_commands);
+		return -1;
 	}
 
-	if (response) {
-		fprintf(stderr, "HTTP %d - %s\n", status, response);
-		free(response);
+	return http_request(HTTP_STREAM_POST, argv[3], argv[4]);
+}
+
+static int http_put(int argc, char **argv)
+{
+	if (argc < 5) {
+		fprintf(stderr, "Wrong number of arguments\n");
+		usage(argv[1], http_commands);
+		return -1;
 	}
 
-exit:
-	artik_release_api_module(http);
-	return (ret == S_OK);
+	return http_request(HTTP_STREAM_PUT, argv[3], argv[4]);
 }
 
 static int http_delete(int argc, char **argv)
 {
-	artik_http_module *http = (artik_http_module *)artik_request_api_module("http");
-	artik_error ret = S_OK;
-	char *response = NULL;
-	int status = 0;
-	artik_http_headers headers;
-	artik_http_header_field fields[] = {
-		{"Connect", "close"},
-		{"User-Agent", "Artik browser"},
-		{"Accept-Language", "en-US,en;q=0.8"},
-	};
+	if (argc < 4) {
+		fprintf(stderr, "Wrong number of arguments\n");
+		usage(argv[1], http_commands);
+		return -1;
+	}
+
+	return http_request(HTTP_STREAM_DELETE, argv[3], NULL);
+}
 
-	if (argc < 3) {
-		fprintf(stderr, "Wrong number of arguments");
-		goto exit;
+static int http_tls(int argc, char **argv)
+{
+	if ((argc > 3) && !strcmp(argv[3], "flush")) {
+		tls_cache_flush();
+		return 0;
 	}
 
-	headers.fields = fields;
-	headers.num_fields = ARRAY_SIZE(fields);
+	tls_cache_dump();
 
-	ret = http->del(argv[3], &headers, &response, &status, NULL);
-	if (ret != S_OK) {
-		fprintf(stderr, "Failed to get %s (err:%s)\n", argv[3], error_msg(ret));
-		goto exit;
+	return 0;
+}
+
+static int http_bench_command(int argc, char **argv)
+{
+	int body_size = 0;
+	bool gzip = false;
+	int i;
+
+	if (argc < 6) {
+		fprintf(stderr, "Wrong number of arguments\n");
+		usage(argv[1], http_commands);
+		return -1;
 	}
 
-	if (response) {
-		fprintf(stderr, "HTTP %d - %s\n", status, response);
-		free(response);
+	for (i = 6; i < argc; i++) {
+		if (!strcmp(argv[i], "gzip"))
+			gzip = true;
+		else
+			body_size = atoi(argv[i]);
 	}
 
-exit:
-	artik_release_api_module(http);
-	return (ret == S_OK);
+	if (http_network_ready() < 0)
+		return -1;
+
+	return http_bench(argv[3], atoi(argv[4]), atoi(argv[5]), body_size, gzip);
 }
 
 int http_main(int argc, char *argv[])
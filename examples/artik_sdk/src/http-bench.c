@@ -0,0 +1,205 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file http-bench.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <artik_error.h>
+
+#include "http-bench.h"
+#include "http-stream.h"
+#include "perf-stats.h"
+
+#define ARRAY_SIZE(a) (sizeof(a)/sizeof((a)[0]))
+
+/* Host C libraries need more than the TizenRT default */
+#ifndef HTTP_BENCH_STACK_SIZE
+#define HTTP_BENCH_STACK_SIZE	16384
+#endif
+
+struct http_bench {
+	const char *url;
+	char *body;
+	int requests;
+	int issued;
+	unsigned int flags;
+	unsigned int errors;
+	uint64_t bytes;
+	uint64_t received;
+	uint64_t inflate_us;
+	struct perf_histogram latency;
+	pthread_mutex_t lock;
+};
+
+static int http_bench_discard(const char *data, unsigned int len, void *user_data)
+{
+	return len;
+}
+
+static bool http_bench_next(struct http_bench *bench)
+{
+	bool more;
+
+	pthread_mutex_lock(&bench->lock);
+	more = bench->issued < bench->requests;
+	if (more)
+		bench->issued++;
+	pthread_mutex_unlock(&bench->lock);
+
+	return more;
+}
+
+static pthread_addr_t http_bench_worker(pthread_addr_t arg)
+{
+	struct http_bench *bench = (struct http_bench *)arg;
+	char chunk[HTTP_STREAM_CHUNK_SIZE];
+	struct http_stream stream;
+	artik_ssl_config ssl;
+	artik_http_headers headers;
+	artik_http_header_field fields[] = {
+		{"User-Agent", "Artik bench"},
+	};
+
+	headers.fields = fields;
+	headers.num_fields = ARRAY_SIZE(fields);
+
+	/* The benchmark measures the transfer, not the certificate checks */
+	memset(&ssl, 0, sizeof(ssl));
+	ssl.verify_cert = ARTIK_SSL_VERIFY_NONE;
+
+	while (http_bench_next(bench)) {
+		artik_error err;
+		int status = 0;
+		uint64_t start;
+		uint32_t elapsed;
+
+		http_stream_init(&stream, chunk, sizeof(chunk), http_bench_discard, NULL);
+		stream.flags = bench->flags;
+		stream.ssl = &ssl;
+
+		start = perf_now_us();
+		err = http_stream_request(bench->body ? HTTP_STREAM_POST : HTTP_STREAM_GET,
+				bench->url, &headers, bench->body, &status, &stream);
+		elapsed = perf_now_us() - start;
+
+		pthread_mutex_lock(&bench->lock);
+		if ((err != S_OK) || (status < 200) || (status >= 300)) {
+			bench->errors++;
+		} else {
+			perf_hist_add(&bench->latency, elapsed);
+			bench->bytes += stream.total;
+			bench->received += stream.received;
+			bench->inflate_us += stream.inflate_us;
+		}
+		pthread_mutex_unlock(&bench->lock);
+	}
+
+	return NULL;
+}
+
+int http_bench(const char *url, int requests, int concurrency, int body_size,
+		bool gzip)
+{
+	struct http_bench *bench;
+	pthread_t workers[HTTP_BENCH_MAX_WORKERS];
+	pthread_attr_t attr;
+	uint64_t start;
+	uint64_t elapsed;
+	unsigned int errors;
+	int started = 0;
+	int i;
+
+	if (!url || (requests <= 0) || (concurrency <= 0) ||
+			(concurrency > HTTP_BENCH_MAX_WORKERS) || (body_size < 0)) {
+		fprintf(stderr, "Invalid bench parameters (max %d workers)\n",
+			HTTP_BENCH_MAX_WORKERS);
+		return -1;
+	}
+
+	/* The histogram is too large for the command task stack */
+	bench = malloc(sizeof(struct http_bench));
+	if (!bench) {
+		fprintf(stderr, "Failed to allocate bench context\n");
+		return -1;
+	}
+
+	memset(bench, 0, sizeof(struct http_bench));
+	bench->url = url;
+	bench->requests = requests;
+	bench->flags = gzip ? HTTP_STREAM_ACCEPT_ENCODING : 0;
+	pthread_mutex_init(&bench->lock, NULL);
+
+	if (body_size > 0) {
+		bench->body = malloc(body_size + 1);
+		if (!bench->body) {
+			fprintf(stderr, "Failed to allocate %d bytes of body\n", body_size);
+			free(bench);
+			return -1;
+		}
+		memset(bench->body, 'a', body_size);
+		bench->body[body_size] = '\0';
+	}
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, HTTP_BENCH_STACK_SIZE);
+
+	start = perf_now_us();
+	for (i = 0; i < concurrency; i++) {
+		if (pthread_create(&workers[i], &attr, http_bench_worker, bench) != 0) {
+			fprintf(stderr, "Failed to start worker %d\n", i);
+			break;
+		}
+		started++;
+	}
+
+	for (i = 0; i < started; i++)
+		pthread_join(workers[i], NULL);
+	elapsed = perf_now_us() - start;
+
+	pthread_attr_destroy(&attr);
+
+	fprintf(stdout, "%s: %d requests, %d workers, %d bytes body\n", url,
+		bench->issued, started, body_size);
+	perf_hist_print("latency", &bench->latency);
+	if (elapsed) {
+		fprintf(stdout, "throughput: %llu req/s, %llu bytes/s\n",
+			(unsigned long long)bench->latency.stats.count * 1000000 / elapsed,
+			(unsigned long long)(bench->bytes * 1000000 / elapsed));
+	}
+	if (gzip && bench->bytes) {
+		fprintf(stdout, "encoding: %llu bytes received for %llu decoded (%llu%%), inflate %llu us/request\n",
+			(unsigned long long)bench->received,
+			(unsigned long long)bench->bytes,
+			(unsigned long long)(bench->received * 100 / bench->bytes),
+			(unsigned long long)(bench->inflate_us / bench->latency.stats.count));
+	}
+	fprintf(stdout, "errors: %u\n", bench->errors);
+	errors = bench->errors;
+
+	pthread_mutex_destroy(&bench->lock);
+	free(bench->body);
+	free(bench);
+
+	return (started && !errors) ? 0 : -1;
+}
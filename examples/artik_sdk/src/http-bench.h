@@ -0,0 +1,42 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file http-bench.h
+ */
+
+#ifndef __ARTIK_HTTP_BENCH_H__
+#define __ARTIK_HTTP_BENCH_H__
+
+#include <stdbool.h>
+
+#define HTTP_BENCH_MAX_WORKERS	8
+
+/*
+ * Issues the requests from up to HTTP_BENCH_MAX_WORKERS threads through
+ * http-stream and prints the latency percentiles and throughput. Returns
+ * -1 when a request failed or answered other than 2xx.
+ *
+ * The native env builds it with HTTP_CLIENT_NO_TLS, so that the bench runs
+ * on the host against a local plain HTTP server; https:// URLs then fail.
+ */
+
+int http_bench(const char *url, int requests, int concurrency, int body_size,
+		bool gzip);
+
+#endif /* __ARTIK_HTTP_BENCH_H__ */
@@ -0,0 +1,454 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file http-client.c
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+
+#ifndef HTTP_CLIENT_NO_TLS
+#include <tls/net.h>
+#include <tls/ssl.h>
+#include <tls/entropy.h>
+#include <tls/ctr_drbg.h>
+#include <tls/x509_crt.h>
+#endif
+
+#include "dns-cache.h"
+#include "http-client.h"
+#include "perf-stats.h"
+#include "uri.h"
+
+#ifndef HTTP_CLIENT_NO_TLS
+#include "tls-cache.h"
+#endif
+
+struct http_conn {
+	int fd;
+	bool tls;
+	bool timed_out;
+#ifndef HTTP_CLIENT_NO_TLS
+	mbedtls_ssl_context ssl;
+	mbedtls_ssl_config conf;
+	mbedtls_x509_crt ca;
+	mbedtls_entropy_context entropy;
+	mbedtls_ctr_drbg_context drbg;
+#endif
+	char tx[HTTP_CLIENT_RX_SIZE];
+	unsigned int tx_fill;
+};
+
+#ifndef HTTP_CLIENT_NO_TLS
+/*
+ * mbedTLS only understands its own error codes from the BIO callbacks. The
+ * socket blocks, so EAGAIN means that SO_RCVTIMEO or SO_SNDTIMEO ran out:
+ * it is reported as WANT_READ/WANT_WRITE and ends the retry loops below.
+ */
+static int http_conn_bio_errno(struct http_conn *conn, int want, int failed)
+{
+	if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+		conn->timed_out = true;
+		return want;
+	}
+
+	return (errno == EINTR) ? want : failed;
+}
+
+static int http_conn_bio_send(void *ctx, const unsigned char *buf, size_t len)
+{
+	struct http_conn *conn = (struct http_conn *)ctx;
+	int ret = send(conn->fd, buf, len, 0);
+
+	if (ret < 0)
+		return http_conn_bio_errno(conn, MBEDTLS_ERR_SSL_WANT_WRITE,
+			MBEDTLS_ERR_NET_SEND_FAILED);
+
+	return ret;
+}
+
+static int http_conn_bio_recv(void *ctx, unsigned char *buf, size_t len)
+{
+	struct http_conn *conn = (struct http_conn *)ctx;
+	int ret = recv(conn->fd, buf, len, 0);
+
+	if (ret < 0)
+		return http_conn_bio_errno(conn, MBEDTLS_ERR_SSL_WANT_READ,
+			MBEDTLS_ERR_NET_RECV_FAILED);
+
+	return ret;
+}
+
+static bool http_conn_retry(struct http_conn *conn, int ret)
+{
+	return ((ret == MBEDTLS_ERR_SSL_WANT_READ) || (ret == MBEDTLS_ERR_SSL_WANT_WRITE)) &&
+		!conn->timed_out;
+}
+
+static artik_error http_conn_handshake(struct http_conn *conn, const char *host,
+		artik_ssl_config *ssl)
+{
+	static const char pers[] = "http-client";
+	int authmode = MBEDTLS_SSL_VERIFY_NONE;
+	bool offered = false;
+	uint64_t start = 0;
+	int ret;
+
+	/* Keys held in the secure element are only reachable through the SDK */
+	if (ssl && ssl->use_se)
+		return E_NOT_SUPPORTED;
+
+	conn->tls = true;
+	mbedtls_ssl_init(&conn->ssl);
+	mbedtls_ssl_config_init(&conn->conf);
+	mbedtls_x509_crt_init(&conn->ca);
+	mbedtls_entropy_init(&conn->entropy);
+	mbedtls_ctr_drbg_init(&conn->drbg);
+
+	ret = mbedtls_ctr_drbg_seed(&conn->drbg, mbedtls_entropy_func, &conn->entropy,
+		(const unsigned char *)pers, sizeof(pers) - 1);
+	if (ret)
+		goto exit;
+
+	ret = mbedtls_ssl_config_defaults(&conn->conf, MBEDTLS_SSL_IS_CLIENT,
+		MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+	if (ret)
+		goto exit;
+
+	if (ssl) {
+		if (ssl->verify_cert == ARTIK_SSL_VERIFY_REQUIRED)
+			authmode = MBEDTLS_SSL_VERIFY_REQUIRED;
+		else if (ssl->verify_cert == ARTIK_SSL_VERIFY_OPTIONAL)
+			authmode = MBEDTLS_SSL_VERIFY_OPTIONAL;
+
+		if (ssl->ca_cert.data && ssl->ca_cert.len) {
+			ret = mbedtls_x509_crt_parse(&conn->ca,
+				(const unsigned char *)ssl->ca_cert.data, ssl->ca_cert.len);
+			if (ret)
+				goto exit;
+			mbedtls_ssl_conf_ca_chain(&conn->conf, &conn->ca, NULL);
+		}
+	}
+
+	mbedtls_ssl_conf_authmode(&conn->conf, authmode);
+	mbedtls_ssl_conf_rng(&conn->conf, mbedtls_ctr_drbg_random, &conn->drbg);
+
+	ret = mbedtls_ssl_setup(&conn->ssl, &conn->conf);
+	if (ret)
+		goto exit;
+
+	ret = mbedtls_ssl_set_hostname(&conn->ssl, host);
+	if (ret)
+		goto exit;
+
+	mbedtls_ssl_set_bio(&conn->ssl, conn, http_conn_bio_send, http_conn_bio_recv, NULL);
+
+	offered = tls_cache_resume(host, &conn->ssl);
+
+	start = perf_now_us();
+	do {
+		ret = mbedtls_ssl_handshake(&conn->ssl);
+	} while (http_conn_retry(conn, ret));
+
+	if (ret)
+		tls_cache_forget(host);
+	else
+		tls_cache_update(host, &conn->ssl, offered, perf_now_us() - start);
+
+exit:
+	if (ret) {
+		fprintf(stderr, "TLS handshake with %s failed (-0x%x)\n", host, -ret);
+		return E_NOT_CONNECTED;
+	}
+
+	return S_OK;
+}
+
+static void http_conn_tls_close(struct http_conn *conn)
+{
+	mbedtls_ssl_close_notify(&conn->ssl);
+	mbedtls_ssl_free(&conn->ssl);
+	mbedtls_ssl_config_free(&conn->conf);
+	mbedtls_x509_crt_free(&conn->ca);
+	mbedtls_ctr_drbg_free(&conn->drbg);
+	mbedtls_entropy_free(&conn->entropy);
+}
+
+static int http_conn_tls_write(struct http_conn *conn, const char *data, unsigned int len)
+{
+	int ret;
+
+	do {
+		ret = mbedtls_ssl_write(&conn->ssl, (const unsigned char *)data, len);
+	} while (http_conn_retry(conn, ret));
+
+	return ret;
+}
+
+static int http_conn_tls_read(struct http_conn *conn, char *buf, unsigned int len)
+{
+	int ret;
+
+	do {
+		ret = mbedtls_ssl_read(&conn->ssl, (unsigned char *)buf, len);
+	} while (http_conn_retry(conn, ret));
+
+	if (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY)
+		return 0;
+
+	return ret;
+}
+#else
+/* Host builds without mbedTLS, such as the native env, only speak plain HTTP */
+static artik_error http_conn_handshake(struct http_conn *conn, const char *host,
+		artik_ssl_config *ssl)
+{
+	fprintf(stderr, "No TLS support to connect to %s\n", host);
+
+	return E_NOT_SUPPORTED;
+}
+
+static void http_conn_tls_close(struct http_conn *conn)
+{
+}
+
+static int http_conn_tls_write(struct http_conn *conn, const char *data, unsigned int len)
+{
+	return -1;
+}
+
+static int http_conn_tls_read(struct http_conn *conn, char *buf, unsigned int len)
+{
+	return -1;
+}
+#endif /* HTTP_CLIENT_NO_TLS */
+
+static artik_error http_conn_open(struct http_conn *conn, const char *url,
+		artik_ssl_config *ssl)
+{
+	char host[URI_MAX_HOST_LEN];
+	struct sockaddr_in addr;
+	struct timeval timeout;
+	artik_error ret = S_OK;
+
+	if (uri_get_host(url, host, URI_MAX_HOST_LEN) < 0)
+		return E_BAD_ARGS;
+
+	memset(&addr, 0, sizeof(addr));
+	ret = dns_cache_lookup(host, &addr.sin_addr);
+	if (ret != S_OK)
+		return ret;
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(uri_get_port(url));
+
+	conn->fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (conn->fd < 0)
+		return E_NO_MEM;
+
+	timeout.tv_sec = HTTP_CLIENT_TIMEOUT_S;
+	timeout.tv_usec = 0;
+	setsockopt(conn->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(conn->fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+	if (connect(conn->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		fprintf(stderr, "Failed to connect to %s\n", host);
+		return E_NOT_CONNECTED;
+	}
+
+	if (!uri_is_secure(url))
+		return S_OK;
+
+	return http_conn_handshake(conn, host, ssl);
+}
+
+static void http_conn_close(struct http_conn *conn)
+{
+	if (conn->tls)
+		http_conn_tls_close(conn);
+
+	if (conn->fd >= 0)
+		close(conn->fd);
+}
+
+static artik_error http_conn_write(struct http_conn *conn, const char *data, unsigned int len)
+{
+	int ret;
+
+	while (len) {
+		if (conn->tls)
+			ret = http_conn_tls_write(conn, data, len);
+		else
+			ret = send(conn->fd, data, len, 0);
+
+		if (ret <= 0)
+			return E_HTTP_ERROR;
+
+		data += ret;
+		len -= ret;
+	}
+
+	return S_OK;
+}
+
+/* Returns the number of bytes read, 0 once the server closed the connection */
+static int http_conn_read(struct http_conn *conn, char *buf, unsigned int len)
+{
+	if (conn->tls)
+		return http_conn_tls_read(conn, buf, len);
+
+	return recv(conn->fd, buf, len, 0);
+}
+
+/* Request lines and headers are gathered so that they go out in few segments */
+static artik_error http_conn_puts(struct http_conn *conn, const char *s)
+{
+	unsigned int len = strlen(s);
+	artik_error ret = S_OK;
+
+	if (conn->tx_fill + len > sizeof(conn->tx)) {
+		ret = http_conn_write(conn, conn->tx, conn->tx_fill);
+		conn->tx_fill = 0;
+		if (ret != S_OK)
+			return ret;
+	}
+
+	if (len > sizeof(conn->tx))
+		return http_conn_write(conn, s, len);
+
+	memcpy(conn->tx + conn->tx_fill, s, len);
+	conn->tx_fill += len;
+
+	return S_OK;
+}
+
+static bool http_client_reserved_header(const char *name)
+{
+	return !strcasecmp(name, "Host") || !strcasecmp(name, "Content-Length") ||
+		!strcasecmp(name, "Connection");
+}
+
+static artik_error http_client_send_request(struct http_conn *conn, const char *method,
+		const char *url, artik_http_headers *headers, const char *body)
+{
+	char host[URI_MAX_HOST_LEN + 8];
+	char length[32];
+	const char *path = uri_get_path(url);
+	artik_error ret = S_OK;
+	int port = uri_get_port(url);
+	int i;
+
+	uri_get_host(url, host, URI_MAX_HOST_LEN);
+	if (port != (uri_is_secure(url) ? 443 : 80))
+		snprintf(host + strlen(host), 8, ":%d", port);
+
+	ret = http_conn_puts(conn, method);
+	ret = ret ? ret : http_conn_puts(conn, (*path == '/') ? " " : " /");
+	ret = ret ? ret : http_conn_puts(conn, path);
+	ret = ret ? ret : http_conn_puts(conn, " HTTP/1.1\r\nHost: ");
+	ret = ret ? ret : http_conn_puts(conn, host);
+	ret = ret ? ret : http_conn_puts(conn, "\r\nConnection: close\r\n");
+	if (body) {
+		snprintf(length, sizeof(length), "Content-Length: %u\r\n",
+			(unsigned int)strlen(body));
+		ret = ret ? ret : http_conn_puts(conn, length);
+	}
+
+	for (i = 0; headers && (i < headers->num_fields); i++) {
+		if (http_client_reserved_header(headers->fields[i].name))
+			continue;
+		ret = ret ? ret : http_conn_puts(conn, headers->fields[i].name);
+		ret = ret ? ret : http_conn_puts(conn, ": ");
+		ret = ret ? ret : http_conn_puts(conn, headers->fields[i].data);
+		ret = ret ? ret : http_conn_puts(conn, "\r\n");
+	}
+
+	ret = ret ? ret : http_conn_puts(conn, "\r\n");
+	ret = ret ? ret : http_conn_write(conn, conn->tx, conn->tx_fill);
+	conn->tx_fill = 0;
+
+	if ((ret == S_OK) && body)
+		ret = http_conn_write(conn, body, strlen(body));
+
+	return ret;
+}
+
+artik_error http_client_request(const char *method, const char *url,
+		artik_http_headers *headers, const char *body, int *status,
+		const struct http_parser_handler *handler, artik_ssl_config *ssl)
+{
+	struct http_parser parser;
+	struct http_conn *conn = NULL;
+	char rx[HTTP_CLIENT_RX_SIZE];
+	artik_error ret = S_OK;
+	int n;
+
+	if (!method || !url || !handler)
+		return E_BAD_ARGS;
+
+	conn = malloc(sizeof(struct http_conn));
+	if (!conn)
+		return E_NO_MEM;
+
+	memset(conn, 0, sizeof(struct http_conn));
+	conn->fd = -1;
+
+	http_parser_init(&parser, handler, !strcmp(method, "HEAD"));
+
+	ret = http_conn_open(conn, url, ssl);
+	if (ret != S_OK)
+		goto exit;
+
+	ret = http_client_send_request(conn, method, url, headers, body);
+	if (ret != S_OK)
+		goto exit;
+
+	while (parser.state != HTTP_PARSER_DONE) {
+		n = http_conn_read(conn, rx, sizeof(rx));
+		if (n < 0) {
+			ret = E_HTTP_ERROR;
+			break;
+		}
+
+		if (n == 0) {
+			ret = http_parser_close(&parser);
+			break;
+		}
+
+		ret = http_parser_feed(&parser, rx, n);
+		if (ret != S_OK)
+			break;
+	}
+
+	if (status)
+		*status = parser.status;
+
+exit:
+	http_conn_close(conn);
+	free(conn);
+
+	return ret;
+}
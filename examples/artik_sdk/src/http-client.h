@@ -0,0 +1,46 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file http-client.h
+ */
+
+#ifndef __ARTIK_HTTP_CLIENT_H__
+#define __ARTIK_HTTP_CLIENT_H__
+
+#include <artik_error.h>
+#include <artik_http.h>
+#include <artik_ssl.h>
+
+#include "http-parser.h"
+
+#define HTTP_CLIENT_RX_SIZE		512
+#define HTTP_CLIENT_TIMEOUT_S	30
+
+/*
+ * Minimal HTTP/1.1 client for the responses the SDK can only return as one
+ * string. One request per connection ("Connection: close"), plain or over
+ * TLS, with the response read into a HTTP_CLIENT_RX_SIZE buffer and handed
+ * to http-parser, which calls the handler.
+ */
+artik_error http_client_request(const char *method, const char *url,
+		artik_http_headers *headers, const char *body, int *status,
+		const struct http_parser_handler *handler, artik_ssl_config *ssl);
+
+#endif /* __ARTIK_HTTP_CLIENT_H__ */
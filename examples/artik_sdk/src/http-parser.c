@@ -0,0 +1,210 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file http-parser.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "http-parser.h"
+
+/* Looks for a whole element of a list such as "gzip, chunked" */
+static bool http_parser_has_token(const char *value, const char *token)
+{
+	unsigned int len = strlen(token);
+	const char *end;
+
+	while (*value) {
+		while ((*value == ' ') || (*value == '\t') || (*value == ','))
+			value++;
+
+		/* Parameters after ';' are not part of the token */
+		end = value;
+		while (*end && (*end != ',') && (*end != ';') && (*end != ' ') && (*end != '\t'))
+			end++;
+
+		if (((unsigned int)(end - value) == len) && !strncasecmp(value, token, len))
+			return true;
+
+		value = end;
+		while (*value && (*value != ','))
+			value++;
+	}
+
+	return false;
+}
+
+static artik_error http_parser_end_of_headers(struct http_parser *p)
+{
+	/* Interim responses such as 100 Continue are followed by the real one */
+	if ((p->status >= 100) && (p->status < 200)) {
+		p->chunked = false;
+		p->has_length = false;
+		p->state = HTTP_PARSER_STATUS;
+	} else if (p->head || (p->status == 204) || (p->status == 304)) {
+		p->state = HTTP_PARSER_DONE;
+	} else if (p->chunked) {
+		p->state = HTTP_PARSER_CHUNK_SIZE;
+	} else if (p->has_length) {
+		p->state = p->remaining ? HTTP_PARSER_BODY : HTTP_PARSER_DONE;
+	} else {
+		p->state = HTTP_PARSER_BODY_UNTIL_CLOSE;
+	}
+
+	return S_OK;
+}
+
+static artik_error http_parser_header(struct http_parser *p)
+{
+	const struct http_parser_handler *handler = p->handler;
+	char *value = strchr(p->line, ':');
+
+	/* Not a header, and too broken to be worth failing the request over */
+	if (!value)
+		return S_OK;
+
+	*value++ = '\0';
+	while ((*value == ' ') || (*value == '\t'))
+		value++;
+
+	if (!strcasecmp(p->line, "Content-Length")) {
+		p->has_length = true;
+		p->remaining = strtoul(value, NULL, 10);
+	} else if (!strcasecmp(p->line, "Transfer-Encoding")) {
+		p->chunked = http_parser_has_token(value, "chunked");
+	}
+
+	if (handler->header && (handler->header(p->line, value, handler->user_data) < 0))
+		return E_INTERRUPTED;
+
+	return S_OK;
+}
+
+static artik_error http_parser_line(struct http_parser *p)
+{
+	char *end;
+
+	switch (p->state) {
+	case HTTP_PARSER_STATUS:
+		/* "HTTP/1.1 200 OK" */
+		if ((p->line_len < 12) || strncmp(p->line, "HTTP/1.", 7))
+			return E_HTTP_ERROR;
+		p->status = atoi(p->line + 9);
+		p->state = HTTP_PARSER_HEADERS;
+		break;
+	case HTTP_PARSER_HEADERS:
+		if (!p->line_len)
+			return http_parser_end_of_headers(p);
+		return http_parser_header(p);
+	case HTTP_PARSER_CHUNK_SIZE:
+		p->remaining = strtoul(p->line, &end, 16);
+		if (end == p->line)
+			return E_HTTP_ERROR;
+		p->state = p->remaining ? HTTP_PARSER_CHUNK_DATA : HTTP_PARSER_TRAILERS;
+		break;
+	case HTTP_PARSER_CHUNK_END:
+		if (p->line_len)
+			return E_HTTP_ERROR;
+		p->state = HTTP_PARSER_CHUNK_SIZE;
+		break;
+	case HTTP_PARSER_TRAILERS:
+		if (!p->line_len)
+			p->state = HTTP_PARSER_DONE;
+		break;
+	default:
+		break;
+	}
+
+	return S_OK;
+}
+
+static bool http_parser_in_line(struct http_parser *p)
+{
+	return (p->state != HTTP_PARSER_CHUNK_DATA) && (p->state != HTTP_PARSER_BODY) &&
+		(p->state != HTTP_PARSER_BODY_UNTIL_CLOSE);
+}
+
+artik_error http_parser_feed(struct http_parser *p, char *data, unsigned int len)
+{
+	const struct http_parser_handler *handler = p->handler;
+	artik_error ret = S_OK;
+	unsigned int n;
+	char c;
+
+	while (len && (p->state != HTTP_PARSER_DONE)) {
+		if (http_parser_in_line(p)) {
+			c = *data++;
+			len--;
+			if (c != '\n') {
+				/* Overlong lines are truncated, only headers can be that long */
+				if (p->line_len < HTTP_PARSER_LINE_MAX - 1)
+					p->line[p->line_len++] = c;
+				continue;
+			}
+
+			if (p->line_len && (p->line[p->line_len - 1] == '\r'))
+				p->line_len--;
+			p->line[p->line_len] = '\0';
+			ret = http_parser_line(p);
+			p->line_len = 0;
+			if (ret != S_OK)
+				return ret;
+			continue;
+		}
+
+		n = len;
+		if ((p->state != HTTP_PARSER_BODY_UNTIL_CLOSE) && (n > p->remaining))
+			n = p->remaining;
+
+		if (handler->body && (handler->body(data, n, handler->user_data) < 0))
+			return E_INTERRUPTED;
+
+		data += n;
+		len -= n;
+
+		if (p->state == HTTP_PARSER_BODY_UNTIL_CLOSE)
+			continue;
+
+		p->remaining -= n;
+		if (!p->remaining)
+			p->state = (p->state == HTTP_PARSER_CHUNK_DATA) ? HTTP_PARSER_CHUNK_END :
+				HTTP_PARSER_DONE;
+	}
+
+	return S_OK;
+}
+
+void http_parser_init(struct http_parser *p, const struct http_parser_handler *handler,
+		bool head)
+{
+	memset(p, 0, sizeof(struct http_parser));
+	p->handler = handler;
+	p->head = head;
+}
+
+artik_error http_parser_close(struct http_parser *p)
+{
+	/* Closing the connection only ends bodies of unknown length */
+	if (p->state == HTTP_PARSER_BODY_UNTIL_CLOSE)
+		p->state = HTTP_PARSER_DONE;
+
+	return (p->state == HTTP_PARSER_DONE) ? S_OK : E_HTTP_ERROR;
+}
@@ -0,0 +1,85 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file http-parser.h
+ */
+
+#ifndef __ARTIK_HTTP_PARSER_H__
+#define __ARTIK_HTTP_PARSER_H__
+
+#include <stdbool.h>
+
+#include <artik_error.h>
+
+#define HTTP_PARSER_LINE_MAX	256
+
+/*
+ * Incremental parser of HTTP/1.1 responses, kept apart from the sockets
+ * so that it builds and is tested on the host.
+ *
+ * Response headers and body pieces are handed to the callbacks as they are
+ * parsed, straight out of the buffer given to http_parser_feed(), which can
+ * split the response anywhere. A negative return from either callback
+ * aborts the response with E_INTERRUPTED. Interim 1xx responses are parsed
+ * and skipped, and 204, 304 and HEAD responses end with their headers.
+ */
+typedef int (*http_parser_header_cb)(const char *name, const char *value, void *user_data);
+typedef int (*http_parser_body_cb)(char *data, unsigned int len, void *user_data);
+
+struct http_parser_handler {
+	http_parser_header_cb header;
+	http_parser_body_cb body;
+	void *user_data;
+};
+
+enum http_parser_state {
+	HTTP_PARSER_STATUS,
+	HTTP_PARSER_HEADERS,
+	HTTP_PARSER_CHUNK_SIZE,
+	HTTP_PARSER_CHUNK_DATA,
+	HTTP_PARSER_CHUNK_END,
+	HTTP_PARSER_TRAILERS,
+	HTTP_PARSER_BODY,
+	HTTP_PARSER_BODY_UNTIL_CLOSE,
+	HTTP_PARSER_DONE
+};
+
+struct http_parser {
+	enum http_parser_state state;
+	const struct http_parser_handler *handler;
+	char line[HTTP_PARSER_LINE_MAX];
+	unsigned int line_len;
+	int status;
+	bool head;
+	bool chunked;
+	bool has_length;
+	unsigned long remaining;
+};
+
+/*
+ * head is set for responses to HEAD requests, which have no body whatever
+ * their headers say. http_parser_close() is called when the server closes
+ * the connection and fails unless that ends the response.
+ */
+void http_parser_init(struct http_parser *p, const struct http_parser_handler *handler,
+		bool head);
+artik_error http_parser_feed(struct http_parser *p, char *data, unsigned int len);
+artik_error http_parser_close(struct http_parser *p);
+
+#endif /* __ARTIK_HTTP_PARSER_H__ */
@@ -0,0 +1,207 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file http-stream.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "http-client.h"
+#include "http-stream.h"
+#include "perf-stats.h"
+#include "uri.h"
+
+static int http_stream_flush(struct http_stream *stream)
+{
+	int ret = 0;
+
+	if (stream->fill && !stream->aborted) {
+		ret = stream->sink(stream->buf, stream->fill, stream->user_data);
+		if (ret < 0)
+			stream->aborted = true;
+	}
+
+	stream->fill = 0;
+
+	return ret;
+}
+
+static int http_stream_put(const char *data, unsigned int len, void *user_data)
+{
+	struct http_stream *stream = (struct http_stream *)user_data;
+	unsigned int consumed = 0;
+
+	while (consumed < len) {
+		unsigned int room = stream->size - stream->fill;
+		unsigned int n = (len - consumed) < room ? (len - consumed) : room;
+
+		memcpy(stream->buf + stream->fill, data + consumed, n);
+		stream->fill += n;
+		consumed += n;
+
+		if ((stream->fill == stream->size) && (http_stream_flush(stream) < 0))
+			return -1;
+	}
+
+	stream->total += len;
+
+	return len;
+}
+
+/*
+ * The sink runs in the receive path, so a slow consumer delays the next
+ * socket read and the TCP window throttles the sender.
+ */
+static int http_stream_feed(char *data, unsigned int len, void *user_data)
+{
+	struct http_stream *stream = (struct http_stream *)user_data;
+	uint64_t start;
+	int ret;
+
+	/* The sink or the inflater gave up, nothing more reaches them */
+	if (stream->aborted)
+		return -1;
+
+	stream->received += len;
+
+	if (!stream->inflater)
+		return http_stream_put(data, len, stream);
+
+	start = perf_now_us();
+	ret = inflate_feed(stream->inflater, data, len);
+	stream->inflate_us += perf_now_us() - start;
+
+	if (ret == INFLATE_ERROR) {
+		stream->aborted = true;
+		return -1;
+	}
+
+	return len;
+}
+
+/* Only a Content-Encoding announced by the server turns the inflater on */
+static int http_stream_header(const char *name, const char *value, void *user_data)
+{
+	struct http_stream *stream = (struct http_stream *)user_data;
+	enum inflate_wrapper wrapper;
+
+	if (stream->header)
+		stream->header(name, value, stream->user_data);
+
+	if (!(stream->flags & HTTP_STREAM_ACCEPT_ENCODING) ||
+			strcasecmp(name, "Content-Encoding") || !strcasecmp(value, "identity"))
+		return 0;
+
+	if (!strcasecmp(value, "gzip") || !strcasecmp(value, "x-gzip")) {
+		wrapper = INFLATE_WRAPPER_GZIP;
+	} else if (!strcasecmp(value, "deflate")) {
+		/* zlib as specified, or raw DEFLATE as some servers send it */
+		wrapper = INFLATE_WRAPPER_AUTO;
+	} else {
+		fprintf(stderr, "Unsupported content encoding %s\n", value);
+		stream->aborted = true;
+		return -1;
+	}
+
+	if (stream->inflater)
+		return 0;
+
+	stream->inflater = malloc(sizeof(struct inflate_stream));
+	if (!stream->inflater) {
+		stream->aborted = true;
+		return -1;
+	}
+	inflate_init(stream->inflater, wrapper, http_stream_put, stream);
+
+	return 0;
+}
+
+void http_stream_init(struct http_stream *stream, char *buf, unsigned int size,
+		http_stream_sink sink, void *user_data)
+{
+	memset(stream, 0, sizeof(struct http_stream));
+	stream->buf = buf;
+	stream->size = size;
+	stream->sink = sink;
+	stream->user_data = user_data;
+}
+
+artik_error http_stream_request(enum http_stream_method method, const char *url,
+		artik_http_headers *headers, const char *body, int *status,
+		struct http_stream *stream)
+{
+	static const char * const methods[] = { "GET", "POST", "PUT", "DELETE" };
+	struct http_parser_handler handler;
+	artik_error ret = S_OK;
+	artik_http_headers encoded;
+	artik_http_header_field fields[HTTP_STREAM_MAX_HEADERS];
+
+	if (!url || !stream || !stream->buf || !stream->size || !stream->sink ||
+			(method > HTTP_STREAM_DELETE))
+		return E_BAD_ARGS;
+
+	if (uri_is_secure(url) && !stream->ssl) {
+		fprintf(stderr, "No TLS configuration for %s\n", url);
+		return E_BAD_ARGS;
+	}
+
+	if (stream->flags & HTTP_STREAM_ACCEPT_ENCODING) {
+		int num = headers ? headers->num_fields : 0;
+
+		if (num >= HTTP_STREAM_MAX_HEADERS)
+			return E_BAD_ARGS;
+
+		if (num)
+			memcpy(fields, headers->fields, num * sizeof(artik_http_header_field));
+		fields[num].name = "Accept-Encoding";
+		fields[num].data = "gzip, deflate";
+		encoded.fields = fields;
+		encoded.num_fields = num + 1;
+		headers = &encoded;
+	}
+
+	/*
+	 * The SDK only streams GET and returns the other verbs as one string,
+	 * so every verb goes through the local HTTP client instead.
+	 */
+	handler.header = http_stream_header;
+	handler.body = http_stream_feed;
+	handler.user_data = stream;
+
+	ret = http_client_request(methods[method], url, headers, body, status, &handler,
+		stream->ssl);
+
+	if (stream->inflater) {
+		if ((ret == S_OK) && !inflate_finished(stream->inflater))
+			stream->aborted = true;
+		free(stream->inflater);
+		stream->inflater = NULL;
+	}
+
+	if (ret == S_OK)
+		http_stream_flush(stream);
+
+	if (stream->aborted)
+		ret = E_INTERRUPTED;
+
+	return ret;
+}
@@ -0,0 +1,94 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file http-stream.h
+ */
+
+#ifndef __ARTIK_HTTP_STREAM_H__
+#define __ARTIK_HTTP_STREAM_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <artik_error.h>
+#include <artik_http.h>
+#include <artik_ssl.h>
+
+#include "inflate.h"
+
+#define HTTP_STREAM_CHUNK_SIZE	512
+#define HTTP_STREAM_MAX_HEADERS	16
+
+/*
+ * Advertise "Accept-Encoding: gzip, deflate" and inflate the response
+ * before it reaches the sink when the server answers with a matching
+ * Content-Encoding. The body itself is never sniffed, and the inflater
+ * (about 33 KB) is only allocated for encoded responses.
+ */
+#define HTTP_STREAM_ACCEPT_ENCODING	(1 << 0)
+
+enum http_stream_method {
+	HTTP_STREAM_GET,
+	HTTP_STREAM_POST,
+	HTTP_STREAM_PUT,
+	HTTP_STREAM_DELETE
+};
+
+/*
+ * Called each time the caller-provided buffer is full and once more with
+ * the remaining bytes when the response ends. Return a negative value to
+ * abort the transfer.
+ */
+typedef int (*http_stream_sink)(const char *data, unsigned int len, void *user_data);
+
+/*
+ * Optional, set after http_stream_init() to see each response header. It
+ * gets the same user_data as the sink.
+ */
+typedef void (*http_stream_header_cb)(const char *name, const char *value, void *user_data);
+
+/*
+ * https:// URLs are refused unless the caller sets ssl after
+ * http_stream_init(), so that each one decides how the server is verified.
+ * The configuration is only read during the request.
+ */
+
+struct http_stream {
+	char *buf;
+	unsigned int size;
+	unsigned int fill;
+	unsigned int total;
+	unsigned int received;
+	unsigned int flags;
+	uint32_t inflate_us;
+	bool aborted;
+	struct inflate_stream *inflater;
+	http_stream_sink sink;
+	http_stream_header_cb header;
+	artik_ssl_config *ssl;
+	void *user_data;
+};
+
+void http_stream_init(struct http_stream *stream, char *buf, unsigned int size,
+		http_stream_sink sink, void *user_data);
+artik_error http_stream_request(enum http_stream_method method, const char *url,
+		artik_http_headers *headers, const char *body, int *status,
+		struct http_stream *stream);
+
+#endif /* __ARTIK_HTTP_STREAM_H__ */
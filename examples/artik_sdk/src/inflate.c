@@ -0,0 +1,646 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file inflate.c
+ */
+
+#include <string.h>
+
+#include "inflate.h"
+
+#define GZIP_FHCRC		0x02
+#define GZIP_FEXTRA		0x04
+#define GZIP_FNAME		0x08
+#define GZIP_FCOMMENT	0x10
+
+#define ZLIB_FDICT		0x20
+
+#define INFLATE_NEED_INPUT	-2
+#define INFLATE_BAD_CODE	-3
+
+enum inflate_state_id {
+	ST_WRAPPER,
+	ST_GZIP_HEADER,
+	ST_GZIP_EXTRA_LEN,
+	ST_GZIP_EXTRA,
+	ST_GZIP_NAME,
+	ST_GZIP_COMMENT,
+	ST_GZIP_HCRC,
+	ST_ZLIB_HEADER,
+	ST_BLOCK,
+	ST_STORED_LEN,
+	ST_STORED_NLEN,
+	ST_STORED_COPY,
+	ST_DYN_HEADER,
+	ST_DYN_CODELENS,
+	ST_DYN_LENS,
+	ST_DYN_REPEAT,
+	ST_CODES,
+	ST_LEN_EXTRA,
+	ST_DIST,
+	ST_DIST_EXTRA,
+	ST_COPY,
+	ST_TRAILER,
+	ST_DONE,
+	ST_ERROR
+};
+
+static const uint16_t length_base[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t length_extra[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const uint16_t dist_base[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+	8193, 12289, 16385, 24577
+};
+
+static const uint8_t dist_extra[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static const uint8_t codelen_order[19] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+static const uint32_t crc32_nibble[16] = {
+	0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+	0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+	0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+	0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+};
+
+uint32_t inflate_crc32(uint32_t crc, const unsigned char *data, unsigned int len)
+{
+	crc = ~crc;
+	while (len--) {
+		crc ^= *data++;
+		crc = (crc >> 4) ^ crc32_nibble[crc & 0x0f];
+		crc = (crc >> 4) ^ crc32_nibble[crc & 0x0f];
+	}
+
+	return ~crc;
+}
+
+static void inflate_update_check(struct inflate_stream *strm,
+		const unsigned char *data, unsigned int len)
+{
+	uint32_t check = strm->check;
+
+	if (strm->wrapper == INFLATE_WRAPPER_GZIP) {
+		check = inflate_crc32(check, data, len);
+	} else if (strm->wrapper == INFLATE_WRAPPER_ZLIB) {
+		uint32_t a = check & 0xffff;
+		uint32_t b = check >> 16;
+
+		while (len) {
+			unsigned int n = len < 5552 ? len : 5552;
+
+			len -= n;
+			while (n--) {
+				a += *data++;
+				b += a;
+			}
+			a %= 65521;
+			b %= 65521;
+		}
+		check = (b << 16) | a;
+	}
+
+	strm->check = check;
+}
+
+static int inflate_flush(struct inflate_stream *strm)
+{
+	unsigned int len = strm->wpos - strm->wflush;
+	const unsigned char *data = strm->window + strm->wflush;
+
+	if (!len)
+		return 0;
+
+	strm->wflush = strm->wpos;
+	inflate_update_check(strm, data, len);
+
+	return strm->sink((const char *)data, len, strm->user_data) < 0 ? -1 : 0;
+}
+
+static int inflate_put(struct inflate_stream *strm, unsigned char c)
+{
+	strm->window[strm->wpos++] = c;
+	strm->total++;
+
+	if (strm->wpos == INFLATE_WINDOW_SIZE) {
+		if (inflate_flush(strm) < 0)
+			return -1;
+		strm->wpos = 0;
+		strm->wflush = 0;
+	}
+
+	return 0;
+}
+
+static bool need_bits(struct inflate_stream *strm, unsigned int n)
+{
+	while (strm->bitcnt < n) {
+		if (!strm->avail)
+			return false;
+		strm->bitbuf |= (uint32_t)*strm->next++ << strm->bitcnt;
+		strm->avail--;
+		strm->bitcnt += 8;
+	}
+
+	return true;
+}
+
+static unsigned int get_bits(struct inflate_stream *strm, unsigned int n)
+{
+	unsigned int value = strm->bitbuf & ((1UL << n) - 1);
+
+	strm->bitbuf >>= n;
+	strm->bitcnt -= n;
+
+	return value;
+}
+
+static void align_byte(struct inflate_stream *strm)
+{
+	get_bits(strm, strm->bitcnt & 7);
+}
+
+static int build_huffman(struct inflate_huffman *h, const uint8_t *lens, unsigned int n)
+{
+	uint16_t offs[16];
+	int left = 1;
+	unsigned int i;
+
+	memset(h->counts, 0, sizeof(h->counts));
+	for (i = 0; i < n; i++)
+		h->counts[lens[i]]++;
+	h->counts[0] = 0;
+
+	for (i = 1; i < 16; i++) {
+		left <<= 1;
+		left -= h->counts[i];
+		if (left < 0)
+			return -1;
+	}
+
+	offs[1] = 0;
+	for (i = 1; i < 15; i++)
+		offs[i + 1] = offs[i] + h->counts[i];
+
+	for (i = 0; i < n; i++) {
+		if (lens[i])
+			h->symbols[offs[lens[i]]++] = i;
+	}
+
+	return 0;
+}
+
+/*
+ * Canonical decode, one bit at a time. Bits are only consumed once a
+ * symbol is complete, so running out of input simply restarts the decode
+ * on the next call.
+ */
+static int decode_symbol(struct inflate_stream *strm, const struct inflate_huffman *h)
+{
+	int code = 0;
+	int first = 0;
+	int index = 0;
+	unsigned int len;
+
+	for (len = 1; len < 16; len++) {
+		int count = h->counts[len];
+
+		if (!need_bits(strm, len))
+			return INFLATE_NEED_INPUT;
+
+		code |= (strm->bitbuf >> (len - 1)) & 1;
+		if (code - count < first) {
+			get_bits(strm, len);
+			return h->symbols[index + (code - first)];
+		}
+
+		index += count;
+		first += count;
+		first <<= 1;
+		code <<= 1;
+	}
+
+	return INFLATE_BAD_CODE;
+}
+
+static void build_fixed(struct inflate_stream *strm)
+{
+	unsigned int i;
+
+	for (i = 0; i < 144; i++)
+		strm->lens[i] = 8;
+	for (; i < 256; i++)
+		strm->lens[i] = 9;
+	for (; i < 280; i++)
+		strm->lens[i] = 7;
+	for (; i < 288; i++)
+		strm->lens[i] = 8;
+	build_huffman(&strm->lencode, strm->lens, 288);
+
+	for (i = 0; i < 30; i++)
+		strm->lens[i] = 5;
+	build_huffman(&strm->distcode, strm->lens, 30);
+}
+
+static int inflate_run(struct inflate_stream *strm)
+{
+	int sym;
+
+	for (;;) {
+		switch (strm->state) {
+		case ST_WRAPPER:
+			if (strm->wrapper == INFLATE_WRAPPER_AUTO) {
+				if (!need_bits(strm, 16))
+					return INFLATE_OK;
+				if ((strm->bitbuf & 0xffff) == 0x8b1f)
+					strm->wrapper = INFLATE_WRAPPER_GZIP;
+				else if (((strm->bitbuf & 0x0f) == 8) &&
+						(((strm->bitbuf & 0xff) << 8 |
+						  ((strm->bitbuf >> 8) & 0xff)) % 31 == 0))
+					strm->wrapper = INFLATE_WRAPPER_ZLIB;
+				else
+					strm->wrapper = INFLATE_WRAPPER_RAW;
+			}
+
+			strm->count = 0;
+			if (strm->wrapper == INFLATE_WRAPPER_GZIP) {
+				strm->check = 0;
+				strm->state = ST_GZIP_HEADER;
+			} else if (strm->wrapper == INFLATE_WRAPPER_ZLIB) {
+				strm->check = 1;
+				strm->state = ST_ZLIB_HEADER;
+			} else {
+				strm->state = ST_BLOCK;
+			}
+			break;
+
+		case ST_GZIP_HEADER:
+			/* ID1 ID2 CM FLG MTIME(4) XFL OS */
+			while (strm->count < 10) {
+				unsigned int c;
+
+				if (!need_bits(strm, 8))
+					return INFLATE_OK;
+				c = get_bits(strm, 8);
+				if (((strm->count == 0) && (c != 0x1f)) ||
+						((strm->count == 1) && (c != 0x8b)) ||
+						((strm->count == 2) && (c != 8)))
+					return INFLATE_ERROR;
+				if (strm->count == 3)
+					strm->flags = c;
+				strm->count++;
+			}
+			strm->state = ST_GZIP_EXTRA_LEN;
+			break;
+
+		case ST_GZIP_EXTRA_LEN:
+			if (strm->flags & GZIP_FEXTRA) {
+				if (!need_bits(strm, 16))
+					return INFLATE_OK;
+				strm->length = get_bits(strm, 16);
+			} else {
+				strm->length = 0;
+			}
+			strm->state = ST_GZIP_EXTRA;
+			break;
+
+		case ST_GZIP_EXTRA:
+			while (strm->length) {
+				if (!need_bits(strm, 8))
+					return INFLATE_OK;
+				get_bits(strm, 8);
+				strm->length--;
+			}
+			strm->state = ST_GZIP_NAME;
+			break;
+
+		case ST_GZIP_NAME:
+		case ST_GZIP_COMMENT:
+			if (strm->flags & ((strm->state == ST_GZIP_NAME) ?
+						GZIP_FNAME : GZIP_FCOMMENT)) {
+				do {
+					if (!need_bits(strm, 8))
+						return INFLATE_OK;
+				} while (get_bits(strm, 8));
+			}
+			strm->state++;
+			break;
+
+		case ST_GZIP_HCRC:
+			if (strm->flags & GZIP_FHCRC) {
+				if (!need_bits(strm, 16))
+					return INFLATE_OK;
+				get_bits(strm, 16);
+			}
+			strm->state = ST_BLOCK;
+			break;
+
+		case ST_ZLIB_HEADER:
+			if (!need_bits(strm, 16))
+				return INFLATE_OK;
+			if (((strm->bitbuf >> 4) & 0x0f) + 8 > INFLATE_WINDOW_BITS)
+				return INFLATE_ERROR;
+			if ((strm->bitbuf >> 8) & ZLIB_FDICT)
+				return INFLATE_ERROR;
+			get_bits(strm, 16);
+			strm->state = ST_BLOCK;
+			break;
+
+		case ST_BLOCK:
+			if (strm->final) {
+				strm->count = 0;
+				strm->trailer = 0;
+				strm->state = ST_TRAILER;
+				break;
+			}
+			if (!need_bits(strm, 3))
+				return INFLATE_OK;
+			strm->final = get_bits(strm, 1);
+			switch (get_bits(strm, 2)) {
+			case 0:
+				align_byte(strm);
+				strm->state = ST_STORED_LEN;
+				break;
+			case 1:
+				build_fixed(strm);
+				strm->state = ST_CODES;
+				break;
+			case 2:
+				strm->state = ST_DYN_HEADER;
+				break;
+			default:
+				return INFLATE_ERROR;
+			}
+			break;
+
+		case ST_STORED_LEN:
+			if (!need_bits(strm, 16))
+				return INFLATE_OK;
+			strm->length = get_bits(strm, 16);
+			strm->state = ST_STORED_NLEN;
+			break;
+
+		case ST_STORED_NLEN:
+			if (!need_bits(strm, 16))
+				return INFLATE_OK;
+			if ((get_bits(strm, 16) ^ 0xffff) != strm->length)
+				return INFLATE_ERROR;
+			strm->state = ST_STORED_COPY;
+			break;
+
+		case ST_STORED_COPY:
+			while (strm->length) {
+				if (!need_bits(strm, 8))
+					return INFLATE_OK;
+				if (inflate_put(strm, get_bits(strm, 8)) < 0)
+					return INFLATE_ERROR;
+				strm->length--;
+			}
+			strm->state = ST_BLOCK;
+			break;
+
+		case ST_DYN_HEADER:
+			if (!need_bits(strm, 14))
+				return INFLATE_OK;
+			strm->hlit = get_bits(strm, 5) + 257;
+			strm->hdist = get_bits(strm, 5) + 1;
+			strm->hclen = get_bits(strm, 4) + 4;
+			if ((strm->hlit > 286) || (strm->hdist > 30))
+				return INFLATE_ERROR;
+			memset(strm->lens, 0, 19);
+			strm->index = 0;
+			strm->state = ST_DYN_CODELENS;
+			break;
+
+		case ST_DYN_CODELENS:
+			while (strm->index < strm->hclen) {
+				if (!need_bits(strm, 3))
+					return INFLATE_OK;
+				strm->lens[codelen_order[strm->index++]] = get_bits(strm, 3);
+			}
+			/* The code length code is kept in distcode until both are read */
+			if (build_huffman(&strm->distcode, strm->lens, 19) < 0)
+				return INFLATE_ERROR;
+			strm->index = 0;
+			strm->state = ST_DYN_LENS;
+			break;
+
+		case ST_DYN_LENS:
+			while (strm->index < strm->hlit + strm->hdist) {
+				sym = decode_symbol(strm, &strm->distcode);
+				if (sym == INFLATE_NEED_INPUT)
+					return INFLATE_OK;
+				if (sym < 0)
+					return INFLATE_ERROR;
+				if (sym < 16) {
+					strm->lens[strm->index++] = sym;
+					continue;
+				}
+				if ((sym == 16) && !strm->index)
+					return INFLATE_ERROR;
+				strm->symbol = sym;
+				strm->state = ST_DYN_REPEAT;
+				break;
+			}
+			if (strm->state == ST_DYN_REPEAT)
+				break;
+
+			if (!strm->lens[256])
+				return INFLATE_ERROR;
+			if ((build_huffman(&strm->lencode, strm->lens, strm->hlit) < 0) ||
+					(build_huffman(&strm->distcode, strm->lens + strm->hlit,
+						       strm->hdist) < 0))
+				return INFLATE_ERROR;
+			strm->state = ST_CODES;
+			break;
+
+		case ST_DYN_REPEAT: {
+			unsigned int bits = (strm->symbol == 16) ? 2 : (strm->symbol == 17) ? 3 : 7;
+			unsigned int base = (strm->symbol == 18) ? 11 : 3;
+			uint8_t value = 0;
+			unsigned int repeat;
+
+			if (!need_bits(strm, bits))
+				return INFLATE_OK;
+			repeat = base + get_bits(strm, bits);
+			if (strm->symbol == 16)
+				value = strm->lens[strm->index - 1];
+			if (strm->index + repeat > strm->hlit + strm->hdist)
+				return INFLATE_ERROR;
+			while (repeat--)
+				strm->lens[strm->index++] = value;
+			strm->state = ST_DYN_LENS;
+			break;
+		}
+
+		case ST_CODES:
+			sym = decode_symbol(strm, &strm->lencode);
+			if (sym == INFLATE_NEED_INPUT)
+				return INFLATE_OK;
+			if (sym < 0)
+				return INFLATE_ERROR;
+			if (sym < 256) {
+				if (inflate_put(strm, sym) < 0)
+					return INFLATE_ERROR;
+			} else if (sym == 256) {
+				strm->state = ST_BLOCK;
+			} else {
+				strm->symbol = sym - 257;
+				if (strm->symbol >= 29)
+					return INFLATE_ERROR;
+				strm->state = ST_LEN_EXTRA;
+			}
+			break;
+
+		case ST_LEN_EXTRA:
+			if (!need_bits(strm, length_extra[strm->symbol]))
+				return INFLATE_OK;
+			strm->length = length_base[strm->symbol] +
+				get_bits(strm, length_extra[strm->symbol]);
+			strm->state = ST_DIST;
+			break;
+
+		case ST_DIST:
+			sym = decode_symbol(strm, &strm->distcode);
+			if (sym == INFLATE_NEED_INPUT)
+				return INFLATE_OK;
+			if ((sym < 0) || (sym >= 30))
+				return INFLATE_ERROR;
+			strm->symbol = sym;
+			strm->state = ST_DIST_EXTRA;
+			break;
+
+		case ST_DIST_EXTRA:
+			if (!need_bits(strm, dist_extra[strm->symbol]))
+				return INFLATE_OK;
+			strm->distance = dist_base[strm->symbol] +
+				get_bits(strm, dist_extra[strm->symbol]);
+			if ((strm->distance > INFLATE_WINDOW_SIZE) ||
+					(strm->distance > strm->total))
+				return INFLATE_ERROR;
+			strm->state = ST_COPY;
+			break;
+
+		case ST_COPY:
+			while (strm->length) {
+				unsigned int from = (strm->wpos - strm->distance) &
+					(INFLATE_WINDOW_SIZE - 1);
+
+				if (inflate_put(strm, strm->window[from]) < 0)
+					return INFLATE_ERROR;
+				strm->length--;
+			}
+			strm->state = ST_CODES;
+			break;
+
+		case ST_TRAILER: {
+			unsigned int size = (strm->wrapper == INFLATE_WRAPPER_GZIP) ? 8 :
+				(strm->wrapper == INFLATE_WRAPPER_ZLIB) ? 4 : 0;
+
+			if (!strm->count)
+				align_byte(strm);
+
+			while (strm->count < size) {
+				unsigned int c;
+
+				if (!need_bits(strm, 8))
+					return INFLATE_OK;
+				c = get_bits(strm, 8);
+
+				if (strm->wrapper == INFLATE_WRAPPER_GZIP) {
+					/* CRC32 then ISIZE, both little endian */
+					if (strm->count < 4)
+						strm->trailer |= c << (8 * strm->count);
+					else if (c != ((strm->total >> (8 * (strm->count - 4))) & 0xff))
+						return INFLATE_ERROR;
+				} else {
+					/* Adler32, big endian */
+					strm->trailer = (strm->trailer << 8) | c;
+				}
+				strm->count++;
+			}
+
+			if (inflate_flush(strm) < 0)
+				return INFLATE_ERROR;
+			if (size && (strm->trailer != strm->check))
+				return INFLATE_ERROR;
+			strm->state = ST_DONE;
+			break;
+		}
+
+		case ST_DONE:
+			return INFLATE_DONE;
+
+		default:
+			return INFLATE_ERROR;
+		}
+	}
+}
+
+void inflate_init(struct inflate_stream *strm, enum inflate_wrapper wrapper,
+		inflate_sink sink, void *user_data)
+{
+	memset(strm, 0, sizeof(struct inflate_stream) - INFLATE_WINDOW_SIZE);
+	strm->state = ST_WRAPPER;
+	strm->wrapper = wrapper;
+	strm->sink = sink;
+	strm->user_data = user_data;
+}
+
+int inflate_feed(struct inflate_stream *strm, const char *data, unsigned int len)
+{
+	int ret;
+
+	if (strm->state == ST_ERROR)
+		return INFLATE_ERROR;
+
+	strm->next = (const unsigned char *)data;
+	strm->avail = len;
+
+	ret = inflate_run(strm);
+	if ((ret == INFLATE_OK) && (inflate_flush(strm) < 0))
+		ret = INFLATE_ERROR;
+
+	if (ret == INFLATE_ERROR)
+		strm->state = ST_ERROR;
+
+	strm->next = NULL;
+	strm->avail = 0;
+
+	return ret;
+}
+
+bool inflate_finished(const struct inflate_stream *strm)
+{
+	return strm->state == ST_DONE;
+}
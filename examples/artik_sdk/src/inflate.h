@@ -0,0 +1,101 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file inflate.h
+ */
+
+#ifndef __ARTIK_INFLATE_H__
+#define __ARTIK_INFLATE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Streaming DEFLATE decoder (RFC 1951) with gzip (RFC 1952) and zlib
+ * (RFC 1950) wrappers. Input can be pushed in arbitrarily small pieces
+ * and decoded data is handed to the sink as it leaves the sliding window,
+ * so memory use is fixed at about sizeof(struct inflate_stream).
+ *
+ * INFLATE_WINDOW_BITS can be lowered when the server is known to compress
+ * with a smaller window; streams referring further back are rejected.
+ */
+#ifndef INFLATE_WINDOW_BITS
+#define INFLATE_WINDOW_BITS	15
+#endif
+#define INFLATE_WINDOW_SIZE	(1 << INFLATE_WINDOW_BITS)
+
+#define INFLATE_OK		0
+#define INFLATE_DONE	1
+#define INFLATE_ERROR	-1
+
+enum inflate_wrapper {
+	INFLATE_WRAPPER_AUTO,
+	INFLATE_WRAPPER_GZIP,
+	INFLATE_WRAPPER_ZLIB,
+	INFLATE_WRAPPER_RAW
+};
+
+typedef int (*inflate_sink)(const char *data, unsigned int len, void *user_data);
+
+struct inflate_huffman {
+	uint16_t counts[16];
+	uint16_t symbols[288];
+};
+
+struct inflate_stream {
+	int state;
+	enum inflate_wrapper wrapper;
+	inflate_sink sink;
+	void *user_data;
+
+	const unsigned char *next;
+	unsigned int avail;
+	uint32_t bitbuf;
+	unsigned int bitcnt;
+
+	bool final;
+	unsigned int flags;
+	unsigned int count;
+	unsigned int index;
+	unsigned int hlit;
+	unsigned int hdist;
+	unsigned int hclen;
+	unsigned int symbol;
+	unsigned int length;
+	unsigned int distance;
+	uint32_t check;
+	uint32_t trailer;
+	uint32_t total;
+
+	struct inflate_huffman lencode;
+	struct inflate_huffman distcode;
+	uint8_t lens[288 + 32];
+
+	unsigned int wpos;
+	unsigned int wflush;
+	unsigned char window[INFLATE_WINDOW_SIZE];
+};
+
+void inflate_init(struct inflate_stream *strm, enum inflate_wrapper wrapper,
+		inflate_sink sink, void *user_data);
+int inflate_feed(struct inflate_stream *strm, const char *data, unsigned int len);
+bool inflate_finished(const struct inflate_stream *strm);
+uint32_t inflate_crc32(uint32_t crc, const unsigned char *data, unsigned int len);
+
+#endif /* __ARTIK_INFLATE_H__ */
@@ -0,0 +1,140 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file perf-stats.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "perf-stats.h"
+
+uint64_t perf_now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void perf_stats_reset(struct perf_stats *stats)
+{
+	memset(stats, 0, sizeof(struct perf_stats));
+}
+
+void perf_stats_add(struct perf_stats *stats, uint32_t elapsed_us)
+{
+	if (!stats->count || elapsed_us < stats->min_us)
+		stats->min_us = elapsed_us;
+	if (elapsed_us > stats->max_us)
+		stats->max_us = elapsed_us;
+
+	stats->total_us += elapsed_us;
+	stats->count++;
+}
+
+void perf_stats_print(const char *label, const struct perf_stats *stats)
+{
+	if (!stats->count) {
+		fprintf(stdout, "%s: no samples\n", label);
+		return;
+	}
+
+	fprintf(stdout, "%s: n=%u min=%u.%03ums avg=%u.%03ums max=%u.%03ums\n",
+		label, stats->count,
+		stats->min_us / 1000, stats->min_us % 1000,
+		(uint32_t)(stats->total_us / stats->count) / 1000,
+		(uint32_t)(stats->total_us / stats->count) % 1000,
+		stats->max_us / 1000, stats->max_us % 1000);
+}
+
+static unsigned int perf_hist_index(uint32_t value)
+{
+	unsigned int msb = 31;
+
+	if (value < (1 << (PERF_HIST_SUB_BITS + 1)))
+		return value;
+
+	while (!(value & (1UL << msb)))
+		msb--;
+
+	return (1 << (PERF_HIST_SUB_BITS + 1)) +
+		((msb - PERF_HIST_SUB_BITS - 1) << PERF_HIST_SUB_BITS) +
+		((value >> (msb - PERF_HIST_SUB_BITS)) & ((1 << PERF_HIST_SUB_BITS) - 1));
+}
+
+static uint32_t perf_hist_upper_bound(unsigned int index)
+{
+	unsigned int msb;
+	unsigned int sub;
+
+	if (index < (1 << (PERF_HIST_SUB_BITS + 1)))
+		return index;
+
+	index -= 1 << (PERF_HIST_SUB_BITS + 1);
+	msb = (index >> PERF_HIST_SUB_BITS) + PERF_HIST_SUB_BITS + 1;
+	sub = index & ((1 << PERF_HIST_SUB_BITS) - 1);
+
+	return (((1UL << PERF_HIST_SUB_BITS) + sub + 1) << (msb - PERF_HIST_SUB_BITS)) - 1;
+}
+
+void perf_hist_reset(struct perf_histogram *hist)
+{
+	memset(hist, 0, sizeof(struct perf_histogram));
+}
+
+void perf_hist_add(struct perf_histogram *hist, uint32_t elapsed_us)
+{
+	perf_stats_add(&hist->stats, elapsed_us);
+	hist->buckets[perf_hist_index(elapsed_us)]++;
+}
+
+uint32_t perf_hist_percentile(const struct perf_histogram *hist, unsigned int permille)
+{
+	uint64_t target = ((uint64_t)hist->stats.count * permille + 999) / 1000;
+	uint64_t seen = 0;
+	unsigned int i;
+
+	if (!hist->stats.count)
+		return 0;
+
+	for (i = 0; i < PERF_HIST_BUCKETS; i++) {
+		seen += hist->buckets[i];
+		if (seen >= target) {
+			uint32_t bound = perf_hist_upper_bound(i);
+
+			return bound < hist->stats.max_us ? bound : hist->stats.max_us;
+		}
+	}
+
+	return hist->stats.max_us;
+}
+
+void perf_hist_print(const char *label, const struct perf_histogram *hist)
+{
+	perf_stats_print(label, &hist->stats);
+	if (!hist->stats.count)
+		return;
+
+	fprintf(stdout, "\tp50=%uus p90=%uus p99=%uus max=%uus\n",
+		perf_hist_percentile(hist, 500), perf_hist_percentile(hist, 900),
+		perf_hist_percentile(hist, 990), hist->stats.max_us);
+}
@@ -0,0 +1,58 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file perf-stats.h
+ */
+
+#ifndef __ARTIK_PERF_STATS_H__
+#define __ARTIK_PERF_STATS_H__
+
+#include <stdint.h>
+
+struct perf_stats {
+	unsigned int count;
+	uint32_t min_us;
+	uint32_t max_us;
+	uint64_t total_us;
+};
+
+/*
+ * Log-linear latency histogram: values below 16us get their own bucket,
+ * larger values are split in 8 buckets per power of two, which bounds the
+ * percentile error to 12.5%.
+ */
+#define PERF_HIST_SUB_BITS	3
+#define PERF_HIST_BUCKETS	240
+
+struct perf_histogram {
+	struct perf_stats stats;
+	uint32_t buckets[PERF_HIST_BUCKETS];
+};
+
+uint64_t perf_now_us(void);
+void perf_stats_reset(struct perf_stats *stats);
+void perf_stats_add(struct perf_stats *stats, uint32_t elapsed_us);
+void perf_stats_print(const char *label, const struct perf_stats *stats);
+
+void perf_hist_reset(struct perf_histogram *hist);
+void perf_hist_add(struct perf_histogram *hist, uint32_t elapsed_us);
+uint32_t perf_hist_percentile(const struct perf_histogram *hist, unsigned int permille);
+void perf_hist_print(const char *label, const struct perf_histogram *hist);
+
+#endif /* __ARTIK_PERF_STATS_H__ */
@@ -21,6 +21,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <shell/tash.h>
 
@@ -28,25 +29,59 @@
 #include <artik_pwm.h>
 
 #include "command.h"
+#include "pwm-channels.h"
 
-static artik_pwm_handle pwm_handle;
+#define PWM_FADE_STEPS	16
 
 static int pwm_start(int argc, char *argv[]);
+static int pwm_set(int argc, char *argv[]);
 static int pwm_stop(int argc, char *argv[]);
+static int pwm_seq(int argc, char *argv[]);
+static int pwm_fade(int argc, char *argv[]);
+static int pwm_list(int argc, char *argv[]);
 
 const struct command pwm_commands[] = {
 	{ "start", "start <pin num> <period> <duty cycle> [invert]", pwm_start },
-	{ "stop", "stop", pwm_stop},
+	{ "set", "set <pin num> <period|0> <duty cycle> [invert|normal] - Change a running PWM",
+		pwm_set },
+	{ "stop", "stop [<pin num>]", pwm_stop},
+	{ "seq", "seq <pin num> <duty>:<ms>[:<period>][,...] [<loops>] - 0 loops repeats forever",
+		pwm_seq },
+	{ "fade", "fade <pin num> <from duty> <to duty> <ms> [<steps>]", pwm_fade },
+	{ "list", "list", pwm_list },
 	{"", "", NULL}
 };
 
 static int pwm_start(int argc, char *argv[])
 {
-	artik_pwm_module *pwm = NULL;
-	int ret = 0;
+	artik_error err = S_OK;
+	bool invert = false;
 
-	artik_pwm_config config;
-	char name[16] = "";
+	if (argc < 6) {
+		fprintf(stderr, "Wrong number of arguments\n");
+		usage(argv[1], pwm_commands);
+		return -1;
+	}
+
+	if ((argc > 6) && !strcmp(argv[6], "invert"))
+		invert = true;
+
+	err = pwm_channel_open(atoi(argv[3]), atoi(argv[4]), atoi(argv[5]), invert);
+	if (err == E_BUSY) {
+		fprintf(stderr, "PWM %s was already started\n", argv[3]);
+		return -1;
+	} else if (err != S_OK) {
+		fprintf(stderr, "Failed to request PWM %s (%d)\n", argv[3], err);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Updates the open handle, the output is not stopped in between */
+static int pwm_set(int argc, char *argv[])
+{
+	artik_error err = S_OK;
 
 	if (argc < 6) {
 		fprintf(stderr, "Wrong number of arguments\n");
@@ -54,62 +89,115 @@ static int pwm_start(int argc, char *argv[])
 		return -1;
 	}
 
-	pwm = (artik_pwm_module *)artik_request_api_module("pwm");
-	if (!pwm) {
-		fprintf(stderr, "PWM module is not available\n");
+	if (argc > 6)
+		err = pwm_channel_set_polarity(atoi(argv[3]), !strcmp(argv[6], "invert"));
+	if (err == S_OK)
+		err = pwm_channel_set(atoi(argv[3]), atoi(argv[4]), atoi(argv[5]));
+	if (err != S_OK) {
+		fprintf(stderr, "Failed to update PWM %s (%d)\n", argv[3], err);
 		return -1;
 	}
 
-	if (pwm_handle) {
-		fprintf(stderr, "PW was already started\n");
-		ret = -1;
-		goto exit;
+	return 0;
+}
+
+static int pwm_stop(int argc, char *argv[])
+{
+	if (argc < 4) {
+		pwm_channel_close_all();
+		return 0;
 	}
 
-	memset(&config, 0, sizeof(config));
-	config.pin_num = atoi(argv[3]);
-	config.period = atoi(argv[4]);
-	config.duty_cycle = atoi(argv[5]);
-	if ((argc > 5) && !strcmp(argv[6], "invert")) {
-		config.polarity = ARTIK_PWM_POLR_INVERT;
+	if (pwm_channel_close(atoi(argv[3])) != S_OK) {
+		fprintf(stderr, "PWM %s was not started\n", argv[3]);
+		return -1;
 	}
 
-	snprintf(name, 16, "pwm%d", config.pin_num);
-	config.name = name;
+	return 0;
+}
+
+static int pwm_seq(int argc, char *argv[])
+{
+	struct pwm_step steps[PWM_SEQ_MAX_STEPS];
+	unsigned int loops = 0;
+	int num_steps = 0;
+	char *step;
 
-	if (pwm->request(&pwm_handle, &config) != S_OK) {
-		fprintf(stderr, "Failed to request PWM %d\n", config.pin_num);
-		ret = -1;
-		goto exit;
+	if (argc < 5) {
+		fprintf(stderr, "Wrong number of arguments\n");
+		usage(argv[1], pwm_commands);
+		return -1;
 	}
 
-exit:
-	artik_release_api_module(pwm);
-	return ret;
+	memset(steps, 0, sizeof(steps));
+	for (step = strtok(argv[4], ","); step; step = strtok(NULL, ",")) {
+		if (num_steps == PWM_SEQ_MAX_STEPS) {
+			fprintf(stderr, "Too many steps, at most %d\n", PWM_SEQ_MAX_STEPS);
+			return -1;
+		}
+		if (sscanf(step, "%u:%u:%u", &steps[num_steps].duty, &steps[num_steps].duration_ms,
+				&steps[num_steps].period) < 2) {
+			fprintf(stderr, "Invalid step '%s'\n", step);
+			return -1;
+		}
+		num_steps++;
+	}
+
+	if (argc > 5)
+		loops = atoi(argv[5]);
+
+	if (pwm_seq_play(atoi(argv[3]), steps, num_steps, loops) != S_OK) {
+		fprintf(stderr, "Failed to play sequence on PWM %s\n", argv[3]);
+		return -1;
+	}
+
+	return 0;
 }
 
-static int pwm_stop(int argc, char *argv[])
+/* Linear ramp of the duty cycle, played once by the sequencer */
+static int pwm_fade(int argc, char *argv[])
 {
-	int ret = 0;
-	artik_pwm_module *pwm = (artik_pwm_module *)artik_request_api_module("pwm");
+	struct pwm_step steps[PWM_SEQ_MAX_STEPS];
+	int from, to, ms, i;
+	int num_steps = PWM_FADE_STEPS;
 
-	if (!pwm) {
-		fprintf(stderr, "PWM module is not available\n");
+	if (argc < 7) {
+		fprintf(stderr, "Wrong number of arguments\n");
+		usage(argv[1], pwm_commands);
 		return -1;
 	}
 
-	if (!pwm_handle) {
-		fprintf(stderr, "PWM was not started\n");
-		ret = -1;
-		goto exit;
+	from = atoi(argv[4]);
+	to = atoi(argv[5]);
+	ms = atoi(argv[6]);
+	if (argc > 7)
+		num_steps = atoi(argv[7]);
+	if ((num_steps < 1) || (num_steps > PWM_SEQ_MAX_STEPS) || (ms < num_steps)) {
+		fprintf(stderr, "Steps must be 1 to %d and at least 1 ms each\n",
+			PWM_SEQ_MAX_STEPS);
+		return -1;
+	}
+
+	memset(steps, 0, sizeof(steps));
+	for (i = 0; i < num_steps; i++) {
+		steps[i].duty = (num_steps == 1) ? to :
+			from + (int)((long long)(to - from) * i / (num_steps - 1));
+		steps[i].duration_ms = ms / num_steps;
+	}
+
+	if (pwm_seq_play(atoi(argv[3]), steps, num_steps, 1) != S_OK) {
+		fprintf(stderr, "Failed to fade PWM %s\n", argv[3]);
+		return -1;
 	}
 
-	pwm->release(pwm_handle);
-	pwm_handle = NULL;
+	return 0;
+}
+
+static int pwm_list(int argc, char *argv[])
+{
+	pwm_channels_dump();
 
-exit:
-	artik_release_api_module(pwm);
-	return ret;
+	return 0;
 }
 
 #ifdef CONFIG_BUILD_KERNEL
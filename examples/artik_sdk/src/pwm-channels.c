@@ -0,0 +1,441 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file pwm-channels.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <artik_module.h>
+
+#include "perf-stats.h"
+#include "pwm-channels.h"
+
+#define PWM_SEQ_STACK_SIZE	4096
+
+struct pwm_channel {
+	bool used;
+	unsigned int pin;
+	artik_pwm_handle handle;
+	unsigned int period;
+	unsigned int duty;
+	bool invert;
+
+	/* Sequence being played */
+	struct pwm_step steps[PWM_SEQ_MAX_STEPS];
+	int num_steps;
+	int step;
+	unsigned int base_period;
+	unsigned int loops;
+	unsigned int loop;
+	uint64_t next_us;
+	unsigned int steps_played;
+	uint32_t max_late_us;
+};
+
+struct pwm_channels {
+	struct pwm_channel channels[PWM_MAX_CHANNELS];
+	artik_pwm_module *pwm;
+	int open;
+	pthread_mutex_t lock;
+	sem_t wake;
+	pthread_t thread;
+	bool running;
+};
+
+static struct pwm_channels g_pwm = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/* Must be called with g_pwm.lock held */
+static struct pwm_channel *pwm_channel_find(unsigned int pin)
+{
+	int i;
+
+	for (i = 0; i < PWM_MAX_CHANNELS; i++) {
+		if (g_pwm.channels[i].used && (g_pwm.channels[i].pin == pin))
+			return &g_pwm.channels[i];
+	}
+
+	return NULL;
+}
+
+/* Must be called with g_pwm.lock held */
+static artik_error pwm_channel_apply(struct pwm_channel *ch, unsigned int period,
+		unsigned int duty)
+{
+	artik_error ret = S_OK;
+
+	if (!period)
+		period = ch->period;
+	if (duty > period)
+		return E_BAD_ARGS;
+
+	if (period < ch->period) {
+		if (duty != ch->duty)
+			ret = g_pwm.pwm->set_duty_cycle(ch->handle, duty);
+		if (ret == S_OK)
+			ret = g_pwm.pwm->set_period(ch->handle, period);
+	} else {
+		if (period != ch->period)
+			ret = g_pwm.pwm->set_period(ch->handle, period);
+		if ((ret == S_OK) && (duty != ch->duty))
+			ret = g_pwm.pwm->set_duty_cycle(ch->handle, duty);
+	}
+
+	if (ret == S_OK) {
+		ch->period = period;
+		ch->duty = duty;
+	}
+
+	return ret;
+}
+
+/* Must be called with g_pwm.lock held, returns the time of the next step or 0 */
+static uint64_t pwm_seq_run(struct pwm_channel *ch, uint64_t now)
+{
+	struct pwm_step *step;
+
+	while (ch->num_steps && (ch->next_us <= now)) {
+		if (ch->step == ch->num_steps) {
+			ch->step = 0;
+			if (ch->loops && (++ch->loop >= ch->loops)) {
+				ch->num_steps = 0;
+				return 0;
+			}
+		}
+
+		step = &ch->steps[ch->step++];
+		if (pwm_channel_apply(ch, step->period ? step->period : ch->base_period,
+				step->duty) != S_OK) {
+			fprintf(stderr, "PWM %u: failed to apply step %d, sequence stopped\n",
+				ch->pin, ch->step - 1);
+			ch->num_steps = 0;
+			return 0;
+		}
+
+		if (now - ch->next_us > ch->max_late_us)
+			ch->max_late_us = now - ch->next_us;
+		ch->steps_played++;
+
+		/* Scheduled from the previous deadline so that lateness does not add up */
+		ch->next_us += (uint64_t)step->duration_ms * 1000;
+	}
+
+	return ch->num_steps ? ch->next_us : 0;
+}
+
+static pthread_addr_t pwm_seq_thread(pthread_addr_t arg)
+{
+	struct timespec timeout;
+	uint64_t now, next, wake;
+	int i;
+
+	while (1) {
+		pthread_mutex_lock(&g_pwm.lock);
+		now = perf_now_us();
+		wake = 0;
+		for (i = 0; i < PWM_MAX_CHANNELS; i++) {
+			if (!g_pwm.channels[i].used)
+				continue;
+
+			next = pwm_seq_run(&g_pwm.channels[i], now);
+			if (next && (!wake || (next < wake)))
+				wake = next;
+		}
+		pthread_mutex_unlock(&g_pwm.lock);
+
+		if (!wake) {
+			sem_wait(&g_pwm.wake);
+			continue;
+		}
+
+		now = perf_now_us();
+		if (wake <= now)
+			continue;
+
+		wake -= now;
+		clock_gettime(CLOCK_REALTIME, &timeout);
+		timeout.tv_nsec += (wake % 1000000) * 1000;
+		timeout.tv_sec += wake / 1000000 + timeout.tv_nsec / 1000000000;
+		timeout.tv_nsec %= 1000000000;
+		sem_timedwait(&g_pwm.wake, &timeout);
+	}
+
+	return NULL;
+}
+
+/* Must be called with g_pwm.lock held */
+static artik_error pwm_seq_start_thread(void)
+{
+	pthread_attr_t attr;
+	int ret;
+
+	if (g_pwm.running)
+		return S_OK;
+
+	sem_init(&g_pwm.wake, 0, 0);
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, PWM_SEQ_STACK_SIZE);
+	ret = pthread_create(&g_pwm.thread, &attr, pwm_seq_thread, NULL);
+	pthread_attr_destroy(&attr);
+
+	if (ret != 0) {
+		sem_destroy(&g_pwm.wake);
+		return E_NO_MEM;
+	}
+
+	g_pwm.running = true;
+
+	return S_OK;
+}
+
+artik_error pwm_channel_open(unsigned int pin, unsigned int period, unsigned int duty,
+		bool invert)
+{
+	struct pwm_channel *ch = NULL;
+	artik_pwm_config config;
+	artik_error ret = S_OK;
+	char name[16];
+	int i;
+
+	if (duty > period)
+		return E_BAD_ARGS;
+
+	pthread_mutex_lock(&g_pwm.lock);
+	if (pwm_channel_find(pin)) {
+		ret = E_BUSY;
+		goto exit;
+	}
+
+	for (i = 0; i < PWM_MAX_CHANNELS; i++) {
+		if (!g_pwm.channels[i].used) {
+			ch = &g_pwm.channels[i];
+			break;
+		}
+	}
+
+	if (!ch) {
+		ret = E_NO_MEM;
+		goto exit;
+	}
+
+	if (!g_pwm.pwm) {
+		g_pwm.pwm = (artik_pwm_module *)artik_request_api_module("pwm");
+		if (!g_pwm.pwm) {
+			ret = E_NOT_SUPPORTED;
+			goto exit;
+		}
+	}
+
+	memset(&config, 0, sizeof(config));
+	config.pin_num = pin;
+	config.period = period;
+	config.duty_cycle = duty;
+	config.polarity = invert ? ARTIK_PWM_POLR_INVERT : ARTIK_PWM_POLR_NORMAL;
+	snprintf(name, sizeof(name), "pwm%u", pin);
+	config.name = name;
+
+	ret = g_pwm.pwm->request(&ch->handle, &config);
+	if (ret != S_OK) {
+		if (!g_pwm.open) {
+			artik_release_api_module(g_pwm.pwm);
+			g_pwm.pwm = NULL;
+		}
+		goto exit;
+	}
+
+	memset(ch->steps, 0, sizeof(ch->steps));
+	ch->num_steps = 0;
+	ch->used = true;
+	ch->pin = pin;
+	ch->period = period;
+	ch->duty = duty;
+	ch->invert = invert;
+	g_pwm.open++;
+
+exit:
+	pthread_mutex_unlock(&g_pwm.lock);
+
+	return ret;
+}
+
+/* A period of 0 keeps the current one, playing sequences are stopped */
+artik_error pwm_channel_set(unsigned int pin, unsigned int period, unsigned int duty)
+{
+	struct pwm_channel *ch;
+	artik_error ret;
+
+	pthread_mutex_lock(&g_pwm.lock);
+	ch = pwm_channel_find(pin);
+	if (ch) {
+		ch->num_steps = 0;
+		ret = pwm_channel_apply(ch, period, duty);
+	} else {
+		ret = E_BAD_ARGS;
+	}
+	pthread_mutex_unlock(&g_pwm.lock);
+
+	return ret;
+}
+
+artik_error pwm_channel_set_polarity(unsigned int pin, bool invert)
+{
+	struct pwm_channel *ch;
+	artik_error ret = S_OK;
+
+	pthread_mutex_lock(&g_pwm.lock);
+	ch = pwm_channel_find(pin);
+	if (!ch) {
+		ret = E_BAD_ARGS;
+	} else if (ch->invert != invert) {
+		ret = g_pwm.pwm->set_polarity(ch->handle,
+			invert ? ARTIK_PWM_POLR_INVERT : ARTIK_PWM_POLR_NORMAL);
+		if (ret == S_OK)
+			ch->invert = invert;
+	}
+	pthread_mutex_unlock(&g_pwm.lock);
+
+	return ret;
+}
+
+/* Must be called with g_pwm.lock held */
+static void pwm_channel_release(struct pwm_channel *ch)
+{
+	g_pwm.pwm->release(ch->handle);
+	ch->used = false;
+	ch->num_steps = 0;
+
+	if (--g_pwm.open == 0) {
+		artik_release_api_module(g_pwm.pwm);
+		g_pwm.pwm = NULL;
+	}
+}
+
+artik_error pwm_channel_close(unsigned int pin)
+{
+	struct pwm_channel *ch;
+
+	pthread_mutex_lock(&g_pwm.lock);
+	ch = pwm_channel_find(pin);
+	if (ch)
+		pwm_channel_release(ch);
+	pthread_mutex_unlock(&g_pwm.lock);
+
+	return ch ? S_OK : E_BAD_ARGS;
+}
+
+void pwm_channel_close_all(void)
+{
+	int i;
+
+	pthread_mutex_lock(&g_pwm.lock);
+	for (i = 0; i < PWM_MAX_CHANNELS; i++) {
+		if (g_pwm.channels[i].used)
+			pwm_channel_release(&g_pwm.channels[i]);
+	}
+	pthread_mutex_unlock(&g_pwm.lock);
+}
+
+/* Plays the steps 'loops' times, or until stopped if 0 */
+artik_error pwm_seq_play(unsigned int pin, const struct pwm_step *steps, int num_steps,
+		unsigned int loops)
+{
+	struct pwm_channel *ch;
+	artik_error ret = S_OK;
+	int i;
+
+	if (!steps || (num_steps <= 0) || (num_steps > PWM_SEQ_MAX_STEPS))
+		return E_BAD_ARGS;
+
+	for (i = 0; i < num_steps; i++) {
+		if (!steps[i].duration_ms)
+			return E_BAD_ARGS;
+	}
+
+	pthread_mutex_lock(&g_pwm.lock);
+	ch = pwm_channel_find(pin);
+	if (!ch) {
+		ret = E_BAD_ARGS;
+		goto exit;
+	}
+
+	ret = pwm_seq_start_thread();
+	if (ret != S_OK)
+		goto exit;
+
+	memcpy(ch->steps, steps, num_steps * sizeof(struct pwm_step));
+	ch->num_steps = num_steps;
+	ch->step = 0;
+	ch->base_period = ch->period;
+	ch->loops = loops;
+	ch->loop = 0;
+	ch->steps_played = 0;
+	ch->max_late_us = 0;
+	ch->next_us = perf_now_us();
+	sem_post(&g_pwm.wake);
+
+exit:
+	pthread_mutex_unlock(&g_pwm.lock);
+
+	return ret;
+}
+
+artik_error pwm_seq_stop(unsigned int pin)
+{
+	struct pwm_channel *ch;
+
+	pthread_mutex_lock(&g_pwm.lock);
+	ch = pwm_channel_find(pin);
+	if (ch)
+		ch->num_steps = 0;
+	pthread_mutex_unlock(&g_pwm.lock);
+
+	return ch ? S_OK : E_BAD_ARGS;
+}
+
+void pwm_channels_dump(void)
+{
+	struct pwm_channel *ch;
+	int i;
+
+	pthread_mutex_lock(&g_pwm.lock);
+	for (i = 0; i < PWM_MAX_CHANNELS; i++) {
+		ch = &g_pwm.channels[i];
+		if (!ch->used)
+			continue;
+
+		fprintf(stdout, "PWM %u: period %u duty %u%s", ch->pin, ch->period, ch->duty,
+			ch->invert ? " inverted" : "");
+		if (ch->num_steps)
+			fprintf(stdout, ", step %d/%d", ch->step, ch->num_steps);
+		if (ch->num_steps && ch->loops)
+			fprintf(stdout, " loop %u/%u", ch->loop + 1, ch->loops);
+		if (ch->steps_played)
+			fprintf(stdout, ", %u steps played, max late %u us", ch->steps_played,
+				ch->max_late_us);
+		fprintf(stdout, "\n");
+	}
+	pthread_mutex_unlock(&g_pwm.lock);
+}
@@ -0,0 +1,66 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file pwm-channels.h
+ */
+
+#ifndef __ARTIK_PWM_CHANNELS_H__
+#define __ARTIK_PWM_CHANNELS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <artik_pwm.h>
+
+#define PWM_MAX_CHANNELS	4
+#define PWM_SEQ_MAX_STEPS	32
+
+/*
+ * Open PWM channels, several of which can run at the same time, keyed by
+ * pin number.
+ *
+ * Period, duty cycle and polarity are changed in place on the open handle
+ * so that the output keeps running. When the period shrinks the duty cycle
+ * is lowered first, when it grows the period goes first, so the duty
+ * cycle never exceeds the period in between.
+ *
+ * A channel can also play a sequence of steps, each holding a duty cycle
+ * and optionally a period for a given time. A single sequencer thread
+ * serves all channels. It sleeps until the next step is due, so steps
+ * do not go through the command parser and do not drift with it.
+ */
+struct pwm_step {
+	unsigned int duty;
+	unsigned int period;	/* 0 for the period the sequence started with */
+	unsigned int duration_ms;
+};
+
+artik_error pwm_channel_open(unsigned int pin, unsigned int period, unsigned int duty,
+		bool invert);
+artik_error pwm_channel_set(unsigned int pin, unsigned int period, unsigned int duty);
+artik_error pwm_channel_set_polarity(unsigned int pin, bool invert);
+artik_error pwm_channel_close(unsigned int pin);
+void pwm_channel_close_all(void);
+
+artik_error pwm_seq_play(unsigned int pin, const struct pwm_step *steps, int num_steps,
+		unsigned int loops);
+artik_error pwm_seq_stop(unsigned int pin);
+void pwm_channels_dump(void);
+
+#endif /* __ARTIK_PWM_CHANNELS_H__ */
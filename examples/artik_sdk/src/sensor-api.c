@@ -0,0 +1,172 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file sensor-api.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <shell/tash.h>
+
+#include <artik_error.h>
+
+#include "command.h"
+#include "sensor-sched.h"
+
+#define SENSOR_RING_BATCH	16
+
+static int sensor_add(int argc, char *argv[]);
+static int sensor_del(int argc, char *argv[]);
+static int sensor_cloud(int argc, char *argv[]);
+static int sensor_load(int argc, char *argv[]);
+static int sensor_ring(int argc, char *argv[]);
+static int sensor_list(int argc, char *argv[]);
+
+const struct command sensor_commands[] = {
+	{ "add", "add <name> adc:<pin>|gpio:<pin>|avg|min|max:<job> <period ms> [<sink>[,...]|none]",
+		sensor_add },
+	{ "del", "del <name>|all", sensor_del },
+	{ "cloud", "cloud <device id> - Device the cloud sink adds readings to", sensor_cloud },
+	{ "load", "load [<path>] - Add the jobs of a configuration file", sensor_load },
+	{ "ring", "ring [<count>] - Print and remove the oldest readings of the ring sink",
+		sensor_ring },
+	{ "list", "list - Display jobs, jitter and sinks", sensor_list },
+	{ "", "", NULL }
+};
+
+static int sensor_add(int argc, char *argv[])
+{
+	artik_error err;
+
+	if (argc < 6) {
+		fprintf(stderr, "Wrong arguments\n");
+		usage(argv[1], sensor_commands);
+		return -1;
+	}
+
+	err = sensor_sched_add(argv[3], argv[4], atoi(argv[5]), (argc > 6) ? argv[6] : NULL);
+	if (err == E_BUSY) {
+		fprintf(stderr, "Sensor job %s already exists\n", argv[3]);
+		return -1;
+	} else if (err != S_OK) {
+		fprintf(stderr, "Failed to add sensor job %s (%d)\n", argv[3], err);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int sensor_del(int argc, char *argv[])
+{
+	artik_error err;
+
+	if (argc < 4) {
+		fprintf(stderr, "Wrong arguments\n");
+		usage(argv[1], sensor_commands);
+		return -1;
+	}
+
+	if (!strcmp(argv[3], "all")) {
+		sensor_sched_remove_all();
+		return 0;
+	}
+
+	err = sensor_sched_remove(argv[3]);
+	if (err == E_BUSY) {
+		fprintf(stderr, "Sensor job %s feeds another job\n", argv[3]);
+		return -1;
+	} else if (err != S_OK) {
+		fprintf(stderr, "No sensor job %s\n", argv[3]);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int sensor_cloud(int argc, char *argv[])
+{
+	if (argc < 4) {
+		fprintf(stderr, "Wrong arguments\n");
+		usage(argv[1], sensor_commands);
+		return -1;
+	}
+
+	sensor_sched_set_cloud_device(argv[3]);
+
+	return 0;
+}
+
+static int sensor_load(int argc, char *argv[])
+{
+	const char *path = (argc > 3) ? argv[3] : SENSOR_SCHED_CONFIG_PATH;
+	artik_error err;
+
+	err = sensor_sched_load(path);
+	if (err == E_ACCESS_DENIED) {
+		fprintf(stderr, "Failed to open %s\n", path);
+		return -1;
+	} else if (err != S_OK) {
+		fprintf(stderr, "Some jobs of %s could not be added\n", path);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int sensor_ring(int argc, char *argv[])
+{
+	struct sensor_reading readings[SENSOR_RING_BATCH];
+	unsigned int count = SENSOR_SCHED_RING_SIZE;
+	unsigned int i, n;
+
+	if (argc > 3)
+		count = atoi(argv[3]);
+
+	while (count) {
+		n = sensor_sched_ring_read(readings,
+			(count < SENSOR_RING_BATCH) ? count : SENSOR_RING_BATCH);
+		if (!n)
+			break;
+
+		for (i = 0; i < n; i++)
+			fprintf(stdout, "%u %s=%d\n", readings[i].time_ms, readings[i].name,
+				readings[i].value);
+		count -= n;
+	}
+
+	return 0;
+}
+
+static int sensor_list(int argc, char *argv[])
+{
+	sensor_sched_dump();
+
+	return 0;
+}
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int sensor_main(int argc, char *argv[])
+#endif
+{
+	return commands_parser(argc, argv, sensor_commands);
+}
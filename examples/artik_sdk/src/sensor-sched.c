@@ -0,0 +1,865 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file sensor-sched.c
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <artik_module.h>
+#include <artik_adc.h>
+
+#include "gpio-cache.h"
+#include "gpio-watch.h"
+#include "perf-stats.h"
+#include "sensor-sched.h"
+#include "telemetry-batch.h"
+
+#define SENSOR_SCHED_STACK_SIZE	4096
+#define SENSOR_SCHED_TICK_US	(SENSOR_SCHED_TICK_MS * 1000)
+#define SENSOR_SCHED_WHEEL_MASK	(SENSOR_SCHED_WHEEL_SLOTS - 1)
+#define SENSOR_SCHED_BATCH		(2 * SENSOR_SCHED_MAX_JOBS)
+#define SENSOR_SCHED_MAX_ARGS	8
+
+enum sensor_source {
+	SENSOR_SOURCE_ADC,
+	SENSOR_SOURCE_GPIO,
+	SENSOR_SOURCE_AVG,
+	SENSOR_SOURCE_MIN,
+	SENSOR_SOURCE_MAX
+};
+
+static const char * const sensor_source_names[] = {
+	"adc", "gpio", "avg", "min", "max"
+};
+
+struct sensor_job {
+	bool used;
+	char name[SENSOR_SCHED_NAME_LEN];
+	enum sensor_source source;
+	int pin;
+	struct sensor_job *input;
+	unsigned int period_ticks;
+	uint32_t sinks;		/* Bit n set for g_sensor.sinks[n] */
+
+	/* Wheel slot list, the slot is due_tick modulo the wheel size */
+	struct sensor_job *next;
+	uint64_t due_tick;
+
+	artik_adc_handle adc;
+	struct gpio_watch *watch;
+	int32_t last;
+	bool have_last;
+
+	/* Values emitted by the input job since the last period */
+	int64_t acc_sum;
+	int32_t acc_min;
+	int32_t acc_max;
+	unsigned int acc_count;
+
+	unsigned int runs;
+	unsigned int emitted;
+	unsigned int missed;
+	unsigned int errors;
+	unsigned int edges;
+	struct perf_stats jitter;
+};
+
+struct sensor_sink {
+	char name[SENSOR_SCHED_NAME_LEN];
+	sensor_sink_fn fn;
+	void *user_data;
+	unsigned int delivered;
+	unsigned int failed;
+};
+
+struct sensor_delivery {
+	struct sensor_reading reading;
+	uint32_t sinks;
+};
+
+struct sensor_sched {
+	struct sensor_job jobs[SENSOR_SCHED_MAX_JOBS];
+	struct sensor_job *wheel[SENSOR_SCHED_WHEEL_SLOTS];
+	int num_jobs;
+	struct sensor_sink sinks[SENSOR_SCHED_MAX_SINKS];
+	int num_sinks;
+	artik_adc_module *adc;
+	int adc_users;
+	uint64_t start_us;
+	uint64_t tick;		/* Last tick run */
+	pthread_mutex_t lock;
+	sem_t wake;
+	pthread_t thread;
+	bool running;
+
+	/* State of the built in sinks, called without g_sensor.lock */
+	pthread_mutex_t sink_lock;
+	struct sensor_reading ring[SENSOR_SCHED_RING_SIZE];
+	unsigned int ring_head;
+	unsigned int ring_count;
+	unsigned int ring_overwritten;
+	char cloud_device[TELEMETRY_BATCH_DEVICE_LEN];
+};
+
+static struct sensor_sched g_sensor = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.sink_lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static artik_error sensor_sink_console(const struct sensor_reading *reading, void *user_data)
+{
+	fprintf(stdout, "%u %s=%d\n", reading->time_ms, reading->name, reading->value);
+
+	return S_OK;
+}
+
+/* Keeps the latest readings, the oldest one is overwritten when full */
+static artik_error sensor_sink_ring(const struct sensor_reading *reading, void *user_data)
+{
+	pthread_mutex_lock(&g_sensor.sink_lock);
+	g_sensor.ring[g_sensor.ring_head] = *reading;
+	g_sensor.ring_head = (g_sensor.ring_head + 1) % SENSOR_SCHED_RING_SIZE;
+	if (g_sensor.ring_count < SENSOR_SCHED_RING_SIZE)
+		g_sensor.ring_count++;
+	else
+		g_sensor.ring_overwritten++;
+	pthread_mutex_unlock(&g_sensor.sink_lock);
+
+	return S_OK;
+}
+
+static artik_error sensor_sink_cloud(const struct sensor_reading *reading, void *user_data)
+{
+	struct telemetry_field field;
+	char device_id[TELEMETRY_BATCH_DEVICE_LEN];
+
+	pthread_mutex_lock(&g_sensor.sink_lock);
+	memcpy(device_id, g_sensor.cloud_device, sizeof(device_id));
+	pthread_mutex_unlock(&g_sensor.sink_lock);
+
+	if (!device_id[0])
+		return E_NOT_INITIALIZED;
+
+	field.name = reading->name;
+	field.type = TELEMETRY_INT;
+	field.value.i = reading->value;
+
+	return telemetry_batch_add(device_id, &field, 1);
+}
+
+/* Must be called with g_sensor.lock held */
+static int sensor_sink_find(const char *name)
+{
+	int i;
+
+	for (i = 0; i < g_sensor.num_sinks; i++) {
+		if (!strcmp(g_sensor.sinks[i].name, name))
+			return i;
+	}
+
+	return -1;
+}
+
+/* Must be called with g_sensor.lock held */
+static int sensor_sink_register(const char *name, sensor_sink_fn fn, void *user_data)
+{
+	struct sensor_sink *sink;
+
+	if (!name || !fn || !name[0] || (strlen(name) >= SENSOR_SCHED_NAME_LEN) ||
+			!strcmp(name, "none"))
+		return -1;
+
+	if ((sensor_sink_find(name) >= 0) || (g_sensor.num_sinks == SENSOR_SCHED_MAX_SINKS))
+		return -1;
+
+	sink = &g_sensor.sinks[g_sensor.num_sinks];
+	memset(sink, 0, sizeof(*sink));
+	strncpy(sink->name, name, SENSOR_SCHED_NAME_LEN - 1);
+	sink->fn = fn;
+	sink->user_data = user_data;
+
+	return g_sensor.num_sinks++;
+}
+
+/* Must be called with g_sensor.lock held */
+static void sensor_sinks_init(void)
+{
+	if (g_sensor.num_sinks)
+		return;
+
+	sensor_sink_register("console", sensor_sink_console, NULL);
+	sensor_sink_register("ring", sensor_sink_ring, NULL);
+	sensor_sink_register("cloud", sensor_sink_cloud, NULL);
+}
+
+/* Must be called with g_sensor.lock held, "none" only feeds other jobs */
+static artik_error sensor_sinks_parse(const char *list, uint32_t *mask)
+{
+	char buf[SENSOR_SCHED_LINE_MAX];
+	char *name, *save = NULL;
+	int index;
+
+	*mask = 0;
+	if (!strcmp(list, "none"))
+		return S_OK;
+
+	strncpy(buf, list, sizeof(buf) - 1);
+	buf[sizeof(buf) - 1] = '\0';
+
+	for (name = strtok_r(buf, ",", &save); name; name = strtok_r(NULL, ",", &save)) {
+		index = sensor_sink_find(name);
+		if (index < 0)
+			return E_BAD_ARGS;
+		*mask |= 1 << index;
+	}
+
+	return *mask ? S_OK : E_BAD_ARGS;
+}
+
+int sensor_sched_add_sink(const char *name, sensor_sink_fn fn, void *user_data)
+{
+	int ret;
+
+	pthread_mutex_lock(&g_sensor.lock);
+	sensor_sinks_init();
+	ret = sensor_sink_register(name, fn, user_data);
+	pthread_mutex_unlock(&g_sensor.lock);
+
+	return ret;
+}
+
+/* Must be called with g_sensor.lock held */
+static struct sensor_job *sensor_job_find(const char *name)
+{
+	int i;
+
+	for (i = 0; i < SENSOR_SCHED_MAX_JOBS; i++) {
+		if (g_sensor.jobs[i].used && !strcmp(g_sensor.jobs[i].name, name))
+			return &g_sensor.jobs[i];
+	}
+
+	return NULL;
+}
+
+/* Must be called with g_sensor.lock held */
+static artik_error sensor_job_open(struct sensor_job *job)
+{
+	artik_adc_config adc_config;
+	artik_error ret = S_OK;
+	char name[16];
+
+	if (job->source == SENSOR_SOURCE_ADC) {
+		if (!g_sensor.adc) {
+			g_sensor.adc = (artik_adc_module *)artik_request_api_module("adc");
+			if (!g_sensor.adc)
+				return E_NOT_SUPPORTED;
+		}
+
+		memset(&adc_config, 0, sizeof(adc_config));
+		adc_config.pin_num = job->pin;
+		snprintf(name, sizeof(name), "adc%d", job->pin);
+		adc_config.name = name;
+
+		ret = g_sensor.adc->request(&job->adc, &adc_config);
+		if (ret == S_OK) {
+			g_sensor.adc_users++;
+		} else if (!g_sensor.adc_users) {
+			artik_release_api_module(g_sensor.adc);
+			g_sensor.adc = NULL;
+		}
+	} else if (job->source == SENSOR_SOURCE_GPIO) {
+		job->watch = malloc(sizeof(struct gpio_watch));
+		if (!job->watch)
+			return E_NO_MEM;
+
+		/* A pin left open by the gpio commands would make the request fail */
+		gpio_cache_release(job->pin);
+		ret = gpio_watch_start(job->watch, job->pin, GPIO_EDGE_BOTH,
+			GPIO_WATCH_DEBOUNCE_MS);
+		if (ret != S_OK) {
+			free(job->watch);
+			job->watch = NULL;
+		}
+	}
+
+	return ret;
+}
+
+/* Must be called with g_sensor.lock held */
+static void sensor_job_close(struct sensor_job *job)
+{
+	if (job->source == SENSOR_SOURCE_ADC) {
+		g_sensor.adc->release(job->adc);
+		if (--g_sensor.adc_users == 0) {
+			artik_release_api_module(g_sensor.adc);
+			g_sensor.adc = NULL;
+		}
+	} else if (job->source == SENSOR_SOURCE_GPIO) {
+		gpio_watch_stop(job->watch);
+		free(job->watch);
+		job->watch = NULL;
+	}
+}
+
+/* Must be called with g_sensor.lock held */
+static void sensor_wheel_insert(struct sensor_job *job)
+{
+	struct sensor_job **slot = &g_sensor.wheel[job->due_tick & SENSOR_SCHED_WHEEL_MASK];
+
+	job->next = *slot;
+	*slot = job;
+}
+
+/* Must be called with g_sensor.lock held */
+static void sensor_wheel_remove(struct sensor_job *job)
+{
+	struct sensor_job **pp = &g_sensor.wheel[job->due_tick & SENSOR_SCHED_WHEEL_MASK];
+
+	while (*pp && (*pp != job))
+		pp = &(*pp)->next;
+	if (*pp)
+		*pp = job->next;
+}
+
+/* Must be called with g_sensor.lock held */
+static void sensor_job_feed(struct sensor_job *input, int32_t value)
+{
+	struct sensor_job *job;
+	int i;
+
+	for (i = 0; i < SENSOR_SCHED_MAX_JOBS; i++) {
+		job = &g_sensor.jobs[i];
+		if (!job->used || (job->input != input))
+			continue;
+
+		if (!job->acc_count || (value < job->acc_min))
+			job->acc_min = value;
+		if (!job->acc_count || (value > job->acc_max))
+			job->acc_max = value;
+		job->acc_sum += value;
+		job->acc_count++;
+	}
+}
+
+/*
+ * Must be called with g_sensor.lock held. Returns true if a reading for
+ * the sinks was stored in 'out'.
+ */
+static bool sensor_job_run(struct sensor_job *job, uint64_t now, struct sensor_delivery *out)
+{
+	struct gpio_event event;
+	uint64_t time_us = now;
+	int32_t value = 0;
+	unsigned int n;
+	int raw;
+
+	switch (job->source) {
+	case SENSOR_SOURCE_ADC:
+		if (g_sensor.adc->get_value(job->adc, &raw) != S_OK) {
+			job->errors++;
+			return false;
+		}
+		value = raw;
+		break;
+	case SENSOR_SOURCE_GPIO:
+		if (gpio_watch_wait(job->watch, &event, 0) != S_OK)
+			return false;
+
+		/* Edges queued since the last period, all but the last one only feed other jobs */
+		n = 0;
+		do {
+			if (n++)
+				sensor_job_feed(job, value);
+			value = event.value;
+			time_us = event.time_us;
+		} while (gpio_watch_wait(job->watch, &event, 0) == S_OK);
+		job->edges += n;
+		break;
+	default:
+		if (!job->acc_count)
+			return false;
+
+		if (job->source == SENSOR_SOURCE_AVG)
+			value = (int32_t)(job->acc_sum / (int64_t)job->acc_count);
+		else if (job->source == SENSOR_SOURCE_MIN)
+			value = job->acc_min;
+		else
+			value = job->acc_max;
+
+		job->acc_sum = 0;
+		job->acc_count = 0;
+		break;
+	}
+
+	job->last = value;
+	job->have_last = true;
+	job->emitted++;
+	sensor_job_feed(job, value);
+
+	if (!job->sinks)
+		return false;
+
+	out->sinks = job->sinks;
+	out->reading.time_ms = (time_us > g_sensor.start_us) ?
+		(uint32_t)((time_us - g_sensor.start_us) / 1000) : 0;
+	memcpy(out->reading.name, job->name, SENSOR_SCHED_NAME_LEN);
+	out->reading.value = value;
+
+	return true;
+}
+
+/* Must be called with g_sensor.lock held, returns the number of readings stored */
+static int sensor_wheel_run(uint64_t tick, uint64_t now, struct sensor_delivery *out)
+{
+	struct sensor_job **pp = &g_sensor.wheel[tick & SENSOR_SCHED_WHEEL_MASK];
+	struct sensor_job *job;
+	uint64_t due_us, skipped;
+	int n = 0;
+
+	while ((job = *pp) != NULL) {
+		/* Due in a later turn of the wheel */
+		if (job->due_tick > tick) {
+			pp = &job->next;
+			continue;
+		}
+
+		*pp = job->next;
+
+		due_us = g_sensor.start_us + job->due_tick * SENSOR_SCHED_TICK_US;
+		perf_stats_add(&job->jitter, (now > due_us) ? (uint32_t)(now - due_us) : 0);
+		job->runs++;
+		if (sensor_job_run(job, now, &out[n]))
+			n++;
+
+		/* Periods that went by entirely while the job waited are not caught up */
+		job->due_tick += job->period_ticks;
+		if (job->due_tick <= tick) {
+			skipped = (tick - job->due_tick) / job->period_ticks + 1;
+			job->missed += skipped;
+			job->due_tick += skipped * job->period_ticks;
+		}
+
+		/* Goes at the head of its slot, which may be this one */
+		sensor_wheel_insert(job);
+	}
+
+	return n;
+}
+
+static void sensor_deliver(const struct sensor_delivery *out, int n)
+{
+	struct sensor_sink sinks[SENSOR_SCHED_MAX_SINKS];
+	unsigned int delivered[SENSOR_SCHED_MAX_SINKS];
+	unsigned int failed[SENSOR_SCHED_MAX_SINKS];
+	int num_sinks, i, s;
+
+	if (!n)
+		return;
+
+	pthread_mutex_lock(&g_sensor.lock);
+	num_sinks = g_sensor.num_sinks;
+	memcpy(sinks, g_sensor.sinks, num_sinks * sizeof(struct sensor_sink));
+	pthread_mutex_unlock(&g_sensor.lock);
+
+	memset(delivered, 0, sizeof(delivered));
+	memset(failed, 0, sizeof(failed));
+
+	for (i = 0; i < n; i++) {
+		for (s = 0; s < num_sinks; s++) {
+			if (!(out[i].sinks & (1 << s)))
+				continue;
+
+			if (sinks[s].fn(&out[i].reading, sinks[s].user_data) == S_OK)
+				delivered[s]++;
+			else
+				failed[s]++;
+		}
+	}
+
+	pthread_mutex_lock(&g_sensor.lock);
+	for (s = 0; s < num_sinks; s++) {
+		g_sensor.sinks[s].delivered += delivered[s];
+		g_sensor.sinks[s].failed += failed[s];
+	}
+	pthread_mutex_unlock(&g_sensor.lock);
+}
+
+static pthread_addr_t sensor_sched_thread(pthread_addr_t arg)
+{
+	struct sensor_delivery out[SENSOR_SCHED_BATCH];
+	struct timespec timeout;
+	uint64_t now, target, wake;
+	int n;
+
+	while (1) {
+		pthread_mutex_lock(&g_sensor.lock);
+		if (!g_sensor.num_jobs) {
+			pthread_mutex_unlock(&g_sensor.lock);
+			sem_wait(&g_sensor.wake);
+			continue;
+		}
+
+		now = perf_now_us();
+		target = (now - g_sensor.start_us) / SENSOR_SCHED_TICK_US;
+
+		/* More than a turn behind, looking at every slot once is enough */
+		if (target > g_sensor.tick + SENSOR_SCHED_WHEEL_SLOTS)
+			g_sensor.tick = target - SENSOR_SCHED_WHEEL_SLOTS;
+
+		/* A tick stores at most one reading per job */
+		n = 0;
+		while ((g_sensor.tick < target) &&
+				(n + g_sensor.num_jobs <= SENSOR_SCHED_BATCH))
+			n += sensor_wheel_run(++g_sensor.tick, now, &out[n]);
+
+		wake = g_sensor.start_us + (g_sensor.tick + 1) * SENSOR_SCHED_TICK_US;
+		pthread_mutex_unlock(&g_sensor.lock);
+
+		sensor_deliver(out, n);
+
+		now = perf_now_us();
+		if (wake <= now)
+			continue;
+
+		wake -= now;
+		clock_gettime(CLOCK_REALTIME, &timeout);
+		timeout.tv_nsec += (wake % 1000000) * 1000;
+		timeout.tv_sec += wake / 1000000 + timeout.tv_nsec / 1000000000;
+		timeout.tv_nsec %= 1000000000;
+		sem_timedwait(&g_sensor.wake, &timeout);
+	}
+
+	return NULL;
+}
+
+/* Must be called with g_sensor.lock held */
+static artik_error sensor_sched_start_thread(void)
+{
+	pthread_attr_t attr;
+	int ret;
+
+	if (g_sensor.running)
+		return S_OK;
+
+	sem_init(&g_sensor.wake, 0, 0);
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, SENSOR_SCHED_STACK_SIZE);
+	ret = pthread_create(&g_sensor.thread, &attr, sensor_sched_thread, NULL);
+	pthread_attr_destroy(&attr);
+
+	if (ret != 0) {
+		sem_destroy(&g_sensor.wake);
+		return E_NO_MEM;
+	}
+
+	g_sensor.running = true;
+
+	return S_OK;
+}
+
+static int sensor_source_from_string(const char *str)
+{
+	int i;
+
+	for (i = 0; i < (int)(sizeof(sensor_source_names) / sizeof(sensor_source_names[0])); i++) {
+		if (!strcmp(str, sensor_source_names[i]))
+			return i;
+	}
+
+	return -1;
+}
+
+/* Sinks is a comma separated list of sink names, console if NULL */
+artik_error sensor_sched_add(const char *name, const char *source, unsigned int period_ms,
+		const char *sinks)
+{
+	struct sensor_job *job = NULL;
+	char spec[SENSOR_SCHED_LINE_MAX];
+	artik_error ret = S_OK;
+	uint32_t mask = 0;
+	char *arg;
+	int kind, i;
+
+	if (!name || !name[0] || (strlen(name) >= SENSOR_SCHED_NAME_LEN) || !source ||
+			(period_ms < SENSOR_SCHED_TICK_MS))
+		return E_BAD_ARGS;
+
+	strncpy(spec, source, sizeof(spec) - 1);
+	spec[sizeof(spec) - 1] = '\0';
+	arg = strchr(spec, ':');
+	if (!arg || !arg[1])
+		return E_BAD_ARGS;
+	*arg++ = '\0';
+
+	kind = sensor_source_from_string(spec);
+	if (kind < 0)
+		return E_BAD_ARGS;
+
+	pthread_mutex_lock(&g_sensor.lock);
+	sensor_sinks_init();
+
+	ret = sensor_sinks_parse(sinks ? sinks : "console", &mask);
+	if (ret != S_OK)
+		goto exit;
+
+	if (sensor_job_find(name)) {
+		ret = E_BUSY;
+		goto exit;
+	}
+
+	for (i = 0; i < SENSOR_SCHED_MAX_JOBS; i++) {
+		if (!g_sensor.jobs[i].used) {
+			job = &g_sensor.jobs[i];
+			break;
+		}
+	}
+
+	if (!job) {
+		ret = E_NO_MEM;
+		goto exit;
+	}
+
+	memset(job, 0, sizeof(*job));
+	perf_stats_reset(&job->jitter);
+	job->source = kind;
+	if ((kind == SENSOR_SOURCE_ADC) || (kind == SENSOR_SOURCE_GPIO)) {
+		job->pin = atoi(arg);
+		ret = sensor_job_open(job);
+	} else {
+		job->input = sensor_job_find(arg);
+		if (!job->input)
+			ret = E_BAD_ARGS;
+	}
+
+	if (ret != S_OK)
+		goto exit;
+
+	ret = sensor_sched_start_thread();
+	if (ret != S_OK) {
+		sensor_job_close(job);
+		goto exit;
+	}
+
+	strncpy(job->name, name, SENSOR_SCHED_NAME_LEN - 1);
+	job->period_ticks = (period_ms + SENSOR_SCHED_TICK_MS / 2) / SENSOR_SCHED_TICK_MS;
+	job->sinks = mask;
+	job->used = true;
+
+	if (!g_sensor.num_jobs++) {
+		g_sensor.start_us = perf_now_us();
+		g_sensor.tick = 0;
+	}
+
+	job->due_tick = g_sensor.tick + 1;
+	sensor_wheel_insert(job);
+	sem_post(&g_sensor.wake);
+
+exit:
+	pthread_mutex_unlock(&g_sensor.lock);
+
+	return ret;
+}
+
+/* Must be called with g_sensor.lock held */
+static void sensor_job_remove(struct sensor_job *job)
+{
+	sensor_wheel_remove(job);
+	sensor_job_close(job);
+	job->used = false;
+	g_sensor.num_jobs--;
+}
+
+/* A job still feeding another one cannot be removed */
+artik_error sensor_sched_remove(const char *name)
+{
+	struct sensor_job *job;
+	artik_error ret = S_OK;
+	int i;
+
+	pthread_mutex_lock(&g_sensor.lock);
+	job = sensor_job_find(name);
+	if (!job) {
+		ret = E_BAD_ARGS;
+		goto exit;
+	}
+
+	for (i = 0; i < SENSOR_SCHED_MAX_JOBS; i++) {
+		if (g_sensor.jobs[i].used && (g_sensor.jobs[i].input == job)) {
+			ret = E_BUSY;
+			goto exit;
+		}
+	}
+
+	sensor_job_remove(job);
+
+exit:
+	pthread_mutex_unlock(&g_sensor.lock);
+
+	return ret;
+}
+
+void sensor_sched_remove_all(void)
+{
+	int i;
+
+	pthread_mutex_lock(&g_sensor.lock);
+	for (i = 0; i < SENSOR_SCHED_MAX_JOBS; i++) {
+		if (g_sensor.jobs[i].used)
+			sensor_job_remove(&g_sensor.jobs[i]);
+	}
+	pthread_mutex_unlock(&g_sensor.lock);
+}
+
+void sensor_sched_set_cloud_device(const char *device_id)
+{
+	pthread_mutex_lock(&g_sensor.sink_lock);
+	memset(g_sensor.cloud_device, 0, sizeof(g_sensor.cloud_device));
+	if (device_id)
+		strncpy(g_sensor.cloud_device, device_id, sizeof(g_sensor.cloud_device) - 1);
+	pthread_mutex_unlock(&g_sensor.sink_lock);
+}
+
+/* Lines that fail are reported and skipped, the error of the last one is returned */
+artik_error sensor_sched_load(const char *path)
+{
+	char line[SENSOR_SCHED_LINE_MAX];
+	char *argv[SENSOR_SCHED_MAX_ARGS];
+	char *token, *save = NULL;
+	artik_error err, ret = S_OK;
+	int argc, line_num = 0;
+	FILE *fp;
+
+	fp = fopen(path, "r");
+	if (!fp)
+		return E_ACCESS_DENIED;
+
+	while (fgets(line, sizeof(line), fp)) {
+		line_num++;
+
+		token = strchr(line, '#');
+		if (token)
+			*token = '\0';
+
+		argc = 0;
+		for (token = strtok_r(line, " \t\r\n", &save);
+				token && (argc < SENSOR_SCHED_MAX_ARGS);
+				token = strtok_r(NULL, " \t\r\n", &save))
+			argv[argc++] = token;
+
+		if (!argc)
+			continue;
+
+		if ((argc == 2) && !strcmp(argv[0], "cloud")) {
+			sensor_sched_set_cloud_device(argv[1]);
+			continue;
+		}
+
+		if (argc < 3)
+			err = E_BAD_ARGS;
+		else
+			err = sensor_sched_add(argv[0], argv[1], atoi(argv[2]),
+				(argc > 3) ? argv[3] : NULL);
+
+		if (err != S_OK) {
+			fprintf(stderr, "%s:%d: failed to add sensor job (%d)\n", path, line_num,
+				err);
+			ret = err;
+		}
+	}
+
+	fclose(fp);
+
+	return ret;
+}
+
+/* Takes the oldest readings out of the ring sink */
+unsigned int sensor_sched_ring_read(struct sensor_reading *readings, unsigned int max)
+{
+	unsigned int i, n, first;
+
+	pthread_mutex_lock(&g_sensor.sink_lock);
+	n = (max < g_sensor.ring_count) ? max : g_sensor.ring_count;
+	first = (g_sensor.ring_head + SENSOR_SCHED_RING_SIZE - g_sensor.ring_count) %
+		SENSOR_SCHED_RING_SIZE;
+	for (i = 0; i < n; i++)
+		readings[i] = g_sensor.ring[(first + i) % SENSOR_SCHED_RING_SIZE];
+	g_sensor.ring_count -= n;
+	pthread_mutex_unlock(&g_sensor.sink_lock);
+
+	return n;
+}
+
+void sensor_sched_dump(void)
+{
+	struct sensor_job *job;
+	char sinks[SENSOR_SCHED_LINE_MAX];
+	int i, s;
+
+	pthread_mutex_lock(&g_sensor.lock);
+	for (i = 0; i < SENSOR_SCHED_MAX_JOBS; i++) {
+		job = &g_sensor.jobs[i];
+		if (!job->used)
+			continue;
+
+		sinks[0] = '\0';
+		for (s = 0; s < g_sensor.num_sinks; s++) {
+			if (job->sinks & (1 << s))
+				snprintf(sinks + strlen(sinks), sizeof(sinks) - strlen(sinks), "%s%s",
+					sinks[0] ? "," : "", g_sensor.sinks[s].name);
+		}
+
+		if (job->input)
+			fprintf(stdout, "%s: %s:%s", job->name, sensor_source_names[job->source],
+				job->input->name);
+		else
+			fprintf(stdout, "%s: %s:%d", job->name, sensor_source_names[job->source],
+				job->pin);
+		fprintf(stdout, " every %u ms to %s\n", job->period_ticks * SENSOR_SCHED_TICK_MS,
+			sinks[0] ? sinks : "none");
+		fprintf(stdout, "\truns %u, emitted %u, missed %u, errors %u", job->runs,
+			job->emitted, job->missed, job->errors);
+		if (job->watch)
+			fprintf(stdout, ", edges %u, dropped %u", job->edges, job->watch->dropped);
+		if (job->have_last)
+			fprintf(stdout, ", last %d", job->last);
+		fprintf(stdout, "\n");
+		perf_stats_print("\tjitter", &job->jitter);
+	}
+
+	for (s = 0; s < g_sensor.num_sinks; s++)
+		fprintf(stdout, "sink %s: delivered %u, failed %u\n", g_sensor.sinks[s].name,
+			g_sensor.sinks[s].delivered, g_sensor.sinks[s].failed);
+	pthread_mutex_unlock(&g_sensor.lock);
+
+	pthread_mutex_lock(&g_sensor.sink_lock);
+	fprintf(stdout, "ring: %u readings, %u overwritten\n", g_sensor.ring_count,
+		g_sensor.ring_overwritten);
+	if (g_sensor.cloud_device[0])
+		fprintf(stdout, "cloud device: %s\n", g_sensor.cloud_device);
+	pthread_mutex_unlock(&g_sensor.sink_lock);
+}
@@ -0,0 +1,103 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file sensor-sched.h
+ */
+
+#ifndef __ARTIK_SENSOR_SCHED_H__
+#define __ARTIK_SENSOR_SCHED_H__
+
+#include <stdint.h>
+
+#include <artik_error.h>
+
+#define SENSOR_SCHED_MAX_JOBS		16
+#define SENSOR_SCHED_MAX_SINKS		8
+#define SENSOR_SCHED_NAME_LEN		16
+#define SENSOR_SCHED_TICK_MS		10
+#define SENSOR_SCHED_WHEEL_SLOTS	64	/* Must be a power of two */
+#define SENSOR_SCHED_RING_SIZE		128
+#define SENSOR_SCHED_LINE_MAX		128
+#ifndef SENSOR_SCHED_CONFIG_PATH
+#define SENSOR_SCHED_CONFIG_PATH	"/mnt/sensors.conf"
+#endif
+
+/*
+ * Periodic sampling jobs run by a single scheduler thread.
+ *
+ * A job reads one source every period and hands the value to the sinks
+ * it was added with. Sources are:
+ *
+ *   adc:<pin>              value of an ADC pin
+ *   gpio:<pin>             level of a GPIO pin, only emitted when it changed
+ *   avg|min|max:<job>      reduction of the values another job emitted
+ *                          since the last period, nothing if there were none
+ *
+ * Pins are requested when the job is added and kept open, so running a
+ * job costs the read and nothing else: no task is created and no module
+ * is looked up per sample. GPIO pins are not read at all: the job
+ * subscribes to the pin's edges through gpio-watch, and each period takes
+ * the debounced edges queued since the last one. Every edge feeds the
+ * reductions of other jobs, the sinks get the level the pin ended on with
+ * the time of its last edge, so a press and release within one period is
+ * not lost. A pin cached by the gpio commands is released when the job is
+ * added, and the job releases its own when removed.
+ *
+ * Jobs are kept in a hashed timer wheel of SENSOR_SCHED_WHEEL_SLOTS slots
+ * of SENSOR_SCHED_TICK_MS each, so a tick only looks at the jobs whose
+ * deadline falls in its slot. Deadlines advance by whole periods from the
+ * previous one, so they do not drift. A job run late records how late in
+ * its jitter statistics, and the periods it could not run at all are
+ * counted as missed.
+ *
+ * Readings are handed to the sinks outside of the scheduler lock. The
+ * console, ring and cloud sinks are built in; the cloud sink adds the
+ * readings to the telemetry batch of the device set with
+ * sensor_sched_set_cloud_device(), which sends them as set with
+ * 'cloud batch config'.
+ *
+ * A configuration file holds one job per line, as given to
+ * sensor_sched_add(), or a "cloud <device id>" line. Text after a '#' is
+ * ignored:
+ *
+ *   cloud 0123456789abcdef0123456789abcdef
+ *   light  adc:0       10     ring
+ *   light1 avg:light   10000  cloud
+ *   button gpio:45     20     console,cloud
+ */
+struct sensor_reading {
+	uint32_t time_ms;	/* Since the scheduler was started */
+	char name[SENSOR_SCHED_NAME_LEN];
+	int32_t value;
+};
+
+typedef artik_error (*sensor_sink_fn)(const struct sensor_reading *reading, void *user_data);
+
+int sensor_sched_add_sink(const char *name, sensor_sink_fn fn, void *user_data);
+artik_error sensor_sched_add(const char *name, const char *source, unsigned int period_ms,
+		const char *sinks);
+artik_error sensor_sched_remove(const char *name);
+void sensor_sched_remove_all(void);
+void sensor_sched_set_cloud_device(const char *device_id);
+artik_error sensor_sched_load(const char *path);
+unsigned int sensor_sched_ring_read(struct sensor_reading *readings, unsigned int max);
+void sensor_sched_dump(void);
+
+#endif /* __ARTIK_SENSOR_SCHED_H__ */
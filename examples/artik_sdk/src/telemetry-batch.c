@@ -0,0 +1,662 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file telemetry-batch.c
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "perf-stats.h"
+#include "telemetry-batch.h"
+
+#define TELEMETRY_BATCH_DEFAULT_RECORDS	10
+#define TELEMETRY_BATCH_DEFAULT_AGE_MS	5000
+#define TELEMETRY_BATCH_TICK_MS			100
+#define TELEMETRY_BATCH_RETRY_MS		2000
+#define TELEMETRY_BATCH_STACK_SIZE		8192
+
+/* Room kept at the end of a message for the aggregated fields */
+#define TELEMETRY_BATCH_AGG_RESERVE		(TELEMETRY_BATCH_MAX_FIELDS * \
+		(TELEMETRY_BATCH_NAME_LEN + 24) + 16)
+
+enum batch_reason {
+	BATCH_REASON_SIZE,
+	BATCH_REASON_AGE,
+	BATCH_REASON_EXPLICIT,
+	BATCH_REASON_COUNT
+};
+
+struct batch_field {
+	char name[TELEMETRY_BATCH_NAME_LEN];
+	enum telemetry_type type;
+	enum telemetry_agg agg;
+	bool typed;
+};
+
+struct batch_record {
+	uint64_t mono_us;
+	uint8_t present;
+	union telemetry_value values[TELEMETRY_BATCH_MAX_FIELDS];
+};
+
+struct batch_stats {
+	unsigned int samples;
+	unsigned int messages;
+	unsigned int flushes[BATCH_REASON_COUNT];
+	unsigned int dropped;
+	unsigned int errors;
+};
+
+struct telemetry_batch {
+	bool used;
+	char device_id[TELEMETRY_BATCH_DEVICE_LEN];
+	unsigned int max_records;
+	unsigned int max_age_ms;
+	struct batch_field fields[TELEMETRY_BATCH_MAX_FIELDS];
+	int field_count;
+	struct batch_record records[TELEMETRY_BATCH_MAX_RECORDS];
+	unsigned int count;
+	uint64_t retry_us;
+	struct batch_stats stats;
+};
+
+struct batch_context {
+	struct telemetry_batch batches[TELEMETRY_BATCH_MAX_DEVICES];
+	pthread_mutex_t lock;
+	telemetry_batch_sink sink;
+	void *user_data;
+	bool running;
+	pthread_t thread;
+	sem_t wake;
+
+	/* Used by one flush at a time, under flush_lock */
+	pthread_mutex_t flush_lock;
+	struct batch_field fields[TELEMETRY_BATCH_MAX_FIELDS];
+	struct batch_record records[TELEMETRY_BATCH_MAX_RECORDS];
+	char device_id[TELEMETRY_BATCH_DEVICE_LEN];
+	char message[TELEMETRY_BATCH_MESSAGE_SIZE];
+};
+
+static struct batch_context g_batch = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.flush_lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static const char * const agg_names[] = { "none", "last", "min", "max", "mean" };
+static const char * const reason_names[] = { "size", "age", "explicit" };
+
+static double value_to_double(enum telemetry_type type, const union telemetry_value *value)
+{
+	switch (type) {
+	case TELEMETRY_INT:
+		return value->i;
+	case TELEMETRY_FLOAT:
+		return value->f;
+	case TELEMETRY_BOOL:
+		return value->b;
+	default:
+		return 0;
+	}
+}
+
+static void value_convert(enum telemetry_type to, const struct telemetry_field *from,
+		union telemetry_value *value)
+{
+	double v = value_to_double(from->type, &from->value);
+
+	if (to == TELEMETRY_INT)
+		value->i = (int32_t)v;
+	else if (to == TELEMETRY_FLOAT)
+		value->f = (float)v;
+	else
+		value->b = (v != 0);
+}
+
+/* Must be called with g_batch.lock held */
+static struct telemetry_batch *batch_find(const char *device_id, bool create)
+{
+	struct telemetry_batch *free_slot = NULL;
+	int i;
+
+	for (i = 0; i < TELEMETRY_BATCH_MAX_DEVICES; i++) {
+		struct telemetry_batch *b = &g_batch.batches[i];
+
+		if (b->used && !strncmp(b->device_id, device_id, TELEMETRY_BATCH_DEVICE_LEN))
+			return b;
+		if (!b->used && !free_slot)
+			free_slot = b;
+	}
+
+	if (!create || !free_slot || (strlen(device_id) >= TELEMETRY_BATCH_DEVICE_LEN))
+		return NULL;
+
+	memset(free_slot, 0, sizeof(struct telemetry_batch));
+	free_slot->used = true;
+	strncpy(free_slot->device_id, device_id, TELEMETRY_BATCH_DEVICE_LEN - 1);
+	free_slot->max_records = TELEMETRY_BATCH_DEFAULT_RECORDS;
+	free_slot->max_age_ms = TELEMETRY_BATCH_DEFAULT_AGE_MS;
+
+	return free_slot;
+}
+
+static int batch_field_index(const struct telemetry_batch *b, const char *name)
+{
+	int i;
+
+	for (i = 0; i < b->field_count; i++) {
+		if (!strncmp(b->fields[i].name, name, TELEMETRY_BATCH_NAME_LEN))
+			return i;
+	}
+
+	return -1;
+}
+
+/* Appends formatted text at *len, fails without writing past limit */
+static bool batch_append(char *buf, unsigned int *len, unsigned int limit, const char *fmt, ...)
+	__attribute__((format(printf, 4, 5)));
+
+static bool batch_append(char *buf, unsigned int *len, unsigned int limit, const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	if (*len >= limit)
+		return false;
+
+	va_start(ap, fmt);
+	n = vsnprintf(buf + *len, limit - *len, fmt, ap);
+	va_end(ap);
+
+	if ((n < 0) || (*len + n >= limit))
+		return false;
+
+	*len += n;
+
+	return true;
+}
+
+static bool batch_append_value(char *buf, unsigned int *len, unsigned int limit,
+		enum telemetry_type type, const union telemetry_value *value)
+{
+	int n;
+
+	if (*len >= limit)
+		return false;
+
+	n = telemetry_format_value(buf + *len, limit - *len, type, value);
+	if (n < 0)
+		return false;
+
+	*len += n;
+
+	return true;
+}
+
+static bool batch_append_aggregate(char *buf, unsigned int *len, unsigned int size,
+		const struct batch_field *field, int index, const struct batch_record *records,
+		int count)
+{
+	const union telemetry_value *pick = NULL;
+	union telemetry_value mean;
+	enum telemetry_type type = field->type;
+	double v, best = 0, sum = 0;
+	int i, n = 0;
+
+	for (i = 0; i < count; i++) {
+		if (!(records[i].present & (1 << index)))
+			continue;
+
+		v = value_to_double(field->type, &records[i].values[index]);
+		if (!n || (field->agg == TELEMETRY_AGG_LAST) ||
+				((field->agg == TELEMETRY_AGG_MIN) && (v < best)) ||
+				((field->agg == TELEMETRY_AGG_MAX) && (v > best))) {
+			best = v;
+			pick = &records[i].values[index];
+		}
+		sum += v;
+		n++;
+	}
+
+	if (!n)
+		return true;
+
+	if (field->agg == TELEMETRY_AGG_MEAN) {
+		mean.f = (float)(sum / n);
+		pick = &mean;
+		type = TELEMETRY_FLOAT;
+	}
+
+	return batch_append(buf, len, size, ",\"%s\":{\"%s\":", field->name,
+			agg_names[field->agg]) &&
+		batch_append_value(buf, len, size, type, pick) &&
+		batch_append(buf, len, size, "}");
+}
+
+/*
+ * Encodes as many of the records as fit in one message and returns their
+ * number, 0 if not even the first one fits.
+ */
+static int batch_encode(const struct batch_field *fields, int field_count,
+		const struct batch_record *records, int count, char *buf, unsigned int size)
+{
+	uint64_t now_us = perf_now_us();
+	unsigned long long base_ms;
+	struct timespec now;
+	unsigned int len = 0, mark;
+	unsigned int limit = size - TELEMETRY_BATCH_AGG_RESERVE;
+	bool samples = false;
+	int i, f, done = count;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	base_ms = (unsigned long long)now.tv_sec * 1000 + now.tv_nsec / 1000000 -
+		(now_us - records[0].mono_us) / 1000;
+
+	for (f = 0; f < field_count; f++) {
+		if (fields[f].agg == TELEMETRY_AGG_NONE)
+			samples = true;
+	}
+
+	batch_append(buf, &len, size, "{\"ts\":%llu", base_ms);
+
+	if (samples) {
+		batch_append(buf, &len, limit, ",\"samples\":[");
+
+		for (i = 0; i < count; i++) {
+			bool fits;
+
+			mark = len;
+			fits = batch_append(buf, &len, limit, "%s{\"dt\":%u", i ? "," : "",
+				(unsigned int)((records[i].mono_us - records[0].mono_us) / 1000));
+			for (f = 0; fits && (f < field_count); f++) {
+				if ((fields[f].agg != TELEMETRY_AGG_NONE) ||
+						!(records[i].present & (1 << f)))
+					continue;
+				fits = batch_append(buf, &len, limit, ",\"%s\":", fields[f].name) &&
+					batch_append_value(buf, &len, limit, fields[f].type,
+						&records[i].values[f]);
+			}
+			if (!fits || !batch_append(buf, &len, limit, "}")) {
+				len = mark;
+				break;
+			}
+		}
+
+		done = i;
+		if (!done)
+			return 0;
+
+		batch_append(buf, &len, size, "]");
+	}
+
+	for (f = 0; f < field_count; f++) {
+		if ((fields[f].agg != TELEMETRY_AGG_NONE) &&
+				!batch_append_aggregate(buf, &len, size, &fields[f], f, records, done))
+			return 0;
+	}
+
+	if (!batch_append(buf, &len, size, ",\"count\":%d}", done))
+		return 0;
+
+	return done;
+}
+
+static artik_error batch_flush(struct telemetry_batch *b, enum batch_reason reason)
+{
+	artik_error err = S_OK;
+	int field_count, count, sent;
+
+	pthread_mutex_lock(&g_batch.flush_lock);
+
+	pthread_mutex_lock(&g_batch.lock);
+	if (b->used && b->count)
+		b->stats.flushes[reason]++;
+	pthread_mutex_unlock(&g_batch.lock);
+
+	while (1) {
+		/* Work on a copy so that samples can keep coming in while sending */
+		pthread_mutex_lock(&g_batch.lock);
+		count = b->used ? b->count : 0;
+		field_count = b->field_count;
+		memcpy(g_batch.fields, b->fields, sizeof(g_batch.fields));
+		memcpy(g_batch.records, b->records, count * sizeof(struct batch_record));
+		memcpy(g_batch.device_id, b->device_id, sizeof(g_batch.device_id));
+		pthread_mutex_unlock(&g_batch.lock);
+
+		if (!count)
+			break;
+
+		sent = batch_encode(g_batch.fields, field_count, g_batch.records, count,
+			g_batch.message, sizeof(g_batch.message));
+		if (!sent) {
+			/* A single sample too large for a message can never be sent */
+			err = E_OVERFLOW;
+			sent = 1;
+		} else if (!g_batch.sink) {
+			err = E_NOT_INITIALIZED;
+		} else {
+			err = g_batch.sink(g_batch.device_id, g_batch.message, g_batch.user_data);
+		}
+
+		pthread_mutex_lock(&g_batch.lock);
+		if (err == E_OVERFLOW) {
+			b->stats.dropped++;
+		} else if (err != S_OK) {
+			b->stats.errors++;
+			b->retry_us = perf_now_us() + TELEMETRY_BATCH_RETRY_MS * 1000ULL;
+			pthread_mutex_unlock(&g_batch.lock);
+			break;
+		} else {
+			b->stats.messages++;
+			b->retry_us = 0;
+		}
+		b->count -= sent;
+		memmove(b->records, b->records + sent, b->count * sizeof(struct batch_record));
+		pthread_mutex_unlock(&g_batch.lock);
+	}
+
+	pthread_mutex_unlock(&g_batch.flush_lock);
+
+	return err;
+}
+
+static pthread_addr_t batch_thread(pthread_addr_t arg)
+{
+	struct timespec timeout;
+	struct telemetry_batch *b;
+	enum batch_reason reason;
+	uint64_t now;
+	bool due;
+	int i;
+
+	while (1) {
+		clock_gettime(CLOCK_REALTIME, &timeout);
+		timeout.tv_nsec += TELEMETRY_BATCH_TICK_MS * 1000000;
+		if (timeout.tv_nsec >= 1000000000) {
+			timeout.tv_sec++;
+			timeout.tv_nsec -= 1000000000;
+		}
+		sem_timedwait(&g_batch.wake, &timeout);
+
+		for (i = 0; i < TELEMETRY_BATCH_MAX_DEVICES; i++) {
+			b = &g_batch.batches[i];
+			now = perf_now_us();
+
+			pthread_mutex_lock(&g_batch.lock);
+			due = b->used && b->count && (now >= b->retry_us);
+			if (due && (b->count >= b->max_records))
+				reason = BATCH_REASON_SIZE;
+			else if (due && (now - b->records[0].mono_us >= b->max_age_ms * 1000ULL))
+				reason = BATCH_REASON_AGE;
+			else
+				due = false;
+			pthread_mutex_unlock(&g_batch.lock);
+
+			if (due)
+				batch_flush(b, reason);
+		}
+	}
+
+	return NULL;
+}
+
+/* Must be called with g_batch.lock held */
+static int batch_start(void)
+{
+	pthread_attr_t attr;
+	int ret;
+
+	if (g_batch.running)
+		return 0;
+
+	sem_init(&g_batch.wake, 0, 0);
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, TELEMETRY_BATCH_STACK_SIZE);
+	ret = pthread_create(&g_batch.thread, &attr, batch_thread, NULL);
+	pthread_attr_destroy(&attr);
+
+	if (ret != 0) {
+		sem_destroy(&g_batch.wake);
+		return -1;
+	}
+
+	g_batch.running = true;
+
+	return 0;
+}
+
+void telemetry_batch_set_sink(telemetry_batch_sink sink, void *user_data)
+{
+	pthread_mutex_lock(&g_batch.lock);
+	g_batch.sink = sink;
+	g_batch.user_data = user_data;
+	pthread_mutex_unlock(&g_batch.lock);
+}
+
+artik_error telemetry_batch_configure(const char *device_id, unsigned int max_records,
+		unsigned int max_age_ms)
+{
+	struct telemetry_batch *b;
+	artik_error ret = S_OK;
+
+	if (!device_id || !max_records || (max_records > TELEMETRY_BATCH_MAX_RECORDS) ||
+			!max_age_ms)
+		return E_BAD_ARGS;
+
+	pthread_mutex_lock(&g_batch.lock);
+	b = batch_find(device_id, true);
+	if (!b || (batch_start() < 0)) {
+		ret = E_BUSY;
+	} else {
+		b->max_records = max_records;
+		b->max_age_ms = max_age_ms;
+	}
+	pthread_mutex_unlock(&g_batch.lock);
+
+	if (ret == S_OK)
+		sem_post(&g_batch.wake);
+
+	return ret;
+}
+
+artik_error telemetry_batch_set_aggregation(const char *device_id, const char *field,
+		enum telemetry_agg agg)
+{
+	struct telemetry_batch *b;
+	artik_error ret = S_OK;
+	int i;
+
+	if (!device_id || !field || (strlen(field) >= TELEMETRY_BATCH_NAME_LEN) ||
+			(agg > TELEMETRY_AGG_MEAN))
+		return E_BAD_ARGS;
+
+	pthread_mutex_lock(&g_batch.lock);
+	b = batch_find(device_id, false);
+	if (!b) {
+		ret = E_BAD_ARGS;
+		goto exit;
+	}
+
+	i = batch_field_index(b, field);
+	if (i < 0) {
+		if (b->count || (b->field_count == TELEMETRY_BATCH_MAX_FIELDS)) {
+			ret = E_BUSY;
+			goto exit;
+		}
+		i = b->field_count++;
+		strncpy(b->fields[i].name, field, TELEMETRY_BATCH_NAME_LEN - 1);
+	}
+	b->fields[i].agg = agg;
+
+exit:
+	pthread_mutex_unlock(&g_batch.lock);
+
+	return ret;
+}
+
+artik_error telemetry_batch_add(const char *device_id, const struct telemetry_field *fields,
+		int count)
+{
+	struct telemetry_batch *b;
+	struct batch_record *rec;
+	artik_error ret = S_OK;
+	bool full = false;
+	int i, index, added = 0;
+
+	if (!device_id || !fields || (count <= 0))
+		return E_BAD_ARGS;
+
+	for (i = 0; i < count; i++) {
+		if ((fields[i].type == TELEMETRY_STRING) ||
+				(strlen(fields[i].name) >= TELEMETRY_BATCH_NAME_LEN))
+			return E_NOT_SUPPORTED;
+	}
+
+	pthread_mutex_lock(&g_batch.lock);
+	b = batch_find(device_id, true);
+	if (!b || (batch_start() < 0)) {
+		ret = E_BUSY;
+		goto exit;
+	}
+
+	/*
+	 * max_records only triggers the flush, the rest of the array is
+	 * headroom for samples arriving while that flush is being sent.
+	 */
+	if (b->count >= TELEMETRY_BATCH_MAX_RECORDS) {
+		b->stats.dropped++;
+		ret = E_BUSY;
+		goto exit;
+	}
+
+	/* Make sure every field has a column before storing anything */
+	for (i = 0; i < count; i++) {
+		if (batch_field_index(b, fields[i].name) < 0)
+			added++;
+	}
+	if (b->field_count + added > TELEMETRY_BATCH_MAX_FIELDS) {
+		ret = E_OVERFLOW;
+		goto exit;
+	}
+
+	rec = &b->records[b->count];
+	rec->mono_us = perf_now_us();
+	rec->present = 0;
+
+	for (i = 0; i < count; i++) {
+		index = batch_field_index(b, fields[i].name);
+		if (index < 0) {
+			index = b->field_count++;
+			memset(&b->fields[index], 0, sizeof(struct batch_field));
+			strncpy(b->fields[index].name, fields[i].name, TELEMETRY_BATCH_NAME_LEN - 1);
+		}
+		/* A column takes the type of the first value stored in it */
+		if (!b->fields[index].typed) {
+			b->fields[index].type = fields[i].type;
+			b->fields[index].typed = true;
+		}
+		value_convert(b->fields[index].type, &fields[i], &rec->values[index]);
+		rec->present |= 1 << index;
+	}
+
+	b->count++;
+	b->stats.samples++;
+	full = (b->count >= b->max_records);
+
+exit:
+	pthread_mutex_unlock(&g_batch.lock);
+
+	if (full)
+		sem_post(&g_batch.wake);
+
+	return ret;
+}
+
+/* Flushes one device, or all of them when device_id is NULL */
+artik_error telemetry_batch_flush(const char *device_id)
+{
+	artik_error ret = S_OK, err;
+	struct telemetry_batch *b;
+	bool found = false;
+	int i;
+
+	for (i = 0; i < TELEMETRY_BATCH_MAX_DEVICES; i++) {
+		b = &g_batch.batches[i];
+
+		pthread_mutex_lock(&g_batch.lock);
+		if (!b->used || (device_id &&
+				strncmp(b->device_id, device_id, TELEMETRY_BATCH_DEVICE_LEN))) {
+			pthread_mutex_unlock(&g_batch.lock);
+			continue;
+		}
+		pthread_mutex_unlock(&g_batch.lock);
+
+		found = true;
+		err = batch_flush(b, BATCH_REASON_EXPLICIT);
+		if (err != S_OK)
+			ret = err;
+	}
+
+	return (device_id && !found) ? E_BAD_ARGS : ret;
+}
+
+int telemetry_agg_from_string(const char *str)
+{
+	unsigned int i;
+
+	for (i = 0; i < sizeof(agg_names) / sizeof(agg_names[0]); i++) {
+		if (!strcmp(str, agg_names[i]))
+			return i;
+	}
+
+	return -1;
+}
+
+void telemetry_batch_dump(void)
+{
+	struct telemetry_batch *b;
+	int i, f;
+
+	pthread_mutex_lock(&g_batch.lock);
+	for (i = 0; i < TELEMETRY_BATCH_MAX_DEVICES; i++) {
+		b = &g_batch.batches[i];
+		if (!b->used)
+			continue;
+
+		fprintf(stdout, "%s: %u/%u samples buffered, max age %u ms\n", b->device_id,
+			b->count, b->max_records, b->max_age_ms);
+		fprintf(stdout, "  fields:");
+		for (f = 0; f < b->field_count; f++)
+			fprintf(stdout, " %s(%s)", b->fields[f].name, agg_names[b->fields[f].agg]);
+		fprintf(stdout, "\n");
+		fprintf(stdout, "  %u samples in %u messages", b->stats.samples, b->stats.messages);
+		if (b->stats.messages)
+			fprintf(stdout, " (%u per message)", b->stats.samples / b->stats.messages);
+		fprintf(stdout, ", flushes");
+		for (f = 0; f < BATCH_REASON_COUNT; f++)
+			fprintf(stdout, " %s %u", reason_names[f], b->stats.flushes[f]);
+		fprintf(stdout, ", dropped %u errors %u\n", b->stats.dropped, b->stats.errors);
+	}
+	pthread_mutex_unlock(&g_batch.lock);
+}
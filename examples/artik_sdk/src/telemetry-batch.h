@@ -0,0 +1,78 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file telemetry-batch.h
+ */
+
+#ifndef __ARTIK_TELEMETRY_BATCH_H__
+#define __ARTIK_TELEMETRY_BATCH_H__
+
+#include <artik_error.h>
+
+#include "telemetry.h"
+
+/*
+ * Per device telemetry batching.
+ *
+ * Samples are stored in a fixed buffer for each device and sent as one
+ * multi-record JSON message when the batch reaches its record limit, when
+ * its oldest sample reaches the age limit, or on telemetry_batch_flush().
+ * Fields left at TELEMETRY_AGG_NONE are kept sample by sample in the
+ * "samples" array with their offset in ms from "ts"; the other fields are
+ * reduced to a single last/min/max/mean value per message:
+ *
+ *   {"ts":1500000000000,"samples":[{"dt":0,"temp":21.50},{"dt":1000,...}],
+ *    "humidity":{"mean":41.33},"count":3}
+ *
+ * Samples are only removed once the sink accepted the message carrying
+ * them; a batch that cannot be sent keeps its samples. Reaching max_records
+ * starts a flush, samples keep being stored while it runs and are only
+ * rejected and counted as dropped once TELEMETRY_BATCH_MAX_RECORDS are held. A batch larger than
+ * TELEMETRY_BATCH_MESSAGE_SIZE is split over several messages.
+ */
+#define TELEMETRY_BATCH_MAX_DEVICES		4
+#define TELEMETRY_BATCH_MAX_FIELDS		8
+#define TELEMETRY_BATCH_MAX_RECORDS		32
+#define TELEMETRY_BATCH_NAME_LEN		16
+#define TELEMETRY_BATCH_DEVICE_LEN		40
+#define TELEMETRY_BATCH_MESSAGE_SIZE	1000
+
+enum telemetry_agg {
+	TELEMETRY_AGG_NONE,
+	TELEMETRY_AGG_LAST,
+	TELEMETRY_AGG_MIN,
+	TELEMETRY_AGG_MAX,
+	TELEMETRY_AGG_MEAN
+};
+
+typedef artik_error (*telemetry_batch_sink)(const char *device_id, const char *message,
+		void *user_data);
+
+void telemetry_batch_set_sink(telemetry_batch_sink sink, void *user_data);
+artik_error telemetry_batch_configure(const char *device_id, unsigned int max_records,
+		unsigned int max_age_ms);
+artik_error telemetry_batch_set_aggregation(const char *device_id, const char *field,
+		enum telemetry_agg agg);
+artik_error telemetry_batch_add(const char *device_id, const struct telemetry_field *fields,
+		int count);
+artik_error telemetry_batch_flush(const char *device_id);
+int telemetry_agg_from_string(const char *str);
+void telemetry_batch_dump(void);
+
+#endif /* __ARTIK_TELEMETRY_BATCH_H__ */
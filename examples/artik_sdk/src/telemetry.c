@@ -0,0 +1,118 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file telemetry.c
+ */
+
+#include <stdio.h>
+
+#include "cbor.h"
+#include "telemetry.h"
+
+/* Formats a value as JSON, returns its length or -1 if it does not fit */
+int telemetry_format_value(char *buf, unsigned int size, enum telemetry_type type,
+		const union telemetry_value *value)
+{
+	int n = -1;
+
+	switch (type) {
+	case TELEMETRY_INT:
+		n = snprintf(buf, size, "%d", (int)value->i);
+		break;
+	case TELEMETRY_FLOAT:
+		n = snprintf(buf, size, "%.2f", (double)value->f);
+		break;
+	case TELEMETRY_BOOL:
+		n = snprintf(buf, size, "%s", value->b ? "true" : "false");
+		break;
+	case TELEMETRY_STRING:
+		n = snprintf(buf, size, "\"%s\"", value->s);
+		break;
+	}
+
+	return ((n < 0) || ((unsigned int)n >= size)) ? -1 : n;
+}
+
+/* Returns the length of the JSON object, or -1 if it does not fit in buf */
+int telemetry_to_json(const struct telemetry_field *fields, int count, char *buf,
+		unsigned int size)
+{
+	unsigned int len = 0;
+	int i, n = 0;
+
+	if (size < 2)
+		return -1;
+
+	buf[len++] = '{';
+
+	for (i = 0; i < count; i++) {
+		const struct telemetry_field *f = &fields[i];
+		const char *sep = i ? "," : "";
+
+		n = snprintf(buf + len, size - len, "%s\"%s\":", sep, f->name);
+		if ((n < 0) || (len + n >= size))
+			return -1;
+		len += n;
+
+		n = telemetry_format_value(buf + len, size - len, f->type, &f->value);
+		if ((n < 0) || (len + n >= size))
+			return -1;
+		len += n;
+	}
+
+	if (len + 2 > size)
+		return -1;
+	buf[len++] = '}';
+	buf[len] = '\0';
+
+	return len;
+}
+
+/* Returns the length of the CBOR map, or -1 if it does not fit in buf */
+int telemetry_to_cbor(const struct telemetry_field *fields, int count, uint8_t *buf,
+		unsigned int size)
+{
+	struct cbor_writer w;
+	int i;
+
+	cbor_init(&w, buf, size, NULL, NULL);
+	cbor_put_map(&w, count);
+
+	for (i = 0; i < count; i++) {
+		const struct telemetry_field *f = &fields[i];
+
+		cbor_put_string(&w, f->name);
+		switch (f->type) {
+		case TELEMETRY_INT:
+			cbor_put_int(&w, f->value.i);
+			break;
+		case TELEMETRY_FLOAT:
+			cbor_put_float(&w, f->value.f);
+			break;
+		case TELEMETRY_BOOL:
+			cbor_put_bool(&w, f->value.b);
+			break;
+		case TELEMETRY_STRING:
+			cbor_put_string(&w, f->value.s);
+			break;
+		}
+	}
+
+	return cbor_finish(&w);
+}
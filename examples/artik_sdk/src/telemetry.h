@@ -0,0 +1,66 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file telemetry.h
+ */
+
+#ifndef __ARTIK_TELEMETRY_H__
+#define __ARTIK_TELEMETRY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Sensor message as a flat list of named values, encoded either as the
+ * JSON "data" object sent to ARTIK Cloud or as the equivalent CBOR map.
+ *
+ * The CBOR form maps one to one onto the JSON one: text keys, integers,
+ * float32 numbers, booleans and text. A server or gateway converting it
+ * with the generic CBOR to JSON rules of RFC 7049 section 4.1 gets the same
+ * object as the JSON path, except for the float formatting. Field names and
+ * string values are expected to be plain identifiers and are not escaped.
+ */
+enum telemetry_type {
+	TELEMETRY_INT,
+	TELEMETRY_FLOAT,
+	TELEMETRY_BOOL,
+	TELEMETRY_STRING
+};
+
+union telemetry_value {
+	int32_t i;
+	float f;
+	bool b;
+	const char *s;
+};
+
+struct telemetry_field {
+	const char *name;
+	enum telemetry_type type;
+	union telemetry_value value;
+};
+
+int telemetry_format_value(char *buf, unsigned int size, enum telemetry_type type,
+		const union telemetry_value *value);
+int telemetry_to_json(const struct telemetry_field *fields, int count, char *buf,
+		unsigned int size);
+int telemetry_to_cbor(const struct telemetry_field *fields, int count, uint8_t *buf,
+		unsigned int size);
+
+#endif /* __ARTIK_TELEMETRY_H__ */
@@ -0,0 +1,179 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file tls-cache.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "perf-stats.h"
+#include "tls-cache.h"
+#include "uri.h"
+
+struct tls_cache_entry {
+	char host[URI_MAX_HOST_LEN];
+	bool valid;
+	mbedtls_ssl_session session;
+	struct perf_stats full;
+	struct perf_stats resumed;
+	unsigned int offered;
+	uint64_t last_used;
+};
+
+static struct tls_cache_entry g_tls_cache[TLS_CACHE_MAX_HOSTS];
+static pthread_mutex_t g_tls_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Must be called with g_tls_lock held */
+static void tls_cache_clear(struct tls_cache_entry *entry)
+{
+	if (entry->valid)
+		mbedtls_ssl_session_free(&entry->session);
+	memset(entry, 0, sizeof(struct tls_cache_entry));
+}
+
+/* Must be called with g_tls_lock held */
+static struct tls_cache_entry *tls_cache_find(const char *host, bool create)
+{
+	struct tls_cache_entry *entry = NULL;
+	struct tls_cache_entry *oldest = &g_tls_cache[0];
+	int i;
+
+	for (i = 0; i < TLS_CACHE_MAX_HOSTS; i++) {
+		if (!strcmp(g_tls_cache[i].host, host)) {
+			entry = &g_tls_cache[i];
+			break;
+		}
+
+		if (g_tls_cache[i].last_used < oldest->last_used)
+			oldest = &g_tls_cache[i];
+	}
+
+	if (!entry && create) {
+		entry = oldest;
+		tls_cache_clear(entry);
+		strncpy(entry->host, host, URI_MAX_HOST_LEN - 1);
+	}
+
+	if (entry)
+		entry->last_used = perf_now_us();
+
+	return entry;
+}
+
+bool tls_cache_resume(const char *host, mbedtls_ssl_context *ssl)
+{
+	struct tls_cache_entry *entry;
+	bool offered = false;
+
+	if (!host || !ssl)
+		return false;
+
+	/* The session is deep-copied into the context, the entry can go away */
+	pthread_mutex_lock(&g_tls_lock);
+	entry = tls_cache_find(host, false);
+	if (entry && entry->valid && !mbedtls_ssl_set_session(ssl, &entry->session)) {
+		entry->offered++;
+		offered = true;
+	}
+	pthread_mutex_unlock(&g_tls_lock);
+
+	return offered;
+}
+
+void tls_cache_update(const char *host, const mbedtls_ssl_context *ssl, bool offered,
+		uint32_t handshake_us)
+{
+	struct tls_cache_entry *entry;
+	mbedtls_ssl_session session;
+	bool resumed = false;
+
+	if (!host || !ssl)
+		return;
+
+	mbedtls_ssl_session_init(&session);
+	if (mbedtls_ssl_get_session(ssl, &session)) {
+		mbedtls_ssl_session_free(&session);
+		return;
+	}
+
+	pthread_mutex_lock(&g_tls_lock);
+	entry = tls_cache_find(host, true);
+
+	/*
+	 * A resumed session keeps the master secret of the one offered, a full
+	 * handshake derives a new one. Session IDs cannot tell them apart since
+	 * the client makes up a fresh ID whenever it offers a ticket.
+	 */
+	if (offered && entry->valid)
+		resumed = !memcmp(session.master, entry->session.master,
+			sizeof(session.master));
+
+	perf_stats_add(resumed ? &entry->resumed : &entry->full, handshake_us);
+
+	if (entry->valid)
+		mbedtls_ssl_session_free(&entry->session);
+	memcpy(&entry->session, &session, sizeof(mbedtls_ssl_session));
+	entry->valid = true;
+	pthread_mutex_unlock(&g_tls_lock);
+}
+
+void tls_cache_forget(const char *host)
+{
+	struct tls_cache_entry *entry;
+
+	if (!host)
+		return;
+
+	pthread_mutex_lock(&g_tls_lock);
+	entry = tls_cache_find(host, false);
+	if (entry && entry->valid) {
+		mbedtls_ssl_session_free(&entry->session);
+		entry->valid = false;
+	}
+	pthread_mutex_unlock(&g_tls_lock);
+}
+
+void tls_cache_dump(void)
+{
+	int i;
+
+	pthread_mutex_lock(&g_tls_lock);
+	for (i = 0; i < TLS_CACHE_MAX_HOSTS; i++) {
+		if (!g_tls_cache[i].host[0])
+			continue;
+
+		fprintf(stdout, "%s (session %s, offered %u)\n", g_tls_cache[i].host,
+			g_tls_cache[i].valid ? "cached" : "none", g_tls_cache[i].offered);
+		perf_stats_print("\tfull handshake", &g_tls_cache[i].full);
+		perf_stats_print("\tresumed handshake", &g_tls_cache[i].resumed);
+	}
+	pthread_mutex_unlock(&g_tls_lock);
+}
+
+void tls_cache_flush(void)
+{
+	int i;
+
+	pthread_mutex_lock(&g_tls_lock);
+	for (i = 0; i < TLS_CACHE_MAX_HOSTS; i++)
+		tls_cache_clear(&g_tls_cache[i]);
+	pthread_mutex_unlock(&g_tls_lock);
+}
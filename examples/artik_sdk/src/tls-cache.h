@@ -0,0 +1,58 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file tls-cache.h
+ */
+
+#ifndef __ARTIK_TLS_CACHE_H__
+#define __ARTIK_TLS_CACHE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <tls/ssl.h>
+
+#define TLS_CACHE_MAX_HOSTS	8
+
+/*
+ * TLS session cache of the local HTTP client, one session per host.
+ *
+ * After each handshake the negotiated session (ID or ticket) is copied out
+ * of the mbedTLS context, and tls_cache_resume() offers it again on the
+ * next connection to the same host. A server that still knows the session
+ * skips the key exchange and the certificate chain. Only the
+ * mbedtls_ssl_handshake() loop is timed, and full and resumed handshakes
+ * are counted apart.
+ *
+ * The SDK keeps the mbedTLS context of its websocket and cloud connections
+ * to itself, so those do not go through this cache.
+ *
+ * tls_cache_resume() must be called between mbedtls_ssl_setup() and the
+ * handshake and returns whether a session was offered, to be handed back
+ * to tls_cache_update() once the handshake succeeded. A failed handshake
+ * calls tls_cache_forget() so that a stale session is not offered again.
+ */
+bool tls_cache_resume(const char *host, mbedtls_ssl_context *ssl);
+void tls_cache_update(const char *host, const mbedtls_ssl_context *ssl, bool offered,
+		uint32_t handshake_us);
+void tls_cache_forget(const char *host);
+void tls_cache_dump(void);
+void tls_cache_flush(void);
+
+#endif /* __ARTIK_TLS_CACHE_H__ */
@@ -0,0 +1,85 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file uri.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "uri.h"
+
+static const char *uri_skip_scheme(const char *uri)
+{
+	const char *p = strstr(uri, "://");
+
+	return p ? p + 3 : uri;
+}
+
+int uri_get_host(const char *uri, char *host, int len)
+{
+	const char *start = uri_skip_scheme(uri);
+	const char *end = start;
+	int host_len;
+
+	while (*end && *end != ':' && *end != '/' && *end != '?')
+		end++;
+
+	host_len = end - start;
+	if (!host_len || host_len >= len)
+		return -1;
+
+	memcpy(host, start, host_len);
+	host[host_len] = '\0';
+
+	return 0;
+}
+
+int uri_get_port(const char *uri)
+{
+	const char *p = uri_skip_scheme(uri);
+
+	while (*p && *p != ':' && *p != '/')
+		p++;
+
+	if (*p == ':')
+		return atoi(p + 1);
+
+	if (!strncmp(uri, "coaps+tcp://", 12))
+		return 5684;
+
+	return uri_is_secure(uri) ? 443 : 80;
+}
+
+/* Returns the path and query, or an empty string when the URI has none */
+const char *uri_get_path(const char *uri)
+{
+	const char *p = uri_skip_scheme(uri);
+
+	while (*p && *p != '/' && *p != '?')
+		p++;
+
+	return p;
+}
+
+bool uri_is_secure(const char *uri)
+{
+	return !strncmp(uri, "https://", 8) || !strncmp(uri, "wss://", 6) ||
+		!strncmp(uri, "coaps", 5);
+}
@@ -0,0 +1,35 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file uri.h
+ */
+
+#ifndef __ARTIK_URI_H__
+#define __ARTIK_URI_H__
+
+#include <stdbool.h>
+
+#define URI_MAX_HOST_LEN	64
+
+int uri_get_host(const char *uri, char *host, int len);
+int uri_get_port(const char *uri);
+const char *uri_get_path(const char *uri);
+bool uri_is_secure(const char *uri);
+
+#endif /* __ARTIK_URI_H__ */
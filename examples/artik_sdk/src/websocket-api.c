@@ -22,12 +22,19 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
 #include <shell/tash.h>
 
 #include <artik_module.h>
 #include <artik_websocket.h>
 
 #include "command.h"
+#include "perf-stats.h"
+#include "wifi-manager.h"
+#include "ws-manager.h"
 #ifdef CONFIG_EXAMPLES_ARTIK_WEBSOCKET
 #include "wifi-auto.h"
 #endif
@@ -35,116 +42,251 @@
 static int websocket_connect(int argc, char *argv[]);
 static int websocket_disconnect(int argc, char *argv[]);
 static int websocket_send(int argc, char *argv[]);
+static int websocket_bench(int argc, char *argv[]);
+static int websocket_list(int argc, char *argv[]);
+static int websocket_stats(int argc, char *argv[]);
 
-static artik_websocket_handle g_handle;
-static artik_websocket_module *g_websocket;
-static artik_websocket_config g_config;
+#define WEBSOCKET_BENCH_TIMEOUT	30
+
+struct websocket_bench {
+	bool active;
+	char name[WS_MANAGER_NAME_LEN];
+	int expected;
+	int received;
+	uint32_t *sent_us;
+	struct perf_stats rx;
+	struct perf_stats rtt;
+	sem_t done;
+};
+
+/* Echoes arrive on the SDK threads, the bench state is shared with them */
+static struct websocket_bench g_bench;
+static pthread_mutex_t g_bench_lock = PTHREAD_MUTEX_INITIALIZER;
 
 const struct command websocket_commands[] = {
-	{ "connect", "connect <uri>\n\t\t <uri> - example: wss://echo.websocket.org/", websocket_connect },
-	{ "disconnect", "disconnect", websocket_disconnect },
-	{ "send", "send <message>", websocket_send },
+	{ "connect", "connect <name> <uri>\n\t\t <uri> - example: wss://echo.websocket.org/", websocket_connect },
+	{ "disconnect", "disconnect <name>", websocket_disconnect },
+	{ "send", "send <name> <message> [coalesce]", websocket_send },
+	{ "bench", "bench <name> <count> <size> - Echo <count> frames of <size> bytes", websocket_bench },
+	{ "list", "List open connections", websocket_list },
+	{ "stats", "stats <name> - Display connection statistics", websocket_stats },
 	{ "", "", NULL }
 };
 
-static void websocket_rx_callback(void *user_data, void *result)
+static void websocket_rx_callback(const char *name, struct ws_frame *frame, void *user_data)
 {
-	if (result) {
-		fprintf(stderr, "RX: %s\n", (char *)result);
-		free(result);
-	}
-}
+	uint64_t start = perf_now_us();
 
-static void websocket_connection_callback(void *user_data, void *result)
-{
-	artik_websocket_connection_state state = (artik_websocket_connection_state)result;
+	pthread_mutex_lock(&g_bench_lock);
+	if (!g_bench.active || strncmp(name, g_bench.name, WS_MANAGER_NAME_LEN)) {
+		pthread_mutex_unlock(&g_bench_lock);
+		fprintf(stderr, "RX %s: %.*s\n", name, frame->len, frame->data);
+		return;
+	}
 
-	if (state == ARTIK_WEBSOCKET_CLOSED)
-		fprintf(stderr, "Websocket connection has been closed\n");
-	else if (state == ARTIK_WEBSOCKET_CONNECTED)
-		fprintf(stderr, "Websocket is connected\n");
+	perf_stats_add(&g_bench.rx, perf_now_us() - start);
+	if (g_bench.received < g_bench.expected)
+		perf_stats_add(&g_bench.rtt, (uint32_t)start - g_bench.sent_us[g_bench.received]);
+	if (++g_bench.received == g_bench.expected)
+		sem_post(&g_bench.done);
+	pthread_mutex_unlock(&g_bench_lock);
 }
 
 static int websocket_connect(int argc, char *argv[])
 {
 	artik_error ret = S_OK;
 
-	if (argc < 4) {
-		fprintf(stderr, "Missing uri parameter\n");
+	if (argc < 5) {
+		fprintf(stderr, "Wrong number of arguments\n");
 		usage(argv[1], websocket_commands);
 		return -1;
 	}
 
-	g_websocket = (artik_websocket_module *)artik_request_api_module("websocket");
-	if (!g_websocket) {
-		fprintf(stderr, "Websocket module is not available\n");
-		return -1;
-	}
-
-	memset(&g_config, 0, sizeof(artik_websocket_config));
-	g_config.uri = argv[3];
-
-	ret = g_websocket->websocket_request(&g_handle, &g_config);
+	ret = wifi_manager_wait_ready(WIFI_MANAGER_READY_TIMEOUT_MS);
 	if (ret != S_OK) {
-		fprintf(stderr, "Failed to request websocket (ret=%d)\n", ret);
+		fprintf(stderr, "Network is not ready (%s)\n", error_msg(ret));
 		return -1;
 	}
 
-	ret = g_websocket->websocket_open_stream(g_handle);
+	ret = ws_manager_open(argv[3], argv[4], websocket_rx_callback, NULL);
 	if (ret != S_OK) {
-		fprintf(stderr, "Failed to open websocket (ret=%d)\n", ret);
+		fprintf(stderr, "Failed to open websocket '%s' (%s)\n", argv[3], error_msg(ret));
 		return -1;
 	}
 
-	ret = g_websocket->websocket_set_receive_callback(g_handle, websocket_rx_callback, NULL);
-	if (ret != S_OK) {
-		fprintf(stderr, "Failed to register rx callback (ret=%d)\n", ret);
+	return 0;
+}
+
+static int websocket_disconnect(int argc, char *argv[])
+{
+	if (argc < 4) {
+		fprintf(stderr, "Missing name parameter\n");
+		usage(argv[1], websocket_commands);
 		return -1;
 	}
 
-	ret = g_websocket->websocket_set_connection_callback(g_handle, websocket_connection_callback, NULL);
-	if (ret != S_OK) {
-		fprintf(stderr, "Failed to register connection callback (ret=%d)\n", ret);
+	if (ws_manager_close(argv[3]) != S_OK) {
+		fprintf(stderr, "Websocket '%s' is not connected\n", argv[3]);
 		return -1;
 	}
 
 	return 0;
 }
 
-static int websocket_disconnect(int argc, char *argv[])
+static int websocket_send(int argc, char *argv[])
 {
-	if (!g_websocket || !g_handle) {
-		fprintf(stderr, "Websocket is not connected\n");
+	artik_error err = S_OK;
+
+	if (argc < 5) {
+		fprintf(stderr, "Wrong number of arguments\n");
+		usage(argv[1], websocket_commands);
 		return -1;
 	}
 
-	g_websocket->websocket_close_stream(g_handle);
+	err = ws_manager_send(argv[3], argv[4],
+		((argc > 5) && !strcmp(argv[5], "coalesce")) ? WS_SENDQ_COALESCE : 0);
+	if (err != S_OK) {
+		fprintf(stderr, "Failed to queue message (%s)\n", error_msg(err));
+		return -1;
+	}
 
-	artik_release_api_module(g_websocket);
-	g_websocket = NULL;
-	g_handle = NULL;
+	return 0;
+}
+
+static int websocket_list(int argc, char *argv[])
+{
+	ws_manager_dump(NULL);
 
 	return 0;
 }
 
-static int websocket_send(int argc, char *argv[])
+static int websocket_stats(int argc, char *argv[])
 {
 	if (argc < 4) {
-		fprintf(stderr, "Missing message parameter\n");
+		fprintf(stderr, "Missing name parameter\n");
 		usage(argv[1], websocket_commands);
 		return -1;
 	}
 
-	if (!g_websocket || !g_handle) {
-		fprintf(stderr, "Websocket is not connected\n");
+	if (!ws_manager_get_handle(argv[3])) {
+		fprintf(stderr, "Websocket '%s' is not connected\n", argv[3]);
 		return -1;
 	}
 
-	g_websocket->websocket_write_stream(g_handle, argv[3]);
+	ws_manager_dump(argv[3]);
 
 	return 0;
 }
 
+static int websocket_bench(int argc, char *argv[])
+{
+	struct ws_rxpool_stats before, after;
+	struct timespec timeout;
+	uint32_t *sent_us = NULL;
+	char *message = NULL;
+	uint64_t start = 0;
+	uint32_t elapsed = 0;
+	bool timed_out = false;
+	int count, size, i;
+	int ret = 0;
+
+	if (argc < 6) {
+		fprintf(stderr, "Wrong number of arguments\n");
+		usage(argv[1], websocket_commands);
+		return -1;
+	}
+
+	if (!ws_manager_get_handle(argv[3])) {
+		fprintf(stderr, "Websocket '%s' is not connected\n", argv[3]);
+		return -1;
+	}
+
+	count = atoi(argv[4]);
+	size = atoi(argv[5]);
+	if ((count <= 0) || (size <= 0)) {
+		fprintf(stderr, "Invalid count or size\n");
+		return -1;
+	}
+
+	message = malloc(size + 1);
+	sent_us = malloc(count * sizeof(uint32_t));
+	if (!message || !sent_us) {
+		fprintf(stderr, "Failed to allocate message\n");
+		ret = -1;
+		goto exit;
+	}
+	memset(message, 'x', size);
+	message[size] = '\0';
+
+	pthread_mutex_lock(&g_bench_lock);
+	memset(&g_bench, 0, sizeof(g_bench));
+	sem_init(&g_bench.done, 0, 0);
+	g_bench.sent_us = sent_us;
+	strncpy(g_bench.name, argv[3], WS_MANAGER_NAME_LEN - 1);
+	g_bench.expected = count;
+	g_bench.active = true;
+	pthread_mutex_unlock(&g_bench_lock);
+
+	ws_rxpool_get_stats(&before);
+	start = perf_now_us();
+	for (i = 0; i < count; i++) {
+		artik_error err;
+
+		pthread_mutex_lock(&g_bench_lock);
+		sent_us[i] = (uint32_t)perf_now_us();
+		pthread_mutex_unlock(&g_bench_lock);
+		/* Back off while the manager task drains the queue */
+		while ((err = ws_manager_send(argv[3], message, 0)) == E_BUSY)
+			usleep(1000);
+
+		if (err != S_OK) {
+			fprintf(stderr, "Failed to send frame %d (%s)\n", i, error_msg(err));
+			ret = -1;
+			break;
+		}
+	}
+
+	clock_gettime(CLOCK_REALTIME, &timeout);
+	timeout.tv_sec += WEBSOCKET_BENCH_TIMEOUT;
+	if ((ret == 0) && (sem_timedwait(&g_bench.done, &timeout) < 0) &&
+			(errno == ETIMEDOUT))
+		timed_out = true;
+	elapsed = perf_now_us() - start;
+
+	/* No echo touches the bench state past this point */
+	pthread_mutex_lock(&g_bench_lock);
+	g_bench.active = false;
+	pthread_mutex_unlock(&g_bench_lock);
+
+	if (timed_out) {
+		fprintf(stderr, "Timed out, %d/%d frames echoed\n", g_bench.received, count);
+		ret = -1;
+	}
+
+	fprintf(stdout, "%d frames of %d bytes echoed in %u ms", g_bench.received, size,
+		elapsed / 1000);
+	if (elapsed)
+		fprintf(stdout, " (%llu frames/s)", (unsigned long long)g_bench.received *
+			1000000 / elapsed);
+	fprintf(stdout, "\n");
+	perf_stats_print("rx callback", &g_bench.rx);
+	perf_stats_print("round trip", &g_bench.rtt);
+
+	/* Copied frames freed the SDK string in the callback, adopted ones keep it */
+	ws_rxpool_get_stats(&after);
+	fprintf(stdout, "rx buffers: %u pooled copies, %u adopted, %u heap descriptors, "
+		"high water %u/%d\n", after.copied - before.copied, after.adopted - before.adopted,
+		after.allocated - before.allocated, after.high_water, WS_RXPOOL_BUFFERS);
+
+	sem_destroy(&g_bench.done);
+
+exit:
+	free(sent_us);
+	free(message);
+
+	return ret;
+}
+
 int websocket_main(int argc, char *argv[])
 {
 	return commands_parser(argc, argv, websocket_commands);
@@ -28,14 +28,15 @@
 
 #include <artik_module.h>
 #include <artik_wifi.h>
-#include <artik_network.h>
+
+#include "dhcp-lease.h"
+#include "wifi-assoc.h"
+#include "wifi-manager.h"
 
 #define WIFI_SCAN_TIMEOUT       15
 #define WIFI_CONNECT_TIMEOUT    30
 #define WIFI_DISCONNECT_TIMEOUT 10
 
-static artik_network_dhcp_client_handle g_dhcp_handle;
-
 static void usage(void);
 
 typedef int (*command_fn)(int argc, char *argv[]);
@@ -60,22 +61,27 @@ static void wifi_scan_callback(void *result, void *user_data)
 	sem_post(&(res->sem));
 }
 
-static void wifi_connect_callback(void *result, void *user_data)
+/* The manager owns the radio until 'wifi disconnect' */
+static bool manager_owns_radio(void)
 {
-	struct callback_result *res = (struct callback_result *)user_data;
+	if (!wifi_manager_active())
+		return false;
 
-	memcpy(&(res->info), (artik_wifi_connection_info *)result,
-	       sizeof(artik_wifi_connection_info));
-	sem_post(&(res->sem));
+	fprintf(stderr, "The wifi manager is connected to a network, disconnect first\n");
+
+	return true;
 }
 
 static int startsta_command(int argc, char *argv[])
 {
 	int ret = 0;
 	artik_error err = S_OK;
-	artik_wifi_module *wifi = (artik_wifi_module *)
-		artik_request_api_module("wifi");
+	artik_wifi_module *wifi = NULL;
 
+	if (manager_owns_radio())
+		return -1;
+
+	wifi = (artik_wifi_module *)artik_request_api_module("wifi");
 	if (!wifi) {
 		fprintf(stderr, "Failed to request wifi module\n");
 		return -1;
@@ -98,9 +104,12 @@ static int startap_command(int argc, char *argv[])
 	int ret = 0;
 	char *passphrase = NULL;
 	artik_error err = S_OK;
-	artik_wifi_module *wifi = (artik_wifi_module *)
-		artik_request_api_module("wifi");
+	artik_wifi_module *wifi = NULL;
 
+	if (manager_owns_radio())
+		return -1;
+
+	wifi = (artik_wifi_module *)artik_request_api_module("wifi");
 	if (!wifi) {
 		fprintf(stderr, "Failed to request wifi module\n");
 		return -1;
@@ -212,145 +221,70 @@ exit:
 
 static int connect_command(int argc, char *argv[])
 {
-	int ret = 0;
 	artik_error err = S_OK;
-	struct callback_result conn_res;
-	struct timespec timeout;
-	bool persistent = false;
-	artik_wifi_module *wifi = (artik_wifi_module *)
-		artik_request_api_module("wifi");
-
-	if (!wifi) {
-		fprintf(stderr, "Failed to request wifi module\n");
-		return -1;
-	}
+	unsigned int flags = 0;
 
 	/* Check number of arguments */
 	if (argc < 5) {
 		fprintf(stderr, "Wrong number of arguments\n");
 		usage();
-		ret = -1;
-		goto exit;
+		return -1;
 	}
 
+	/* Joined again at boot by StartWifiConnection() */
 	if ((argc == 6) && !strncmp(argv[5], "persistent", strlen("persistent")))
-		persistent = true;
-
-	sem_init(&(conn_res.sem), 0, 0);
-
-	err = wifi->set_connect_callback(wifi_connect_callback, &(conn_res.sem));
-	if (err != S_OK) {
-		sem_destroy(&(conn_res.sem));
-		fprintf(stderr, "Failed to set connect callback (%)\n", error_msg(err));
-		ret = -1;
-		goto exit;
-	}
-
-	err = wifi->connect(argv[3], argv[4], persistent);
-	if (err != S_OK) {
-		sem_destroy(&(conn_res.sem));
-		wifi->set_connect_callback(NULL, NULL);
-		fprintf(stderr, "Failed to start connection to AP (%s)\n",
-			error_msg(err));
-		ret = -1;
-		goto exit;
-	}
+		flags = WIFI_MANAGER_PERSISTENT | WIFI_MANAGER_SAVE;
 
-	clock_gettime(CLOCK_REALTIME, &timeout);
-	timeout.tv_sec += WIFI_CONNECT_TIMEOUT;
-	if ((sem_timedwait(&(conn_res.sem), &timeout) < 0)
-	    && (errno == ETIMEDOUT)) {
-		sem_destroy(&(conn_res.sem));
-		wifi->set_connect_callback(NULL, NULL);
-		fprintf(stderr, "Timed out while waiting for connection\n");
-		ret = -1;
-		goto exit;
+	err = wifi_manager_start(argv[3], argv[4], flags);
+	if (err == E_BUSY) {
+		fprintf(stderr, "Already managing another network, disconnect first\n");
+		return -1;
+	} else if (err != S_OK) {
+		fprintf(stderr, "Failed to start connection to AP (%s)\n", error_msg(err));
+		return -1;
 	}
 
-	sem_destroy(&(conn_res.sem));
-	wifi->set_connect_callback(NULL, NULL);
-
-	if (!conn_res.info.connected) {
-		fprintf(stderr, "Failed to join the network (err=%d)\n",
-			conn_res.info.error);
-		ret = -1;
-		goto exit;
+	if (wifi_manager_wait(WIFI_STATE_READY, WIFI_CONNECT_TIMEOUT * 1000) != S_OK) {
+		fprintf(stderr, "Network is not ready yet, still trying in the background\n");
+		return -1;
 	}
 
-	fprintf(stderr, "Connected to %s\n", argv[3]);
-
-exit:
-	artik_release_api_module(wifi);
-	return ret;
+	return 0;
 }
 
 static int disconnect_command(int argc, char *argv[])
 {
-	int ret = 0;
-	artik_error err = S_OK;
-	struct callback_result conn_res;
-	struct timespec timeout;
-	artik_wifi_module *wifi = (artik_wifi_module *)
-		artik_request_api_module("wifi");
-
-	if (!wifi) {
-		fprintf(stderr, "Failed to request wifi module\n");
-		return -1;
-	}
-
-	sem_init(&(conn_res.sem), 0, 0);
-
-	err = wifi->set_connect_callback(wifi_connect_callback, &(conn_res.sem));
-	if (err != S_OK) {
-		sem_destroy(&(conn_res.sem));
-		fprintf(stderr, "Failed to set connect callback (%s)\n",
-			error_msg(err));
-		ret = -1;
-		goto exit;
-	}
-
-	err = wifi->disconnect();
-	if (err != S_OK) {
-		sem_destroy(&(conn_res.sem));
-		wifi->set_connect_callback(NULL, NULL);
-		fprintf(stderr, "Failed to disconnect from AP (%s)\n", error_msg(err));
-		ret = -1;
-		goto exit;
-	}
+	wifi_manager_stop();
 
-	clock_gettime(CLOCK_REALTIME, &timeout);
-	timeout.tv_sec += WIFI_DISCONNECT_TIMEOUT;
-	if ((sem_timedwait(&(conn_res.sem), &timeout) < 0)
-	    && (errno == ETIMEDOUT)) {
-		sem_destroy(&(conn_res.sem));
-		wifi->set_connect_callback(NULL, NULL);
+	if (wifi_manager_wait(WIFI_STATE_IDLE, WIFI_DISCONNECT_TIMEOUT * 1000) != S_OK) {
 		fprintf(stderr, "Timed out while waiting for disconnection\n");
-		ret = -1;
-		goto exit;
+		return -1;
 	}
 
-	sem_destroy(&(conn_res.sem));
-	wifi->set_connect_callback(NULL, NULL);
+	return 0;
+}
 
-	if (conn_res.info.connected) {
-		fprintf(stderr, "Failed to disconnect from the network (err=%d)\n",
-			conn_res.info.error);
-		ret = -1;
-		goto exit;
-	}
+static int status_command(int argc, char *argv[])
+{
+	wifi_manager_dump();
 
-exit:
-	artik_release_api_module(wifi);
-	return ret;
+	return 0;
 }
 
 static int stop_command(int argc, char *argv[])
 {
 	int ret = 0;
 	artik_error err = S_OK;
-	artik_wifi_module *wifi = (artik_wifi_module *)
-		artik_request_api_module("wifi");
+	artik_wifi_module *wifi = NULL;
+
+	/* Leave the network first, the manager would keep retrying on a stopped radio */
+	wifi_manager_stop();
+	if (wifi_manager_wait(WIFI_STATE_IDLE, WIFI_DISCONNECT_TIMEOUT * 1000) != S_OK) {
+		fprintf(stderr, "Timed out while waiting for disconnection\n");
+		return -1;
+	}
 
+	wifi = (artik_wifi_module *)artik_request_api_module("wifi");
 	if (!wifi) {
 		fprintf(stderr, "Failed to request wifi module\n");
 		return -1;
@@ -368,28 +302,64 @@ exit:
 	return ret;
 }
 
+static void dhcp_renewed(artik_error result, void *user_data)
+{
+	if (result != S_OK)
+		fprintf(stderr, "DHCP renewal failed (err=%d), the interface has no address\n",
+			result);
+}
+
 static int dhcp_command(int argc, char *argv[])
 {
-	int ret = 0;
-	artik_network_module *network = (artik_network_module *)
-		artik_request_api_module("network");
+	bool use_saved = true;
 	artik_error err = S_OK;
 
-	if (!network) {
-		fprintf(stderr, "Failed to request network module\n");
+	if (argc > 3) {
+		if (!strcmp(argv[3], "stats")) {
+			dhcp_lease_dump();
+			return 0;
+		} else if (!strcmp(argv[3], "clear")) {
+			dhcp_lease_clear();
+			return 0;
+		} else if (!strcmp(argv[3], "full")) {
+			use_saved = false;
+		} else {
+			fprintf(stderr, "Wrong arguments\n");
+			usage();
+			return -1;
+		}
+	}
+
+	err = dhcp_lease_start(use_saved, dhcp_renewed, NULL);
+	if (err == E_BUSY) {
+		fprintf(stderr, "DHCP is still renewing the saved lease\n");
+		return -1;
+	} else if (err != S_OK) {
+		fprintf(stderr, "Failed to request DHCP lease (err=%d)\n", err);
 		return -1;
 	}
 
-	err = network->dhcp_client_start(&g_dhcp_handle, ARTIK_WIFI);
-	if (err != S_OK) {
-		fprintf(stderr, "Failed to request DHCP lease (err=%d)\n", ret);
-		ret = -1;
-		goto exit;
+	return 0;
+}
+
+static int saved_command(int argc, char *argv[])
+{
+	struct wifi_assoc assoc;
+
+	if ((argc > 3) && !strcmp(argv[3], "clear")) {
+		wifi_assoc_clear();
+		return 0;
 	}
 
-exit:
-	artik_release_api_module(network);
-	return ret;
+	if (wifi_assoc_load(&assoc) != S_OK) {
+		fprintf(stderr, "No saved network\n");
+		return -1;
+	}
+
+	fprintf(stdout, "%s: connected in %u ms, %u ms after boot\n", assoc.ssid,
+		assoc.connect_ms, assoc.boot_ms);
+
+	return 0;
 }
 
 static const struct wifi_command commands[] = {
@@ -398,8 +368,10 @@ static const struct wifi_command commands[] = {
 	{ "scan", "", scan_command },
 	{ "connect", "<ssid> <passphrase> [persistent]", connect_command },
 	{ "disconnect", "", disconnect_command },
+	{ "status", "", status_command },
 	{ "stop", "", stop_command },
-	{ "dhcp", "", dhcp_command },
+	{ "dhcp", "[full|stats|clear]", dhcp_command },
+	{ "saved", "[clear]", saved_command },
 	{ "", "", NULL }
 };
 
@@ -0,0 +1,92 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file wifi-assoc.c
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "inflate.h"
+#include "wifi-assoc.h"
+
+#define WIFI_ASSOC_MAGIC	0x57415343	/* "WASC" */
+
+struct wifi_assoc_record {
+	uint32_t magic;
+	struct wifi_assoc assoc;
+	uint32_t crc;
+};
+
+artik_error wifi_assoc_load(struct wifi_assoc *assoc)
+{
+	struct wifi_assoc_record rec;
+	ssize_t len;
+	int fd;
+
+	fd = open(WIFI_ASSOC_PATH, O_RDONLY);
+	if (fd < 0)
+		return E_ACCESS_DENIED;
+
+	len = read(fd, &rec, sizeof(rec));
+	close(fd);
+
+	if ((len != sizeof(rec)) || (rec.magic != WIFI_ASSOC_MAGIC) ||
+			(rec.crc != inflate_crc32(0, (const unsigned char *)&rec.assoc,
+				sizeof(rec.assoc))))
+		return E_INVALID_VALUE;
+
+	rec.assoc.ssid[WIFI_ASSOC_SSID_LEN - 1] = '\0';
+	if (!rec.assoc.ssid[0])
+		return E_INVALID_VALUE;
+
+	memcpy(assoc, &rec.assoc, sizeof(struct wifi_assoc));
+
+	return S_OK;
+}
+
+artik_error wifi_assoc_save(const struct wifi_assoc *assoc)
+{
+	struct wifi_assoc_record rec;
+	ssize_t len;
+	int fd;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.magic = WIFI_ASSOC_MAGIC;
+	strncpy(rec.assoc.ssid, assoc->ssid, WIFI_ASSOC_SSID_LEN - 1);
+	rec.assoc.connect_ms = assoc->connect_ms;
+	rec.assoc.boot_ms = assoc->boot_ms;
+	rec.crc = inflate_crc32(0, (const unsigned char *)&rec.assoc, sizeof(rec.assoc));
+
+	fd = open(WIFI_ASSOC_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0)
+		return E_ACCESS_DENIED;
+
+	len = write(fd, &rec, sizeof(rec));
+	close(fd);
+
+	return (len == sizeof(rec)) ? S_OK : E_ACCESS_DENIED;
+}
+
+void wifi_assoc_clear(void)
+{
+	unlink(WIFI_ASSOC_PATH);
+}
@@ -0,0 +1,58 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file wifi-assoc.h
+ */
+
+#ifndef __ARTIK_WIFI_ASSOC_H__
+#define __ARTIK_WIFI_ASSOC_H__
+
+#include <stdint.h>
+
+#include <artik_error.h>
+
+#define WIFI_ASSOC_SSID_LEN			33
+#ifndef WIFI_ASSOC_PATH
+#define WIFI_ASSOC_PATH				"/mnt/wifi-assoc"
+#endif
+
+/*
+ * Last network the device associated with, kept in a file so that it can
+ * be joined again at boot without being configured, along with how long
+ * the last connection took. The record carries a CRC32 and is ignored
+ * when it does not match, e.g. after a write cut by a reset.
+ *
+ * The passphrase is not part of the record. A network is only saved when
+ * it was connected to with the persistent flag, which has the wifi module
+ * keep the credentials itself. There is no directed join either: the SDK
+ * connects by SSID only, so the saved network is joined with a regular
+ * scan.
+ */
+struct wifi_assoc {
+	char ssid[WIFI_ASSOC_SSID_LEN];
+	uint32_t connect_ms;	/* From connect request to associated */
+	uint32_t boot_ms;		/* From boot to associated */
+};
+
+artik_error wifi_assoc_load(struct wifi_assoc *assoc);
+artik_error wifi_assoc_save(const struct wifi_assoc *assoc);
+void wifi_assoc_clear(void);
+
+#endif /* __ARTIK_WIFI_ASSOC_H__ */
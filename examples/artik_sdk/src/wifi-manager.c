@@ -0,0 +1,710 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file wifi-manager.c
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <artik_module.h>
+#include <artik_wifi.h>
+
+#include "dhcp-lease.h"
+#include "dns-cache.h"
+#include "perf-stats.h"
+#include "wifi-assoc.h"
+#include "wifi-manager.h"
+
+#define WIFI_MANAGER_STACK_SIZE	8192
+#define WIFI_MANAGER_QUEUE_SIZE	8
+#define WIFI_MANAGER_DHCP_POLL_MS	100
+
+enum wifi_manager_input {
+	WIFI_INPUT_START,
+	WIFI_INPUT_STOP,
+	WIFI_INPUT_LINK_UP,
+	WIFI_INPUT_LINK_DOWN,
+	WIFI_INPUT_DHCP_DONE,
+	WIFI_INPUT_DHCP_FAILED,
+	WIFI_INPUT_DHCP_LOST,
+	WIFI_INPUT_RECONNECT,
+	WIFI_INPUT_TIMEOUT
+};
+
+static const char * const wifi_state_names[] = {
+	"idle", "connecting", "dhcp", "ready", "backoff", "leaving"
+};
+
+struct wifi_subscriber {
+	wifi_manager_callback cb;
+	void *user_data;
+};
+
+struct wifi_manager {
+	artik_wifi_module *wifi;
+	enum wifi_manager_state state;	/* Only written by the manager task */
+	uint64_t deadline_us;			/* Of the current state, 0 for none */
+	bool active;					/* Between start and stop */
+	bool link_up;
+	char ssid[WIFI_ASSOC_SSID_LEN];
+	char passphrase[WIFI_MANAGER_PASSPHRASE_LEN];
+	unsigned int flags;
+	unsigned int failures;
+	uint64_t connect_start_us;
+	unsigned int dhcp_gen;			/* Of the association DHCP runs for */
+
+	enum wifi_manager_input queue[WIFI_MANAGER_QUEUE_SIZE];
+	unsigned int head;
+	unsigned int count;
+
+	struct wifi_subscriber subscribers[WIFI_MANAGER_MAX_SUBSCRIBERS];
+
+	unsigned int attempts;
+	unsigned int connects;
+	unsigned int link_losses;
+	unsigned int dhcp_failures;
+	unsigned int dropped;
+	struct perf_stats connect;
+	uint32_t first_boot_ms;
+
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+	sem_t wake;
+	pthread_t thread;
+	bool running;
+};
+
+static struct wifi_manager g_wifi = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.changed = PTHREAD_COND_INITIALIZER,
+};
+
+/* Must be called with g_wifi.lock held */
+static void wifi_manager_queue(enum wifi_manager_input input)
+{
+	if (g_wifi.count == WIFI_MANAGER_QUEUE_SIZE) {
+		g_wifi.dropped++;
+	} else {
+		g_wifi.queue[(g_wifi.head + g_wifi.count) % WIFI_MANAGER_QUEUE_SIZE] = input;
+		g_wifi.count++;
+	}
+}
+
+static void wifi_manager_post(enum wifi_manager_input input)
+{
+	pthread_mutex_lock(&g_wifi.lock);
+	wifi_manager_queue(input);
+	pthread_mutex_unlock(&g_wifi.lock);
+
+	sem_post(&g_wifi.wake);
+}
+
+/* Results of DHCP for an earlier association are dropped */
+static void wifi_manager_post_dhcp(enum wifi_manager_input input, unsigned int gen)
+{
+	bool current;
+
+	pthread_mutex_lock(&g_wifi.lock);
+	current = (gen == g_wifi.dhcp_gen);
+	if (current)
+		wifi_manager_queue(input);
+	pthread_mutex_unlock(&g_wifi.lock);
+
+	if (current)
+		sem_post(&g_wifi.wake);
+}
+
+static bool wifi_manager_dhcp_current(unsigned int gen)
+{
+	bool current;
+
+	pthread_mutex_lock(&g_wifi.lock);
+	current = (gen == g_wifi.dhcp_gen);
+	pthread_mutex_unlock(&g_wifi.lock);
+
+	return current;
+}
+
+/* Called from the wifi module, only queues the outcome to the manager task */
+static void wifi_manager_connect_callback(void *result, void *user_data)
+{
+	artik_wifi_connection_info *info = (artik_wifi_connection_info *)result;
+
+	wifi_manager_post(info->connected ? WIFI_INPUT_LINK_UP : WIFI_INPUT_LINK_DOWN);
+}
+
+/* Called from the DHCP renewal task */
+static void wifi_manager_dhcp_renewed(artik_error result, void *user_data)
+{
+	if (result != S_OK)
+		wifi_manager_post_dhcp(WIFI_INPUT_DHCP_LOST, (unsigned int)(uintptr_t)user_data);
+}
+
+/*
+ * Runs DHCP off the manager task, which keeps handling link events and
+ * stop requests meanwhile, and posts the outcome to it.
+ */
+static pthread_addr_t wifi_manager_dhcp_thread(pthread_addr_t arg)
+{
+	unsigned int gen = (unsigned int)(uintptr_t)arg;
+	unsigned int waited = 0;
+	artik_error err;
+
+	/* Busy while the lease of the previous association is still being renewed */
+	while (((err = dhcp_lease_start(true, wifi_manager_dhcp_renewed, arg)) == E_BUSY) &&
+			(waited < WIFI_MANAGER_DHCP_TIMEOUT_MS) && wifi_manager_dhcp_current(gen)) {
+		usleep(WIFI_MANAGER_DHCP_POLL_MS * 1000);
+		waited += WIFI_MANAGER_DHCP_POLL_MS;
+	}
+
+	if (err != S_OK)
+		fprintf(stderr, "Failed to request DHCP lease (err=%d)\n", err);
+
+	wifi_manager_post_dhcp((err == S_OK) ? WIFI_INPUT_DHCP_DONE : WIFI_INPUT_DHCP_FAILED,
+		gen);
+
+	return NULL;
+}
+
+static enum wifi_manager_input wifi_manager_next_input(uint64_t deadline)
+{
+	enum wifi_manager_input input;
+	struct timespec timeout;
+	uint64_t now, wait;
+
+	while (1) {
+		pthread_mutex_lock(&g_wifi.lock);
+		if (g_wifi.count) {
+			input = g_wifi.queue[g_wifi.head];
+			g_wifi.head = (g_wifi.head + 1) % WIFI_MANAGER_QUEUE_SIZE;
+			g_wifi.count--;
+			pthread_mutex_unlock(&g_wifi.lock);
+			return input;
+		}
+		pthread_mutex_unlock(&g_wifi.lock);
+
+		if (!deadline) {
+			sem_wait(&g_wifi.wake);
+			continue;
+		}
+
+		now = perf_now_us();
+		if (now >= deadline)
+			return WIFI_INPUT_TIMEOUT;
+
+		wait = deadline - now;
+		clock_gettime(CLOCK_REALTIME, &timeout);
+		timeout.tv_nsec += (wait % 1000000) * 1000;
+		timeout.tv_sec += wait / 1000000 + timeout.tv_nsec / 1000000000;
+		timeout.tv_nsec %= 1000000000;
+		sem_timedwait(&g_wifi.wake, &timeout);
+	}
+}
+
+/* Drops link and DHCP events left over from an earlier attempt */
+static void wifi_manager_flush_link_events(void)
+{
+	enum wifi_manager_input input;
+	unsigned int i, count;
+
+	pthread_mutex_lock(&g_wifi.lock);
+	count = g_wifi.count;
+	g_wifi.count = 0;
+	for (i = 0; i < count; i++) {
+		input = g_wifi.queue[(g_wifi.head + i) % WIFI_MANAGER_QUEUE_SIZE];
+		if ((input == WIFI_INPUT_LINK_UP) || (input == WIFI_INPUT_LINK_DOWN) ||
+				(input == WIFI_INPUT_DHCP_DONE) || (input == WIFI_INPUT_DHCP_FAILED) ||
+				(input == WIFI_INPUT_DHCP_LOST))
+			continue;
+		g_wifi.queue[(g_wifi.head + g_wifi.count) % WIFI_MANAGER_QUEUE_SIZE] = input;
+		g_wifi.count++;
+	}
+	pthread_mutex_unlock(&g_wifi.lock);
+}
+
+static void wifi_manager_set_state(enum wifi_manager_state state, unsigned int timeout_ms)
+{
+	pthread_mutex_lock(&g_wifi.lock);
+	g_wifi.state = state;
+	g_wifi.deadline_us = timeout_ms ? perf_now_us() + (uint64_t)timeout_ms * 1000 : 0;
+	pthread_cond_broadcast(&g_wifi.changed);
+	pthread_mutex_unlock(&g_wifi.lock);
+}
+
+static void wifi_manager_publish(enum wifi_manager_event event)
+{
+	struct wifi_subscriber subscribers[WIFI_MANAGER_MAX_SUBSCRIBERS];
+	int i;
+
+	pthread_mutex_lock(&g_wifi.lock);
+	memcpy(subscribers, g_wifi.subscribers, sizeof(subscribers));
+	pthread_mutex_unlock(&g_wifi.lock);
+
+	for (i = 0; i < WIFI_MANAGER_MAX_SUBSCRIBERS; i++) {
+		if (subscribers[i].cb)
+			subscribers[i].cb(event, subscribers[i].user_data);
+	}
+}
+
+static void wifi_manager_backoff(void)
+{
+	unsigned int backoff;
+
+	pthread_mutex_lock(&g_wifi.lock);
+	backoff = WIFI_MANAGER_BACKOFF_MIN_MS << (g_wifi.failures < 6 ? g_wifi.failures : 6);
+	g_wifi.failures++;
+	pthread_mutex_unlock(&g_wifi.lock);
+
+	if (backoff > WIFI_MANAGER_BACKOFF_MAX_MS)
+		backoff = WIFI_MANAGER_BACKOFF_MAX_MS;
+	/* Jitter keeps devices that lost the same access point from retrying together */
+	backoff = backoff / 2 + rand() % (backoff / 2 + 1);
+
+	fprintf(stderr, "Retrying in %u ms\n", backoff);
+	wifi_manager_set_state(WIFI_STATE_BACKOFF, backoff);
+}
+
+static void wifi_manager_link_down(void)
+{
+	bool was_up;
+
+	pthread_mutex_lock(&g_wifi.lock);
+	was_up = g_wifi.link_up;
+	g_wifi.link_up = false;
+	pthread_mutex_unlock(&g_wifi.lock);
+
+	if (was_up)
+		wifi_manager_publish(WIFI_EVENT_LINK_DOWN);
+}
+
+static void wifi_manager_connect(void)
+{
+	char ssid[WIFI_ASSOC_SSID_LEN];
+	char passphrase[WIFI_MANAGER_PASSPHRASE_LEN];
+	artik_error err = S_OK;
+	unsigned int flags;
+
+	pthread_mutex_lock(&g_wifi.lock);
+	memcpy(ssid, g_wifi.ssid, sizeof(ssid));
+	memcpy(passphrase, g_wifi.passphrase, sizeof(passphrase));
+	flags = g_wifi.flags;
+	g_wifi.attempts++;
+	pthread_mutex_unlock(&g_wifi.lock);
+
+	wifi_manager_flush_link_events();
+	wifi_manager_set_state(WIFI_STATE_CONNECTING, WIFI_MANAGER_CONNECT_TIMEOUT_MS);
+
+	g_wifi.connect_start_us = perf_now_us();
+	err = g_wifi.wifi->connect(ssid, passphrase[0] ? passphrase : NULL,
+		flags & WIFI_MANAGER_PERSISTENT);
+	if (err != S_OK) {
+		fprintf(stderr, "Failed to start connection to %s (%s)\n", ssid, error_msg(err));
+		wifi_manager_backoff();
+	}
+}
+
+/* Drops the association, DHCP did not give it a usable address */
+static void wifi_manager_dhcp_failed(void)
+{
+	pthread_mutex_lock(&g_wifi.lock);
+	g_wifi.dhcp_failures++;
+	pthread_mutex_unlock(&g_wifi.lock);
+
+	g_wifi.wifi->disconnect();
+	wifi_manager_link_down();
+	wifi_manager_backoff();
+}
+
+static void wifi_manager_link_up(void)
+{
+	struct wifi_assoc assoc;
+	pthread_attr_t attr;
+	pthread_t thread;
+	unsigned int flags, gen;
+	uint32_t elapsed;
+	int ret;
+
+	memset(&assoc, 0, sizeof(assoc));
+	elapsed = perf_now_us() - g_wifi.connect_start_us;
+
+	pthread_mutex_lock(&g_wifi.lock);
+	g_wifi.link_up = true;
+	g_wifi.connects++;
+	perf_stats_add(&g_wifi.connect, elapsed);
+	/* The monotonic clock starts at boot */
+	assoc.boot_ms = perf_now_us() / 1000;
+	if (!g_wifi.first_boot_ms)
+		g_wifi.first_boot_ms = assoc.boot_ms;
+	memcpy(assoc.ssid, g_wifi.ssid, sizeof(assoc.ssid));
+	flags = g_wifi.flags;
+	gen = ++g_wifi.dhcp_gen;
+	pthread_mutex_unlock(&g_wifi.lock);
+
+	assoc.connect_ms = elapsed / 1000;
+	fprintf(stderr, "Connected to %s in %u ms, %u ms after boot\n", assoc.ssid,
+		assoc.connect_ms, assoc.boot_ms);
+	dhcp_lease_network_changed(assoc.ssid);
+
+	if ((flags & WIFI_MANAGER_SAVE) && (wifi_assoc_save(&assoc) != S_OK))
+		fprintf(stderr, "Failed to save the association to %s\n", WIFI_ASSOC_PATH);
+
+	wifi_manager_publish(WIFI_EVENT_LINK_UP);
+	wifi_manager_set_state(WIFI_STATE_DHCP, WIFI_MANAGER_DHCP_TIMEOUT_MS);
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, WIFI_MANAGER_STACK_SIZE);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	ret = pthread_create(&thread, &attr, wifi_manager_dhcp_thread, (void *)(uintptr_t)gen);
+	pthread_attr_destroy(&attr);
+
+	if (ret != 0) {
+		fprintf(stderr, "Failed to start DHCP\n");
+		wifi_manager_dhcp_failed();
+	}
+}
+
+static void wifi_manager_ready(void)
+{
+	char ssid[WIFI_ASSOC_SSID_LEN];
+
+	pthread_mutex_lock(&g_wifi.lock);
+	g_wifi.failures = 0;
+	memcpy(ssid, g_wifi.ssid, sizeof(ssid));
+	pthread_mutex_unlock(&g_wifi.lock);
+
+	/* The resolver cache keys the network on its addresses as well */
+	dns_cache_network_changed(ssid);
+
+	wifi_manager_set_state(WIFI_STATE_READY, 0);
+	wifi_manager_publish(WIFI_EVENT_IP_READY);
+}
+
+static void wifi_manager_leave(void)
+{
+	g_wifi.wifi->disconnect();
+	wifi_manager_link_down();
+	wifi_manager_set_state(WIFI_STATE_LEAVING, WIFI_MANAGER_LEAVE_TIMEOUT_MS);
+}
+
+/* True between wifi_manager_start() and wifi_manager_stop() */
+bool wifi_manager_active(void)
+{
+	bool active;
+
+	pthread_mutex_lock(&g_wifi.lock);
+	active = g_wifi.active;
+	pthread_mutex_unlock(&g_wifi.lock);
+
+	return active;
+}
+
+/* Leaves the radio to the previous owner until started */
+static void wifi_manager_idle(void)
+{
+	wifi_manager_set_state(WIFI_STATE_IDLE, 0);
+
+	/* Started again while leaving */
+	if (wifi_manager_active())
+		wifi_manager_connect();
+}
+
+static void wifi_manager_handle(enum wifi_manager_input input)
+{
+	switch (g_wifi.state) {
+	case WIFI_STATE_IDLE:
+		if ((input == WIFI_INPUT_START) && wifi_manager_active())
+			wifi_manager_connect();
+		break;
+	case WIFI_STATE_CONNECTING:
+		if (input == WIFI_INPUT_LINK_UP) {
+			wifi_manager_link_up();
+		} else if (input == WIFI_INPUT_LINK_DOWN) {
+			fprintf(stderr, "Failed to join the network\n");
+			wifi_manager_backoff();
+		} else if (input == WIFI_INPUT_TIMEOUT) {
+			fprintf(stderr, "Timed out while waiting for connection\n");
+			g_wifi.wifi->disconnect();
+			wifi_manager_backoff();
+		} else if ((input == WIFI_INPUT_STOP) || (input == WIFI_INPUT_RECONNECT)) {
+			wifi_manager_leave();
+		}
+		break;
+	case WIFI_STATE_DHCP:
+	case WIFI_STATE_READY:
+		if (input == WIFI_INPUT_LINK_DOWN) {
+			fprintf(stderr, "Lost the link to the network\n");
+			pthread_mutex_lock(&g_wifi.lock);
+			g_wifi.link_losses++;
+			pthread_mutex_unlock(&g_wifi.lock);
+			wifi_manager_link_down();
+			wifi_manager_backoff();
+		} else if ((input == WIFI_INPUT_DHCP_DONE) && (g_wifi.state == WIFI_STATE_DHCP)) {
+			wifi_manager_ready();
+		} else if (((input == WIFI_INPUT_DHCP_FAILED) || (input == WIFI_INPUT_TIMEOUT)) &&
+				(g_wifi.state == WIFI_STATE_DHCP)) {
+			fprintf(stderr, "Failed to get an address\n");
+			wifi_manager_dhcp_failed();
+		} else if (input == WIFI_INPUT_DHCP_LOST) {
+			/* The saved lease applied was not renewed, the interface has no address */
+			fprintf(stderr, "Failed to renew the DHCP lease\n");
+			wifi_manager_dhcp_failed();
+		} else if ((input == WIFI_INPUT_STOP) || (input == WIFI_INPUT_RECONNECT)) {
+			wifi_manager_leave();
+		}
+		break;
+	case WIFI_STATE_BACKOFF:
+		if ((input == WIFI_INPUT_TIMEOUT) || (input == WIFI_INPUT_RECONNECT))
+			wifi_manager_connect();
+		else if (input == WIFI_INPUT_STOP)
+			wifi_manager_idle();
+		break;
+	case WIFI_STATE_LEAVING:
+		if ((input == WIFI_INPUT_LINK_DOWN) || (input == WIFI_INPUT_TIMEOUT))
+			wifi_manager_idle();
+		break;
+	}
+}
+
+static pthread_addr_t wifi_manager_thread(pthread_addr_t arg)
+{
+	uint64_t deadline;
+
+	while (1) {
+		pthread_mutex_lock(&g_wifi.lock);
+		deadline = g_wifi.deadline_us;
+		pthread_mutex_unlock(&g_wifi.lock);
+
+		wifi_manager_handle(wifi_manager_next_input(deadline));
+	}
+
+	return NULL;
+}
+
+/* Must be called with g_wifi.lock held */
+static artik_error wifi_manager_start_thread(void)
+{
+	pthread_attr_t attr;
+	int ret;
+
+	if (g_wifi.running)
+		return S_OK;
+
+	g_wifi.wifi = (artik_wifi_module *)artik_request_api_module("wifi");
+	if (!g_wifi.wifi)
+		return E_NOT_SUPPORTED;
+
+	sem_init(&g_wifi.wake, 0, 0);
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, WIFI_MANAGER_STACK_SIZE);
+	ret = pthread_create(&g_wifi.thread, &attr, wifi_manager_thread, NULL);
+	pthread_attr_destroy(&attr);
+
+	if (ret != 0) {
+		sem_destroy(&g_wifi.wake);
+		artik_release_api_module(g_wifi.wifi);
+		g_wifi.wifi = NULL;
+		return E_NO_MEM;
+	}
+
+	g_wifi.running = true;
+
+	return S_OK;
+}
+
+/*
+ * Starts connecting to the network and keeps it up until stopped. Starting
+ * again with the same network and passphrase and flags does nothing; with
+ * another passphrase or other flags it reconnects with those. Another
+ * network has to wait for wifi_manager_stop().
+ */
+artik_error wifi_manager_start(const char *ssid, const char *passphrase, unsigned int flags)
+{
+	artik_error ret = S_OK;
+	bool changed;
+
+	if (!ssid || !ssid[0] || (strlen(ssid) >= WIFI_ASSOC_SSID_LEN) ||
+			(passphrase && (strlen(passphrase) >= WIFI_MANAGER_PASSPHRASE_LEN)))
+		return E_BAD_ARGS;
+
+	pthread_mutex_lock(&g_wifi.lock);
+	if (g_wifi.active) {
+		if (strcmp(g_wifi.ssid, ssid)) {
+			pthread_mutex_unlock(&g_wifi.lock);
+			return E_BUSY;
+		}
+
+		changed = strcmp(g_wifi.passphrase, passphrase ? passphrase : "") ||
+			(g_wifi.flags != flags);
+		memset(g_wifi.passphrase, 0, sizeof(g_wifi.passphrase));
+		if (passphrase)
+			strncpy(g_wifi.passphrase, passphrase, WIFI_MANAGER_PASSPHRASE_LEN - 1);
+		g_wifi.flags = flags;
+		pthread_mutex_unlock(&g_wifi.lock);
+
+		if (changed)
+			wifi_manager_post(WIFI_INPUT_RECONNECT);
+
+		return S_OK;
+	}
+
+	ret = wifi_manager_start_thread();
+	if (ret != S_OK)
+		goto exit;
+
+	memset(g_wifi.ssid, 0, sizeof(g_wifi.ssid));
+	memset(g_wifi.passphrase, 0, sizeof(g_wifi.passphrase));
+	strncpy(g_wifi.ssid, ssid, WIFI_ASSOC_SSID_LEN - 1);
+	if (passphrase)
+		strncpy(g_wifi.passphrase, passphrase, WIFI_MANAGER_PASSPHRASE_LEN - 1);
+	g_wifi.flags = flags;
+	g_wifi.failures = 0;
+	g_wifi.active = true;
+
+	/* An error here, e.g. when already started by 'wifi startsta', is left to connect */
+	g_wifi.wifi->init(ARTIK_WIFI_MODE_STATION);
+	g_wifi.wifi->set_connect_callback(wifi_manager_connect_callback, NULL);
+
+exit:
+	pthread_mutex_unlock(&g_wifi.lock);
+
+	if (ret == S_OK)
+		wifi_manager_post(WIFI_INPUT_START);
+
+	return ret;
+}
+
+/* Disconnects and stops retrying, wait for WIFI_STATE_IDLE to know when it is done */
+artik_error wifi_manager_stop(void)
+{
+	bool active;
+
+	pthread_mutex_lock(&g_wifi.lock);
+	active = g_wifi.active;
+	g_wifi.active = false;
+	pthread_mutex_unlock(&g_wifi.lock);
+
+	if (active)
+		wifi_manager_post(WIFI_INPUT_STOP);
+
+	return S_OK;
+}
+
+artik_error wifi_manager_wait(enum wifi_manager_state state, unsigned int timeout_ms)
+{
+	struct timespec abstime;
+	artik_error ret = S_OK;
+	int err = 0;
+
+	clock_gettime(CLOCK_REALTIME, &abstime);
+	abstime.tv_nsec += (timeout_ms % 1000) * 1000000;
+	abstime.tv_sec += timeout_ms / 1000 + abstime.tv_nsec / 1000000000;
+	abstime.tv_nsec %= 1000000000;
+
+	pthread_mutex_lock(&g_wifi.lock);
+	while ((g_wifi.state != state) && (err != ETIMEDOUT))
+		err = pthread_cond_timedwait(&g_wifi.changed, &g_wifi.lock, &abstime);
+	if (g_wifi.state != state)
+		ret = E_TIMEOUT;
+	pthread_mutex_unlock(&g_wifi.lock);
+
+	return ret;
+}
+
+/*
+ * For network clients: waits for the managed network to be ready. A
+ * network not managed, e.g. brought up with 'wifi startsta' and 'wifi
+ * dhcp', is left to whoever configured it and counts as ready.
+ */
+artik_error wifi_manager_wait_ready(unsigned int timeout_ms)
+{
+	if (!wifi_manager_active())
+		return S_OK;
+
+	return wifi_manager_wait(WIFI_STATE_READY, timeout_ms);
+}
+
+enum wifi_manager_state wifi_manager_get_state(void)
+{
+	enum wifi_manager_state state;
+
+	pthread_mutex_lock(&g_wifi.lock);
+	state = g_wifi.state;
+	pthread_mutex_unlock(&g_wifi.lock);
+
+	return state;
+}
+
+/* Returns an id for wifi_manager_unsubscribe(), or -1 if there is no room left */
+int wifi_manager_subscribe(wifi_manager_callback cb, void *user_data)
+{
+	int i;
+
+	if (!cb)
+		return -1;
+
+	pthread_mutex_lock(&g_wifi.lock);
+	for (i = 0; i < WIFI_MANAGER_MAX_SUBSCRIBERS; i++) {
+		if (!g_wifi.subscribers[i].cb) {
+			g_wifi.subscribers[i].cb = cb;
+			g_wifi.subscribers[i].user_data = user_data;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&g_wifi.lock);
+
+	return (i < WIFI_MANAGER_MAX_SUBSCRIBERS) ? i : -1;
+}
+
+void wifi_manager_unsubscribe(int id)
+{
+	if ((id < 0) || (id >= WIFI_MANAGER_MAX_SUBSCRIBERS))
+		return;
+
+	pthread_mutex_lock(&g_wifi.lock);
+	g_wifi.subscribers[id].cb = NULL;
+	g_wifi.subscribers[id].user_data = NULL;
+	pthread_mutex_unlock(&g_wifi.lock);
+}
+
+void wifi_manager_dump(void)
+{
+	pthread_mutex_lock(&g_wifi.lock);
+	fprintf(stdout, "state: %s", wifi_state_names[g_wifi.state]);
+	if (g_wifi.active)
+		fprintf(stdout, " (%s)", g_wifi.ssid);
+	fprintf(stdout, "\n");
+	fprintf(stdout, "attempts %u, connects %u, link losses %u, dhcp failures %u, "
+		"dropped events %u\n", g_wifi.attempts, g_wifi.connects, g_wifi.link_losses,
+		g_wifi.dhcp_failures, g_wifi.dropped);
+	perf_stats_print("connect", &g_wifi.connect);
+	if (g_wifi.first_boot_ms)
+		fprintf(stdout, "first associated %u ms after boot\n", g_wifi.first_boot_ms);
+	pthread_mutex_unlock(&g_wifi.lock);
+}
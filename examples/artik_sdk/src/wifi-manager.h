@@ -0,0 +1,102 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file wifi-manager.h
+ */
+
+#ifndef __ARTIK_WIFI_MANAGER_H__
+#define __ARTIK_WIFI_MANAGER_H__
+
+#include <stdbool.h>
+
+#include <artik_error.h>
+
+#define WIFI_MANAGER_MAX_SUBSCRIBERS	8
+#define WIFI_MANAGER_PASSPHRASE_LEN		65
+#define WIFI_MANAGER_CONNECT_TIMEOUT_MS	30000
+#define WIFI_MANAGER_DHCP_TIMEOUT_MS	30000
+#define WIFI_MANAGER_READY_TIMEOUT_MS	30000	/* For the clients */
+#define WIFI_MANAGER_LEAVE_TIMEOUT_MS	10000
+#define WIFI_MANAGER_BACKOFF_MIN_MS		1000
+#define WIFI_MANAGER_BACKOFF_MAX_MS		60000
+
+/* Flags of wifi_manager_start() */
+#define WIFI_MANAGER_PERSISTENT	(1 << 0)	/* Passed on to the wifi module */
+#define WIFI_MANAGER_SAVE		(1 << 1)	/* SSID saved as the network to join at boot */
+
+/*
+ * Station connection manager.
+ *
+ * A single manager task owns the radio once started: it connects to the
+ * network, has DHCP run, and after a failed attempt or a lost link
+ * retries after an exponential backoff with jitter until stopped. A
+ * saved DHCP lease that fails to renew in the background counts as a
+ * lost link. Neither the wifi module's callbacks nor DHCP, which runs on
+ * a task of its own, block the manager task; they only queue events to
+ * it, so a lost link or a stop request is handled while DHCP is running.
+ *
+ * Subscribers are told about link up, IP ready and link down from the
+ * manager task, and must not block. Clients that only need the network
+ * wait for it with wifi_manager_wait_ready() rather than driving the
+ * connection themselves, and hold their traffic from link down until IP
+ * ready. Commands that drive the radio directly are refused while the
+ * manager is active.
+ *
+ * A network saved with WIFI_MANAGER_SAVE is joined at boot without being
+ * configured, but it is joined like any other: the wifi module connects
+ * by SSID only, so there is no BSSID, channel or security to go straight
+ * to and the join scans as usual. Only blink_led_wifi, which drives the
+ * slsi API itself, rejoins the saved access point directly.
+ *
+ *   IDLE -> CONNECTING -> DHCP -> READY
+ *              ^  |        |       |
+ *              |  v        v       v
+ *              BACKOFF <-----------'
+ *
+ * Stopping goes through LEAVING, until the link is down, back to IDLE.
+ */
+enum wifi_manager_state {
+	WIFI_STATE_IDLE,
+	WIFI_STATE_CONNECTING,
+	WIFI_STATE_DHCP,
+	WIFI_STATE_READY,
+	WIFI_STATE_BACKOFF,
+	WIFI_STATE_LEAVING
+};
+
+enum wifi_manager_event {
+	WIFI_EVENT_LINK_UP,
+	WIFI_EVENT_IP_READY,
+	WIFI_EVENT_LINK_DOWN
+};
+
+typedef void (*wifi_manager_callback)(enum wifi_manager_event event, void *user_data);
+
+artik_error wifi_manager_start(const char *ssid, const char *passphrase, unsigned int flags);
+artik_error wifi_manager_stop(void);
+artik_error wifi_manager_wait(enum wifi_manager_state state, unsigned int timeout_ms);
+artik_error wifi_manager_wait_ready(unsigned int timeout_ms);
+bool wifi_manager_active(void);
+enum wifi_manager_state wifi_manager_get_state(void);
+int wifi_manager_subscribe(wifi_manager_callback cb, void *user_data);
+void wifi_manager_unsubscribe(int id);
+void wifi_manager_dump(void);
+
+#endif /* __ARTIK_WIFI_MANAGER_H__ */
@@ -0,0 +1,454 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file ws-manager.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <artik_module.h>
+
+#include "dns-cache.h"
+#include "wifi-manager.h"
+#include "ws-manager.h"
+
+#define WS_MANAGER_STACK_SIZE	8192
+
+struct ws_manager {
+	struct ws_connection conns[WS_MANAGER_MAX_CONNECTIONS];
+	pthread_mutex_t lock;
+	pthread_cond_t idle;
+	sem_t pending;
+	pthread_t thread;
+	bool running;
+	bool link_down;		/* Frames stay queued until the network is back */
+};
+
+static struct ws_manager g_manager = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.idle = PTHREAD_COND_INITIALIZER,
+};
+
+/* Runs on the wifi manager task */
+static void ws_manager_link_event(enum wifi_manager_event event, void *user_data)
+{
+	if ((event != WIFI_EVENT_LINK_DOWN) && (event != WIFI_EVENT_IP_READY))
+		return;
+
+	pthread_mutex_lock(&g_manager.lock);
+	g_manager.link_down = (event == WIFI_EVENT_LINK_DOWN);
+	pthread_mutex_unlock(&g_manager.lock);
+
+	if (event == WIFI_EVENT_IP_READY)
+		sem_post(&g_manager.pending);
+}
+
+/*
+ * Services the send queues of all connections. Every push posts the shared
+ * semaphore, so the task sleeps until there is something to write and then
+ * drains one frame per connection per round to stay fair between them.
+ * Nothing is written while the link is down: the frames stay queued, and
+ * producers get E_BUSY once the queues are full, until IP ready wakes the
+ * task again.
+ */
+static pthread_addr_t ws_manager_thread(pthread_addr_t arg)
+{
+	struct ws_connection *conn;
+	int i, sent;
+
+	while (1) {
+		sem_wait(&g_manager.pending);
+
+		do {
+			sent = 0;
+			for (i = 0; i < WS_MANAGER_MAX_CONNECTIONS; i++) {
+				conn = &g_manager.conns[i];
+
+				pthread_mutex_lock(&g_manager.lock);
+				if (g_manager.link_down) {
+					pthread_mutex_unlock(&g_manager.lock);
+					break;
+				}
+				if (!conn->used || conn->closing) {
+					pthread_mutex_unlock(&g_manager.lock);
+					continue;
+				}
+				conn->servicing = true;
+				pthread_mutex_unlock(&g_manager.lock);
+
+				sent += ws_sendq_service(&conn->sendq);
+
+				pthread_mutex_lock(&g_manager.lock);
+				conn->servicing = false;
+				pthread_cond_broadcast(&g_manager.idle);
+				pthread_mutex_unlock(&g_manager.lock);
+			}
+		} while (sent > 0);
+	}
+
+	return NULL;
+}
+
+/* Must be called with g_manager.lock held */
+static int ws_manager_start(void)
+{
+	pthread_attr_t attr;
+	int ret;
+
+	if (g_manager.running)
+		return 0;
+
+	sem_init(&g_manager.pending, 0, 0);
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, WS_MANAGER_STACK_SIZE);
+	ret = pthread_create(&g_manager.thread, &attr, ws_manager_thread, NULL);
+	pthread_attr_destroy(&attr);
+
+	if (ret != 0) {
+		sem_destroy(&g_manager.pending);
+		return -1;
+	}
+
+	g_manager.running = true;
+	wifi_manager_subscribe(ws_manager_link_event, NULL);
+
+	return 0;
+}
+
+/* Must be called with g_manager.lock held */
+static struct ws_connection *ws_manager_find(const char *name)
+{
+	int i;
+
+	for (i = 0; i < WS_MANAGER_MAX_CONNECTIONS; i++) {
+		if (g_manager.conns[i].used && !g_manager.conns[i].closing &&
+				!strncmp(g_manager.conns[i].name, name, WS_MANAGER_NAME_LEN))
+			return &g_manager.conns[i];
+	}
+
+	return NULL;
+}
+
+/* Reserves a slot, must be called with g_manager.lock held */
+static struct ws_connection *ws_manager_alloc(const char *name)
+{
+	struct ws_connection *conn;
+	int i;
+
+	if (strlen(name) >= WS_MANAGER_NAME_LEN)
+		return NULL;
+
+	/* Also reject names of connections still being opened or closed */
+	for (i = 0; i < WS_MANAGER_MAX_CONNECTIONS; i++) {
+		if (g_manager.conns[i].used &&
+				!strncmp(g_manager.conns[i].name, name, WS_MANAGER_NAME_LEN))
+			return NULL;
+	}
+
+	if (ws_manager_start() < 0)
+		return NULL;
+
+	for (i = 0; i < WS_MANAGER_MAX_CONNECTIONS; i++) {
+		conn = &g_manager.conns[i];
+		if (!conn->used && !conn->servicing) {
+			memset(conn, 0, sizeof(struct ws_connection));
+			strncpy(conn->name, name, WS_MANAGER_NAME_LEN);
+			conn->used = true;
+			/* Not serviced until the send queue is initialized */
+			conn->closing = true;
+			return conn;
+		}
+	}
+
+	return NULL;
+}
+
+static void ws_manager_free(struct ws_connection *conn)
+{
+	pthread_mutex_lock(&g_manager.lock);
+	free(conn->uri);
+	conn->uri = NULL;
+	conn->used = false;
+	pthread_mutex_unlock(&g_manager.lock);
+}
+
+static void ws_manager_watermark(bool congested, void *user_data)
+{
+	struct ws_connection *conn = (struct ws_connection *)user_data;
+
+	fprintf(stderr, "Websocket '%s' send queue %s\n", conn->name,
+		congested ? "congested" : "drained");
+}
+
+static artik_error ws_manager_activate(struct ws_connection *conn,
+		artik_websocket_handle handle, ws_sendq_write write)
+{
+	conn->handle = handle;
+	if (ws_sendq_init(&conn->sendq, handle, write, ws_manager_watermark, conn) < 0)
+		return E_BAD_ARGS;
+	ws_sendq_set_notify(&conn->sendq, &g_manager.pending);
+
+	pthread_mutex_lock(&g_manager.lock);
+	conn->connects++;
+	conn->connected = true;
+	conn->closing = false;
+	pthread_mutex_unlock(&g_manager.lock);
+
+	return S_OK;
+}
+
+void ws_manager_receive_callback(void *user_data, void *result)
+{
+	struct ws_connection *conn = (struct ws_connection *)user_data;
+	struct ws_frame *frame = ws_frame_take((char *)result);
+	char name[WS_MANAGER_NAME_LEN];
+	ws_manager_rx rx = NULL;
+	void *rx_data = NULL;
+
+	if (!frame)
+		return;
+
+	/* The slot is only read under the lock, ws_manager_close() may be freeing it */
+	pthread_mutex_lock(&g_manager.lock);
+	if (conn->used && !conn->closing) {
+		conn->rx_frames++;
+		conn->rx_bytes += frame->len;
+		rx = conn->rx;
+		rx_data = conn->user_data;
+		memcpy(name, conn->name, WS_MANAGER_NAME_LEN);
+	}
+	pthread_mutex_unlock(&g_manager.lock);
+
+	if (rx)
+		rx(name, frame, rx_data);
+
+	ws_frame_release(frame);
+}
+
+static void ws_manager_connection_callback(void *user_data, void *result)
+{
+	struct ws_connection *conn = (struct ws_connection *)user_data;
+	artik_websocket_connection_state state = (artik_websocket_connection_state)result;
+
+	if (state == ARTIK_WEBSOCKET_CLOSED) {
+		pthread_mutex_lock(&g_manager.lock);
+		conn->connected = false;
+		conn->disconnects++;
+		pthread_mutex_unlock(&g_manager.lock);
+		fprintf(stderr, "Websocket '%s' has been closed\n", conn->name);
+	} else if (state == ARTIK_WEBSOCKET_CONNECTED) {
+		pthread_mutex_lock(&g_manager.lock);
+		conn->connected = true;
+		pthread_mutex_unlock(&g_manager.lock);
+		fprintf(stderr, "Websocket '%s' is connected\n", conn->name);
+	}
+}
+
+artik_error ws_manager_open(const char *name, const char *uri, ws_manager_rx rx,
+		void *user_data)
+{
+	struct ws_connection *conn = NULL;
+	artik_websocket_module *websocket = NULL;
+	artik_websocket_handle handle = NULL;
+	artik_error ret = S_OK;
+
+	if (!name || !uri)
+		return E_BAD_ARGS;
+
+	ret = dns_cache_lookup_uri(uri, NULL);
+	if (ret != S_OK)
+		return ret;
+
+	pthread_mutex_lock(&g_manager.lock);
+	conn = ws_manager_alloc(name);
+	pthread_mutex_unlock(&g_manager.lock);
+	if (!conn)
+		return E_BUSY;
+
+	conn->uri = strdup(uri);
+	websocket = (artik_websocket_module *)artik_request_api_module("websocket");
+	if (!conn->uri || !websocket) {
+		ret = E_NOT_SUPPORTED;
+		goto exit;
+	}
+
+	conn->module = websocket;
+	conn->rx = rx;
+	conn->user_data = user_data;
+	conn->config.uri = conn->uri;
+	conn->config.ssl_config.verify_cert = ARTIK_SSL_VERIFY_NONE;
+
+	ret = websocket->websocket_request(&handle, &conn->config);
+	if (ret != S_OK)
+		goto exit;
+
+	ret = websocket->websocket_open_stream(handle);
+	if (ret != S_OK)
+		goto exit;
+
+	ret = websocket->websocket_set_receive_callback(handle, ws_manager_receive_callback, conn);
+	if (ret != S_OK)
+		goto exit;
+
+	ret = websocket->websocket_set_connection_callback(handle,
+		ws_manager_connection_callback, conn);
+	if (ret != S_OK)
+		goto exit;
+
+	ret = ws_manager_activate(conn, handle, websocket->websocket_write_stream);
+	if (ret != S_OK)
+		goto exit;
+
+	return S_OK;
+
+exit:
+	if (handle)
+		websocket->websocket_close_stream(handle);
+	if (websocket)
+		artik_release_api_module(websocket);
+	ws_manager_free(conn);
+
+	return ret;
+}
+
+artik_error ws_manager_register(const char *name, artik_websocket_handle handle,
+		ws_sendq_write write, ws_manager_close_fn close, ws_manager_rx rx,
+		void *user_data, struct ws_connection **conn)
+{
+	struct ws_connection *c = NULL;
+
+	if (!name || !handle || !write || !close)
+		return E_BAD_ARGS;
+
+	pthread_mutex_lock(&g_manager.lock);
+	c = ws_manager_alloc(name);
+	pthread_mutex_unlock(&g_manager.lock);
+	if (!c)
+		return E_BUSY;
+
+	c->close = close;
+	c->rx = rx;
+	c->user_data = user_data;
+	if (ws_manager_activate(c, handle, write) != S_OK) {
+		ws_manager_free(c);
+		return E_BAD_ARGS;
+	}
+
+	if (conn)
+		*conn = c;
+
+	return S_OK;
+}
+
+/*
+ * Removes a connection from the table once the manager task is done with
+ * its queue. The stream is closed first, through the websocket module or
+ * the close function given to ws_manager_register(), so that no SDK
+ * callback can reach the slot once it is freed and reused.
+ */
+artik_error ws_manager_close(const char *name)
+{
+	struct ws_connection *conn = NULL;
+
+	pthread_mutex_lock(&g_manager.lock);
+	conn = ws_manager_find(name);
+	if (!conn) {
+		pthread_mutex_unlock(&g_manager.lock);
+		return E_BAD_ARGS;
+	}
+
+	conn->closing = true;
+	while (conn->servicing)
+		pthread_cond_wait(&g_manager.idle, &g_manager.lock);
+	pthread_mutex_unlock(&g_manager.lock);
+
+	ws_sendq_stop(&conn->sendq);
+
+	if (conn->module) {
+		conn->module->websocket_close_stream(conn->handle);
+		artik_release_api_module(conn->module);
+		conn->module = NULL;
+	} else if (conn->close) {
+		conn->close(conn->handle);
+	}
+
+	ws_manager_free(conn);
+
+	return S_OK;
+}
+
+/* Only queues the message, the manager task writes it to the socket */
+artik_error ws_manager_send(const char *name, const char *message, unsigned int flags)
+{
+	struct ws_connection *conn = NULL;
+	artik_error ret;
+
+	pthread_mutex_lock(&g_manager.lock);
+	conn = ws_manager_find(name);
+	if (!conn) {
+		pthread_mutex_unlock(&g_manager.lock);
+		return E_BAD_ARGS;
+	}
+	ret = ws_sendq_push(&conn->sendq, message, flags);
+	pthread_mutex_unlock(&g_manager.lock);
+
+	return ret;
+}
+
+artik_websocket_handle ws_manager_get_handle(const char *name)
+{
+	struct ws_connection *conn = NULL;
+	artik_websocket_handle handle = NULL;
+
+	pthread_mutex_lock(&g_manager.lock);
+	conn = ws_manager_find(name);
+	if (conn)
+		handle = conn->handle;
+	pthread_mutex_unlock(&g_manager.lock);
+
+	return handle;
+}
+
+void ws_manager_dump(const char *name)
+{
+	struct ws_connection *conn;
+	int i;
+
+	pthread_mutex_lock(&g_manager.lock);
+	for (i = 0; i < WS_MANAGER_MAX_CONNECTIONS; i++) {
+		conn = &g_manager.conns[i];
+		if (!conn->used || conn->closing)
+			continue;
+		if (name && strncmp(conn->name, name, WS_MANAGER_NAME_LEN))
+			continue;
+
+		fprintf(stdout, "%s: %s%s, rx %u frames %u bytes, connects %u disconnects %u\n",
+			conn->name, conn->uri ? conn->uri : "(registered)",
+			conn->connected ? "" : " (closed)", conn->rx_frames, conn->rx_bytes,
+			conn->connects, conn->disconnects);
+		if (name)
+			ws_sendq_dump(&conn->sendq);
+	}
+	pthread_mutex_unlock(&g_manager.lock);
+}
@@ -0,0 +1,90 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file ws-manager.h
+ */
+
+#ifndef __ARTIK_WS_MANAGER_H__
+#define __ARTIK_WS_MANAGER_H__
+
+#include <stdbool.h>
+
+#include <artik_websocket.h>
+
+#include "ws-rxpool.h"
+#include "ws-sendq.h"
+
+/*
+ * Table of named websocket connections.
+ *
+ * Connections are either opened by the manager through the websocket
+ * module or registered after being opened elsewhere (the cloud module).
+ * Outgoing traffic of every connection goes through its send queue, and a
+ * single manager task services all the queues. Only sending is shared:
+ * reception still happens on the SDK's own thread for each handle, so the
+ * receive callback may run on several threads at once. Frames are taken
+ * into the receive buffer pool, counted under the table lock and passed to
+ * the connection's receive callback. The manager drops its reference once
+ * the callback returns; a callback that keeps the frame takes its own with
+ * ws_frame_ref().
+ *
+ * Frames go out uncompressed. The websocket module owns the opening
+ * handshake and the framing: it cannot offer permessage-deflate (RFC 7692)
+ * in Sec-WebSocket-Extensions, set RSV1 or send binary frames, so
+ * compression would take a websocket client of our own.
+ */
+#define WS_MANAGER_MAX_CONNECTIONS	4
+#define WS_MANAGER_NAME_LEN			16
+
+typedef void (*ws_manager_rx)(const char *name, struct ws_frame *frame, void *user_data);
+typedef artik_error (*ws_manager_close_fn)(artik_websocket_handle handle);
+
+struct ws_connection {
+	char name[WS_MANAGER_NAME_LEN];
+	bool used;
+	bool connected;
+	bool closing;
+	bool servicing;
+	artik_websocket_module *module;
+	artik_websocket_handle handle;
+	artik_websocket_config config;
+	char *uri;
+	struct ws_sendq sendq;
+	ws_manager_close_fn close;
+	ws_manager_rx rx;
+	void *user_data;
+
+	unsigned int rx_frames;
+	unsigned int rx_bytes;
+	unsigned int connects;
+	unsigned int disconnects;
+};
+
+artik_error ws_manager_open(const char *name, const char *uri, ws_manager_rx rx,
+		void *user_data);
+artik_error ws_manager_register(const char *name, artik_websocket_handle handle,
+		ws_sendq_write write, ws_manager_close_fn close, ws_manager_rx rx,
+		void *user_data, struct ws_connection **conn);
+artik_error ws_manager_close(const char *name);
+artik_error ws_manager_send(const char *name, const char *message, unsigned int flags);
+artik_websocket_handle ws_manager_get_handle(const char *name);
+void ws_manager_receive_callback(void *user_data, void *result);
+void ws_manager_dump(const char *name);
+
+#endif /* __ARTIK_WS_MANAGER_H__ */
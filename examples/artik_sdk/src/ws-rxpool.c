@@ -0,0 +1,149 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file ws-rxpool.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "ws-rxpool.h"
+
+static struct ws_frame g_frames[WS_RXPOOL_BUFFERS];
+static struct ws_frame *g_free_frames;
+static bool g_pool_ready;
+static struct ws_rxpool_stats g_stats;
+static pthread_mutex_t g_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Must be called with g_pool_lock held */
+static struct ws_frame *ws_rxpool_get(void)
+{
+	struct ws_frame *frame;
+	int i;
+
+	if (!g_pool_ready) {
+		for (i = 0; i < WS_RXPOOL_BUFFERS - 1; i++)
+			g_frames[i].next = &g_frames[i + 1];
+		g_free_frames = &g_frames[0];
+		g_pool_ready = true;
+	}
+
+	frame = g_free_frames;
+	if (frame)
+		g_free_frames = frame->next;
+
+	return frame;
+}
+
+struct ws_frame *ws_frame_take(char *message)
+{
+	struct ws_frame *frame;
+	unsigned int len;
+
+	if (!message)
+		return NULL;
+
+	pthread_mutex_lock(&g_pool_lock);
+	frame = ws_rxpool_get();
+	pthread_mutex_unlock(&g_pool_lock);
+
+	if (frame) {
+		frame->pooled = true;
+	} else {
+		frame = malloc(sizeof(struct ws_frame));
+		if (!frame) {
+			free(message);
+			return NULL;
+		}
+		frame->pooled = false;
+	}
+
+	/* The copy finds the end of the string, nothing else walks it */
+	for (len = 0; (len < WS_RXPOOL_BUF_SIZE - 1) && message[len]; len++)
+		frame->buf[len] = message[len];
+
+	if (message[len]) {
+		frame->adopted = message;
+		frame->data = message;
+		frame->len = len + strlen(message + len);
+	} else {
+		frame->buf[len] = '\0';
+		frame->adopted = NULL;
+		frame->data = frame->buf;
+		frame->len = len;
+		free(message);
+	}
+	frame->refs = 1;
+	frame->next = NULL;
+
+	pthread_mutex_lock(&g_pool_lock);
+	g_stats.frames++;
+	if (frame->adopted)
+		g_stats.adopted++;
+	else
+		g_stats.copied++;
+	if (!frame->pooled)
+		g_stats.allocated++;
+	if (++g_stats.in_use > g_stats.high_water)
+		g_stats.high_water = g_stats.in_use;
+	pthread_mutex_unlock(&g_pool_lock);
+
+	return frame;
+}
+
+void ws_frame_ref(struct ws_frame *frame)
+{
+	pthread_mutex_lock(&g_pool_lock);
+	frame->refs++;
+	pthread_mutex_unlock(&g_pool_lock);
+}
+
+void ws_frame_release(struct ws_frame *frame)
+{
+	char *adopted = NULL;
+	bool heap = false;
+
+	if (!frame)
+		return;
+
+	pthread_mutex_lock(&g_pool_lock);
+	if (--frame->refs == 0) {
+		heap = !frame->pooled;
+		g_stats.in_use--;
+		adopted = frame->adopted;
+		frame->adopted = NULL;
+		if (frame->pooled) {
+			frame->next = g_free_frames;
+			g_free_frames = frame;
+		}
+	}
+	pthread_mutex_unlock(&g_pool_lock);
+
+	free(adopted);
+	if (heap)
+		free(frame);
+}
+
+void ws_rxpool_get_stats(struct ws_rxpool_stats *stats)
+{
+	pthread_mutex_lock(&g_pool_lock);
+	memcpy(stats, &g_stats, sizeof(struct ws_rxpool_stats));
+	pthread_mutex_unlock(&g_pool_lock);
+}
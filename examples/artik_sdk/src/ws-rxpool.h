@@ -0,0 +1,72 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file ws-rxpool.h
+ */
+
+#ifndef __ARTIK_WS_RXPOOL_H__
+#define __ARTIK_WS_RXPOOL_H__
+
+#include <stdbool.h>
+
+/*
+ * Pool of reference-counted receive buffers for websocket frames.
+ *
+ * The SDK hands each frame to the receive callback as a heap string.
+ * ws_frame_take() copies a frame that fits into one of WS_RXPOOL_BUFFERS
+ * static buffers, measuring it on the way, and frees the SDK string at
+ * once, so the heap block lives for the callback only and whatever keeps
+ * the frame holds pool memory instead of allocating its own copy. Larger
+ * frames keep the SDK string, without copying it, in a pool descriptor.
+ * Only when every buffer is in use does a descriptor come from the heap.
+ *
+ * A frame starts with one reference. Consumers that keep it past the
+ * callback, for instance to hand it to another task, take their own with
+ * ws_frame_ref(); every reference is dropped with ws_frame_release(), and
+ * the last one returns the buffer to the pool. Frame data is read-only
+ * and NUL-terminated.
+ */
+#define WS_RXPOOL_BUFFERS	8
+#define WS_RXPOOL_BUF_SIZE	512
+
+struct ws_frame {
+	const char *data;
+	unsigned int len;
+	int refs;
+	char *adopted;
+	bool pooled;
+	struct ws_frame *next;
+	char buf[WS_RXPOOL_BUF_SIZE];
+};
+
+struct ws_rxpool_stats {
+	unsigned int frames;
+	unsigned int copied;
+	unsigned int adopted;
+	unsigned int allocated;
+	unsigned int in_use;
+	unsigned int high_water;
+};
+
+struct ws_frame *ws_frame_take(char *message);
+void ws_frame_ref(struct ws_frame *frame);
+void ws_frame_release(struct ws_frame *frame);
+void ws_rxpool_get_stats(struct ws_rxpool_stats *stats);
+
+#endif /* __ARTIK_WS_RXPOOL_H__ */
@@ -0,0 +1,317 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file ws-sendq.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ws-sendq.h"
+
+#define WS_SENDQ_STACK_SIZE	8192
+
+/* Record flag: the ring holds a pointer to a heap copy of the message */
+#define WS_SENDQ_HEAP		(1 << 15)
+
+struct ws_sendq_record {
+	uint32_t len;
+	uint16_t flags;
+	uint32_t enqueued_us;
+};
+
+/* Must be called with q->lock held */
+static void ws_sendq_copy_in(struct ws_sendq *q, const void *data, unsigned int len)
+{
+	unsigned int first = WS_SENDQ_SIZE - q->tail;
+
+	if (first > len)
+		first = len;
+
+	memcpy(q->ring + q->tail, data, first);
+	memcpy(q->ring, (const char *)data + first, len - first);
+	q->tail = (q->tail + len) % WS_SENDQ_SIZE;
+	q->used += len;
+}
+
+/* Must be called with q->lock held */
+static void ws_sendq_peek(struct ws_sendq *q, unsigned int offset, void *data,
+		unsigned int len)
+{
+	unsigned int start = (q->head + offset) % WS_SENDQ_SIZE;
+	unsigned int first = WS_SENDQ_SIZE - start;
+
+	if (first > len)
+		first = len;
+
+	memcpy(data, q->ring + start, first);
+	memcpy((char *)data + first, q->ring, len - first);
+}
+
+/* Must be called with q->lock held */
+static void ws_sendq_consume(struct ws_sendq *q, unsigned int len)
+{
+	q->head = (q->head + len) % WS_SENDQ_SIZE;
+	q->used -= len;
+}
+
+/* Bytes taken by a message, whether it sits in the ring or on the heap */
+static unsigned int ws_sendq_level(struct ws_sendq *q)
+{
+	return q->used + q->heap_used;
+}
+
+int ws_sendq_init(struct ws_sendq *q, artik_websocket_handle handle,
+		ws_sendq_write write, ws_sendq_watermark watermark, void *user_data)
+{
+	if (!q || !handle || !write || q->running)
+		return -1;
+
+	memset(q, 0, sizeof(struct ws_sendq));
+	q->handle = handle;
+	q->write = write;
+	q->watermark = watermark;
+	q->user_data = user_data;
+	pthread_mutex_init(&q->lock, NULL);
+	sem_init(&q->pending, 0, 0);
+	q->notify = &q->pending;
+
+	return 0;
+}
+
+void ws_sendq_set_notify(struct ws_sendq *q, sem_t *notify)
+{
+	q->notify = notify ? notify : &q->pending;
+}
+
+artik_error ws_sendq_push(struct ws_sendq *q, const char *message, unsigned int flags)
+{
+	struct ws_sendq_record rec;
+	unsigned int len = strlen(message);
+	char *copy = NULL;
+	bool notify = false;
+
+	rec.len = len;
+	rec.flags = flags & ~WS_SENDQ_HEAP;
+	rec.enqueued_us = (uint32_t)perf_now_us();
+
+	if (len > WS_SENDQ_FRAME_MAX) {
+		copy = strdup(message);
+		if (!copy)
+			return E_NO_MEM;
+		rec.flags |= WS_SENDQ_HEAP;
+	}
+
+	pthread_mutex_lock(&q->lock);
+	if (copy ? (q->depth && (ws_sendq_level(q) + len > WS_SENDQ_SIZE)) ||
+			(q->used + sizeof(rec) + sizeof(copy) > WS_SENDQ_SIZE) :
+			(ws_sendq_level(q) + sizeof(rec) + len > WS_SENDQ_SIZE)) {
+		q->stats.rejected++;
+		pthread_mutex_unlock(&q->lock);
+		free(copy);
+		return E_BUSY;
+	}
+
+	ws_sendq_copy_in(q, &rec, sizeof(rec));
+	if (copy) {
+		ws_sendq_copy_in(q, &copy, sizeof(copy));
+		q->heap_used += len;
+		q->stats.oversized++;
+	} else {
+		ws_sendq_copy_in(q, message, len);
+	}
+	q->depth++;
+	q->stats.pushed++;
+	if (q->depth > q->stats.max_depth)
+		q->stats.max_depth = q->depth;
+
+	if (!q->congested && (ws_sendq_level(q) >= WS_SENDQ_HIGH_WATERMARK)) {
+		q->congested = true;
+		notify = true;
+	}
+	pthread_mutex_unlock(&q->lock);
+
+	sem_post(q->notify);
+
+	if (notify && q->watermark)
+		q->watermark(true, q->user_data);
+
+	return S_OK;
+}
+
+/*
+ * Pops one frame worth of messages and writes it. Returns the number of
+ * messages sent, 0 when the queue was empty.
+ */
+int ws_sendq_service(struct ws_sendq *q)
+{
+	struct ws_sendq_record rec;
+	struct ws_sendq_record first;
+	unsigned int frame_len = 0;
+	char *heap = NULL;
+	int messages = 0;
+	bool notify = false;
+	artik_error err;
+
+	pthread_mutex_lock(&q->lock);
+	while (q->depth) {
+		ws_sendq_peek(q, 0, &rec, sizeof(rec));
+
+		/* Heap messages always go out alone */
+		if (rec.flags & WS_SENDQ_HEAP) {
+			if (messages)
+				break;
+			first = rec;
+			ws_sendq_peek(q, sizeof(rec), &heap, sizeof(heap));
+			ws_sendq_consume(q, sizeof(rec) + sizeof(heap));
+			q->heap_used -= rec.len;
+			q->depth--;
+			messages++;
+			break;
+		}
+
+		if (messages) {
+			/* Only coalescible messages are merged, and only while they fit */
+			if (!(first.flags & WS_SENDQ_COALESCE) ||
+					!(rec.flags & WS_SENDQ_COALESCE) ||
+					(frame_len + 1 + rec.len > WS_SENDQ_FRAME_MAX))
+				break;
+			q->frame[frame_len++] = '\n';
+		} else {
+			first = rec;
+		}
+
+		ws_sendq_peek(q, sizeof(rec), q->frame + frame_len, rec.len);
+		ws_sendq_consume(q, sizeof(rec) + rec.len);
+		frame_len += rec.len;
+		q->depth--;
+		messages++;
+	}
+
+	if (q->congested && (ws_sendq_level(q) <= WS_SENDQ_LOW_WATERMARK)) {
+		q->congested = false;
+		notify = true;
+	}
+	pthread_mutex_unlock(&q->lock);
+
+	if (!messages)
+		return 0;
+
+	if (heap) {
+		err = q->write(q->handle, heap);
+		free(heap);
+	} else {
+		q->frame[frame_len] = '\0';
+		err = q->write(q->handle, q->frame);
+	}
+
+	pthread_mutex_lock(&q->lock);
+	if (err != S_OK) {
+		q->stats.errors++;
+	} else {
+		q->stats.frames++;
+		q->stats.coalesced += messages - 1;
+		perf_stats_add(&q->stats.latency, (uint32_t)perf_now_us() - first.enqueued_us);
+	}
+	pthread_mutex_unlock(&q->lock);
+
+	if (notify && q->watermark)
+		q->watermark(false, q->user_data);
+
+	return messages;
+}
+
+static pthread_addr_t ws_sendq_thread(pthread_addr_t arg)
+{
+	struct ws_sendq *q = (struct ws_sendq *)arg;
+
+	while (q->running) {
+		sem_wait(&q->pending);
+		while (q->running && ws_sendq_service(q) > 0)
+			;
+	}
+
+	return NULL;
+}
+
+int ws_sendq_start(struct ws_sendq *q)
+{
+	pthread_attr_t attr;
+	int ret;
+
+	if (q->running)
+		return -1;
+
+	q->running = true;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, WS_SENDQ_STACK_SIZE);
+	ret = pthread_create(&q->thread, &attr, ws_sendq_thread, q);
+	pthread_attr_destroy(&attr);
+
+	if (ret != 0) {
+		q->running = false;
+		return -1;
+	}
+
+	return 0;
+}
+
+void ws_sendq_stop(struct ws_sendq *q)
+{
+	struct ws_sendq_record rec;
+	char *heap;
+
+	if (q->running) {
+		q->running = false;
+		sem_post(&q->pending);
+		pthread_join(q->thread, NULL);
+	}
+
+	/* Unsent messages are dropped, heap copies included */
+	while (q->depth) {
+		ws_sendq_peek(q, 0, &rec, sizeof(rec));
+		if (rec.flags & WS_SENDQ_HEAP) {
+			ws_sendq_peek(q, sizeof(rec), &heap, sizeof(heap));
+			free(heap);
+			ws_sendq_consume(q, sizeof(rec) + sizeof(heap));
+		} else {
+			ws_sendq_consume(q, sizeof(rec) + rec.len);
+		}
+		q->depth--;
+	}
+	q->heap_used = 0;
+
+	pthread_mutex_destroy(&q->lock);
+	sem_destroy(&q->pending);
+}
+
+void ws_sendq_dump(struct ws_sendq *q)
+{
+	pthread_mutex_lock(&q->lock);
+	fprintf(stdout, "queue: %u messages, %u/%u bytes%s, max depth %u\n", q->depth,
+		ws_sendq_level(q), WS_SENDQ_SIZE, q->congested ? " (congested)" : "",
+		q->stats.max_depth);
+	fprintf(stdout, "pushed %u rejected %u oversized %u frames %u coalesced %u errors %u\n",
+		q->stats.pushed, q->stats.rejected, q->stats.oversized, q->stats.frames,
+		q->stats.coalesced, q->stats.errors);
+	perf_stats_print("send latency", &q->stats.latency);
+	pthread_mutex_unlock(&q->lock);
+}
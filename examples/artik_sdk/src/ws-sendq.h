@@ -0,0 +1,107 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file ws-sendq.h
+ */
+
+#ifndef __ARTIK_WS_SENDQ_H__
+#define __ARTIK_WS_SENDQ_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <artik_websocket.h>
+
+#include "perf-stats.h"
+
+/*
+ * Bounded asynchronous send queue for one websocket handle.
+ *
+ * ws_sendq_push() copies the message into a byte ring and returns at once;
+ * either the queue's own sender thread (ws_sendq_start()) or an external
+ * task calling ws_sendq_service() when notified writes queued messages to
+ * the socket. Consecutive messages pushed with WS_SENDQ_COALESCE are
+ * joined with '\n' into a single frame of up to WS_SENDQ_FRAME_MAX bytes,
+ * which is only valid for peers that accept newline-delimited records.
+ * Longer messages are copied to the heap and only their pointer is queued;
+ * they count against the queue size like the others and are always
+ * accepted by an empty queue. The watermark callback is called with true
+ * when the queue fills past the high watermark and with false once it
+ * drains below the low one.
+ *
+ * ws_sendq_init() expects a zeroed or stopped queue and refuses a running
+ * one.
+ */
+#define WS_SENDQ_SIZE			4096
+#define WS_SENDQ_FRAME_MAX		1024
+#define WS_SENDQ_HIGH_WATERMARK	(WS_SENDQ_SIZE * 3 / 4)
+#define WS_SENDQ_LOW_WATERMARK	(WS_SENDQ_SIZE / 4)
+
+#define WS_SENDQ_COALESCE		(1 << 0)
+
+typedef artik_error (*ws_sendq_write)(artik_websocket_handle handle, char *message);
+typedef void (*ws_sendq_watermark)(bool congested, void *user_data);
+
+struct ws_sendq_stats {
+	unsigned int pushed;
+	unsigned int rejected;
+	unsigned int oversized;
+	unsigned int frames;
+	unsigned int coalesced;
+	unsigned int errors;
+	unsigned int max_depth;
+	struct perf_stats latency;
+};
+
+struct ws_sendq {
+	artik_websocket_handle handle;
+	ws_sendq_write write;
+	ws_sendq_watermark watermark;
+	void *user_data;
+
+	char ring[WS_SENDQ_SIZE];
+	unsigned int head;
+	unsigned int tail;
+	unsigned int used;
+	unsigned int heap_used;
+	unsigned int depth;
+	bool congested;
+
+	bool running;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	sem_t pending;
+	sem_t *notify;
+
+	struct ws_sendq_stats stats;
+	char frame[WS_SENDQ_FRAME_MAX + 1];
+};
+
+int ws_sendq_init(struct ws_sendq *q, artik_websocket_handle handle,
+		ws_sendq_write write, ws_sendq_watermark watermark, void *user_data);
+void ws_sendq_set_notify(struct ws_sendq *q, sem_t *notify);
+int ws_sendq_start(struct ws_sendq *q);
+void ws_sendq_stop(struct ws_sendq *q);
+artik_error ws_sendq_push(struct ws_sendq *q, const char *message, unsigned int flags);
+int ws_sendq_service(struct ws_sendq *q);
+void ws_sendq_dump(struct ws_sendq *q);
+
+#endif /* __ARTIK_WS_SENDQ_H__ */
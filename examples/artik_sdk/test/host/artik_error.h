@@ -0,0 +1,47 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file artik_error.h
+ */
+
+#ifndef __ARTIK_HOST_ERROR_H__
+#define __ARTIK_HOST_ERROR_H__
+
+/*
+ * Stand-in for the SDK header when the host-portable modules are built for
+ * the native unit tests. Only the codes those modules return are defined.
+ */
+typedef int artik_error;
+
+#define S_OK				0
+#define E_BAD_ARGS			-7
+#define E_NO_MEM			-8
+#define E_NOT_SUPPORTED		-9
+#define E_NOT_INITIALIZED	-10
+#define E_INVALID_VALUE		-11
+#define E_BUSY				-12
+#define E_TIMEOUT			-13
+#define E_ACCESS_DENIED		-14
+#define E_OVERFLOW			-15
+#define E_TRY_AGAIN			-16
+#define E_INTERRUPTED		-17
+#define E_HTTP_ERROR		-18
+#define E_NOT_CONNECTED		-19
+
+#endif /* __ARTIK_HOST_ERROR_H__ */
@@ -0,0 +1,43 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file artik_http.h
+ */
+
+#ifndef __ARTIK_HOST_HTTP_H__
+#define __ARTIK_HOST_HTTP_H__
+
+#include "artik_error.h"
+#include "artik_ssl.h"
+
+/*
+ * Stand-in for the SDK header in the native unit tests, with the header
+ * list the HTTP client sends. The http module itself is not provided.
+ */
+typedef struct {
+	char *name;
+	char *data;
+} artik_http_header_field;
+
+typedef struct {
+	artik_http_header_field *fields;
+	int num_fields;
+} artik_http_headers;
+
+#endif /* __ARTIK_HOST_HTTP_H__ */
@@ -0,0 +1,38 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file artik_module.h
+ */
+
+#ifndef __ARTIK_HOST_MODULE_H__
+#define __ARTIK_HOST_MODULE_H__
+
+#include "artik_error.h"
+
+/*
+ * Stand-in for the SDK header in the native unit tests. The tests provide
+ * the modules the code under test requests. The functions are weak so
+ * that the tests of modules that never request one link without them.
+ */
+typedef void *artik_module_ops;
+
+artik_module_ops artik_request_api_module(const char *name) __attribute__((weak));
+artik_error artik_release_api_module(const artik_module_ops module) __attribute__((weak));
+
+#endif /* __ARTIK_HOST_MODULE_H__ */
@@ -0,0 +1,71 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file artik_network.h
+ */
+
+#ifndef __ARTIK_HOST_NETWORK_H__
+#define __ARTIK_HOST_NETWORK_H__
+
+#include "artik_error.h"
+
+/*
+ * Stand-in for the SDK header in the native unit tests, with the part of
+ * the network module the DHCP lease code uses.
+ */
+#define MAX_IP_ADDRESS_LEN	40
+#define MAX_DNS_ADDRESSES	2
+#define MAX_MAC_ADDRESS_LEN	18
+
+typedef void *artik_network_dhcp_client_handle;
+
+typedef enum {
+	ARTIK_WIFI = 0,
+	ARTIK_ETHERNET
+} artik_network_interface_t;
+
+typedef enum {
+	ARTIK_IPV4 = 0,
+	ARTIK_IPV6
+} artik_ip_type;
+
+typedef struct {
+	char address[MAX_IP_ADDRESS_LEN];
+	artik_ip_type type;
+} artik_network_ip;
+
+typedef struct {
+	artik_network_ip ip_addr;
+	artik_network_ip netmask;
+	artik_network_ip gw_addr;
+	artik_network_ip dns_addr[MAX_DNS_ADDRESSES];
+	char mac_addr[MAX_MAC_ADDRESS_LEN];
+} artik_network_config;
+
+typedef struct {
+	artik_error (*set_network_config)(artik_network_config *config,
+			artik_network_interface_t interface);
+	artik_error (*get_network_config)(artik_network_config *config,
+			artik_network_interface_t interface);
+	artik_error (*dhcp_client_start)(artik_network_dhcp_client_handle *handle,
+			artik_network_interface_t interface);
+	artik_error (*dhcp_client_stop)(artik_network_dhcp_client_handle handle);
+} artik_network_module;
+
+#endif /* __ARTIK_HOST_NETWORK_H__ */
@@ -0,0 +1,51 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file artik_ssl.h
+ */
+
+#ifndef __ARTIK_HOST_SSL_H__
+#define __ARTIK_HOST_SSL_H__
+
+#include <stdbool.h>
+
+/*
+ * Stand-in for the SDK header in the native unit tests, with the SSL
+ * configuration the HTTP client takes. The host build has no TLS.
+ */
+typedef enum {
+	ARTIK_SSL_VERIFY_NONE = 0,
+	ARTIK_SSL_VERIFY_OPTIONAL,
+	ARTIK_SSL_VERIFY_REQUIRED
+} artik_ssl_verify_t;
+
+typedef struct {
+	char *data;
+	unsigned int len;
+} artik_ssl_cert;
+
+typedef struct {
+	bool use_se;
+	artik_ssl_cert ca_cert;
+	artik_ssl_cert client_cert;
+	artik_ssl_cert client_key;
+	artik_ssl_verify_t verify_cert;
+} artik_ssl_config;
+
+#endif /* __ARTIK_HOST_SSL_H__ */
@@ -0,0 +1,365 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file test_main.c
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <unity.h>
+
+#include <artik_module.h>
+#include <artik_network.h>
+
+#include "dhcp-lease.h"
+
+#define TEST_WAIT_MS		3000
+#define TEST_DELAY_MS		200
+
+/*
+ * Stands in for the DHCP server on the network and for the interface the
+ * client configures with what it hands out.
+ */
+static struct {
+	bool up;
+	unsigned int delay_ms;
+	char address[MAX_IP_ADDRESS_LEN];
+	char gateway[MAX_IP_ADDRESS_LEN];
+	unsigned int exchanges;
+} server;
+
+static artik_network_config iface;
+static unsigned int applied;
+static pthread_mutex_t iface_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static volatile unsigned int renewals;
+static artik_error renew_result;
+
+static artik_error test_set_config(artik_network_config *config,
+		artik_network_interface_t interface)
+{
+	pthread_mutex_lock(&iface_lock);
+	memcpy(&iface, config, sizeof(iface));
+	applied++;
+	pthread_mutex_unlock(&iface_lock);
+
+	return S_OK;
+}
+
+static artik_error test_get_config(artik_network_config *config,
+		artik_network_interface_t interface)
+{
+	pthread_mutex_lock(&iface_lock);
+	memcpy(config, &iface, sizeof(iface));
+	pthread_mutex_unlock(&iface_lock);
+
+	return S_OK;
+}
+
+static artik_error test_dhcp_start(artik_network_dhcp_client_handle *handle,
+		artik_network_interface_t interface)
+{
+	artik_error err = S_OK;
+
+	usleep(server.delay_ms * 1000);
+
+	pthread_mutex_lock(&iface_lock);
+	server.exchanges++;
+	if (server.up) {
+		memset(&iface, 0, sizeof(iface));
+		strncpy(iface.ip_addr.address, server.address, MAX_IP_ADDRESS_LEN - 1);
+		strncpy(iface.netmask.address, "255.255.255.0", MAX_IP_ADDRESS_LEN - 1);
+		strncpy(iface.gw_addr.address, server.gateway, MAX_IP_ADDRESS_LEN - 1);
+		strncpy(iface.dns_addr[0].address, server.gateway, MAX_IP_ADDRESS_LEN - 1);
+		*handle = &server;
+	} else {
+		err = E_TIMEOUT;
+	}
+	pthread_mutex_unlock(&iface_lock);
+
+	return err;
+}
+
+static artik_error test_dhcp_stop(artik_network_dhcp_client_handle handle)
+{
+	return S_OK;
+}
+
+static artik_network_module network = {
+	.set_network_config = test_set_config,
+	.get_network_config = test_get_config,
+	.dhcp_client_start = test_dhcp_start,
+	.dhcp_client_stop = test_dhcp_stop,
+};
+
+artik_module_ops artik_request_api_module(const char *name)
+{
+	return strcmp(name, "network") ? NULL : (artik_module_ops)&network;
+}
+
+artik_error artik_release_api_module(const artik_module_ops module)
+{
+	return S_OK;
+}
+
+static void renewed(artik_error result, void *user_data)
+{
+	renew_result = result;
+	renewals++;
+}
+
+static bool wait_renewals(unsigned int value)
+{
+	int ms;
+
+	for (ms = 0; ms < TEST_WAIT_MS; ms += 10) {
+		if (renewals >= value)
+			return true;
+		usleep(10000);
+	}
+
+	return false;
+}
+
+static void iface_address(char *address)
+{
+	pthread_mutex_lock(&iface_lock);
+	strcpy(address, iface.ip_addr.address);
+	pthread_mutex_unlock(&iface_lock);
+}
+
+static void server_set(bool up, const char *address, unsigned int delay_ms)
+{
+	pthread_mutex_lock(&iface_lock);
+	server.up = up;
+	strncpy(server.address, address, MAX_IP_ADDRESS_LEN - 1);
+	server.delay_ms = delay_ms;
+	pthread_mutex_unlock(&iface_lock);
+}
+
+static void server_set_gateway(const char *gateway)
+{
+	pthread_mutex_lock(&iface_lock);
+	strncpy(server.gateway, gateway, MAX_IP_ADDRESS_LEN - 1);
+	pthread_mutex_unlock(&iface_lock);
+}
+
+void setUp(void)
+{
+	dhcp_lease_clear();
+	dhcp_lease_network_changed("home");
+
+	memset(&server, 0, sizeof(server));
+	memset(&iface, 0, sizeof(iface));
+	applied = 0;
+	renewals = 0;
+	renew_result = S_OK;
+	server_set(true, "192.168.1.10", 0);
+	server_set_gateway("192.168.1.1");
+}
+
+void tearDown(void)
+{
+	dhcp_lease_clear();
+}
+
+static void test_first_exchange_is_saved(void)
+{
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+	TEST_ASSERT_EQUAL_UINT(1, server.exchanges);
+	TEST_ASSERT_EQUAL_UINT(0, applied);
+	TEST_ASSERT_EQUAL(0, access(DHCP_LEASE_PATH, F_OK));
+
+	/* Run in the foreground, the callback is only for renewals */
+	TEST_ASSERT_EQUAL_UINT(0, renewals);
+}
+
+static void test_saved_lease_applied_before_renewal(void)
+{
+	char address[MAX_IP_ADDRESS_LEN];
+
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+	memset(&iface, 0, sizeof(iface));
+
+	server_set(true, "192.168.1.10", TEST_DELAY_MS);
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+	iface_address(address);
+	TEST_ASSERT_EQUAL_STRING("192.168.1.10", address);
+	TEST_ASSERT_EQUAL_UINT(1, applied);
+	TEST_ASSERT_EQUAL_UINT(1, server.exchanges);
+
+	TEST_ASSERT_TRUE(wait_renewals(1));
+	TEST_ASSERT_EQUAL(S_OK, renew_result);
+	TEST_ASSERT_EQUAL_UINT(2, server.exchanges);
+}
+
+static void test_busy_while_renewing(void)
+{
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+
+	server_set(true, "192.168.1.10", TEST_DELAY_MS);
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+	TEST_ASSERT_EQUAL(E_BUSY, dhcp_lease_start(true, renewed, NULL));
+
+	TEST_ASSERT_TRUE(wait_renewals(1));
+	TEST_ASSERT_EQUAL_UINT(1, renewals);
+}
+
+static pthread_addr_t start_thread(pthread_addr_t arg)
+{
+	*(artik_error *)arg = dhcp_lease_start(false, renewed, NULL);
+
+	return NULL;
+}
+
+static void test_busy_during_exchange(void)
+{
+	artik_error err = E_TIMEOUT;
+	pthread_t thread;
+
+	server_set(true, "192.168.1.10", TEST_DELAY_MS);
+	TEST_ASSERT_EQUAL(0, pthread_create(&thread, NULL, start_thread, &err));
+	usleep(TEST_DELAY_MS * 1000 / 2);
+	TEST_ASSERT_EQUAL(E_BUSY, dhcp_lease_start(true, renewed, NULL));
+
+	pthread_join(thread, NULL);
+	TEST_ASSERT_EQUAL(S_OK, err);
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(false, renewed, NULL));
+}
+
+static void test_failed_renewal_clears_interface(void)
+{
+	char address[MAX_IP_ADDRESS_LEN];
+
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+
+	/* The device moved while off, the server no longer answers */
+	server_set(false, "", TEST_DELAY_MS);
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+	TEST_ASSERT_TRUE(wait_renewals(1));
+	TEST_ASSERT_NOT_EQUAL(S_OK, renew_result);
+
+	iface_address(address);
+	TEST_ASSERT_EQUAL_STRING("0.0.0.0", address);
+
+	/* The lease was dropped, the next start runs the client in the foreground */
+	applied = 0;
+	server_set(false, "", 0);
+	TEST_ASSERT_NOT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+	TEST_ASSERT_EQUAL_UINT(0, applied);
+	TEST_ASSERT_EQUAL_UINT(1, renewals);
+}
+
+static void test_changed_address_replaces_lease(void)
+{
+	char address[MAX_IP_ADDRESS_LEN];
+
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+
+	server_set(true, "192.168.1.20", 0);
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+	TEST_ASSERT_TRUE(wait_renewals(1));
+	TEST_ASSERT_EQUAL(S_OK, renew_result);
+	iface_address(address);
+	TEST_ASSERT_EQUAL_STRING("192.168.1.20", address);
+
+	/* The next connection starts with the new address */
+	memset(&iface, 0, sizeof(iface));
+	server_set(true, "192.168.1.20", TEST_DELAY_MS);
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+	iface_address(address);
+	TEST_ASSERT_EQUAL_STRING("192.168.1.20", address);
+	TEST_ASSERT_TRUE(wait_renewals(2));
+}
+
+static void test_leases_kept_per_network(void)
+{
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+
+	dhcp_lease_network_changed("office");
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+	TEST_ASSERT_EQUAL_UINT(0, applied);
+
+	dhcp_lease_network_changed("home");
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+	TEST_ASSERT_EQUAL_UINT(1, applied);
+	TEST_ASSERT_TRUE(wait_renewals(1));
+}
+
+static void test_same_name_networks_kept_apart(void)
+{
+	char address[MAX_IP_ADDRESS_LEN];
+
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+
+	/* Another network with the same SSID, the saved lease is tried first */
+	server_set(true, "10.0.0.10", 0);
+	server_set_gateway("10.0.0.1");
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+	TEST_ASSERT_EQUAL_UINT(1, applied);
+	TEST_ASSERT_TRUE(wait_renewals(1));
+	iface_address(address);
+	TEST_ASSERT_EQUAL_STRING("10.0.0.10", address);
+
+	/* Which of the two the device is on can no longer be told */
+	server_set(true, "192.168.1.10", 0);
+	server_set_gateway("192.168.1.1");
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+	TEST_ASSERT_EQUAL_UINT(1, applied);
+	TEST_ASSERT_EQUAL_UINT(1, renewals);
+	TEST_ASSERT_EQUAL_UINT(3, server.exchanges);
+}
+
+static void test_saved_lease_not_used_when_asked(void)
+{
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(false, renewed, NULL));
+	TEST_ASSERT_EQUAL_UINT(0, applied);
+	TEST_ASSERT_EQUAL_UINT(2, server.exchanges);
+}
+
+static void test_old_lease_not_applied(void)
+{
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+
+	sleep(DHCP_LEASE_MAX_AGE_S + 1);
+	TEST_ASSERT_EQUAL(S_OK, dhcp_lease_start(true, renewed, NULL));
+	TEST_ASSERT_EQUAL_UINT(0, applied);
+	TEST_ASSERT_EQUAL_UINT(2, server.exchanges);
+	TEST_ASSERT_EQUAL_UINT(0, renewals);
+}
+
+int main(int argc, char *argv[])
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_first_exchange_is_saved);
+	RUN_TEST(test_saved_lease_applied_before_renewal);
+	RUN_TEST(test_busy_while_renewing);
+	RUN_TEST(test_busy_during_exchange);
+	RUN_TEST(test_failed_renewal_clears_interface);
+	RUN_TEST(test_changed_address_replaces_lease);
+	RUN_TEST(test_leases_kept_per_network);
+	RUN_TEST(test_same_name_networks_kept_apart);
+	RUN_TEST(test_saved_lease_not_used_when_asked);
+	RUN_TEST(test_old_lease_not_applied);
+	return UNITY_END();
+}
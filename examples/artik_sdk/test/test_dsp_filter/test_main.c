@@ -0,0 +1,331 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file test_main.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unity.h>
+
+#include "dsp-filter.h"
+
+#define TEST_BLOCK			256
+#define TEST_LEVEL			10000
+#define TEST_BENCH_SAMPLES	(64 * 1024)
+
+static struct dsp_pipeline pipeline;
+
+/* Feeds a constant level and returns the last sample that comes out */
+static q15_t settle(struct dsp_pipeline *p, q15_t level, int blocks)
+{
+	q15_t block[TEST_BLOCK];
+	q15_t last = 0;
+	int i, n;
+
+	while (blocks--) {
+		for (i = 0; i < TEST_BLOCK; i++)
+			block[i] = level;
+		n = dsp_pipeline_process(p, block, TEST_BLOCK);
+		if (n)
+			last = block[n - 1];
+	}
+
+	return last;
+}
+
+/* Runs a 0 to level step, returns how many samples came out */
+static int step(struct dsp_pipeline *p, q15_t level, q15_t *out, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		out[i] = level;
+
+	return dsp_pipeline_process(p, out, count);
+}
+
+static void parse(const char *spec)
+{
+	char buf[64];
+
+	strncpy(buf, spec, sizeof(buf) - 1);
+	buf[sizeof(buf) - 1] = '\0';
+	TEST_ASSERT_EQUAL(S_OK, dsp_pipeline_parse(&pipeline, buf, NULL, NULL, NULL));
+}
+
+void setUp(void)
+{
+	dsp_pipeline_init(&pipeline);
+}
+
+void tearDown(void)
+{
+}
+
+static void test_dc_gain(void)
+{
+	static const char * const specs[] = {
+		"avg:8", "cic:3:4", "cic:2:16", "fir:16:1", "fir:31:2", "iir:0.1",
+		"iir:0.01", "cic:3:4,fir:16:2,iir:0.1", "avg:4,fir:8:4",
+	};
+	unsigned int i;
+
+	for (i = 0; i < sizeof(specs) / sizeof(specs[0]); i++) {
+		parse(specs[i]);
+		TEST_ASSERT_INT_WITHIN(TEST_LEVEL / 100, TEST_LEVEL, settle(&pipeline, TEST_LEVEL, 16));
+		TEST_ASSERT_INT_WITHIN(TEST_LEVEL / 100, -TEST_LEVEL,
+			settle(&pipeline, -TEST_LEVEL, 16));
+	}
+}
+
+static void test_cic_gain_is_exact(void)
+{
+	TEST_ASSERT_EQUAL(S_OK, dsp_add_cic(&pipeline, 3, 8));
+	TEST_ASSERT_EQUAL(TEST_LEVEL, settle(&pipeline, TEST_LEVEL, 4));
+	TEST_ASSERT_EQUAL(DSP_Q15_MIN, settle(&pipeline, DSP_Q15_MIN, 4));
+}
+
+static void test_moving_avg_step(void)
+{
+	q15_t out[16];
+	int i;
+
+	TEST_ASSERT_EQUAL(S_OK, dsp_add_moving_avg(&pipeline, 8));
+	TEST_ASSERT_EQUAL(16, step(&pipeline, 800, out, 16));
+
+	/* A straight ramp over the window, flat after it */
+	for (i = 0; i < 8; i++)
+		TEST_ASSERT_EQUAL(100 * (i + 1), out[i]);
+	for (; i < 16; i++)
+		TEST_ASSERT_EQUAL(800, out[i]);
+}
+
+static void test_iir_step(void)
+{
+	q15_t out[64];
+	float y = 0.0f;
+	int i;
+
+	TEST_ASSERT_EQUAL(S_OK, dsp_add_iir(&pipeline, DSP_FLOAT_TO_Q15(0.1f)));
+	TEST_ASSERT_EQUAL(64, step(&pipeline, TEST_LEVEL, out, 64));
+
+	/* First order response 1 - (1 - alpha)^n, within rounding */
+	for (i = 0; i < 64; i++) {
+		dsp_iir_f32(&y, DSP_FLOAT_TO_Q15(0.1f) / 32768.0f, TEST_LEVEL);
+		TEST_ASSERT_INT_WITHIN(1, (int)lroundf(y), out[i]);
+	}
+}
+
+static void test_iir_small_alpha_does_not_stall(void)
+{
+	TEST_ASSERT_EQUAL(S_OK, dsp_add_iir(&pipeline, 1));
+	TEST_ASSERT_INT_WITHIN(TEST_LEVEL / 100, TEST_LEVEL, settle(&pipeline, TEST_LEVEL, 2048));
+}
+
+static void test_cic_step_is_monotonic(void)
+{
+	q15_t out[TEST_BLOCK];
+	int i, n;
+
+	TEST_ASSERT_EQUAL(S_OK, dsp_add_cic(&pipeline, 3, 4));
+	n = step(&pipeline, TEST_LEVEL, out, TEST_BLOCK);
+	TEST_ASSERT_EQUAL(TEST_BLOCK / 4, n);
+
+	/* Settles within order output samples, without overshoot */
+	for (i = 1; i < n; i++) {
+		TEST_ASSERT_TRUE(out[i] >= out[i - 1]);
+		TEST_ASSERT_TRUE(out[i] <= TEST_LEVEL);
+	}
+	TEST_ASSERT_EQUAL(TEST_LEVEL, out[3]);
+}
+
+static void test_lowpass_step(void)
+{
+	q15_t out[TEST_BLOCK];
+	int i, n;
+
+	TEST_ASSERT_EQUAL(S_OK, dsp_add_lowpass(&pipeline, 16, 2));
+	n = step(&pipeline, TEST_LEVEL, out, TEST_BLOCK);
+	TEST_ASSERT_EQUAL(TEST_BLOCK / 2, n);
+
+	/* The cutoff is sharp enough to ring, but by less than 10% */
+	for (i = 0; i < n; i++)
+		TEST_ASSERT_TRUE(out[i] <= TEST_LEVEL + TEST_LEVEL / 11);
+	for (i = 16 / 2; i < n; i++)
+		TEST_ASSERT_INT_WITHIN(TEST_LEVEL / 100, TEST_LEVEL, out[i]);
+}
+
+static void test_lowpass_rejects_nyquist(void)
+{
+	q15_t block[TEST_BLOCK];
+	int i, n;
+
+	TEST_ASSERT_EQUAL(S_OK, dsp_add_lowpass(&pipeline, 31, 4));
+	for (i = 0; i < TEST_BLOCK; i++)
+		block[i] = (i & 1) ? TEST_LEVEL : -TEST_LEVEL;
+	n = dsp_pipeline_process(&pipeline, block, TEST_BLOCK);
+
+	for (i = 32 / 4; i < n; i++)
+		TEST_ASSERT_INT_WITHIN(TEST_LEVEL / 100, 0, block[i]);
+}
+
+static void test_fir_q15_matches_float(void)
+{
+	float coeffs_f[DSP_FIR_MAX_TAPS];
+	float samples_f[DSP_FIR_MAX_TAPS];
+	q15_t coeffs_q[DSP_FIR_MAX_TAPS];
+	q15_t samples_q[DSP_FIR_MAX_TAPS];
+	int i, k;
+
+	dsp_fir_design_lowpass(coeffs_f, DSP_FIR_MAX_TAPS, 0.1f);
+	for (k = 0; k < DSP_FIR_MAX_TAPS; k++) {
+		coeffs_q[k] = DSP_FLOAT_TO_Q15(coeffs_f[k]);
+		coeffs_f[k] = coeffs_q[k] / 32768.0f;
+	}
+
+	srand(42);
+	for (i = 0; i < 1000; i++) {
+		for (k = 0; k < DSP_FIR_MAX_TAPS; k++) {
+			samples_q[k] = (q15_t)(rand() % 65536 - 32768);
+			samples_f[k] = samples_q[k];
+		}
+		TEST_ASSERT_INT_WITHIN(1,
+			(int)lroundf(dsp_fir_f32(coeffs_f, samples_f, DSP_FIR_MAX_TAPS)),
+			dsp_fir_q15(coeffs_q, samples_q, DSP_FIR_MAX_TAPS));
+	}
+}
+
+static struct dsp_window last_window;
+static unsigned int windows;
+
+static void window_cb(const struct dsp_window *window, void *user_data)
+{
+	last_window = *window;
+	windows++;
+}
+
+static void test_stats_window(void)
+{
+	q15_t block[64];
+	int i;
+
+	windows = 0;
+	TEST_ASSERT_EQUAL(S_OK, dsp_add_stats(&pipeline, 32, window_cb, NULL));
+	for (i = 0; i < 64; i++)
+		block[i] = (i & 1) ? 3000 : -3000;
+	TEST_ASSERT_EQUAL(64, dsp_pipeline_process(&pipeline, block, 64));
+
+	TEST_ASSERT_EQUAL(2, windows);
+	TEST_ASSERT_EQUAL(-3000, last_window.min);
+	TEST_ASSERT_EQUAL(3000, last_window.max);
+	TEST_ASSERT_EQUAL(3000, last_window.rms);
+	TEST_ASSERT_EQUAL(32, last_window.count);
+}
+
+static unsigned int rises, falls;
+
+static void event_cb(bool above, q15_t value, void *user_data)
+{
+	if (above)
+		rises++;
+	else
+		falls++;
+}
+
+static void test_threshold_hysteresis(void)
+{
+	static const q15_t signal[] = { 0, 900, 1100, 950, 1050, 600, 400, 800, 1200 };
+	q15_t block[sizeof(signal) / sizeof(signal[0])];
+
+	rises = falls = 0;
+	TEST_ASSERT_EQUAL(S_OK, dsp_add_threshold(&pipeline, 1000, 500, event_cb, NULL));
+	memcpy(block, signal, sizeof(block));
+	dsp_pipeline_process(&pipeline, block, sizeof(signal) / sizeof(signal[0]));
+
+	TEST_ASSERT_EQUAL(2, rises);
+	TEST_ASSERT_EQUAL(1, falls);
+}
+
+static void test_rejects_bad_stages(void)
+{
+	char spec[] = "cic:3:3";
+
+	TEST_ASSERT_EQUAL(E_BAD_ARGS, dsp_add_cic(&pipeline, 4, 4));
+	TEST_ASSERT_EQUAL(E_BAD_ARGS, dsp_add_cic(&pipeline, 3, 64));
+	TEST_ASSERT_EQUAL(E_BAD_ARGS, dsp_add_lowpass(&pipeline, DSP_FIR_MAX_TAPS + 1, 1));
+	TEST_ASSERT_EQUAL(E_BAD_ARGS, dsp_add_iir(&pipeline, 0));
+	TEST_ASSERT_EQUAL(E_BAD_ARGS, dsp_add_stats(&pipeline, 0, window_cb, NULL));
+	TEST_ASSERT_EQUAL(E_BAD_ARGS, dsp_pipeline_parse(&pipeline, spec, NULL, NULL, NULL));
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Host figures only, the board numbers come from 'adc dspbench' */
+static void test_benchmark(void)
+{
+	static const char * const specs[] = {
+		"avg:16", "cic:3:4", "fir:16:1", "fir:32:1", "iir:0.05", "cic:3:4,fir:16:2,iir:0.1",
+	};
+	q15_t block[TEST_BLOCK];
+	uint64_t start, elapsed;
+	unsigned int i;
+	int n, k;
+
+	for (i = 0; i < sizeof(specs) / sizeof(specs[0]); i++) {
+		parse(specs[i]);
+		start = now_ns();
+		for (n = 0; n < TEST_BENCH_SAMPLES; n += TEST_BLOCK) {
+			for (k = 0; k < TEST_BLOCK; k++)
+				block[k] = (q15_t)((n + k) * 37);
+			dsp_pipeline_process(&pipeline, block, TEST_BLOCK);
+		}
+		elapsed = now_ns() - start;
+		printf("%-26s %6.1f ns/sample\n", specs[i], (double)elapsed / TEST_BENCH_SAMPLES);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_dc_gain);
+	RUN_TEST(test_cic_gain_is_exact);
+	RUN_TEST(test_moving_avg_step);
+	RUN_TEST(test_iir_step);
+	RUN_TEST(test_iir_small_alpha_does_not_stall);
+	RUN_TEST(test_cic_step_is_monotonic);
+	RUN_TEST(test_lowpass_step);
+	RUN_TEST(test_lowpass_rejects_nyquist);
+	RUN_TEST(test_fir_q15_matches_float);
+	RUN_TEST(test_stats_window);
+	RUN_TEST(test_threshold_hysteresis);
+	RUN_TEST(test_rejects_bad_stages);
+	RUN_TEST(test_benchmark);
+
+	return UNITY_END();
+}
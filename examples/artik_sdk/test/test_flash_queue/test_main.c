@@ -0,0 +1,241 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file test_main.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <unity.h>
+
+#include "flash-queue.h"
+
+/* A regular file stands in for the flash partition */
+#define TEST_QUEUE_PATH		"flash-queue-test.bin"
+#define TEST_WAIT_MS		3000
+#define TEST_MAX_RECORDS	64
+
+static struct flash_queue q;
+static char received[TEST_MAX_RECORDS][FLASH_QUEUE_RECORD_MAX + 1];
+static unsigned int num_received;
+static bool sink_fails;
+
+static artik_error test_sink(const char *data, unsigned int len, void *user_data)
+{
+	if (sink_fails || (num_received >= TEST_MAX_RECORDS))
+		return E_BUSY;
+
+	memcpy(received[num_received], data, len);
+	received[num_received][len] = '\0';
+	num_received++;
+
+	return S_OK;
+}
+
+static bool wait_for(volatile unsigned int *counter, unsigned int value)
+{
+	int ms;
+
+	for (ms = 0; ms < TEST_WAIT_MS; ms += 10) {
+		if (*counter >= value)
+			return true;
+		usleep(10000);
+	}
+
+	return false;
+}
+
+static void append(const char *message)
+{
+	artik_error err;
+
+	/* The staging area is small, wait for the worker to write it out */
+	while ((err = flash_queue_append(&q, message, strlen(message))) == E_BUSY)
+		usleep(10000);
+	TEST_ASSERT_EQUAL(S_OK, err);
+}
+
+void setUp(void)
+{
+	unlink(TEST_QUEUE_PATH);
+	num_received = 0;
+	sink_fails = false;
+	TEST_ASSERT_EQUAL(S_OK, flash_queue_open(&q, TEST_QUEUE_PATH));
+}
+
+void tearDown(void)
+{
+	flash_queue_close(&q);
+	unlink(TEST_QUEUE_PATH);
+}
+
+static void test_drains_in_order(void)
+{
+	TEST_ASSERT_TRUE(flash_queue_empty(&q));
+
+	append("{\"seq\":1}");
+	append("{\"seq\":2}");
+	append("{\"seq\":3}");
+	TEST_ASSERT_FALSE(flash_queue_empty(&q));
+
+	flash_queue_drain(&q, test_sink, NULL, 1000, 8);
+	TEST_ASSERT_TRUE(wait_for(&num_received, 3));
+	TEST_ASSERT_EQUAL_STRING("{\"seq\":1}", received[0]);
+	TEST_ASSERT_EQUAL_STRING("{\"seq\":2}", received[1]);
+	TEST_ASSERT_EQUAL_STRING("{\"seq\":3}", received[2]);
+	TEST_ASSERT_TRUE(flash_queue_empty(&q));
+}
+
+static void test_survives_reopen(void)
+{
+	append("first");
+	append("second");
+	TEST_ASSERT_TRUE(wait_for(&q.stats.written, 2));
+
+	flash_queue_close(&q);
+	TEST_ASSERT_EQUAL(S_OK, flash_queue_open(&q, TEST_QUEUE_PATH));
+	TEST_ASSERT_EQUAL(2, q.pending);
+
+	flash_queue_drain(&q, test_sink, NULL, 1000, 8);
+	TEST_ASSERT_TRUE(wait_for(&num_received, 2));
+	TEST_ASSERT_EQUAL_STRING("first", received[0]);
+	TEST_ASSERT_EQUAL_STRING("second", received[1]);
+}
+
+static void test_consumed_records_stay_consumed(void)
+{
+	append("once");
+	flash_queue_drain(&q, test_sink, NULL, 1000, 8);
+	TEST_ASSERT_TRUE(wait_for(&num_received, 1));
+	flash_queue_stop_drain(&q);
+
+	flash_queue_close(&q);
+	TEST_ASSERT_EQUAL(S_OK, flash_queue_open(&q, TEST_QUEUE_PATH));
+	TEST_ASSERT_EQUAL(0, q.pending);
+	TEST_ASSERT_TRUE(flash_queue_empty(&q));
+}
+
+static void test_sink_failure_keeps_record(void)
+{
+	sink_fails = true;
+	append("retry me");
+	flash_queue_drain(&q, test_sink, NULL, 1000, 8);
+	TEST_ASSERT_TRUE(wait_for(&q.stats.sink_errors, 1));
+	TEST_ASSERT_FALSE(flash_queue_empty(&q));
+
+	sink_fails = false;
+	TEST_ASSERT_TRUE(wait_for(&num_received, 1));
+	TEST_ASSERT_EQUAL_STRING("retry me", received[0]);
+}
+
+static void test_write_failure_keeps_record(void)
+{
+	int fd = q.fd;
+	int ro = open(TEST_QUEUE_PATH, O_RDONLY);
+
+	TEST_ASSERT_TRUE(ro >= 0);
+
+	/* Every flash write fails while the store is read only */
+	pthread_mutex_lock(&q.lock);
+	q.fd = ro;
+	pthread_mutex_unlock(&q.lock);
+
+	append("kept in RAM");
+	TEST_ASSERT_TRUE(wait_for(&q.stats.write_errors, 1));
+	TEST_ASSERT_EQUAL(0, q.stats.written);
+	TEST_ASSERT_FALSE(flash_queue_empty(&q));
+
+	pthread_mutex_lock(&q.lock);
+	q.fd = fd;
+	pthread_mutex_unlock(&q.lock);
+	close(ro);
+
+	TEST_ASSERT_TRUE(wait_for(&q.stats.written, 1));
+	flash_queue_drain(&q, test_sink, NULL, 1000, 8);
+	TEST_ASSERT_TRUE(wait_for(&num_received, 1));
+	TEST_ASSERT_EQUAL_STRING("kept in RAM", received[0]);
+}
+
+static void test_full_log_drops_oldest(void)
+{
+	char message[FLASH_QUEUE_RECORD_MAX + 1];
+	unsigned int total = 48, i, first;
+
+	for (i = 0; i < total; i++) {
+		memset(message, 'a' + i % 26, 900);
+		snprintf(message, sizeof(message), "%02u", i);
+		message[2] = '-';
+		message[900] = '\0';
+		append(message);
+	}
+	TEST_ASSERT_TRUE(wait_for(&q.stats.written, total));
+	TEST_ASSERT_TRUE(q.stats.dropped > 0);
+	TEST_ASSERT_EQUAL(total, q.pending + q.stats.dropped);
+
+	flash_queue_drain(&q, test_sink, NULL, 1000, 16);
+	TEST_ASSERT_TRUE(wait_for(&num_received, q.pending));
+
+	/* What is left is the newest records, still in order */
+	first = total - num_received;
+	for (i = 0; i < num_received; i++) {
+		snprintf(message, sizeof(message), "%02u-", first + i);
+		TEST_ASSERT_EQUAL_STRING_LEN(message, received[i], 3);
+	}
+}
+
+static void test_clear(void)
+{
+	append("stale");
+	TEST_ASSERT_TRUE(wait_for(&q.stats.written, 1));
+	TEST_ASSERT_EQUAL(S_OK, flash_queue_clear(&q));
+	TEST_ASSERT_TRUE(flash_queue_empty(&q));
+
+	append("fresh");
+	flash_queue_drain(&q, test_sink, NULL, 1000, 8);
+	TEST_ASSERT_TRUE(wait_for(&num_received, 1));
+	TEST_ASSERT_EQUAL_STRING("fresh", received[0]);
+}
+
+static void test_rejects_bad_records(void)
+{
+	char message[FLASH_QUEUE_RECORD_MAX + 2];
+
+	memset(message, 'x', sizeof(message) - 1);
+	message[sizeof(message) - 1] = '\0';
+
+	TEST_ASSERT_EQUAL(E_BAD_ARGS, flash_queue_append(&q, message, 0));
+	TEST_ASSERT_EQUAL(E_BAD_ARGS, flash_queue_append(&q, message, strlen(message)));
+}
+
+int main(int argc, char *argv[])
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_drains_in_order);
+	RUN_TEST(test_survives_reopen);
+	RUN_TEST(test_consumed_records_stay_consumed);
+	RUN_TEST(test_sink_failure_keeps_record);
+	RUN_TEST(test_write_failure_keeps_record);
+	RUN_TEST(test_full_log_drops_oldest);
+	RUN_TEST(test_clear);
+	RUN_TEST(test_rejects_bad_records);
+
+	return UNITY_END();
+}
@@ -0,0 +1,238 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file test_main.c
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unity.h>
+
+#include "http-bench.h"
+
+#define TEST_BODY_SIZE		1000
+#define TEST_REQUEST_MAX	4096
+
+/*
+ * Local HTTP server the bench runs against. It answers a fixed number of
+ * connections one after the other and checks what each request carried.
+ */
+static struct {
+	int fd;
+	char url[64];
+	int connections;
+	bool chunked;
+	int status;
+	unsigned int requests;
+	unsigned int bad_requests;
+	pthread_t thread;
+} server;
+
+/* Reads a request up to the end of its body, returns false if it is cut short */
+static bool read_request(int fd, char *buf, unsigned int size)
+{
+	unsigned int len = 0;
+	unsigned long body = 0;
+	char *end = NULL;
+	char *length;
+	int n;
+
+	while (len < size - 1) {
+		n = recv(fd, buf + len, size - 1 - len, 0);
+		if (n <= 0)
+			return false;
+		len += n;
+		buf[len] = '\0';
+
+		if (!end) {
+			end = strstr(buf, "\r\n\r\n");
+			if (!end)
+				continue;
+			length = strstr(buf, "Content-Length: ");
+			if (length)
+				body = strtoul(length + 16, NULL, 10);
+		}
+
+		if (len >= (end + 4 - buf) + body)
+			return !strncmp(buf, body ? "POST / HTTP/1.1\r\n" : "GET / HTTP/1.1\r\n",
+				body ? 17 : 16) && strstr(buf, "Host: 127.0.0.1:");
+	}
+
+	return false;
+}
+
+static void send_response(int fd)
+{
+	char body[TEST_BODY_SIZE];
+	char head[128];
+	int i;
+
+	memset(body, 'x', sizeof(body));
+
+	if (server.chunked) {
+		snprintf(head, sizeof(head), "HTTP/1.1 %d OK\r\nTransfer-Encoding: chunked\r\n\r\n",
+			server.status);
+		send(fd, head, strlen(head), 0);
+		for (i = 0; i < 4; i++) {
+			snprintf(head, sizeof(head), "%x\r\n", TEST_BODY_SIZE / 4);
+			send(fd, head, strlen(head), 0);
+			send(fd, body, TEST_BODY_SIZE / 4, 0);
+			send(fd, "\r\n", 2, 0);
+		}
+		send(fd, "0\r\n\r\n", 5, 0);
+	} else {
+		snprintf(head, sizeof(head), "HTTP/1.1 %d OK\r\nContent-Length: %d\r\n\r\n",
+			server.status, TEST_BODY_SIZE);
+		send(fd, head, strlen(head), 0);
+		send(fd, body, sizeof(body), 0);
+	}
+}
+
+static void *serve(void *arg)
+{
+	char *request = malloc(TEST_REQUEST_MAX);
+	int i, fd;
+
+	for (i = 0; i < server.connections; i++) {
+		fd = accept(server.fd, NULL, NULL);
+		if (fd < 0)
+			break;
+
+		server.requests++;
+		if (read_request(fd, request, TEST_REQUEST_MAX))
+			send_response(fd);
+		else
+			server.bad_requests++;
+		close(fd);
+	}
+
+	free(request);
+
+	return NULL;
+}
+
+static void start_server(int connections)
+{
+	server.connections = connections;
+	TEST_ASSERT_EQUAL(0, pthread_create(&server.thread, NULL, serve, NULL));
+}
+
+static void stop_server(void)
+{
+	pthread_join(server.thread, NULL);
+}
+
+void setUp(void)
+{
+	struct sockaddr_in addr;
+	socklen_t len = sizeof(addr);
+
+	memset(&server, 0, sizeof(server));
+	server.status = 200;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	server.fd = socket(AF_INET, SOCK_STREAM, 0);
+	TEST_ASSERT_TRUE(server.fd >= 0);
+	TEST_ASSERT_EQUAL(0, bind(server.fd, (struct sockaddr *)&addr, sizeof(addr)));
+	TEST_ASSERT_EQUAL(0, listen(server.fd, HTTP_BENCH_MAX_WORKERS));
+	TEST_ASSERT_EQUAL(0, getsockname(server.fd, (struct sockaddr *)&addr, &len));
+	snprintf(server.url, sizeof(server.url), "http://127.0.0.1:%d/", ntohs(addr.sin_port));
+}
+
+void tearDown(void)
+{
+	close(server.fd);
+}
+
+static void test_get(void)
+{
+	start_server(20);
+	TEST_ASSERT_EQUAL(0, http_bench(server.url, 20, 4, 0, false));
+	stop_server();
+	TEST_ASSERT_EQUAL(20, server.requests);
+	TEST_ASSERT_EQUAL(0, server.bad_requests);
+}
+
+static void test_post(void)
+{
+	start_server(10);
+	TEST_ASSERT_EQUAL(0, http_bench(server.url, 10, 2, 1500, false));
+	stop_server();
+	TEST_ASSERT_EQUAL(10, server.requests);
+	TEST_ASSERT_EQUAL(0, server.bad_requests);
+}
+
+static void test_chunked(void)
+{
+	server.chunked = true;
+	start_server(8);
+	TEST_ASSERT_EQUAL(0, http_bench(server.url, 8, HTTP_BENCH_MAX_WORKERS, 0, true));
+	stop_server();
+	TEST_ASSERT_EQUAL(8, server.requests);
+}
+
+static void test_errors_fail_the_bench(void)
+{
+	server.status = 500;
+	start_server(4);
+	TEST_ASSERT_EQUAL(-1, http_bench(server.url, 4, 1, 0, false));
+	stop_server();
+	TEST_ASSERT_EQUAL(4, server.requests);
+}
+
+static void test_no_tls_on_host(void)
+{
+	char url[64];
+
+	snprintf(url, sizeof(url), "https://%s", server.url + 7);
+	start_server(1);
+	TEST_ASSERT_EQUAL(-1, http_bench(url, 1, 1, 0, false));
+	stop_server();
+	TEST_ASSERT_EQUAL(1, server.bad_requests);
+}
+
+static void test_rejects_bad_parameters(void)
+{
+	TEST_ASSERT_EQUAL(-1, http_bench(server.url, 0, 1, 0, false));
+	TEST_ASSERT_EQUAL(-1, http_bench(server.url, 1, HTTP_BENCH_MAX_WORKERS + 1, 0, false));
+	TEST_ASSERT_EQUAL(-1, http_bench(server.url, 1, 1, -1, false));
+}
+
+int main(int argc, char **argv)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_get);
+	RUN_TEST(test_post);
+	RUN_TEST(test_chunked);
+	RUN_TEST(test_errors_fail_the_bench);
+	RUN_TEST(test_no_tls_on_host);
+	RUN_TEST(test_rejects_bad_parameters);
+
+	return UNITY_END();
+}
@@ -0,0 +1,248 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file test_main.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "http-parser.h"
+
+#define TEST_BODY_MAX	256
+
+struct response {
+	char body[TEST_BODY_MAX];
+	unsigned int len;
+	unsigned int pieces;
+	unsigned int headers;
+	char etag[32];
+	unsigned int abort_header;
+};
+
+static struct response rsp;
+static struct http_parser_handler handler;
+static struct http_parser parser;
+
+static int on_header(const char *name, const char *value, void *user_data)
+{
+	struct response *r = (struct response *)user_data;
+
+	r->headers++;
+	if (!strcmp(name, "ETag"))
+		strncpy(r->etag, value, sizeof(r->etag) - 1);
+
+	return (r->abort_header && (r->headers == r->abort_header)) ? -1 : 0;
+}
+
+static int on_body(char *data, unsigned int len, void *user_data)
+{
+	struct response *r = (struct response *)user_data;
+
+	TEST_ASSERT_TRUE(r->len + len < TEST_BODY_MAX);
+	memcpy(r->body + r->len, data, len);
+	r->len += len;
+	r->pieces++;
+
+	return 0;
+}
+
+/* Feeds the response in pieces of step bytes, 0 for all at once */
+static artik_error feed(const char *response, unsigned int step)
+{
+	char buf[512];
+	unsigned int len = strlen(response);
+	unsigned int off, n;
+	artik_error ret = S_OK;
+
+	TEST_ASSERT_TRUE(len < sizeof(buf));
+	memcpy(buf, response, len);
+
+	for (off = 0; off < len; off += n) {
+		n = (step && (len - off > step)) ? step : len - off;
+		ret = http_parser_feed(&parser, buf + off, n);
+		if (ret != S_OK)
+			break;
+	}
+
+	return ret;
+}
+
+static void reset(bool head)
+{
+	memset(&rsp, 0, sizeof(rsp));
+	http_parser_init(&parser, &handler, head);
+}
+
+void setUp(void)
+{
+	handler.header = on_header;
+	handler.body = on_body;
+	handler.user_data = &rsp;
+	reset(false);
+}
+
+void tearDown(void)
+{
+}
+
+static void test_content_length_at_every_split(void)
+{
+	static const char response[] =
+		"HTTP/1.1 200 OK\r\nContent-Length: 11\r\nETag: \"v1\"\r\n\r\nhello world";
+	unsigned int step;
+
+	for (step = 1; step <= sizeof(response); step++) {
+		reset(false);
+		TEST_ASSERT_EQUAL(S_OK, feed(response, step));
+		TEST_ASSERT_EQUAL(HTTP_PARSER_DONE, parser.state);
+		TEST_ASSERT_EQUAL(200, parser.status);
+		TEST_ASSERT_EQUAL(11, rsp.len);
+		TEST_ASSERT_EQUAL_MEMORY("hello world", rsp.body, 11);
+		TEST_ASSERT_EQUAL_STRING("\"v1\"", rsp.etag);
+	}
+}
+
+static void test_chunked_at_every_split(void)
+{
+	static const char response[] =
+		"HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+		"5;name=value\r\nhello\r\n1\r\n \r\n5\r\nworld\r\n0\r\nX-Trailer: 1\r\n\r\n";
+	unsigned int step;
+
+	for (step = 1; step <= sizeof(response); step++) {
+		reset(false);
+		TEST_ASSERT_EQUAL(S_OK, feed(response, step));
+		TEST_ASSERT_EQUAL(HTTP_PARSER_DONE, parser.state);
+		TEST_ASSERT_EQUAL(11, rsp.len);
+		TEST_ASSERT_EQUAL_MEMORY("hello world", rsp.body, 11);
+	}
+}
+
+static void test_chunked_stops_at_end_of_response(void)
+{
+	TEST_ASSERT_EQUAL(S_OK, feed("HTTP/1.1 200 OK\r\nTransfer-Encoding: gzip, Chunked\r\n\r\n"
+		"3\r\nabc\r\n0\r\n\r\nHTTP/1.1 500 Junk\r\n\r\n", 0));
+	TEST_ASSERT_EQUAL(HTTP_PARSER_DONE, parser.state);
+	TEST_ASSERT_EQUAL(200, parser.status);
+	TEST_ASSERT_EQUAL(3, rsp.len);
+}
+
+static void test_chunked_token_is_whole_element(void)
+{
+	TEST_ASSERT_EQUAL(S_OK, feed("HTTP/1.1 200 OK\r\nTransfer-Encoding: xchunked\r\n\r\n"
+		"3\r\nabc", 0));
+	TEST_ASSERT_EQUAL(HTTP_PARSER_BODY_UNTIL_CLOSE, parser.state);
+	TEST_ASSERT_EQUAL(S_OK, http_parser_close(&parser));
+	TEST_ASSERT_EQUAL(6, rsp.len);
+	TEST_ASSERT_EQUAL_MEMORY("3\r\nabc", rsp.body, 6);
+}
+
+static void test_bad_chunk_size(void)
+{
+	TEST_ASSERT_EQUAL(E_HTTP_ERROR, feed("HTTP/1.1 200 OK\r\n"
+		"Transfer-Encoding: chunked\r\n\r\nzz\r\n", 0));
+}
+
+static void test_interim_responses_are_skipped(void)
+{
+	static const char response[] =
+		"HTTP/1.1 100 Continue\r\n\r\n"
+		"HTTP/1.1 103 Early Hints\r\nLink: </style.css>\r\n\r\n"
+		"HTTP/1.1 201 Created\r\nContent-Length: 2\r\n\r\nok";
+	unsigned int step;
+
+	for (step = 1; step <= sizeof(response); step += 7) {
+		reset(false);
+		TEST_ASSERT_EQUAL(S_OK, feed(response, step));
+		TEST_ASSERT_EQUAL(HTTP_PARSER_DONE, parser.state);
+		TEST_ASSERT_EQUAL(201, parser.status);
+		TEST_ASSERT_EQUAL(2, rsp.len);
+	}
+}
+
+static void test_no_content_has_no_body(void)
+{
+	TEST_ASSERT_EQUAL(S_OK, feed("HTTP/1.1 204 No Content\r\n\r\n", 0));
+	TEST_ASSERT_EQUAL(HTTP_PARSER_DONE, parser.state);
+	TEST_ASSERT_EQUAL(204, parser.status);
+	TEST_ASSERT_EQUAL(0, rsp.pieces);
+}
+
+static void test_not_modified_ignores_length(void)
+{
+	/* A 304 repeats the length of the cached body without sending it */
+	TEST_ASSERT_EQUAL(S_OK, feed("HTTP/1.1 304 Not Modified\r\nContent-Length: 120\r\n"
+		"ETag: \"v1\"\r\n\r\n", 0));
+	TEST_ASSERT_EQUAL(HTTP_PARSER_DONE, parser.state);
+	TEST_ASSERT_EQUAL(304, parser.status);
+	TEST_ASSERT_EQUAL(0, rsp.pieces);
+	TEST_ASSERT_EQUAL_STRING("\"v1\"", rsp.etag);
+}
+
+static void test_head_ignores_length(void)
+{
+	reset(true);
+	TEST_ASSERT_EQUAL(S_OK, feed("HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\n", 0));
+	TEST_ASSERT_EQUAL(HTTP_PARSER_DONE, parser.state);
+	TEST_ASSERT_EQUAL(0, rsp.pieces);
+}
+
+static void test_close_ends_unknown_length_only(void)
+{
+	TEST_ASSERT_EQUAL(S_OK, feed("HTTP/1.0 200 OK\r\n\r\nsome", 0));
+	TEST_ASSERT_EQUAL(S_OK, http_parser_close(&parser));
+	TEST_ASSERT_EQUAL(4, rsp.len);
+
+	reset(false);
+	TEST_ASSERT_EQUAL(S_OK, feed("HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nsome", 0));
+	TEST_ASSERT_EQUAL(E_HTTP_ERROR, http_parser_close(&parser));
+}
+
+static void test_bad_status_line(void)
+{
+	TEST_ASSERT_EQUAL(E_HTTP_ERROR, feed("ICY 200 OK\r\n\r\n", 0));
+}
+
+static void test_header_callback_aborts(void)
+{
+	rsp.abort_header = 1;
+	TEST_ASSERT_EQUAL(E_INTERRUPTED, feed("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok", 0));
+	TEST_ASSERT_EQUAL(0, rsp.pieces);
+}
+
+int main(int argc, char **argv)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_content_length_at_every_split);
+	RUN_TEST(test_chunked_at_every_split);
+	RUN_TEST(test_chunked_stops_at_end_of_response);
+	RUN_TEST(test_chunked_token_is_whole_element);
+	RUN_TEST(test_bad_chunk_size);
+	RUN_TEST(test_interim_responses_are_skipped);
+	RUN_TEST(test_no_content_has_no_body);
+	RUN_TEST(test_not_modified_ignores_length);
+	RUN_TEST(test_head_ignores_length);
+	RUN_TEST(test_close_ends_unknown_length_only);
+	RUN_TEST(test_bad_status_line);
+	RUN_TEST(test_header_callback_aborts);
+
+	return UNITY_END();
+}
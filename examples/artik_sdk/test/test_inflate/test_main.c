@@ -0,0 +1,327 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file test_main.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+#include "inflate.h"
+
+#define TEST_LINES		50
+#define TEST_TEXT_MAX	4096
+#define TEST_PACKED_MAX	4096
+
+/*
+ * Compressed with zlib: "hello hello hello world" with Z_FIXED, and the
+ * text made by make_text() at level 9, which takes a dynamic block.
+ */
+static const unsigned char fixed_block[] = {
+	0xcb, 0x48, 0xcd, 0xc9, 0xc9, 0x57, 0xc8, 0x40, 0x22, 0xcb, 0xf3, 0x8b,
+	0x72, 0x52, 0x00,
+};
+
+static const unsigned char dynamic_blocks[] = {
+	0x95, 0x96, 0x49, 0x56, 0xc3, 0x40, 0x0c, 0x44, 0xf7, 0x39, 0x45, 0x1f,
+	0xa1, 0x35, 0xb8, 0x6d, 0x73, 0x1b, 0x86, 0x00, 0x81, 0x10, 0x43, 0x42,
+	0x98, 0x4e, 0xcf, 0x03, 0x77, 0x65, 0xff, 0xd7, 0x7e, 0xf5, 0x64, 0x49,
+	0x5f, 0x55, 0xbd, 0xdf, 0x1d, 0xb6, 0xa5, 0x5e, 0x95, 0xf7, 0xc7, 0x6d,
+	0x79, 0x3b, 0xef, 0x6e, 0x9f, 0xcb, 0xcd, 0x71, 0xf9, 0x3c, 0x94, 0xfb,
+	0xe5, 0xab, 0x3c, 0x9d, 0x5f, 0x5e, 0x4f, 0x65, 0xf9, 0xd8, 0x1e, 0xff,
+	0x3f, 0xef, 0xaf, 0x7f, 0xbe, 0xcb, 0xdd, 0xf2, 0x50, 0xea, 0x66, 0xff,
+	0xa7, 0x32, 0xa6, 0xb2, 0x55, 0xe5, 0x4c, 0x95, 0xab, 0x2a, 0x98, 0x6a,
+	0x5e, 0x55, 0x09, 0xff, 0xb0, 0xad, 0xb2, 0x81, 0xc9, 0x7c, 0x58, 0x65,
+	0x8d, 0xc9, 0xa2, 0x57, 0x1b, 0xe1, 0x40, 0x7a, 0x6f, 0x13, 0x93, 0xb5,
+	0x3e, 0xc8, 0x99, 0xc9, 0xa6, 0xbe, 0x35, 0x83, 0x88, 0x58, 0x15, 0x24,
+	0x94, 0x12, 0x57, 0x45, 0x08, 0x8a, 0x65, 0xef, 0xd0, 0x82, 0x6e, 0xbd,
+	0x4f, 0xd4, 0x28, 0x2e, 0x73, 0xdf, 0xa0, 0x51, 0x60, 0x44, 0x8c, 0x35,
+	0x4a, 0x9a, 0x2a, 0x42, 0x68, 0x7c, 0x52, 0x8f, 0x10, 0x9b, 0x70, 0x4d,
+	0x75, 0xa6, 0x74, 0xeb, 0xde, 0x21, 0x39, 0x29, 0x72, 0x1c, 0x92, 0x93,
+	0xa9, 0x8a, 0xd4, 0x62, 0xa6, 0xde, 0xa3, 0x43, 0x72, 0x06, 0xef, 0x53,
+	0x75, 0x48, 0xce, 0x30, 0xf6, 0x3d, 0x3a, 0x24, 0xa7, 0x89, 0x1c, 0x87,
+	0xe4, 0xb4, 0x4b, 0x45, 0x48, 0xce, 0x78, 0xe9, 0x11, 0x92, 0x33, 0x5e,
+	0xa6, 0x4a, 0x2d, 0x47, 0x7b, 0x0c, 0x48, 0xce, 0x2c, 0x72, 0x02, 0x92,
+	0x33, 0x8b, 0xd5, 0xa0, 0x9e, 0x53, 0x75, 0x1e, 0x41, 0x4d, 0xa7, 0xea,
+	0x22, 0x83, 0xba, 0x8e, 0xc9, 0x04, 0x62, 0xa0, 0xd6, 0x2a, 0x7a, 0xa2,
+	0x51, 0xa5, 0xac, 0x2e, 0x20, 0x3e, 0x16, 0x72, 0xd7, 0x98, 0xb0, 0x9f,
+	0x6b, 0xb6, 0x10, 0x20, 0x1b, 0x94, 0x21, 0x49, 0x53, 0xab, 0x09, 0xa1,
+	0xa4, 0xb1, 0xd5, 0x94, 0x94, 0x49, 0x19, 0x1a, 0x15, 0xcd, 0x49, 0x19,
+	0x9a, 0xf4, 0x16, 0x48, 0x9c, 0x5c, 0x7a, 0x7c, 0x24, 0x8d, 0xae, 0x2a,
+	0x86, 0x92, 0x66, 0x97, 0xe9, 0x79, 0x95, 0x34, 0xbc, 0xbc, 0xaa, 0x4f,
+	0xc8, 0x90, 0x47, 0xd5, 0x6c, 0x21, 0x43, 0x9e, 0xd5, 0x36, 0xbf,
+};
+
+static char text[TEST_TEXT_MAX];
+static unsigned int text_len;
+
+static unsigned char packed[TEST_PACKED_MAX];
+static unsigned int packed_len;
+
+static char out[TEST_TEXT_MAX];
+static unsigned int out_len;
+
+static struct inflate_stream *strm;
+
+static int sink(const char *data, unsigned int len, void *user_data)
+{
+	TEST_ASSERT_TRUE(out_len + len <= TEST_TEXT_MAX);
+	memcpy(out + out_len, data, len);
+	out_len += len;
+
+	return 0;
+}
+
+static void make_text(void)
+{
+	int i;
+
+	text_len = 0;
+	for (i = 0; i < TEST_LINES; i++)
+		text_len += snprintf(text + text_len, TEST_TEXT_MAX - text_len,
+			"line %d: the quick brown fox jumps over the lazy dog %d\n", i, i * i);
+}
+
+static void put(const void *data, unsigned int len)
+{
+	TEST_ASSERT_TRUE(packed_len + len <= TEST_PACKED_MAX);
+	memcpy(packed + packed_len, data, len);
+	packed_len += len;
+}
+
+static void put_le32(uint32_t value)
+{
+	unsigned char b[4] = { value, value >> 8, value >> 16, value >> 24 };
+
+	put(b, 4);
+}
+
+static void put_be32(uint32_t value)
+{
+	unsigned char b[4] = { value >> 24, value >> 16, value >> 8, value };
+
+	put(b, 4);
+}
+
+static uint32_t adler32(const char *data, unsigned int len)
+{
+	uint32_t a = 1, b = 0;
+
+	while (len--) {
+		a = (a + (unsigned char)*data++) % 65521;
+		b = (b + a) % 65521;
+	}
+
+	return (b << 16) | a;
+}
+
+/* Two stored blocks, the second one final, splitting the text */
+static void pack_stored(void)
+{
+	unsigned int half = text_len / 2;
+	unsigned char head[5];
+
+	head[0] = 0x00;
+	head[1] = half & 0xff;
+	head[2] = half >> 8;
+	head[3] = ~half & 0xff;
+	head[4] = (~half >> 8) & 0xff;
+	put(head, 5);
+	put(text, half);
+
+	head[0] = 0x01;
+	head[1] = (text_len - half) & 0xff;
+	head[2] = (text_len - half) >> 8;
+	head[3] = ~(text_len - half) & 0xff;
+	head[4] = (~(text_len - half) >> 8) & 0xff;
+	put(head, 5);
+	put(text + half, text_len - half);
+}
+
+/* gzip member with a file name, as servers send for static files */
+static void pack_gzip(void)
+{
+	static const unsigned char head[] = {
+		0x1f, 0x8b, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03,
+		'f', 'w', '.', 't', 'x', 't', '\0'
+	};
+
+	put(head, sizeof(head));
+	put(dynamic_blocks, sizeof(dynamic_blocks));
+	put_le32(inflate_crc32(0, (const unsigned char *)text, text_len));
+	put_le32(text_len);
+}
+
+static void pack_zlib(void)
+{
+	static const unsigned char head[] = { 0x78, 0xda };
+
+	put(head, sizeof(head));
+	put(dynamic_blocks, sizeof(dynamic_blocks));
+	put_be32(adler32(text, text_len));
+}
+
+/* Feeds the packed data in pieces of step bytes, returns the last result */
+static int unpack(enum inflate_wrapper wrapper, unsigned int step)
+{
+	unsigned int off, n;
+	int ret = INFLATE_OK;
+
+	out_len = 0;
+	inflate_init(strm, wrapper, sink, NULL);
+
+	for (off = 0; (off < packed_len) && (ret == INFLATE_OK); off += n) {
+		n = (packed_len - off > step) ? step : packed_len - off;
+		ret = inflate_feed(strm, (const char *)packed + off, n);
+	}
+
+	return ret;
+}
+
+static void check_unpack(enum inflate_wrapper wrapper, const char *expected,
+		unsigned int len)
+{
+	static const unsigned int steps[] = { 1, 2, 7, 64, TEST_PACKED_MAX };
+	unsigned int i;
+
+	for (i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+		TEST_ASSERT_EQUAL(INFLATE_DONE, unpack(wrapper, steps[i]));
+		TEST_ASSERT_TRUE(inflate_finished(strm));
+		TEST_ASSERT_EQUAL(len, out_len);
+		TEST_ASSERT_EQUAL_MEMORY(expected, out, len);
+	}
+}
+
+void setUp(void)
+{
+	strm = malloc(sizeof(struct inflate_stream));
+	TEST_ASSERT_NOT_NULL(strm);
+	make_text();
+	packed_len = 0;
+}
+
+void tearDown(void)
+{
+	free(strm);
+}
+
+static void test_stored_blocks(void)
+{
+	pack_stored();
+	check_unpack(INFLATE_WRAPPER_RAW, text, text_len);
+}
+
+static void test_fixed_block(void)
+{
+	static const char hello[] = "hello hello hello world";
+
+	put(fixed_block, sizeof(fixed_block));
+	check_unpack(INFLATE_WRAPPER_RAW, hello, sizeof(hello) - 1);
+}
+
+static void test_dynamic_block(void)
+{
+	put(dynamic_blocks, sizeof(dynamic_blocks));
+	check_unpack(INFLATE_WRAPPER_RAW, text, text_len);
+}
+
+static void test_gzip(void)
+{
+	pack_gzip();
+	check_unpack(INFLATE_WRAPPER_GZIP, text, text_len);
+	check_unpack(INFLATE_WRAPPER_AUTO, text, text_len);
+}
+
+static void test_zlib(void)
+{
+	pack_zlib();
+	check_unpack(INFLATE_WRAPPER_ZLIB, text, text_len);
+	check_unpack(INFLATE_WRAPPER_AUTO, text, text_len);
+}
+
+static void test_raw_detected(void)
+{
+	put(dynamic_blocks, sizeof(dynamic_blocks));
+	check_unpack(INFLATE_WRAPPER_AUTO, text, text_len);
+}
+
+static void test_gzip_bad_crc(void)
+{
+	pack_gzip();
+	packed[packed_len - 8] ^= 0x01;
+	TEST_ASSERT_EQUAL(INFLATE_ERROR, unpack(INFLATE_WRAPPER_GZIP, 1));
+	TEST_ASSERT_FALSE(inflate_finished(strm));
+}
+
+static void test_gzip_bad_length(void)
+{
+	pack_gzip();
+	packed[packed_len - 4] ^= 0x01;
+	TEST_ASSERT_EQUAL(INFLATE_ERROR, unpack(INFLATE_WRAPPER_GZIP, 1));
+}
+
+static void test_zlib_bad_adler(void)
+{
+	pack_zlib();
+	packed[packed_len - 1] ^= 0x80;
+	TEST_ASSERT_EQUAL(INFLATE_ERROR, unpack(INFLATE_WRAPPER_ZLIB, 1));
+	TEST_ASSERT_FALSE(inflate_finished(strm));
+}
+
+static void test_truncated(void)
+{
+	pack_gzip();
+	packed_len -= 3;
+	TEST_ASSERT_EQUAL(INFLATE_OK, unpack(INFLATE_WRAPPER_GZIP, 1));
+	TEST_ASSERT_FALSE(inflate_finished(strm));
+}
+
+static void test_bad_stored_length(void)
+{
+	pack_stored();
+	packed[3] ^= 0x01;
+	TEST_ASSERT_EQUAL(INFLATE_ERROR, unpack(INFLATE_WRAPPER_RAW, 1));
+}
+
+static void test_crc32(void)
+{
+	TEST_ASSERT_EQUAL_HEX32(0xcbf43926,
+		inflate_crc32(0, (const unsigned char *)"123456789", 9));
+}
+
+int main(int argc, char **argv)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_stored_blocks);
+	RUN_TEST(test_fixed_block);
+	RUN_TEST(test_dynamic_block);
+	RUN_TEST(test_gzip);
+	RUN_TEST(test_zlib);
+	RUN_TEST(test_raw_detected);
+	RUN_TEST(test_gzip_bad_crc);
+	RUN_TEST(test_gzip_bad_length);
+	RUN_TEST(test_zlib_bad_adler);
+	RUN_TEST(test_truncated);
+	RUN_TEST(test_bad_stored_length);
+	RUN_TEST(test_crc32);
+
+	return UNITY_END();
+}
@@ -0,0 +1,160 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file test_main.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+#include "ws-rxpool.h"
+
+/* The receive callback gets heap strings from the SDK */
+static char *sdk_frame(unsigned int len, char c)
+{
+	char *message = malloc(len + 1);
+
+	TEST_ASSERT_NOT_NULL(message);
+	memset(message, c, len);
+	message[len] = '\0';
+
+	return message;
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+	struct ws_rxpool_stats stats;
+
+	ws_rxpool_get_stats(&stats);
+	TEST_ASSERT_EQUAL(0, stats.in_use);
+}
+
+static void test_small_frame_is_copied(void)
+{
+	struct ws_rxpool_stats before, after;
+	struct ws_frame *frame;
+
+	ws_rxpool_get_stats(&before);
+	frame = ws_frame_take(sdk_frame(100, 'a'));
+	TEST_ASSERT_NOT_NULL(frame);
+	TEST_ASSERT_EQUAL(100, frame->len);
+	TEST_ASSERT_EQUAL(100, strlen(frame->data));
+	TEST_ASSERT_TRUE(frame->data == frame->buf);
+	ws_frame_release(frame);
+
+	ws_rxpool_get_stats(&after);
+	TEST_ASSERT_EQUAL(1, after.copied - before.copied);
+	TEST_ASSERT_EQUAL(0, after.adopted - before.adopted);
+}
+
+static void test_boundary_sizes(void)
+{
+	struct ws_frame *frame;
+
+	frame = ws_frame_take(sdk_frame(WS_RXPOOL_BUF_SIZE - 1, 'b'));
+	TEST_ASSERT_EQUAL(WS_RXPOOL_BUF_SIZE - 1, frame->len);
+	TEST_ASSERT_TRUE(frame->data == frame->buf);
+	ws_frame_release(frame);
+
+	frame = ws_frame_take(sdk_frame(WS_RXPOOL_BUF_SIZE, 'c'));
+	TEST_ASSERT_EQUAL(WS_RXPOOL_BUF_SIZE, frame->len);
+	TEST_ASSERT_TRUE(frame->data != frame->buf);
+	ws_frame_release(frame);
+
+	frame = ws_frame_take(sdk_frame(0, 'd'));
+	TEST_ASSERT_EQUAL(0, frame->len);
+	TEST_ASSERT_EQUAL_STRING("", frame->data);
+	ws_frame_release(frame);
+}
+
+static void test_large_frame_is_adopted(void)
+{
+	char *message = sdk_frame(4000, 'e');
+	struct ws_frame *frame = ws_frame_take(message);
+
+	TEST_ASSERT_TRUE(frame->data == message);
+	TEST_ASSERT_EQUAL(4000, frame->len);
+	ws_frame_release(frame);
+}
+
+static void test_references_keep_the_frame(void)
+{
+	struct ws_rxpool_stats stats;
+	struct ws_frame *frame = ws_frame_take(sdk_frame(10, 'f'));
+
+	ws_frame_ref(frame);
+	ws_frame_release(frame);
+	ws_rxpool_get_stats(&stats);
+	TEST_ASSERT_EQUAL(1, stats.in_use);
+	TEST_ASSERT_EQUAL_STRING("ffffffffff", frame->data);
+	ws_frame_release(frame);
+}
+
+static void test_exhausted_pool_uses_the_heap(void)
+{
+	struct ws_frame *frames[WS_RXPOOL_BUFFERS + 2];
+	struct ws_rxpool_stats before, after;
+	int i;
+
+	ws_rxpool_get_stats(&before);
+	for (i = 0; i < WS_RXPOOL_BUFFERS + 2; i++) {
+		frames[i] = ws_frame_take(sdk_frame(20, 'g' + i));
+		TEST_ASSERT_NOT_NULL(frames[i]);
+	}
+
+	ws_rxpool_get_stats(&after);
+	TEST_ASSERT_EQUAL(2, after.allocated - before.allocated);
+	TEST_ASSERT_EQUAL(WS_RXPOOL_BUFFERS + 2, after.in_use);
+	TEST_ASSERT_TRUE(after.high_water >= WS_RXPOOL_BUFFERS + 2);
+
+	for (i = 0; i < WS_RXPOOL_BUFFERS + 2; i++) {
+		TEST_ASSERT_EQUAL('g' + i, frames[i]->data[19]);
+		ws_frame_release(frames[i]);
+	}
+
+	/* Released buffers go back to the pool */
+	frames[0] = ws_frame_take(sdk_frame(20, 'z'));
+	ws_rxpool_get_stats(&before);
+	TEST_ASSERT_EQUAL(after.allocated, before.allocated);
+	ws_frame_release(frames[0]);
+}
+
+static void test_null_message(void)
+{
+	TEST_ASSERT_NULL(ws_frame_take(NULL));
+	ws_frame_release(NULL);
+}
+
+int main(int argc, char **argv)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_small_frame_is_copied);
+	RUN_TEST(test_boundary_sizes);
+	RUN_TEST(test_large_frame_is_adopted);
+	RUN_TEST(test_references_keep_the_frame);
+	RUN_TEST(test_exhausted_pool_uses_the_heap);
+	RUN_TEST(test_null_message);
+
+	return UNITY_END();
+}
@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <apps/netutils/netlib.h>
 #include <apps/netutils/wifi/slsi_wifi_api.h>
 #include <iotbus/iotbus_gpio.h>
@@ -31,24 +32,53 @@
 #define APP_STACKSIZE 2048
 #endif
 
+#define GPIO_MAX_CACHED             8
+
+// Not the artik_sdk record, which has another layout
+#define WIFI_ASSOC_PATH             "/mnt/blink-assoc"
+#define WIFI_ASSOC_MAGIC            0x42415343
+#define DIRECTED_JOIN_TIMEOUT       5
+#define FULL_JOIN_TIMEOUT           30
+
 /*---------------------------------------------------------------------------*/
 /* User Required Defines                                                     */
 /*---------------------------------------------------------------------------*/
 #define SSID "IoTG-test"
 #define PSK  "12345678"
+#define SECURITY SLSI_WIFI_SECURITY_WPA2_AES
+
+// Number of LED toggles timed at startup, 0 to skip the benchmark
+#define TOGGLE_BENCH_COUNT 0
 
 /*---------------------------------------------------------------------------*/
 /* Function Prototypes                                                       */
 /*---------------------------------------------------------------------------*/
 slsi_security_config_t *getSecurityConfig(char *sec_type, char *psk, WiFi_InterFace_ID_t mode);
+static unsigned long long elapsed_us(struct timespec *start);
 
 /*---------------------------------------------------------------------------*/
 /* Global Variables                                                          */
 /*---------------------------------------------------------------------------*/
 static int g_connection_state = STATE_DISCONNECTED;
 static uint8_t g_join_result  = 0;
+static char g_join_bssid[18];
 static sem_t g_sem_join;
 
+// Last access point joined, saved in flash
+struct wifi_assoc {
+    uint32_t magic;
+    char ssid[33];
+    char bssid[18];
+    char security[16];
+};
+
+static struct {
+    int port;
+    int fd;
+} g_gpio_fds[GPIO_MAX_CACHED];
+static int g_gpio_num_fds = 0;
+static int g_gpio_evict = 0;
+
 /**
  * Handler for network link up connection event
  *
@@ -59,6 +89,7 @@ void networkLinkUpHandler(slsi_reason_t* reason) {
     g_connection_state = STATE_CONNECTED;
 
     g_join_result = reason->reason_code;
+    strncpy(g_join_bssid, reason->bssid, sizeof(g_join_bssid) - 1);
     sem_post(&g_sem_join);
 }
 
@@ -79,14 +110,121 @@ void networkLinkDownHandler(slsi_reason_t* reason) {
     }
 }
 
+/**
+ * Load the last association
+ * Return: 0 if one was saved for the configured network, -1 otherwise
+ *
+ *   Reads the access point the device last joined from flash. A record
+ *   saved for another SSID or security type is ignored.
+ */
+static int load_assoc(struct wifi_assoc *assoc)
+{
+    ssize_t len;
+    int fd = open(WIFI_ASSOC_PATH, O_RDONLY);
+
+    if (fd < 0) {
+        return -1;
+    }
+
+    len = read(fd, assoc, sizeof(*assoc));
+    close(fd);
+
+    if (len != sizeof(*assoc) || assoc->magic != WIFI_ASSOC_MAGIC) {
+        return -1;
+    }
+
+    assoc->ssid[sizeof(assoc->ssid) - 1] = '\0';
+    assoc->bssid[sizeof(assoc->bssid) - 1] = '\0';
+    assoc->security[sizeof(assoc->security) - 1] = '\0';
+
+    if (strcmp(assoc->ssid, SSID) || strcmp(assoc->security, SECURITY) || !assoc->bssid[0]) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Save the association
+ *
+ *   Writes the access point just joined to flash, for the next boot to join
+ *   it directly. A record that could not be written whole is removed.
+ */
+static void save_assoc(const char *bssid)
+{
+    struct wifi_assoc assoc;
+    ssize_t len;
+    int fd;
+
+    memset(&assoc, 0, sizeof(assoc));
+    assoc.magic = WIFI_ASSOC_MAGIC;
+    strncpy(assoc.ssid, SSID, sizeof(assoc.ssid) - 1);
+    strncpy(assoc.bssid, bssid, sizeof(assoc.bssid) - 1);
+    strncpy(assoc.security, SECURITY, sizeof(assoc.security) - 1);
+
+    fd = open(WIFI_ASSOC_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        return;
+    }
+
+    len = write(fd, &assoc, sizeof(assoc));
+    close(fd);
+
+    if (len != sizeof(assoc)) {
+        printf("Failed to save the association\n");
+        unlink(WIFI_ASSOC_PATH);
+    }
+}
+
+/**
+ * Join the network and wait for the link to come up
+ * Return: Completed successfully or failed
+ *
+ *   With a BSSID the join is directed to that access point only. A join
+ *   that does not complete within timeout seconds is abandoned.
+ */
+static int8_t join_network(char *bssid, slsi_security_config_t *security_config, int timeout_s)
+{
+    struct timespec timeout;
+    int ret;
+
+    // Drop a link up that came after an abandoned join
+    while (sem_trywait(&g_sem_join) == 0);
+
+    g_join_bssid[0] = '\0';
+
+    if ( WiFiNetworkJoin((uint8_t*)SSID, strlen(SSID), (uint8_t*)bssid, security_config) == SLSI_STATUS_ERROR ) {
+        return SLSI_STATUS_ERROR;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &timeout);
+    timeout.tv_sec += timeout_s;
+
+    while ((ret = sem_timedwait(&g_sem_join, &timeout)) < 0 && errno == EINTR);
+
+    if ( ret < 0 ) {
+        WiFiNetworkLeave();
+        return SLSI_STATUS_ERROR;
+    }
+
+    return g_join_result ? SLSI_STATUS_ERROR : SLSI_STATUS_SUCCESS;
+}
+
 /**
  * Starts the Wi-Fi interface and request connection to the specified network
  * Return: Completed successfully or failed
  *
  *   Starts the Wi-Fi interface in Station mode and requests to join the
- *   specified network.
+ *   specified network. The access point joined last time is tried first
+ *   with a directed join, which falls back to a full scan when it fails.
+ *   The time taken to associate is printed.
  */
 int8_t start_wifi_interface(void) {
+    struct wifi_assoc assoc;
+    struct timespec start;
+    struct timespec boot = { 0, 0 };
+    const char *method = "directed";
+    int8_t result = SLSI_STATUS_ERROR;
 
     if ( WiFiRegisterLinkCallback(&networkLinkUpHandler, &networkLinkDownHandler) ) {
         return SLSI_STATUS_ERROR;
@@ -98,33 +236,106 @@ int8_t start_wifi_interface(void) {
 
     sem_init(&g_sem_join, 0, 0);
 
-    slsi_security_config_t *security_config = getSecurityConfig(SLSI_WIFI_SECURITY_WPA2_AES, PSK, SLSI_WIFI_STATION_IF);
+    slsi_security_config_t *security_config = getSecurityConfig(SECURITY, PSK, SLSI_WIFI_STATION_IF);
 
-    if ( WiFiNetworkJoin((uint8_t*)SSID, strlen(SSID), NULL, security_config) == SLSI_STATUS_ERROR ) {
-        return SLSI_STATUS_ERROR;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if ( load_assoc(&assoc) == 0 ) {
+        result = join_network(assoc.bssid, security_config, DIRECTED_JOIN_TIMEOUT);
+        if ( result == SLSI_STATUS_ERROR ) {
+            printf("Directed join to %s failed, scanning\n", assoc.bssid);
+        }
     }
 
-    sem_wait(&g_sem_join);
+    if ( result == SLSI_STATUS_ERROR ) {
+        method = "full";
+        result = join_network(NULL, security_config, FULL_JOIN_TIMEOUT);
+        if ( result == SLSI_STATUS_SUCCESS && g_join_bssid[0] ) {
+            save_assoc(g_join_bssid);
+        }
+    }
 
-    if( g_join_result ) {
-       return SLSI_STATUS_ERROR;
+    if ( result == SLSI_STATUS_SUCCESS ) {
+        // The monotonic clock starts at boot
+        printf("Associated with %s (%s join) in %llu ms, %llu ms after boot\n", g_join_bssid,
+                method, elapsed_us(&start) / 1000, elapsed_us(&boot) / 1000);
     }
 
     free(security_config);
     sem_destroy(&g_sem_join);
 
-    return SLSI_STATUS_SUCCESS;
+    return result;
+}
+/**
+ * Open a gpio for output
+ * Return: File descriptor of the gpio or -1 on failure
+ *
+ *   The device is opened and set as output on first use only, then the file
+ *   descriptor is kept for all later writes. Once GPIO_MAX_CACHED ports are
+ *   open, the descriptors are closed and replaced round robin.
+ */
+int gpio_open(int port)
+{
+    char devpath[16];
+    int fd;
+    int i;
+
+    for (i = 0; i < g_gpio_num_fds; i++) {
+        if (g_gpio_fds[i].port == port) {
+            return g_gpio_fds[i].fd;
+        }
+    }
+
+    snprintf(devpath, 16, "/dev/gpio%d", port);
+    fd = open(devpath, O_RDWR);
+    if (fd < 0) {
+        return -1;
+    }
+
+    ioctl(fd, GPIOIOC_SET_DIRECTION, GPIO_DIRECTION_OUT);
+
+    if (g_gpio_num_fds < GPIO_MAX_CACHED) {
+        i = g_gpio_num_fds++;
+    } else {
+        i = g_gpio_evict;
+        g_gpio_evict = (g_gpio_evict + 1) % GPIO_MAX_CACHED;
+        close(g_gpio_fds[i].fd);
+    }
+
+    g_gpio_fds[i].port = port;
+    g_gpio_fds[i].fd = fd;
+
+    return fd;
 }
+
 /**
  * Write the value of gpio
  *
- *   Write the value of given gpio port.
+ *   Write the value of given gpio port. A toggle is a single write on the
+ *   cached file descriptor.
  *
  */
 void gpio_write(int port, int value)
+{
+    int fd = gpio_open(port);
+
+    if (fd < 0) {
+        return;
+    }
+
+    write(fd, value ? "1" : "0", 2);
+}
+
+/**
+ * Write the value of gpio without the descriptor cache
+ *
+ *   Opens, configures, writes and closes the device on every call, as
+ *   gpio_write() used to. Only kept for the toggle benchmark.
+ */
+static void gpio_write_uncached(int port, int value)
 {
     char str[4];
-    static char devpath[16];
+    char devpath[16];
     snprintf(devpath, 16, "/dev/gpio%d", port);
     int fd = open(devpath, O_RDWR);
 
@@ -133,6 +344,44 @@ void gpio_write(int port, int value)
 
     close(fd);
 }
+
+static unsigned long long elapsed_us(struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000000ULL + (now.tv_nsec - start->tv_nsec) / 1000;
+}
+
+/**
+ * Measure the toggle rate of a gpio
+ *
+ *   Toggles the gpio count times with and without the descriptor cache and
+ *   prints the achievable frequency, a period being two toggles.
+ */
+void toggle_bench(int port, int count)
+{
+    struct timespec start;
+    unsigned long long us;
+    int i;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < count; i++) {
+        gpio_write_uncached(port, i & 1);
+    }
+    us = elapsed_us(&start) + 1;
+    printf("open/ioctl/write/close: %d toggles in %llu us, %llu Hz\n", count, us,
+            count * 500000ULL / us);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < count; i++) {
+        gpio_write(port, i & 1);
+    }
+    us = elapsed_us(&start) + 1;
+    printf("cached descriptor: %d toggles in %llu us, %llu Hz\n", count, us,
+            count * 500000ULL / us);
+}
+
 /**
  * Blinks the LED for the given file descriptor handle
  *
@@ -188,6 +437,10 @@ int main(int argc, char *argv[]) {
     mount_app_main(0, NULL);
 #endif
 
+    if (TOGGLE_BENCH_COUNT > 0) {
+        toggle_bench(49, TOGGLE_BENCH_COUNT);
+    }
+
     if ( start_wifi_interface() == SLSI_STATUS_ERROR ) {
     	printf("Connect Wi-Fi failed. Exit.\n");
         return SLSI_STATUS_ERROR;